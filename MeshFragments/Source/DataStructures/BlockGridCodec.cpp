@@ -0,0 +1,200 @@
+#include "stdafx.h"
+#include "BlockGridCodec.h"
+
+#include "Utilities/LZCodec.h"
+
+// [Static members initialization]
+
+const char BlockGridCodec::MAGIC[4] = { 'B', 'G', 'R', 'D' };
+const uint16_t BlockGridCodec::VERSION = 1;
+const uint32_t BlockGridCodec::BLOCK_SIZE = 1 << 16;
+
+static_assert(sizeof(BlockGridCodec::Header) == 32, "Header must match the on-disk layout");
+static_assert(sizeof(BlockGridCodec::Block) == 16, "Block must match the on-disk layout");
+
+/// [Reader]
+
+BlockGridCodec::Reader::Reader() : _blocks(nullptr), _header{}
+{
+}
+
+bool BlockGridCodec::Reader::decode(uint16_t* values) const
+{
+	if (!_blocks) return false;
+
+	bool success = true;
+
+	#pragma omp parallel for schedule(dynamic) reduction(&&:success)
+	for (int blockIdx = 0; blockIdx < static_cast<int>(_header._numBlocks); ++blockIdx)
+		if (!this->decodeBlock(blockIdx, values + static_cast<size_t>(blockIdx) * _header._blockSize))
+			success = false;
+
+	return success;
+}
+
+bool BlockGridCodec::Reader::decodeRange(size_t first, size_t count, uint16_t* values) const
+{
+	const size_t numVoxels = static_cast<size_t>(_header._numDivs.x) * _header._numDivs.y * _header._numDivs.z;
+	if (!_blocks || first + count > numVoxels) return false;
+	if (count == 0) return true;
+
+	std::vector<uint16_t> block;
+
+	for (size_t blockIdx = first / _header._blockSize; blockIdx <= (first + count - 1) / _header._blockSize; ++blockIdx)
+	{
+		const size_t blockStart = blockIdx * _header._blockSize, blockEnd = blockStart + this->getNumVoxels(static_cast<uint32_t>(blockIdx));
+		const size_t start = std::max(first, blockStart), end = std::min(first + count, blockEnd);
+
+		// Blocks fully covered by the range are decoded in place
+		if (start == blockStart && end == blockEnd)
+		{
+			if (!this->decodeBlock(static_cast<uint32_t>(blockIdx), values + (start - first))) return false;
+			continue;
+		}
+
+		block.resize(blockEnd - blockStart);
+		if (!this->decodeBlock(static_cast<uint32_t>(blockIdx), block.data())) return false;
+
+		std::copy(block.begin() + (start - blockStart), block.begin() + (end - blockStart), values + (start - first));
+	}
+
+	return true;
+}
+
+bool BlockGridCodec::Reader::decodeSlice(unsigned x, uint16_t* values) const
+{
+	if (x >= _header._numDivs.x) return false;
+
+	const size_t sliceSize = static_cast<size_t>(_header._numDivs.y) * _header._numDivs.z;
+
+	return this->decodeRange(x * sliceSize, sliceSize, values);
+}
+
+bool BlockGridCodec::Reader::open(const std::string& filename)
+{
+	_blocks = nullptr;
+	if (!_file.open(filename) || _file.size() < sizeof(Header)) return false;
+
+	std::memcpy(&_header, _file.data(), sizeof(Header));
+	if (std::memcmp(_header._magic, MAGIC, sizeof(MAGIC)) != 0 || _header._version != VERSION || _header._blockSize == 0)
+		return false;
+
+	const size_t numVoxels = static_cast<size_t>(_header._numDivs.x) * _header._numDivs.y * _header._numDivs.z;
+	if ((numVoxels + _header._blockSize - 1) / _header._blockSize != _header._numBlocks)
+		return false;
+
+	if (sizeof(Header) + static_cast<size_t>(_header._numBlocks) * sizeof(Block) > _file.size())
+		return false;
+
+	const Block* blocks = reinterpret_cast<const Block*>(_file.data() + sizeof(Header));
+	for (uint32_t blockIdx = 0; blockIdx < _header._numBlocks; ++blockIdx)
+	{
+		if (blocks[blockIdx]._offset + blocks[blockIdx]._size > _file.size())
+			return false;
+	}
+
+	_blocks = blocks;
+
+	return true;
+}
+
+bool BlockGridCodec::Reader::decodeBlock(uint32_t blockIdx, uint16_t* values) const
+{
+	const Block& block = _blocks[blockIdx];
+	const uint8_t* data = _file.data() + block._offset;
+	const size_t numVoxels = this->getNumVoxels(blockIdx);
+
+	std::vector<uint8_t> bytes(numVoxels * sizeof(uint16_t));
+	if (block._flags & STORED)
+	{
+		if (block._size != bytes.size()) return false;
+		std::memcpy(bytes.data(), data, bytes.size());
+	}
+	else if (!LZCodec::decompress(data, block._size, bytes.data(), bytes.size()))
+		return false;
+
+	// Interleave low and high bytes back
+	for (size_t idx = 0; idx < numVoxels; ++idx)
+		values[idx] = static_cast<uint16_t>(bytes[idx] | (bytes[numVoxels + idx] << 8));
+
+	return true;
+}
+
+size_t BlockGridCodec::Reader::getNumVoxels(uint32_t blockIdx) const
+{
+	const size_t numVoxels = static_cast<size_t>(_header._numDivs.x) * _header._numDivs.y * _header._numDivs.z;
+
+	return std::min(static_cast<size_t>(_header._blockSize), numVoxels - static_cast<size_t>(blockIdx) * _header._blockSize);
+}
+
+/// [Public methods]
+
+bool BlockGridCodec::write(std::ostream& stream, const uint16_t* values, const uvec3& numDivs)
+{
+	const size_t numVoxels = static_cast<size_t>(numDivs.x) * numDivs.y * numDivs.z;
+	const uint32_t numBlocks = static_cast<uint32_t>((numVoxels + BLOCK_SIZE - 1) / BLOCK_SIZE);
+	std::vector<std::vector<uint8_t>> encodedBlocks(numBlocks);
+	std::vector<Block> blocks(numBlocks);
+
+	#pragma omp parallel for schedule(dynamic)
+	for (int blockIdx = 0; blockIdx < static_cast<int>(numBlocks); ++blockIdx)
+	{
+		const size_t first = static_cast<size_t>(blockIdx) * BLOCK_SIZE;
+		blocks[blockIdx]._flags = encodeBlock(values + first, std::min(static_cast<size_t>(BLOCK_SIZE), numVoxels - first), encodedBlocks[blockIdx]);
+	}
+
+	Header header;
+	std::memcpy(header._magic, MAGIC, sizeof(MAGIC));
+	header._version = VERSION;
+	header._reserved = 0;
+	header._numDivs = numDivs;
+	header._blockSize = BLOCK_SIZE;
+	header._numBlocks = numBlocks;
+	header._reserved2 = 0;
+
+	// Block directory, with blocks placed right after it
+	size_t offset = sizeof(Header) + blocks.size() * sizeof(Block);
+	for (uint32_t blockIdx = 0; blockIdx < numBlocks; ++blockIdx)
+	{
+		blocks[blockIdx]._offset = offset;
+		blocks[blockIdx]._size = static_cast<uint32_t>(encodedBlocks[blockIdx].size());
+		offset += encodedBlocks[blockIdx].size();
+	}
+
+	std::vector<uint8_t> buffer(offset);
+	std::memcpy(buffer.data(), &header, sizeof(Header));
+	if (!blocks.empty())
+		std::memcpy(buffer.data() + sizeof(Header), blocks.data(), blocks.size() * sizeof(Block));
+
+	#pragma omp parallel for
+	for (int blockIdx = 0; blockIdx < static_cast<int>(numBlocks); ++blockIdx)
+		std::copy(encodedBlocks[blockIdx].begin(), encodedBlocks[blockIdx].end(), buffer.begin() + blocks[blockIdx]._offset);
+
+	stream.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+
+	return !stream.fail();
+}
+
+/// [Protected methods]
+
+uint32_t BlockGridCodec::encodeBlock(const uint16_t* values, size_t count, std::vector<uint8_t>& block)
+{
+	// Low bytes first, then high bytes, as labels rarely use the latter
+	std::vector<uint8_t> bytes(count * sizeof(uint16_t));
+	for (size_t idx = 0; idx < count; ++idx)
+	{
+		bytes[idx] = static_cast<uint8_t>(values[idx]);
+		bytes[count + idx] = static_cast<uint8_t>(values[idx] >> 8);
+	}
+
+	block.clear();
+	LZCodec::compress(bytes.data(), bytes.size(), block);
+
+	if (block.size() < bytes.size())
+		return 0;
+
+	block = std::move(bytes);
+
+	return STORED;
+}
+
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "Utilities/MemoryMappedFile.h"
+
+/**
+*	@brief Raw 16-bit voxel grid split into blocks of a fixed number of voxels in grid order (x * ny * nz + y * nz + z). Blocks are
+*	compressed independently, so that they are encoded and decoded in parallel and any slice is read by decoding only the blocks it
+*	overlaps. The low and high bytes of the voxels of a block are stored separately before compressing them with LZCodec.
+*
+*	Layout: Header | Block[numBlocks] | compressed blocks.
+*/
+class BlockGridCodec
+{
+public:
+	const static char		MAGIC[4];							//!< File signature
+	const static uint16_t	VERSION;							//!< Current version of the format
+	const static uint32_t	BLOCK_SIZE;							//!< Voxels per block, except for the last one
+
+	enum BlockFlags : uint32_t { STORED = 1 };					//!< Blocks that did not compress are kept as they are
+
+	struct Header
+	{
+		char		_magic[4];
+		uint16_t	_version;
+		uint16_t	_reserved;
+		uvec3		_numDivs;									//!< Dimensions of the grid
+		uint32_t	_blockSize;									//!< Voxels per block
+		uint32_t	_numBlocks;
+		uint32_t	_reserved2;
+	};
+
+	struct Block
+	{
+		uint64_t	_offset;									//!< Offset of the block from the beginning of the file
+		uint32_t	_size;										//!< Bytes of the block in the file
+		uint32_t	_flags;
+	};
+
+	/**
+	*	@brief Random access to an encoded grid through a memory-mapped view of the file.
+	*/
+	class Reader
+	{
+	protected:
+		const Block*		_blocks;							//!< Block directory of the mapped file
+		MemoryMappedFile	_file;								//!< Encoded grid
+		Header				_header;							//!< Copy of the file header
+
+	protected:
+		/**
+		*	@brief Decodes a whole block into values.
+		*	@return False if the block is corrupted.
+		*/
+		bool decodeBlock(uint32_t blockIdx, uint16_t* values) const;
+
+		/**
+		*	@return Number of voxels of a block.
+		*/
+		size_t getNumVoxels(uint32_t blockIdx) const;
+
+	public:
+		/**
+		*	@brief Constructor. A file must be opened before decoding.
+		*/
+		Reader();
+
+		/**
+		*	@brief Decodes the whole grid. Blocks are decoded in parallel.
+		*	@param values Buffer with room for numDivs.x * numDivs.y * numDivs.z values.
+		*	@return Success of operation.
+		*/
+		bool decode(uint16_t* values) const;
+
+		/**
+		*	@brief Decodes the voxels [first, first + count) in grid order.
+		*	@return Success of operation.
+		*/
+		bool decodeRange(size_t first, size_t count, uint16_t* values) const;
+
+		/**
+		*	@brief Decodes a single x slice of ny * nz voxels.
+		*	@return Success of operation.
+		*/
+		bool decodeSlice(unsigned x, uint16_t* values) const;
+
+		/**
+		*	@return Dimensions of the encoded grid.
+		*/
+		uvec3 getNumSubdivisions() const { return _header._numDivs; }
+
+		/**
+		*	@brief Maps a file and validates its header and block directory.
+		*	@return Success of operation.
+		*/
+		bool open(const std::string& filename);
+	};
+
+protected:
+	/**
+	*	@brief Compresses count voxels into block.
+	*	@return Flags of the block.
+	*/
+	static uint32_t encodeBlock(const uint16_t* values, size_t count, std::vector<uint8_t>& block);
+
+public:
+	/**
+	*	@brief Encodes a grid and writes it with a single call.
+	*	@return Success of operation.
+	*/
+	static bool write(std::ostream& stream, const uint16_t* values, const uvec3& numDivs);
+};
+
@@ -0,0 +1,55 @@
+#include "stdafx.h"
+#include "FragmentShard.h"
+
+// [Static members initialization]
+
+const char FragmentShard::MAGIC[4] = { 'F', 'S', 'H', 'I' };
+const uint16_t FragmentShard::VERSION = 1;
+const uint64_t FragmentShard::MAX_SHARD_SIZE = uint64_t(1) << 30;
+const uint64_t FragmentShard::ENTRY_ALIGNMENT = 8;
+const std::string FragmentShard::INDEX_EXTENSION = ".index";
+const std::string FragmentShard::SHARD_EXTENSION = ".shard";
+
+static_assert(sizeof(FragmentShard::Key) == 16, "Key must match the on-disk layout");
+static_assert(sizeof(FragmentShard::Entry) == 80, "Entry must match the on-disk layout");
+static_assert(sizeof(FragmentShard::Header) == 40, "Header must match the on-disk layout");
+
+/// [Public methods]
+
+bool FragmentShard::Key::operator==(const Key& key) const
+{
+	return _model == key._model && _numFragments == key._numFragments && _iteration == key._iteration && _fragmentId == key._fragmentId &&
+		_type == key._type && _format == key._format && _lod == key._lod;
+}
+
+std::string FragmentShard::getShardFilename(const std::string& prefix, uint32_t shardIdx)
+{
+	std::string index = std::to_string(shardIdx);
+	index.insert(0, std::max(0, 4 - static_cast<int>(index.size())), '0');
+
+	return prefix + "_" + index + SHARD_EXTENSION;
+}
+
+uint64_t FragmentShard::hash(const Key& key)
+{
+	// FNV-1a over the fields, which avoids hashing padding bytes
+	uint64_t hash = 14695981039346656037ull;
+	const auto mix = [&hash](uint64_t value, int numBytes)
+		{
+			for (int byteIdx = 0; byteIdx < numBytes; ++byteIdx)
+			{
+				hash ^= (value >> (byteIdx * 8)) & 0xFF;
+				hash *= 1099511628211ull;
+			}
+		};
+
+	mix(key._model, 4);
+	mix(key._numFragments, 2);
+	mix(key._iteration, 2);
+	mix(key._fragmentId, 2);
+	mix(key._type, 1);
+	mix(key._format, 1);
+	mix(key._lod, 4);
+
+	return hash;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "Graphics/Core/FragmentationProcedure.h"
+
+/**
+*	@brief On-disk layout of a sharded fragment dataset. Exported files are appended to large shard files, while a separate index
+*	maps every (model, number of fragments, iteration, fragment, representation, LOD) key to its location and metadata.
+*
+*	Index layout: Header | Entry[numEntries] | uint32 hash table[tableSize] | uint32 model name offsets[numModels] | names.
+*	Hash table slots hold entry index + 1, or 0 if empty, and are probed linearly.
+*/
+struct FragmentShard
+{
+	const static char		MAGIC[4];							//!< Index signature
+	const static uint16_t	VERSION;							//!< Current version of the index
+	const static uint64_t	MAX_SHARD_SIZE;						//!< A new shard is started once this size is exceeded
+	const static uint64_t	ENTRY_ALIGNMENT;					//!< Entries start at multiples of this offset within shards
+	const static std::string INDEX_EXTENSION, SHARD_EXTENSION;
+
+	const static uint16_t	WHOLE_MODEL = 0xFFFF;				//!< Fragment identifier of files covering every fragment, such as grids
+	const static uint8_t	UNKEYED = 0xFF;						//!< Type of files that were not registered with a key; they are not hashed
+
+	struct Key
+	{
+		uint32_t	_model;										//!< Index of the model name
+		uint16_t	_numFragments;								//!< Zero for the starting model
+		uint16_t	_iteration;
+		uint16_t	_fragmentId;
+		uint8_t		_type;										//!< FragmentationProcedure::FragmentType
+		uint8_t		_format;									//!< Extension index within the type, e.g. FractureParameters::ExportMeshExtension
+		uint32_t	_lod;										//!< Target triangles or points, zero for the full resolution
+
+		bool operator==(const Key& key) const;
+	};
+
+	struct Entry
+	{
+		Key			_key;
+		uint64_t	_offset;									//!< Position of the file within its shard
+		uint64_t	_size;
+		uint32_t	_shard;
+		uint32_t	_nameOffset;								//!< Original file name, within the names block
+
+		// Fragment metadata
+		ivec3		_voxelizationSize;
+		uint32_t	_numVertices, _numFaces;
+		uint32_t	_occupiedVoxels, _voxels;
+		float		_percentage;
+		uint32_t	_numPoints;
+		uint32_t	_reserved;
+	};
+
+	struct Header
+	{
+		char		_magic[4];
+		uint16_t	_version;
+		uint16_t	_reserved;
+		uint32_t	_numShards;
+		uint32_t	_numModels;
+		uint64_t	_numEntries;
+		uint64_t	_tableSize;									//!< Number of hash slots, a power of two
+		uint64_t	_namesBytes;
+	};
+
+	/**
+	*	@return Filename of the i-th shard of a dataset.
+	*/
+	static std::string getShardFilename(const std::string& prefix, uint32_t shardIdx);
+
+	/**
+	*	@return Hash of a key.
+	*/
+	static uint64_t hash(const Key& key);
+};
+
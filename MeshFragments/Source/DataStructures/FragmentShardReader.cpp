@@ -0,0 +1,138 @@
+#include "stdafx.h"
+#include "FragmentShardReader.h"
+
+// [Static members initialization]
+
+const uint32_t FragmentShardReader::INVALID_MODEL = std::numeric_limits<uint32_t>::max();
+
+/// [Public methods]
+
+FragmentShardReader::FragmentShardReader() :
+	_entries(nullptr), _header(nullptr), _modelNames(nullptr), _names(nullptr), _table(nullptr)
+{
+}
+
+FragmentShardReader::~FragmentShardReader()
+{
+	this->close();
+}
+
+void FragmentShardReader::close()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	_shards.clear();
+	_modelIds.clear();
+	_index.close();
+	_entries = nullptr;
+	_header = nullptr;
+	_modelNames = nullptr;
+	_names = nullptr;
+	_table = nullptr;
+}
+
+const FragmentShard::Entry* FragmentShardReader::find(const FragmentShard::Key& key) const
+{
+	if (!_header || _header->_tableSize == 0) return nullptr;
+
+	const uint64_t mask = _header->_tableSize - 1;
+	uint64_t slot = FragmentShard::hash(key) & mask;
+
+	// A table without empty slots is only bounded by its size
+	for (uint64_t probe = 0; probe < _header->_tableSize && _table[slot]; ++probe)
+	{
+		const FragmentShard::Entry& entry = _entries[_table[slot] - 1];
+		if (entry._key == key) return &entry;
+
+		slot = (slot + 1) & mask;
+	}
+
+	return nullptr;
+}
+
+uint32_t FragmentShardReader::findModel(const std::string& name) const
+{
+	auto it = _modelIds.find(name);
+	return it != _modelIds.end() ? it->second : INVALID_MODEL;
+}
+
+bool FragmentShardReader::open(const std::string& prefix)
+{
+	this->close();
+
+	if (!_index.open(prefix + FragmentShard::INDEX_EXTENSION) || _index.size() < sizeof(FragmentShard::Header))
+		return false;
+
+	const FragmentShard::Header* header = reinterpret_cast<const FragmentShard::Header*>(_index.data());
+	if (std::memcmp(header->_magic, FragmentShard::MAGIC, sizeof(FragmentShard::MAGIC)) != 0 || header->_version != FragmentShard::VERSION ||
+		(header->_tableSize & (header->_tableSize - 1)) != 0)
+	{
+		_index.close();
+		return false;
+	}
+
+	// Counts are bounded by the file size before adding them up, so that the expected size cannot overflow
+	const uint64_t indexSize = _index.size();
+	if (header->_numEntries > indexSize / sizeof(FragmentShard::Entry) || header->_tableSize > indexSize / sizeof(uint32_t) || header->_namesBytes > indexSize ||
+		sizeof(FragmentShard::Header) + header->_numEntries * sizeof(FragmentShard::Entry) + (header->_tableSize + header->_numModels) * sizeof(uint32_t) + header->_namesBytes != indexSize)
+	{
+		_index.close();
+		return false;
+	}
+
+	const FragmentShard::Entry* entries = reinterpret_cast<const FragmentShard::Entry*>(_index.data() + sizeof(FragmentShard::Header));
+	const uint32_t* table = reinterpret_cast<const uint32_t*>(entries + header->_numEntries);
+	const uint32_t* modelNames = table + header->_tableSize;
+	const char* names = reinterpret_cast<const char*>(modelNames + header->_numModels);
+
+	// Names are read as C strings, so each one must end within the names block
+	const auto isName = [names, header](uint32_t offset) { return offset < header->_namesBytes && std::memchr(names + offset, '\0', header->_namesBytes - offset); };
+	bool valid = true;
+
+	for (uint64_t entryIdx = 0; entryIdx < header->_numEntries && valid; ++entryIdx)
+		valid = isName(entries[entryIdx]._nameOffset);
+	for (uint64_t slot = 0; slot < header->_tableSize && valid; ++slot)
+		valid = table[slot] <= header->_numEntries;
+	for (uint32_t modelIdx = 0; modelIdx < header->_numModels && valid; ++modelIdx)
+		valid = isName(modelNames[modelIdx]);
+
+	if (!valid)
+	{
+		_index.close();
+		return false;
+	}
+
+	_header = header;
+	_entries = entries;
+	_table = table;
+	_modelNames = modelNames;
+	_names = names;
+	_prefix = prefix;
+	_shards.resize(header->_numShards);
+
+	for (uint32_t modelIdx = 0; modelIdx < header->_numModels; ++modelIdx)
+		_modelIds[std::string(_names + _modelNames[modelIdx])] = modelIdx;
+
+	return true;
+}
+
+const uint8_t* FragmentShardReader::read(const FragmentShard::Entry& entry)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (entry._shard >= _shards.size()) return nullptr;
+
+	std::unique_ptr<MemoryMappedFile>& shard = _shards[entry._shard];
+	if (!shard)
+	{
+		shard = std::make_unique<MemoryMappedFile>();
+		if (!shard->open(FragmentShard::getShardFilename(_prefix, entry._shard)))
+		{
+			shard.reset();
+			return nullptr;
+		}
+	}
+
+	if (entry._offset > shard->size() || entry._size > shard->size() - entry._offset) return nullptr;
+
+	return shard->data() + entry._offset;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "DataStructures/FragmentShard.h"
+#include "Utilities/MemoryMappedFile.h"
+
+/**
+*	@brief Random access to a sharded fragment dataset (see FragmentShard). The index and the shards are memory-mapped, and keys
+*	are resolved in constant time through the hash table stored in the index.
+*/
+class FragmentShardReader
+{
+public:
+	const static uint32_t INVALID_MODEL;									//!< Returned when a model is not in the dataset
+
+protected:
+	const FragmentShard::Entry*						_entries;				//!< Entries of the mapped index
+	const FragmentShard::Header*					_header;				//!< Header of the mapped index
+	MemoryMappedFile								_index;					//!< Index file
+	std::unordered_map<std::string, uint32_t>		_modelIds;				//!< Model name to key identifier
+	const uint32_t*									_modelNames;			//!< Offset of each model name
+	std::mutex										_mutex;					//!< Guards the lazy mapping of shards
+	const char*										_names;					//!< Names block
+	std::string										_prefix;				//!< Path of the dataset, without extension
+	std::vector<std::unique_ptr<MemoryMappedFile>>	_shards;				//!< Shards, mapped on first access
+	const uint32_t*									_table;					//!< Hash table
+
+public:
+	/**
+	*	@brief Constructor. The dataset must be opened before any query.
+	*/
+	FragmentShardReader();
+
+	/**
+	*	@brief Destructor.
+	*/
+	virtual ~FragmentShardReader();
+
+	/**
+	*	@brief Unmaps the index and every shard.
+	*/
+	void close();
+
+	/**
+	*	@return Entry with the given key, or nullptr if it is not in the dataset.
+	*/
+	const FragmentShard::Entry* find(const FragmentShard::Key& key) const;
+
+	/**
+	*	@return Identifier of a model, or INVALID_MODEL.
+	*/
+	uint32_t findModel(const std::string& name) const;
+
+	/**
+	*	@return Every stored file, including those without key.
+	*/
+	const FragmentShard::Entry* getEntries() const { return _entries; }
+
+	/**
+	*	@return Name of a model.
+	*/
+	std::string getModelName(uint32_t modelId) const { return modelId < _header->_numModels ? std::string(_names + _modelNames[modelId]) : std::string(); }
+
+	/**
+	*	@return Original file name of an entry.
+	*/
+	std::string getName(const FragmentShard::Entry& entry) const { return std::string(_names + entry._nameOffset); }
+
+	/**
+	*	@return Number of stored files.
+	*/
+	size_t getNumEntries() const { return _header ? _header->_numEntries : 0; }
+
+	/**
+	*	@return Number of models in the dataset.
+	*/
+	size_t getNumModels() const { return _header ? _header->_numModels : 0; }
+
+	/**
+	*	@brief Maps the index of a dataset and checks its consistency.
+	*	@param prefix Path of the dataset without extension, as given to FragmentShardWriter::open.
+	*	@return Success of operation.
+	*/
+	bool open(const std::string& prefix);
+
+	/**
+	*	@brief Provides the content of a file, which remains valid until the reader is closed. Thread-safe.
+	*	@return Pointer to the first byte of the file, or nullptr if its shard cannot be mapped.
+	*/
+	const uint8_t* read(const FragmentShard::Entry& entry);
+};
+
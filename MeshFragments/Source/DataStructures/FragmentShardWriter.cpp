@@ -0,0 +1,194 @@
+#include "stdafx.h"
+#include "FragmentShardWriter.h"
+
+/// [Public methods]
+
+FragmentShardWriter::FragmentShardWriter() : _shardIdx(0), _shardOffset(0)
+{
+}
+
+FragmentShardWriter::~FragmentShardWriter()
+{
+	this->close();
+}
+
+bool FragmentShardWriter::addFile(const std::string& name, const char* data, size_t size)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (!_shard.is_open()) return false;
+
+	FragmentShard::Entry entry;
+	auto pending = _pending.find(name);
+
+	if (pending != _pending.end())
+	{
+		entry = pending->second;
+		_pending.erase(pending);
+	}
+	else
+	{
+		std::memset(&entry, 0, sizeof(FragmentShard::Entry));
+		entry._key._type = FragmentShard::UNKEYED;
+	}
+
+	if (_shardOffset > 0 && _shardOffset + size > FragmentShard::MAX_SHARD_SIZE)
+	{
+		++_shardIdx;
+		if (!this->openShard()) return false;
+	}
+
+	entry._shard = _shardIdx;
+	entry._offset = _shardOffset;
+	entry._size = size;
+	entry._nameOffset = static_cast<uint32_t>(_names.size());
+	_names.append(name.c_str(), name.size() + 1);
+
+	const uint64_t padding = (FragmentShard::ENTRY_ALIGNMENT - size % FragmentShard::ENTRY_ALIGNMENT) % FragmentShard::ENTRY_ALIGNMENT;
+	const char zeros[FragmentShard::ENTRY_ALIGNMENT] = { 0 };
+
+	_shard.write(data, size);
+	_shard.write(zeros, padding);
+	_shardOffset += size + padding;
+	_entries.push_back(entry);
+
+	return !_shard.fail();
+}
+
+uint32_t FragmentShardWriter::addModel(const std::string& name)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	_models.push_back(name);
+
+	return static_cast<uint32_t>(_models.size() - 1);
+}
+
+bool FragmentShardWriter::close()
+{
+	if (!_shard.is_open()) return false;
+
+	const bool success = this->writeIndex();
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	for (const auto& pending : _pending)
+		std::cout << "Shard entry " << pending.first << " was registered but never written" << std::endl;
+
+	_shard.close();
+	_entries.clear();
+	_models.clear();
+	_names.clear();
+	_pending.clear();
+
+	return success && !_shard.fail();
+}
+
+void FragmentShardWriter::expect(const std::string& name, const FragmentShard::Key& key, const FragmentationProcedure::FragmentMetadata& metadata)
+{
+	FragmentShard::Entry entry;
+	std::memset(&entry, 0, sizeof(FragmentShard::Entry));
+
+	entry._key = key;
+	entry._voxelizationSize = metadata._voxelizationSize;
+
+	if (metadata._type == FragmentationProcedure::POINT_CLOUD)
+		entry._numPoints = metadata._numPoints;
+	else
+	{
+		entry._numVertices = metadata._numVertices;
+		entry._numFaces = metadata._numFaces;
+		entry._occupiedVoxels = metadata._occupiedVoxels;
+		entry._voxels = metadata._voxels;
+		entry._percentage = metadata._percentage;
+	}
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	_pending[name] = entry;
+}
+
+bool FragmentShardWriter::open(const std::string& prefix)
+{
+	this->close();
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	_prefix = prefix;
+	_shardIdx = 0;
+
+	return this->openShard();
+}
+
+/// [Protected methods]
+
+bool FragmentShardWriter::openShard()
+{
+	if (_shard.is_open()) _shard.close();
+
+	_shardOffset = 0;
+	_shard.open(FragmentShard::getShardFilename(_prefix, _shardIdx), std::ios::out | std::ios::binary | std::ios::trunc);
+
+	return _shard.is_open();
+}
+
+bool FragmentShardWriter::writeIndex()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (!_shard.is_open()) return false;
+
+	_shard.flush();
+
+	// Hash table with a load factor of at most 0.5
+	uint64_t tableSize = 1;
+	while (tableSize < _entries.size() * 2) tableSize <<= 1;
+
+	std::vector<uint32_t> table(tableSize, 0);
+	for (uint32_t entryIdx = 0; entryIdx < _entries.size(); ++entryIdx)
+	{
+		const FragmentShard::Key& key = _entries[entryIdx]._key;
+		if (key._type == FragmentShard::UNKEYED) continue;
+
+		uint64_t slot = FragmentShard::hash(key) & (tableSize - 1);
+		while (table[slot] && !(_entries[table[slot] - 1]._key == key))
+			slot = (slot + 1) & (tableSize - 1);
+
+		// Files exported twice with the same key keep the latest one
+		table[slot] = entryIdx + 1;
+	}
+
+	std::string names = _names;
+	std::vector<uint32_t> modelNames(_models.size());
+	for (size_t modelIdx = 0; modelIdx < _models.size(); ++modelIdx)
+	{
+		modelNames[modelIdx] = static_cast<uint32_t>(names.size());
+		names.append(_models[modelIdx].c_str(), _models[modelIdx].size() + 1);
+	}
+
+	FragmentShard::Header header;
+	std::memcpy(header._magic, FragmentShard::MAGIC, sizeof(FragmentShard::MAGIC));
+	header._version = FragmentShard::VERSION;
+	header._reserved = 0;
+	header._numShards = _shardIdx + 1;
+	header._numModels = static_cast<uint32_t>(_models.size());
+	header._numEntries = _entries.size();
+	header._tableSize = tableSize;
+	header._namesBytes = names.size();
+
+	const std::string filename = _prefix + FragmentShard::INDEX_EXTENSION, temporaryFilename = filename + TEMPORARY_EXTENSION;
+	std::ofstream fout(temporaryFilename, std::ios::out | std::ios::binary);
+	if (!fout.is_open()) return false;
+
+	fout.write((char*)&header, sizeof(FragmentShard::Header));
+	fout.write((char*)_entries.data(), _entries.size() * sizeof(FragmentShard::Entry));
+	fout.write((char*)table.data(), table.size() * sizeof(uint32_t));
+	fout.write((char*)modelNames.data(), modelNames.size() * sizeof(uint32_t));
+	fout.write(names.data(), names.size());
+	fout.close();
+
+	if (fout.fail())
+	{
+		std::filesystem::remove(temporaryFilename);
+		return false;
+	}
+
+	std::error_code error;
+	std::filesystem::rename(temporaryFilename, filename, error);
+
+	return !error;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "DataStructures/FragmentShard.h"
+#include "Utilities/ExportContainer.h"
+
+/**
+*	@brief Packs exported files into shards and builds the index of a fragment dataset (see FragmentShard). Files are registered
+*	with their key and metadata before being exported, so that exporters only need to know their file name.
+*/
+class FragmentShardWriter: public ExportContainer
+{
+protected:
+	std::vector<FragmentShard::Entry>						_entries;			//!< Stored files
+	std::vector<std::string>								_models;			//!< Model names, indexed by Key::_model
+	std::mutex												_mutex;				//!< Guards every member, as files arrive from the export workers
+	std::string												_names;				//!< Null-terminated file names
+	std::unordered_map<std::string, FragmentShard::Entry>	_pending;			//!< Registered files which have not arrived yet
+	std::string												_prefix;			//!< Path of the dataset, without extension
+	std::ofstream											_shard;				//!< Shard being written
+	uint32_t												_shardIdx;			//!< Index of the current shard
+	uint64_t												_shardOffset;		//!< Size of the current shard
+
+protected:
+	/**
+	*	@brief Starts the next shard.
+	*/
+	bool openShard();
+
+	/**
+	*	@brief Writes the index of the stored files, replacing the previous one only once it is complete.
+	*	@return Success of operation.
+	*/
+	bool writeIndex();
+
+public:
+	/**
+	*	@brief Constructor. The dataset must be opened before adding files.
+	*/
+	FragmentShardWriter();
+
+	/**
+	*	@brief Destructor. Closes the dataset if it is open.
+	*/
+	virtual ~FragmentShardWriter();
+
+	/**
+	*	@brief Appends a file to the current shard. Files without a registered key are stored, but can only be found by iterating the index.
+	*	@return Success of operation.
+	*/
+	bool addFile(const std::string& name, const char* data, size_t size) override;
+
+	/**
+	*	@brief Registers a model name.
+	*	@return Identifier of the model for the keys.
+	*/
+	uint32_t addModel(const std::string& name);
+
+	/**
+	*	@brief Writes the index and closes the current shard. Registered files that never arrived are reported, as they are not indexed.
+	*	@return Success of operation.
+	*/
+	bool close();
+
+	/**
+	*	@brief Registers the key and metadata of a file that will be added later.
+	*/
+	void expect(const std::string& name, const FragmentShard::Key& key, const FragmentationProcedure::FragmentMetadata& metadata);
+
+	/**
+	*	@brief Starts a dataset. Shards are named prefix_XXXX.shard and the index prefix.index.
+	*	@return Success of operation.
+	*/
+	bool open(const std::string& prefix);
+};
+
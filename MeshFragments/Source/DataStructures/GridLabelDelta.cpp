@@ -0,0 +1,334 @@
+#include "stdafx.h"
+#include "GridLabelDelta.h"
+
+#include "DataStructures/RegularGrid.h"
+#include "Utilities/MemoryMappedFile.h"
+#include "Utilities/RangeCoder.h"
+
+// [Static members initialization]
+
+const char GridLabelDelta::LABEL_MAGIC[4] = { 'G', 'L', 'B', 'L' };
+const char GridLabelDelta::OCCUPANCY_MAGIC[4] = { 'G', 'O', 'C', 'C' };
+const std::string GridLabelDelta::OCCUPANCY_EXTENSION = "vocc";
+const std::string GridLabelDelta::OCCUPANCY_PREFIX = "occupancy_";
+const uint16_t GridLabelDelta::VERSION = 1;
+
+static_assert(sizeof(GridLabelDelta::OccupancyHeader) == 36, "Header must match the on-disk layout");
+static_assert(sizeof(GridLabelDelta::LabelHeader) == 24, "Header must match the on-disk layout");
+
+/// [Public methods]
+
+void GridLabelDelta::captureOccupancy(const uint16_t* grid, const uvec3& numDivs, Occupancy& occupancy)
+{
+	const size_t numVoxels = static_cast<size_t>(numDivs.x) * numDivs.y * numDivs.z;
+	bool occupied = false;
+	uint32_t length = 0;
+
+	occupancy._numDivs = numDivs;
+	occupancy._numOccupied = 0;
+	occupancy._runs.clear();
+
+	for (size_t idx = 0; idx < numVoxels; ++idx)
+	{
+		if ((grid[idx] != VOXEL_EMPTY) != occupied)
+		{
+			occupancy._runs.push_back(length);
+			occupied = !occupied;
+			length = 0;
+		}
+
+		++length;
+		occupancy._numOccupied += static_cast<size_t>(occupied);
+	}
+
+	occupancy._runs.push_back(length);
+	occupancy._checksum = GridLabelDelta::checksum(occupancy);
+}
+
+std::string GridLabelDelta::getOccupancyFilename(const std::string& labelFilename, uint32_t checksum)
+{
+	char name[9];
+	std::snprintf(name, sizeof(name), "%08x", checksum);
+
+	return std::filesystem::path(labelFilename).replace_filename(OCCUPANCY_PREFIX + name + "." + OCCUPANCY_EXTENSION).string();
+}
+
+bool GridLabelDelta::read(const std::string& labelFilename, std::vector<uint16_t>& grid, uvec3& numDivs)
+{
+	MemoryMappedFile occupancyFile, labelFile;
+	Occupancy occupancy;
+	LabelHeader header;
+
+	if (!labelFile.open(labelFilename) || labelFile.size() < sizeof(LabelHeader))
+		return false;
+
+	std::memcpy(&header, labelFile.data(), sizeof(LabelHeader));
+	if (!occupancyFile.open(getOccupancyFilename(labelFilename, header._checksum)) || !readOccupancy(occupancyFile.data(), occupancyFile.size(), occupancy))
+		return false;
+
+	// Occupancy has already been checked against the runs it decoded, but the label file must also match before the grid is allocated
+	if (header._numOccupied != occupancy._numOccupied || header._checksum != occupancy._checksum)
+		return false;
+
+	numDivs = occupancy._numDivs;
+	grid.resize(static_cast<size_t>(numDivs.x) * numDivs.y * numDivs.z);
+
+	return readLabels(labelFile.data(), labelFile.size(), occupancy, grid.data());
+}
+
+bool GridLabelDelta::readLabels(const uint8_t* data, size_t size, const Occupancy& occupancy, uint16_t* grid)
+{
+	LabelHeader header;
+	if (size < sizeof(LabelHeader)) return false;
+
+	std::memcpy(&header, data, sizeof(LabelHeader));
+	if (std::memcmp(header._magic, LABEL_MAGIC, sizeof(LABEL_MAGIC)) != 0 || header._version != VERSION || header._checksum != occupancy._checksum ||
+		header._numOccupied != occupancy._numOccupied || header._paletteSize == 0 || header._bits > 16)
+		return false;
+
+	if (sizeof(LabelHeader) + header._paletteSize * sizeof(uint16_t) + static_cast<size_t>(header._streamBytes) > size)
+		return false;
+
+	std::vector<uint16_t> palette(header._paletteSize);
+	std::memcpy(palette.data(), data + sizeof(LabelHeader), palette.size() * sizeof(uint16_t));
+
+	const uint8_t* stream = data + sizeof(LabelHeader) + palette.size() * sizeof(uint16_t);
+	const bool entropyCoded = header._flags & ENTROPY_CODED;
+	const uint32_t numSymbols = 1u << header._bits;
+
+	// Packed labels
+	uint64_t bitPosition = 0;
+	if (!entropyCoded && (static_cast<uint64_t>(header._numOccupied) * header._bits + 7) / 8 > header._streamBytes)
+		return false;
+
+	// Range-coded labels
+	RangeCoder::Decoder decoder(stream, header._streamBytes);
+	std::vector<uint16_t> probabilities;
+	if (entropyCoded) probabilities.assign(static_cast<size_t>(getNumContexts(header._bits, header._paletteSize)) << header._bits, RangeCoder::INITIAL_PROBABILITY);
+	uint32_t context = 0;
+
+	size_t voxel = 0;
+	bool occupied = false;
+
+	for (uint32_t run : occupancy._runs)
+	{
+		if (!occupied)
+		{
+			std::fill_n(grid + voxel, run, static_cast<uint16_t>(VOXEL_EMPTY));
+		}
+		else
+		{
+			for (uint32_t idx = 0; idx < run; ++idx)
+			{
+				uint32_t symbol = 0;
+
+				if (entropyCoded)
+				{
+					uint32_t node = 1;
+					while (node < numSymbols)
+						node = (node << 1) | decoder.decodeBit(probabilities[(context << header._bits) | node]);
+
+					symbol = node - numSymbols;
+					if (getNumContexts(header._bits, header._paletteSize) > 1) context = symbol;
+				}
+				else
+				{
+					for (uint8_t bit = 0; bit < header._bits; ++bit, ++bitPosition)
+						symbol |= static_cast<uint32_t>((stream[bitPosition >> 3] >> (bitPosition & 7)) & 1) << bit;
+				}
+
+				if (symbol >= header._paletteSize) return false;
+				grid[voxel + idx] = palette[symbol];
+			}
+		}
+
+		voxel += run;
+		occupied = !occupied;
+	}
+
+	return true;
+}
+
+bool GridLabelDelta::readOccupancy(const uint8_t* data, size_t size, Occupancy& occupancy)
+{
+	OccupancyHeader header;
+	if (size < sizeof(OccupancyHeader)) return false;
+
+	std::memcpy(&header, data, sizeof(OccupancyHeader));
+	if (std::memcmp(header._magic, OCCUPANCY_MAGIC, sizeof(OCCUPANCY_MAGIC)) != 0 || header._version != VERSION ||
+		sizeof(OccupancyHeader) + static_cast<size_t>(header._streamBytes) > size)
+		return false;
+
+	// Reject grids whose size overflows and runs that the stream cannot hold before allocating them
+	const uint64_t numVoxels = static_cast<uint64_t>(header._numDivs.x) * header._numDivs.y * header._numDivs.z;
+	if (numVoxels == 0 || numVoxels / header._numDivs.x / header._numDivs.y != header._numDivs.z ||
+		numVoxels > std::numeric_limits<size_t>::max() || header._numOccupied > numVoxels ||
+		header._numRuns > static_cast<uint64_t>(header._streamBytes) * RangeCoder::MAX_SYMBOLS_PER_BYTE)
+		return false;
+
+	RangeCoder::Decoder decoder(data + sizeof(OccupancyHeader), header._streamBytes);
+	RangeCoder::VarintModel models[2];
+	uint64_t numVoxelsRuns = 0;
+
+	occupancy._numDivs = header._numDivs;
+	occupancy._numOccupied = 0;
+	occupancy._runs.resize(header._numRuns);
+
+	for (uint32_t runIdx = 0; runIdx < header._numRuns; ++runIdx)
+	{
+		occupancy._runs[runIdx] = decoder.decodeVarint(models[runIdx % 2]);
+		numVoxelsRuns += occupancy._runs[runIdx];
+		if (runIdx % 2) occupancy._numOccupied += occupancy._runs[runIdx];
+	}
+
+	occupancy._checksum = GridLabelDelta::checksum(occupancy);
+
+	return numVoxelsRuns == numVoxels && occupancy._numOccupied == header._numOccupied && occupancy._checksum == header._checksum;
+}
+
+bool GridLabelDelta::writeLabels(std::ostream& stream, const uint16_t* grid, const Occupancy& occupancy, bool entropyCoding)
+{
+	// Gather labels of occupied voxels and check that the rest are still empty
+	std::vector<uint16_t> labels;
+	labels.reserve(occupancy._numOccupied);
+
+	size_t voxel = 0;
+	bool occupied = false;
+
+	for (uint32_t run : occupancy._runs)
+	{
+		if (occupied)
+			labels.insert(labels.end(), grid + voxel, grid + voxel + run);
+		else if (std::any_of(grid + voxel, grid + voxel + run, [](uint16_t value) { return value != VOXEL_EMPTY; }))
+			return false;
+
+		voxel += run;
+		occupied = !occupied;
+	}
+
+	// Palette sorted by label, so that fragment identifiers keep their order
+	std::vector<int32_t> paletteIndex(std::numeric_limits<uint16_t>::max() + 1, -1);
+	std::vector<uint16_t> palette;
+
+	for (uint16_t label : labels) paletteIndex[label] = 0;
+	for (int32_t label = 0; label < static_cast<int32_t>(paletteIndex.size()); ++label)
+		if (paletteIndex[label] >= 0)
+		{
+			paletteIndex[label] = static_cast<int32_t>(palette.size());
+			palette.push_back(static_cast<uint16_t>(label));
+		}
+
+	if (palette.empty()) palette.push_back(VOXEL_EMPTY);
+	if (palette.size() > std::numeric_limits<uint16_t>::max()) return false;
+
+	LabelHeader header;
+	std::memcpy(header._magic, LABEL_MAGIC, sizeof(LABEL_MAGIC));
+	header._version = VERSION;
+	header._flags = 0;
+	header._checksum = occupancy._checksum;
+	header._numOccupied = static_cast<uint32_t>(labels.size());
+	header._paletteSize = static_cast<uint16_t>(palette.size());
+	header._bits = 0;
+	header._reserved = 0;
+	while ((1u << header._bits) < palette.size()) ++header._bits;
+
+	std::vector<uint16_t> indices(labels.size());
+	std::transform(labels.begin(), labels.end(), indices.begin(), [&paletteIndex](uint16_t label) { return static_cast<uint16_t>(paletteIndex[label]); });
+
+	std::vector<uint8_t> packed((static_cast<uint64_t>(indices.size()) * header._bits + 7) / 8, 0);
+	uint64_t bitPosition = 0;
+
+	for (uint16_t index : indices)
+		for (uint8_t bit = 0; bit < header._bits; ++bit, ++bitPosition)
+			packed[bitPosition >> 3] |= static_cast<uint8_t>(((index >> bit) & 1) << (bitPosition & 7));
+
+	std::vector<uint8_t> coded;
+	if (entropyCoding && header._bits > 0)
+		GridLabelDelta::encodeLabels(indices, header._bits, header._paletteSize, coded);
+
+	const bool useCoded = !coded.empty() && coded.size() < packed.size();
+	const std::vector<uint8_t>& labelStream = useCoded ? coded : packed;
+	header._flags = useCoded ? ENTROPY_CODED : 0;
+	header._streamBytes = static_cast<uint32_t>(labelStream.size());
+
+	stream.write(reinterpret_cast<const char*>(&header), sizeof(LabelHeader));
+	stream.write(reinterpret_cast<const char*>(palette.data()), palette.size() * sizeof(uint16_t));
+	stream.write(reinterpret_cast<const char*>(labelStream.data()), labelStream.size());
+
+	return !stream.fail();
+}
+
+bool GridLabelDelta::writeOccupancy(std::ostream& stream, const Occupancy& occupancy)
+{
+	std::vector<uint8_t> runStream;
+	RangeCoder::Encoder encoder(runStream);
+	RangeCoder::VarintModel models[2];
+
+	for (size_t runIdx = 0; runIdx < occupancy._runs.size(); ++runIdx)
+		encoder.encodeVarint(models[runIdx % 2], occupancy._runs[runIdx]);
+	encoder.finish();
+
+	OccupancyHeader header;
+	std::memcpy(header._magic, OCCUPANCY_MAGIC, sizeof(OCCUPANCY_MAGIC));
+	header._version = VERSION;
+	header._reserved = 0;
+	header._numDivs = occupancy._numDivs;
+	header._numRuns = static_cast<uint32_t>(occupancy._runs.size());
+	header._numOccupied = static_cast<uint32_t>(occupancy._numOccupied);
+	header._checksum = occupancy._checksum;
+	header._streamBytes = static_cast<uint32_t>(runStream.size());
+
+	stream.write(reinterpret_cast<const char*>(&header), sizeof(OccupancyHeader));
+	stream.write(reinterpret_cast<const char*>(runStream.data()), runStream.size());
+
+	return !stream.fail();
+}
+
+/// [Protected methods]
+
+uint32_t GridLabelDelta::checksum(const Occupancy& occupancy)
+{
+	uint32_t hash = 2166136261u;
+	const auto mix = [&hash](uint32_t value)
+		{
+			for (int byteIdx = 0; byteIdx < 4; ++byteIdx)
+			{
+				hash ^= (value >> (byteIdx * 8)) & 0xFF;
+				hash *= 16777619u;
+			}
+		};
+
+	mix(occupancy._numDivs.x);
+	mix(occupancy._numDivs.y);
+	mix(occupancy._numDivs.z);
+	for (uint32_t run : occupancy._runs) mix(run);
+
+	return hash;
+}
+
+void GridLabelDelta::encodeLabels(const std::vector<uint16_t>& indices, uint8_t bits, uint16_t paletteSize, std::vector<uint8_t>& stream)
+{
+	const bool useContext = getNumContexts(bits, paletteSize) > 1;
+	std::vector<uint16_t> probabilities(static_cast<size_t>(getNumContexts(bits, paletteSize)) << bits, RangeCoder::INITIAL_PROBABILITY);
+	RangeCoder::Encoder encoder(stream);
+	uint32_t context = 0;
+
+	stream.reserve(indices.size() * bits / 16);
+
+	for (uint16_t symbol : indices)
+	{
+		uint32_t node = 1;
+
+		for (int bit = bits - 1; bit >= 0; --bit)
+		{
+			const unsigned value = (symbol >> bit) & 1;
+			encoder.encodeBit(probabilities[(context << bits) | node], value);
+			node = (node << 1) | value;
+		}
+
+		if (useContext) context = symbol;
+	}
+
+	encoder.finish();
+}
+
@@ -0,0 +1,124 @@
+#pragma once
+
+/**
+*	@brief Grid output split into the occupancy of a model, written once, and the labels of every fracture iteration, which only cover
+*	occupied voxels. Labels are mapped to a palette and bit-packed to ceil(log2(paletteSize)) bits, or range-coded when that is smaller.
+*
+*	Occupancy layout: OccupancyHeader | range-coded lengths of alternating empty and occupied runs, starting with an empty one.
+*	Label layout: LabelHeader | palette (uint16_t[paletteSize]) | label stream (streamBytes).
+*
+*	Occupancy files are named after their checksum and placed next to the label files, so that a label file locates its occupancy
+*	through the checksum in its header.
+*/
+class GridLabelDelta
+{
+public:
+	const static char			LABEL_MAGIC[4];					//!< Signature of label files
+	const static char			OCCUPANCY_MAGIC[4];				//!< Signature of occupancy files
+	const static std::string	OCCUPANCY_EXTENSION;			//!< Extension of occupancy files, without dot
+	const static std::string	OCCUPANCY_PREFIX;				//!< Name of occupancy files before their checksum
+	const static uint16_t		VERSION;						//!< Current version of the format
+
+	enum LabelFlags : uint16_t { ENTROPY_CODED = 1 };
+
+	struct OccupancyHeader
+	{
+		char		_magic[4];
+		uint16_t	_version;
+		uint16_t	_reserved;
+		uvec3		_numDivs;
+		uint32_t	_numRuns;
+		uint32_t	_numOccupied;
+		uint32_t	_checksum;								//!< Identifies the occupancy that label files refer to
+		uint32_t	_streamBytes;
+	};
+
+	struct LabelHeader
+	{
+		char		_magic[4];
+		uint16_t	_version;
+		uint16_t	_flags;
+		uint32_t	_checksum;								//!< Checksum of the occupancy
+		uint32_t	_numOccupied;
+		uint16_t	_paletteSize;
+		uint8_t		_bits;									//!< Bits per packed label
+		uint8_t		_reserved;
+		uint32_t	_streamBytes;
+	};
+
+	/**
+	*	@brief Occupied voxels of a grid as alternating empty and occupied runs in grid order.
+	*/
+	struct Occupancy
+	{
+		uint32_t				_checksum = 0;
+		uvec3					_numDivs = uvec3(0);
+		size_t					_numOccupied = 0;
+		std::vector<uint32_t>	_runs;
+
+		/**
+		*	@return True if no occupancy has been captured.
+		*/
+		bool empty() const { return _runs.empty(); }
+	};
+
+protected:
+	/**
+	*	@return FNV-1a checksum of the dimensions and runs of an occupancy.
+	*/
+	static uint32_t checksum(const Occupancy& occupancy);
+
+	/**
+	*	@brief Codes palette indices with a bit-tree model conditioned on the previous label.
+	*/
+	static void encodeLabels(const std::vector<uint16_t>& indices, uint8_t bits, uint16_t paletteSize, std::vector<uint8_t>& stream);
+
+	/**
+	*	@return Number of contexts of the label model.
+	*/
+	static unsigned getNumContexts(uint8_t bits, uint16_t paletteSize) { return bits <= 8 ? paletteSize : 1; }
+
+public:
+	/**
+	*	@brief Captures the non-empty voxels of a grid.
+	*/
+	static void captureOccupancy(const uint16_t* grid, const uvec3& numDivs, Occupancy& occupancy);
+
+	/**
+	*	@return Path of the occupancy file with the given checksum, in the folder of labelFilename.
+	*/
+	static std::string getOccupancyFilename(const std::string& labelFilename, uint32_t checksum);
+
+	/**
+	*	@brief Reconstructs an iteration from its label file and the occupancy file its header refers to.
+	*	@return Success of operation.
+	*/
+	static bool read(const std::string& labelFilename, std::vector<uint16_t>& grid, uvec3& numDivs);
+
+	/**
+	*	@brief Decodes a label file into a whole grid, whose voxels out of the occupancy are set to empty.
+	*	@param grid Buffer with room for every voxel of the occupancy.
+	*	@return False if the labels do not belong to the occupancy or the stream is corrupted.
+	*/
+	static bool readLabels(const uint8_t* data, size_t size, const Occupancy& occupancy, uint16_t* grid);
+
+	/**
+	*	@brief Decodes an occupancy file.
+	*	@return Success of operation.
+	*/
+	static bool readOccupancy(const uint8_t* data, size_t size, Occupancy& occupancy);
+
+	/**
+	*	@brief Writes the labels of the occupied voxels of a grid.
+	*	@param entropyCoding Allows range-coding labels if the result is smaller than the packed labels.
+	*	@return False if any voxel out of the occupancy is not empty, as it cannot be represented.
+	*/
+	static bool writeLabels(std::ostream& stream, const uint16_t* grid, const Occupancy& occupancy, bool entropyCoding = true);
+
+	/**
+	*	@brief Writes an occupancy.
+	*	@return Success of operation.
+	*/
+	static bool writeOccupancy(std::ostream& stream, const Occupancy& occupancy);
+};
+
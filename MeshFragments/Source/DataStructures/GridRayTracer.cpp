@@ -0,0 +1,328 @@
+#include "stdafx.h"
+#include "GridRayTracer.h"
+
+#include "DataStructures/RegularGrid.h"
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define GRID_RAY_SSE
+#endif
+
+// [Static members initialization]
+
+const int GridRayTracer::BRICK_SIZE = 8;
+const unsigned GridRayTracer::CHUNK_SIZE = 1024;
+
+static_assert(GridRayTracer::PACKET_SIZE % 4 == 0, "Packets are stepped in groups of four lanes");
+
+/// [Public methods]
+
+GridRayTracer::GridRayTracer(const uint16_t* grid, const uvec3& numDivs, const AABB& aabb, bool skipEmptySpace) :
+	_cellSize(.0f), _grid(grid), _minPoint(aabb.min()), _numBricks(0), _numDivs(numDivs)
+{
+	if (glm::all(glm::greaterThan(numDivs, uvec3(0))))
+		_cellSize = aabb.size() / vec3(numDivs);
+
+	if (skipEmptySpace)
+		this->buildBricks();
+}
+
+GridRayTracer::~GridRayTracer()
+{
+}
+
+void GridRayTracer::trace(const Model3D::RayGPUData* rays, unsigned numRays, RayHit* hits) const
+{
+	// Abstract grids have no extent to be traversed
+	if (!_grid || glm::any(glm::lessThanEqual(_cellSize, vec3(.0f))))
+	{
+		std::fill(hits, hits + numRays, getMiss());
+		return;
+	}
+
+	const int numChunks = static_cast<int>((numRays + CHUNK_SIZE - 1) / CHUNK_SIZE);
+
+	#pragma omp parallel for schedule(dynamic)
+	for (int chunkIdx = 0; chunkIdx < numChunks; ++chunkIdx)
+	{
+		const unsigned firstRay = chunkIdx * CHUNK_SIZE;
+		this->traceChunk(rays + firstRay, std::min(CHUNK_SIZE, numRays - firstRay), hits + firstRay);
+	}
+}
+
+void GridRayTracer::trace(const std::vector<Model3D::RayGPUData>& rays, std::vector<RayHit>& hits) const
+{
+	hits.resize(rays.size());
+	this->trace(rays.data(), static_cast<unsigned>(rays.size()), hits.data());
+}
+
+/// [Protected methods]
+
+void GridRayTracer::buildBricks()
+{
+	_numBricks = (_numDivs + uvec3(BRICK_SIZE - 1)) / uvec3(BRICK_SIZE);
+	_bricks.resize(static_cast<size_t>(_numBricks.x) * _numBricks.y * _numBricks.z);
+
+	#pragma omp parallel for
+	for (int brickIdx = 0; brickIdx < static_cast<int>(_bricks.size()); ++brickIdx)
+	{
+		const uvec3 brick(brickIdx / (_numBricks.y * _numBricks.z), (brickIdx / _numBricks.z) % _numBricks.y, brickIdx % _numBricks.z);
+		const uvec3 minVoxel = brick * uvec3(BRICK_SIZE), maxVoxel = glm::min(minVoxel + uvec3(BRICK_SIZE), _numDivs);
+		uint8_t occupied = 0;
+
+		for (unsigned x = minVoxel.x; x < maxVoxel.x && !occupied; ++x)
+		{
+			for (unsigned y = minVoxel.y; y < maxVoxel.y && !occupied; ++y)
+			{
+				const uint16_t* row = _grid + RegularGrid::getPositionIndex(x, y, 0, _numDivs);
+				for (unsigned z = minVoxel.z; z < maxVoxel.z; ++z)
+					occupied |= row[z] != VOXEL_EMPTY;
+			}
+		}
+
+		_bricks[brickIdx] = occupied;
+	}
+}
+
+bool GridRayTracer::initializeLane(Packet& packet, unsigned lane, const Model3D::RayGPUData& ray, unsigned rayIdx) const
+{
+	const vec3 maxPoint = _minPoint + _cellSize * vec3(_numDivs);
+	const ivec3 stride(_numDivs.y * _numDivs.z, _numDivs.z, 1);
+	float tNear = .0f, tFar = FLT_MAX;
+
+	packet._active[lane] = packet._advance[lane] = 0;
+	if (ray._direction == vec3(.0f) || glm::any(glm::isnan(ray._direction))) return false;
+
+	// Clipping against the slabs of the grid, where rays parallel to an axis must start within its slab
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		if (ray._direction[axis] == .0f)
+		{
+			if (ray._origin[axis] < _minPoint[axis] || ray._origin[axis] > maxPoint[axis]) return false;
+			continue;
+		}
+
+		const float inverseDirection = 1.0f / ray._direction[axis];
+		float t0 = (_minPoint[axis] - ray._origin[axis]) * inverseDirection, t1 = (maxPoint[axis] - ray._origin[axis]) * inverseDirection;
+		if (t0 > t1) std::swap(t0, t1);
+
+		tNear = glm::max(tNear, t0);
+		tFar = glm::min(tFar, t1);
+	}
+
+	if (tNear > tFar) return false;
+
+	const vec3 start = ray._origin + ray._direction * tNear;
+	int index = 0;
+
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		const float direction = ray._direction[axis];
+		const int coordinate = glm::clamp(static_cast<int>(std::floor((start[axis] - _minPoint[axis]) / _cellSize[axis])), 0, static_cast<int>(_numDivs[axis]) - 1);
+		const int step = (direction > .0f) - (direction < .0f);
+
+		packet._coordinates[axis][lane] = coordinate;
+		packet._step[axis][lane] = step;
+		packet._indexStep[axis][lane] = step * stride[axis];
+		packet._tDelta[axis][lane] = step ? _cellSize[axis] / std::abs(direction) : FLT_MAX;
+		packet._tNext[axis][lane] = step ? (_minPoint[axis] + (coordinate + (step > 0)) * _cellSize[axis] - ray._origin[axis]) / direction : FLT_MAX;
+
+		index += coordinate * stride[axis];
+	}
+
+	packet._tEntry[lane] = tNear;
+	packet._index[lane] = index;
+	packet._ray[lane] = rayIdx;
+	packet._active[lane] = -1;
+
+	return true;
+}
+
+bool GridRayTracer::isBrickEmpty(const Packet& packet, unsigned lane) const
+{
+	const unsigned x = packet._coordinates[0][lane] / BRICK_SIZE, y = packet._coordinates[1][lane] / BRICK_SIZE, z = packet._coordinates[2][lane] / BRICK_SIZE;
+
+	return !_bricks[(static_cast<size_t>(x) * _numBricks.y + y) * _numBricks.z + z];
+}
+
+void GridRayTracer::skipBrick(Packet& packet, unsigned lane) const
+{
+	int remaining[3] = { 0, 0, 0 }, exitAxis = 0;
+	float tExit = FLT_MAX;
+
+	// Boundaries left within the brick per axis, and the axis whose last boundary is crossed first
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		const int step = packet._step[axis][lane], coordinate = packet._coordinates[axis][lane];
+		if (!step) continue;
+
+		const int first = coordinate / BRICK_SIZE * BRICK_SIZE, last = std::min(first + BRICK_SIZE, static_cast<int>(_numDivs[axis])) - 1;
+		remaining[axis] = step > 0 ? last - coordinate : coordinate - first;
+
+		const float tAxis = packet._tNext[axis][lane] + remaining[axis] * packet._tDelta[axis][lane];
+		if (tAxis < tExit)
+		{
+			tExit = tAxis;
+			exitAxis = axis;
+		}
+	}
+
+	// Every axis crosses the boundaries met before the exit, but only the exit axis leaves the brick
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		if (!packet._step[axis][lane]) continue;
+
+		int count = remaining[axis] + 1;
+		if (axis != exitAxis)
+		{
+			const float tNext = packet._tNext[axis][lane];
+			count = tNext < tExit ? std::min(remaining[axis], static_cast<int>((tExit - tNext) / packet._tDelta[axis][lane]) + 1) : 0;
+		}
+
+		packet._coordinates[axis][lane] += count * packet._step[axis][lane];
+		packet._tNext[axis][lane] += count * packet._tDelta[axis][lane];
+		packet._index[lane] += count * packet._indexStep[axis][lane];
+
+		if (packet._coordinates[axis][lane] < 0 || packet._coordinates[axis][lane] >= static_cast<int>(_numDivs[axis]))
+			packet._active[lane] = 0;
+	}
+
+	packet._tEntry[lane] = tExit;
+}
+
+void GridRayTracer::step(Packet& packet) const
+{
+#ifdef GRID_RAY_SSE
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i lastX = _mm_set1_epi32(_numDivs.x - 1), lastY = _mm_set1_epi32(_numDivs.y - 1), lastZ = _mm_set1_epi32(_numDivs.z - 1);
+
+	for (unsigned lane = 0; lane < PACKET_SIZE; lane += 4)
+	{
+		const __m128i advance = _mm_load_si128(reinterpret_cast<const __m128i*>(packet._advance + lane));
+		const __m128 advanceMask = _mm_castsi128_ps(advance);
+		const __m128 tX = _mm_load_ps(packet._tNext[0] + lane), tY = _mm_load_ps(packet._tNext[1] + lane), tZ = _mm_load_ps(packet._tNext[2] + lane);
+
+		// Same axis choice as the scalar traversal, ties being resolved towards z
+		const __m128 maskX = _mm_and_ps(_mm_and_ps(_mm_cmplt_ps(tX, tY), _mm_cmplt_ps(tX, tZ)), advanceMask);
+		const __m128 maskY = _mm_andnot_ps(maskX, _mm_and_ps(_mm_cmplt_ps(tY, tZ), advanceMask));
+		const __m128 maskZ = _mm_andnot_ps(_mm_or_ps(maskX, maskY), advanceMask);
+
+		const __m128 tEntry = _mm_min_ps(tX, _mm_min_ps(tY, tZ)), tPrevious = _mm_load_ps(packet._tEntry + lane);
+		_mm_store_ps(packet._tEntry + lane, _mm_or_ps(_mm_and_ps(advanceMask, tEntry), _mm_andnot_ps(advanceMask, tPrevious)));
+		_mm_store_ps(packet._tNext[0] + lane, _mm_add_ps(tX, _mm_and_ps(maskX, _mm_load_ps(packet._tDelta[0] + lane))));
+		_mm_store_ps(packet._tNext[1] + lane, _mm_add_ps(tY, _mm_and_ps(maskY, _mm_load_ps(packet._tDelta[1] + lane))));
+		_mm_store_ps(packet._tNext[2] + lane, _mm_add_ps(tZ, _mm_and_ps(maskZ, _mm_load_ps(packet._tDelta[2] + lane))));
+
+		const __m128i masks[3] = { _mm_castps_si128(maskX), _mm_castps_si128(maskY), _mm_castps_si128(maskZ) };
+		const __m128i last[3] = { lastX, lastY, lastZ };
+		__m128i index = _mm_load_si128(reinterpret_cast<const __m128i*>(packet._index + lane)), outside = zero;
+
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			__m128i* coordinatesPtr = reinterpret_cast<__m128i*>(packet._coordinates[axis] + lane);
+			const __m128i step = _mm_load_si128(reinterpret_cast<const __m128i*>(packet._step[axis] + lane));
+			const __m128i indexStep = _mm_load_si128(reinterpret_cast<const __m128i*>(packet._indexStep[axis] + lane));
+			const __m128i coordinates = _mm_add_epi32(_mm_load_si128(coordinatesPtr), _mm_and_si128(masks[axis], step));
+
+			_mm_store_si128(coordinatesPtr, coordinates);
+			index = _mm_add_epi32(index, _mm_and_si128(masks[axis], indexStep));
+			outside = _mm_or_si128(outside, _mm_or_si128(_mm_cmplt_epi32(coordinates, zero), _mm_cmpgt_epi32(coordinates, last[axis])));
+		}
+
+		__m128i* activePtr = reinterpret_cast<__m128i*>(packet._active + lane);
+		_mm_store_si128(reinterpret_cast<__m128i*>(packet._index + lane), index);
+		_mm_store_si128(activePtr, _mm_andnot_si128(outside, _mm_load_si128(activePtr)));
+	}
+#else
+	for (unsigned lane = 0; lane < PACKET_SIZE; ++lane)
+	{
+		if (!packet._advance[lane]) continue;
+
+		const float tX = packet._tNext[0][lane], tY = packet._tNext[1][lane], tZ = packet._tNext[2][lane];
+		const int axis = tX < tY && tX < tZ ? 0 : (tY < tZ ? 1 : 2);
+
+		packet._tEntry[lane] = glm::min(tX, glm::min(tY, tZ));
+		packet._tNext[axis][lane] += packet._tDelta[axis][lane];
+		packet._coordinates[axis][lane] += packet._step[axis][lane];
+		packet._index[lane] += packet._indexStep[axis][lane];
+
+		if (packet._coordinates[axis][lane] < 0 || packet._coordinates[axis][lane] >= static_cast<int>(_numDivs[axis]))
+			packet._active[lane] = 0;
+	}
+#endif
+}
+
+void GridRayTracer::traceChunk(const Model3D::RayGPUData* rays, unsigned numRays, RayHit* hits) const
+{
+	Packet packet;
+	unsigned nextRay = 0;
+	bool anyActive = true;
+
+	// Takes the next ray that reaches the grid, reporting those that do not as misses
+	auto refill = [&](unsigned lane)
+	{
+		packet._ray[lane] = UINT_MAX;
+		packet._active[lane] = packet._advance[lane] = 0;
+
+		while (nextRay < numRays && !this->initializeLane(packet, lane, rays[nextRay], nextRay))
+			hits[nextRay++] = getMiss();
+
+		if (nextRay < numRays) ++nextRay;
+	};
+
+	for (unsigned lane = 0; lane < PACKET_SIZE; ++lane)
+		refill(lane);
+
+	while (anyActive)
+	{
+		anyActive = false;
+
+		// Each lane goes on until its ray has to step into the next voxel, or there are no rays left
+		for (unsigned lane = 0; lane < PACKET_SIZE; ++lane)
+		{
+			packet._advance[lane] = 0;
+
+			while (packet._ray[lane] != UINT_MAX)
+			{
+				if (!packet._active[lane])
+				{
+					hits[packet._ray[lane]] = getMiss();
+					refill(lane);
+				}
+				else if (!_bricks.empty() && this->isBrickEmpty(packet, lane))
+				{
+					this->skipBrick(packet, lane);
+				}
+				else
+				{
+					const uint16_t value = _grid[packet._index[lane]];
+					if (value == VOXEL_EMPTY)
+					{
+						packet._advance[lane] = -1;
+						anyActive = true;
+						break;
+					}
+
+					RayHit& hit = hits[packet._ray[lane]];
+					hit._voxel = uvec3(packet._coordinates[0][lane], packet._coordinates[1][lane], packet._coordinates[2][lane]);
+					hit._distance = packet._tEntry[lane];
+					hit._label = value;
+
+					refill(lane);
+				}
+			}
+		}
+
+		if (anyActive) this->step(packet);
+	}
+}
+
+GridRayTracer::RayHit GridRayTracer::getMiss()
+{
+	RayHit hit;
+	hit._voxel = uvec3(std::numeric_limits<glm::uint>::max());
+	hit._distance = FLT_MAX;
+	hit._label = VOXEL_EMPTY;
+
+	return hit;
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "Graphics/Core/Model3D.h"
+
+/**
+*	@brief Traces batches of rays through a voxel grid until the first non-empty voxel. Rays are traversed in packets whose lanes step
+*	through the grid at once with SSE, following the Amanatides-Woo traversal, and a lane is refilled with the next ray of the batch as
+*	soon as its ray finishes. Empty space can be skipped through a coarse occupancy level made of bricks of voxels, so that rays cross
+*	empty bricks in a single step.
+*/
+class GridRayTracer
+{
+public:
+	const static int		BRICK_SIZE;						//!< Voxels per axis of a brick of the occupancy level
+	const static unsigned	CHUNK_SIZE;						//!< Rays traced by a thread at once
+	const static unsigned	PACKET_SIZE = 8;				//!< Rays traversed at once
+
+public:
+	/**
+	*	@brief First non-empty voxel hit by a ray.
+	*/
+	struct RayHit
+	{
+		uvec3		_voxel;									//!< Zero-based indices, UINT_MAX if no voxel is hit
+		float		_distance;								//!< Ray parameter where the voxel is entered, in units of the ray direction
+		uint16_t	_label;									//!< Value of the voxel, VOXEL_EMPTY if no voxel is hit
+	};
+
+protected:
+	/**
+	*	@brief State of the rays of a packet, stored as structures of arrays.
+	*/
+	struct alignas(16) Packet
+	{
+		float		_tNext[3][PACKET_SIZE];					//!< Ray parameter of the next voxel boundary per axis
+		float		_tDelta[3][PACKET_SIZE];				//!< Ray parameter between consecutive boundaries per axis
+		float		_tEntry[PACKET_SIZE];					//!< Ray parameter where the current voxel is entered
+		int32_t		_coordinates[3][PACKET_SIZE];
+		int32_t		_step[3][PACKET_SIZE];					//!< Direction of each axis, zero if the ray is parallel to it
+		int32_t		_indexStep[3][PACKET_SIZE];				//!< Change of the voxel index when stepping along each axis
+		int32_t		_index[PACKET_SIZE];					//!< Index of the current voxel
+		int32_t		_active[PACKET_SIZE];					//!< All bits set if the lane holds a ray
+		int32_t		_advance[PACKET_SIZE];					//!< All bits set if the lane must step into the next voxel
+		unsigned	_ray[PACKET_SIZE];						//!< Ray of each lane within the batch
+	};
+
+protected:
+	std::vector<uint8_t>	_bricks;						//!< Occupancy of each brick, empty if empty space is not skipped
+	vec3					_cellSize;
+	const uint16_t*			_grid;
+	vec3					_minPoint;
+	uvec3					_numBricks;
+	uvec3					_numDivs;
+
+protected:
+	/**
+	*	@brief Builds the occupancy of every brick in parallel.
+	*/
+	void buildBricks();
+
+	/**
+	*	@brief Clips a ray against the grid and sets up its traversal in a lane.
+	*	@return False if the ray misses the grid, in which case the lane is left inactive.
+	*/
+	bool initializeLane(Packet& packet, unsigned lane, const Model3D::RayGPUData& ray, unsigned rayIdx) const;
+
+	/**
+	*	@return True if the brick of a lane has no occupied voxel.
+	*/
+	bool isBrickEmpty(const Packet& packet, unsigned lane) const;
+
+	/**
+	*	@brief Moves a lane to the first voxel past its current brick.
+	*/
+	void skipBrick(Packet& packet, unsigned lane) const;
+
+	/**
+	*	@brief Steps every lane flagged to advance into its next voxel, and deactivates those that leave the grid.
+	*/
+	void step(Packet& packet) const;
+
+	/**
+	*	@brief Traces a chunk of rays with a single packet.
+	*/
+	void traceChunk(const Model3D::RayGPUData* rays, unsigned numRays, RayHit* hits) const;
+
+	/**
+	*	@return Hit of a ray that does not reach any non-empty voxel.
+	*/
+	static RayHit getMiss();
+
+public:
+	/**
+	*	@brief Constructor. The grid is referenced rather than copied, so it must outlive the tracer, and it is not expected to change
+	*	while empty space is skipped, as the occupancy of the bricks is computed here.
+	*	@param grid Voxel values indexed as x * ny * nz + y * nz + z.
+	*	@param skipEmptySpace Builds the occupancy level to skip empty bricks.
+	*/
+	GridRayTracer(const uint16_t* grid, const uvec3& numDivs, const AABB& aabb, bool skipEmptySpace = true);
+
+	/**
+	*	@brief Destructor.
+	*/
+	virtual ~GridRayTracer();
+
+	/**
+	*	@brief Finds the first non-empty voxel of every ray, starting from its origin, or its entry point in the grid if the origin is
+	*	outside. Rays are split into chunks that are traced in parallel.
+	*/
+	void trace(const Model3D::RayGPUData* rays, unsigned numRays, RayHit* hits) const;
+
+	/**
+	*	@brief Finds the first non-empty voxel of every ray.
+	*/
+	void trace(const std::vector<Model3D::RayGPUData>& rays, std::vector<RayHit>& hits) const;
+};
+
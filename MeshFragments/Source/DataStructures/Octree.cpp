@@ -3,380 +3,355 @@
 
 #include "Geometry/3D/Intersections3D.h"
 
+// [Static members initialization]
+
+const uint8_t Octree::MAX_LEVEL = 20;
+const int Octree::NUM_CHILDREN = 8;
+
 /// [Public methods]
 
 Octree::Octree(const uint8_t maxLevel, const uint8_t maxTrianglesNode, Model3D* mesh, const AABB& aabb) :
-	_maxLevel(maxLevel), _maxTrianglesPerNode(maxTrianglesNode), _root(nullptr)
+	_aabb(aabb), _maxLevel(std::min(maxLevel, MAX_LEVEL)), _maxTrianglesPerNode(maxTrianglesNode)
 {
-	_root = new OctreeNode(0, aabb, this, nullptr);
+	std::vector<Model3D::ModelComponent*> modelComponents = mesh->getModelComponents();
+	std::vector<uint32_t> firstFace(modelComponents.size() + 1, 0);
+
+	for (size_t componentIdx = 0; componentIdx < modelComponents.size(); ++componentIdx)
+		firstFace[componentIdx + 1] = firstFace[componentIdx] + static_cast<uint32_t>(modelComponents[componentIdx]->_topology.size());
 
-	// Fill octree with mesh triangles
-	for (Model3D::ModelComponent* modelComponent: mesh->_modelComp)
+	// Faces are sorted by the Morton code of their centroid, kept in the high half of the key
+	std::vector<uint64_t> keys(firstFace.back());
+
+	for (size_t componentIdx = 0; componentIdx < modelComponents.size(); ++componentIdx)
 	{
-		for (Model3D::FaceGPUData& face: modelComponent->_topology)
+		const std::vector<Model3D::VertexGPUData>& vertices = modelComponents[componentIdx]->_geometry;
+		const std::vector<Model3D::FaceGPUData>& faces = modelComponents[componentIdx]->_topology;
+
+		#pragma omp parallel for
+		for (int faceIdx = 0; faceIdx < static_cast<int>(faces.size()); ++faceIdx)
 		{
-			Triangle3D* triangle = new Triangle3D(modelComponent->_geometry[face._vertices.x]._position,
-												  modelComponent->_geometry[face._vertices.y]._position,
-												  modelComponent->_geometry[face._vertices.z]._position);
+			const uvec3& face = faces[faceIdx]._vertices;
+			const vec3 centroid = (vertices[face.x]._position + vertices[face.y]._position + vertices[face.z]._position) / 3.0f;
 
-			this->push_back(triangle);
+			keys[firstFace[componentIdx] + faceIdx] = static_cast<uint64_t>(this->computeMortonCode(centroid)) << 32 | (firstFace[componentIdx] + faceIdx);
 		}
 	}
-}
-
-Octree::~Octree()
-{
-	delete _root;
-}
 
-void Octree::getAABBs(std::vector<AABB>& aabb)
-{
-	this->grabNodeData(_root, aabb);
-}
-
-void Octree::intersection(const Ray3D& ray, FaceListNode* triangle)
-{
-	unsigned char a		= 0;
-	const vec3 max		= _root->_aabb.max();
-	const vec3 min		= _root->_aabb.min();
-	const vec3 center	= _root->_aabb.center();
-
-	vec3 rayOrig = ray.getOrigin(), rayDir = ray.getDirection();
-	for (int i = 0; i < 3; ++i)
-	{
-		if (BasicOperations::equal(rayDir[i], 0.0f)) rayDir[i] = FLT_EPSILON;
-	}
+	std::sort(keys.begin(), keys.end());
 
-	if (rayDir.x < 0.0f)
-	{
-		rayOrig[0]	= center.x - (rayOrig[0] - center.x);
-		rayDir[0]	= -rayDir[0];
-		a |= 4;
-	}
+	_triangles.resize(keys.size());
+	_faces.resize(keys.size());
 
-	if (rayDir.y < 0.0f)
+	#pragma omp parallel for
+	for (int triangleIdx = 0; triangleIdx < static_cast<int>(keys.size()); ++triangleIdx)
 	{
-		rayOrig[1]	= center.y - (rayOrig[1] - center.y);
-		rayDir[1]	= -rayDir[1];
-		a |= 2;
-	}
+		const uint32_t faceIdx = static_cast<uint32_t>(keys[triangleIdx]);
+		const size_t componentIdx = std::upper_bound(firstFace.begin(), firstFace.end(), faceIdx) - firstFace.begin() - 1;
+		const std::vector<Model3D::VertexGPUData>& vertices = modelComponents[componentIdx]->_geometry;
+		const uvec3& face = modelComponents[componentIdx]->_topology[faceIdx - firstFace[componentIdx]]._vertices;
 
-	if (rayDir.z < 0.0f)
-	{
-		rayOrig[2]	= center.z - (rayOrig[2] - center.z);
-		rayDir[2]	= -rayDir[2];
-		a |= 1;
+		_triangles[triangleIdx] = Triangle3D(vertices[face.x]._position, vertices[face.y]._position, vertices[face.z]._position);
+		_faces[triangleIdx] = faceIdx;
 	}
 
-	const vec3 div	= 1.0f / rayDir;
-	const float tx0 = (min.x - rayOrig.x) * div.x;
-	const float tx1 = (max.x - rayOrig.x) * div.x;
-	const float ty0 = (min.y - rayOrig.y) * div.y;
-	const float ty1 = (max.y - rayOrig.y) * div.y;
-	const float tz0 = (min.z - rayOrig.z) * div.z;
-	const float tz1 = (max.z - rayOrig.z) * div.z;
-
-	if (std::max(tx0, std::max(ty0, tz0)) <= std::min(tx1, std::min(ty1, tz1)))
-	{
-		retrieveAABB(triangle, tx0, ty0, tz0, tx1, ty1, tz1, a, _root);
-	}
+	this->build();
 }
 
-void Octree::push_back(Triangle3D* triangle)
+Octree::~Octree()
 {
-	std::list<OctreeNode*> nodes;
-	locateNodeForInsertion(_root, nullptr, triangle, &nodes);
-
-	for (OctreeNode* node: nodes)
-	{
-		insert(node, node->_parent, triangle);
-	}
 }
 
-/// [Protected methods]
-
-int Octree::getFirstNode(const float tx0, const float ty0, const float tz0, const float txm, const float tym, const float tzm)
+void Octree::getAABBs(std::vector<AABB>& aabb) const
 {
-	unsigned char node = 0;
+	// Breadth-first order places parents before their children
+	std::vector<uvec3> coordinates(_nodes.size(), uvec3(0));
+	std::vector<uint8_t> levels(_nodes.size(), 0);
 
-	if (tx0 > ty0)
+	for (size_t nodeIdx = 0; nodeIdx < _nodes.size(); ++nodeIdx)
 	{
-		if (tx0 > tz0)				// PLANE YZ
-		{
-			if (tym < tx0)	node |= 2;
-			if (tzm < tx0)	node |= 1;
-			if (txm < ty0)	node |= 4;
-			if (tzm < ty0)	node |= 1;
+		const Node& node = _nodes[nodeIdx];
 
-			return (int)node;
-		}
-	}
-	else
-	{								// PLANE XZ
-		if (ty0 > tz0)
+		if (!node._children)
 		{
-			if (txm < ty0)	node |= 4;
-			if (tzm < ty0)	node |= 1;
+			if (node._begin != node._end) aabb.push_back(this->getNodeAABB(levels[nodeIdx], coordinates[nodeIdx]));
+			continue;
+		}
 
-			return (int)node;
+		for (int childIdx = 0; childIdx < NUM_CHILDREN; ++childIdx)
+		{
+			coordinates[node._children + childIdx] = coordinates[nodeIdx] * 2u + uvec3(childIdx >> 2, (childIdx >> 1) & 1, childIdx & 1);
+			levels[node._children + childIdx] = levels[nodeIdx] + 1;
 		}
 	}
+}
 
-	// PLANE XY
-	if (txm < tz0)			node |= 4;				// Position 2
-	if (tym < tz0)			node |= 2;				// Position 1
+unsigned Octree::getTriangles(unsigned leaf, const unsigned*& triangles) const
+{
+	triangles = _indices.data() + _nodes[leaf]._begin;
 
-	return (int)node;
+	return _nodes[leaf]._end - _nodes[leaf]._begin;
 }
 
-void Octree::grabNodeData(OctreeNode* node, std::vector<AABB>& aabb)
+unsigned Octree::intersection(const Ray3D& ray, unsigned* leaves, unsigned capacity) const
 {
-	if (node->isLeaf())
-	{
-		if (!node->_content.empty()) aabb.push_back(node->_aabb);
+	const vec3 origin = ray.getOrigin(), direction = ray.getDirection(), minPoint = _aabb.min(), maxPoint = _aabb.max();
+	const uint32_t resolution = 1u << _maxLevel;
+	const vec3 cellSize = _aabb.size() / static_cast<float>(resolution);
+	float tEnter = .0f, tLeave = INFINITY;
 
-		return;
-	}
+	if (capacity == 0 || _nodes.empty())
+		return 0;
 
-	for (int i = 0; i < OctreeNode::NUM_CHILDREN; ++i)
+	for (int axis = 0; axis < 3; ++axis)
 	{
-		this->grabNodeData(node->_child[i], aabb);
+		if (direction[axis] == .0f)
+		{
+			if (origin[axis] < minPoint[axis] || origin[axis] > maxPoint[axis])
+				return 0;
+			continue;
+		}
+
+		const float t0 = (minPoint[axis] - origin[axis]) / direction[axis], t1 = (maxPoint[axis] - origin[axis]) / direction[axis];
+		tEnter = std::max(tEnter, std::min(t0, t1));
+		tLeave = std::min(tLeave, std::max(t0, t1));
 	}
-}
 
-void Octree::insert(OctreeNode* node, OctreeNode* parent, Triangle3D* triangle)
-{
-	node->_content.push_back(triangle);
+	if (tEnter > tLeave)
+		return 0;
+
+	// Cells of the finest level are addressed with integers, so that every step is exact
+	const auto getCell = [&](float t, int axis) -> uint32_t
+		{
+			if (cellSize[axis] <= .0f)
+				return 0;
+
+			const float cell = (origin[axis] + direction[axis] * t - minPoint[axis]) / cellSize[axis];
+			return static_cast<uint32_t>(glm::clamp(cell, .0f, static_cast<float>(resolution - 1)));
+		};
+
+	uvec3 cell(getCell(tEnter, 0), getCell(tEnter, 1), getCell(tEnter, 2));
+	uint32_t nodeIdx = 0;
+	uint8_t level = 0;
+	unsigned numLeaves = 0;
 
-	if (node->_level != _maxLevel && node->_content.size() > _maxTrianglesPerNode)
+	while (true)
 	{
-		node->createChildren();
+		while (_nodes[nodeIdx]._children)
+		{
+			++level;
+			const uvec3 bits = (cell >> uvec3(_maxLevel - level)) & 1u;
+			nodeIdx = _nodes[nodeIdx]._children + (bits.x << 2 | bits.y << 1 | bits.z);
+		}
 
-		auto triangleIt = node->_content.begin();
+		if (_nodes[nodeIdx]._begin != _nodes[nodeIdx]._end)
+		{
+			leaves[numLeaves++] = nodeIdx;
+			if (numLeaves == capacity)
+				break;
+		}
+
+		// Exit face of the leaf, as a range of finest cells
+		const uint32_t shift = _maxLevel - level;
+		const uvec3 leafMin = (cell >> uvec3(shift)) << uvec3(shift), leafMax = leafMin + uvec3(1u << shift);
+		float tExit = INFINITY;
+		int exitAxis = -1;
 
-		while (triangleIt != node->_content.end())
+		for (int axis = 0; axis < 3; ++axis)
 		{
-			std::vector<uint8_t> childrenIndices = node->getChildrenIndices(*triangleIt);
+			if (direction[axis] == .0f)
+				continue;
 
-			for (int child = 0; child < childrenIndices.size(); ++child)
+			const float boundary = minPoint[axis] + cellSize[axis] * static_cast<float>(direction[axis] > .0f ? leafMax[axis] : leafMin[axis]);
+			const float t = (boundary - origin[axis]) / direction[axis];
+
+			if (t < tExit)
 			{
-				insert(node->_child[childrenIndices[child]], node, *triangleIt);
+				tExit = t;
+				exitAxis = axis;
 			}
-
-			++triangleIt;
 		}
 
-		node->_content.clear();
-	}
-}
+		if (exitAxis < 0 || (direction[exitAxis] > .0f ? leafMax[exitAxis] >= resolution : leafMin[exitAxis] == 0))
+			break;
 
-void Octree::locateNodeForInsertion(OctreeNode* node, OctreeNode* parent, Triangle3D* triangle, std::list<OctreeNode*>* foundNodes)
-{
-	if (node->isLeaf())
-	{
-		foundNodes->push_back(node);
-		return;
-	}
+		// Neighbouring cell across the exit face. Cells never move backwards along the ray, so the traversal always ends
+		uvec3 next;
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			if (axis == exitAxis)
+				next[axis] = direction[axis] > .0f ? leafMax[axis] : leafMin[axis] - 1;
+			else if (direction[axis] == .0f)
+				next[axis] = cell[axis];
+			else
+			{
+				next[axis] = glm::clamp(getCell(tExit, axis), leafMin[axis], leafMax[axis] - 1);
+				next[axis] = direction[axis] > .0f ? std::max(next[axis], cell[axis]) : std::min(next[axis], cell[axis]);
+			}
+		}
 
-	const std::vector<uint8_t> childIndices = node->getChildrenIndices(triangle);
-	std::vector<OctreeNode*> nodes;
+		// Climb until a node contains the new cell
+		while (level > 0 && (next >> uvec3(_maxLevel - level)) != (cell >> uvec3(_maxLevel - level)))
+		{
+			nodeIdx = _nodes[nodeIdx]._parent;
+			--level;
+		}
 
-	for (int child = 0; child < childIndices.size(); ++child)
-	{
-		locateNodeForInsertion(node->_child[childIndices[child]], node, triangle, foundNodes);
+		cell = next;
 	}
+
+	return numLeaves;
 }
 
-void Octree::locateNode(OctreeNode * node, Triangle3D* triangle, std::list<OctreeNode*>* foundNodes)
+/// [Protected methods]
+
+void Octree::build()
 {
-	if (!node || node->isLeaf())
-	{
-		foundNodes->push_back(node);
-		return;
-	}
+	const uint32_t numTriangles = static_cast<uint32_t>(_triangles.size());
 
-	const std::vector<uint8_t> childrenIndices = node->getChildrenIndices(triangle);
-	std::vector<OctreeNode*> nodes;
+	// Entries of a level are the triangle indices of its nodes, with a node for each range
+	std::vector<uint32_t> entries(numTriangles), nextEntries;
+	std::vector<uint32_t> level{ 0 }, nextLevel;
+	std::vector<uvec3> coordinates{ uvec3(0) }, nextCoordinates;
+	std::vector<uint8_t> masks;
+	std::vector<uint32_t> childCounts, offsets;
 
-	for (int child = 0; child < childrenIndices.size(); ++child)
-	{
-		locateNode(node->_child[childrenIndices[child]], triangle, foundNodes);
-	}
-}
+	std::iota(entries.begin(), entries.end(), 0);
+	_nodes.assign(1, Node{ 0, 0, 0, numTriangles });
+	_indices.clear();
 
-Octree::OctreeNode* Octree::locateNode(OctreeNode* node, vec3& point)
-{
-	if (node->isLeaf())
+	for (uint8_t depth = 0; !level.empty(); ++depth)
 	{
-		return node;
-	}
+		const int numNodes = static_cast<int>(level.size());
+		const bool canSplit = depth < _maxLevel;
 
-	int childrenIndex = node->getChildrenIndex(point);
-	return locateNode(node->_child[childrenIndex], point);
-}
+		masks.resize(entries.size());
+		childCounts.assign(level.size() * NUM_CHILDREN, 0);
 
-int Octree::newNode(const float txm, const int x, const float tym, const int y, const float tzm, const int z)
-{
-	if (txm < tym)
-	{
-		if (txm < tzm) return x;				// YZ plane
-	}
-	else
-	{
-		if (tym < tzm) return y;				// XZ plane
-	}
+		// Children overlapped by each triangle of the nodes to be split
+		#pragma omp parallel for schedule(dynamic)
+		for (int nodeIdx = 0; nodeIdx < numNodes; ++nodeIdx)
+		{
+			const Node& node = _nodes[level[nodeIdx]];
+			if (!canSplit || node._end - node._begin <= _maxTrianglesPerNode)
+				continue;
 
-	return z;
-}
+			AABB childAABB[8];
+			for (int childIdx = 0; childIdx < NUM_CHILDREN; ++childIdx)
+				childAABB[childIdx] = this->getNodeAABB(depth + 1, coordinates[nodeIdx] * 2u + uvec3(childIdx >> 2, (childIdx >> 1) & 1, childIdx & 1));
 
-void Octree::retrieveAABB(FaceListNode* face, const float tx0, const float ty0, const float tz0, const float tx1, const float ty1, const float tz1, unsigned char a, OctreeNode* node)
-{
-	if (tx1 < 0.0f || ty1 < 0.0f || tz1 < 0.0f)
-	{
-		return;
-	}
+			for (uint32_t entryIdx = node._begin; entryIdx < node._end; ++entryIdx)
+			{
+				Triangle3D triangle = _triangles[entries[entryIdx]];
+				uint8_t mask = 0;
+
+				for (int childIdx = 0; childIdx < NUM_CHILDREN; ++childIdx)
+				{
+					if (Intersections3D::intersect(triangle, childAABB[childIdx]))
+					{
+						mask |= 1 << childIdx;
+						++childCounts[nodeIdx * NUM_CHILDREN + childIdx];
+					}
+				}
+
+				masks[entryIdx] = mask;
+			}
+		}
 
-	if (node->isLeaf())
-	{
-		if (node->_content.size() > 0)
+		// Children of a level are appended in the same order as their parents, and leaves are given their final range
+		offsets.resize(level.size() * NUM_CHILDREN);
+		nextLevel.clear();
+		nextCoordinates.clear();
+		uint32_t numNextEntries = 0;
+
+		for (int nodeIdx = 0; nodeIdx < numNodes; ++nodeIdx)
 		{
-			face->push_back(node->_content);
-		}
+			const uint32_t numEntries = _nodes[level[nodeIdx]]._end - _nodes[level[nodeIdx]]._begin;
 
-		return;
-	}
+			if (!canSplit || numEntries <= _maxTrianglesPerNode)
+			{
+				offsets[nodeIdx * NUM_CHILDREN] = static_cast<uint32_t>(_indices.size());
+				_indices.resize(_indices.size() + numEntries);
+				continue;
+			}
 
-	const float txm = (tx0 + tx1) / 2.0f, tym = (ty0 + ty1) / 2.0f, tzm = (tz0 + tz1) / 2.0f;
-	int currNode	= getFirstNode(tx0, ty0, tz0, txm, tym, tzm);
+			_nodes[level[nodeIdx]]._children = static_cast<uint32_t>(_nodes.size());
 
-	do {
-		switch (currNode) {
-		case 0:
-		{
-			retrieveAABB(face, tx0, ty0, tz0, txm, tym, tzm, a, node->_child[a]);
-			currNode = newNode(txm, 4, tym, 2, tzm, 1);
-			break;
-		}
-		case 1:
-		{
-			retrieveAABB(face, tx0, ty0, tzm, txm, tym, tz1, a, node->_child[1 ^ a]);
-			currNode = newNode(txm, 5, tym, 3, tz1, 8);
-			break;
-		}
-		case 2:
-		{
-			retrieveAABB(face, tx0, tym, tz0, txm, ty1, tzm, a, node->_child[2 ^ a]);
-			currNode = newNode(txm, 6, ty1, 8, tzm, 3);
-			break;
-		}
-		case 3:
-		{
-			retrieveAABB(face, tx0, tym, tzm, txm, ty1, tz1, a, node->_child[3 ^ a]);
-			currNode = newNode(txm, 7, ty1, 8, tz1, 8);
-			break;
-		}
-		case 4:
-		{
-			retrieveAABB(face, txm, ty0, tz0, tx1, tym, tzm, a, node->_child[4 ^ a]);
-			currNode = newNode(tx1, 8, tym, 6, tzm, 5);
-			break;
-		}
-		case 5:
-		{
-			retrieveAABB(face, txm, ty0, tzm, tx1, tym, tz1, a, node->_child[5 ^ a]);
-			currNode = newNode(tx1, 8, tym, 7, tz1, 8);
-			break;
-		}
-		case 6:
-		{
-			retrieveAABB(face, txm, tym, tz0, tx1, ty1, tzm, a, node->_child[6 ^ a]);
-			currNode = newNode(tx1, 8, ty1, 8, tzm, 7);
-			break;
-		}
-		case 7:
-		{
-			retrieveAABB(face, txm, tym, tzm, tx1, ty1, tz1, a, node->_child[7 ^ a]);
-			currNode = 8;
-			break;
-		}
+			for (int childIdx = 0; childIdx < NUM_CHILDREN; ++childIdx)
+			{
+				const uint32_t count = childCounts[nodeIdx * NUM_CHILDREN + childIdx];
+
+				offsets[nodeIdx * NUM_CHILDREN + childIdx] = numNextEntries;
+				nextLevel.push_back(static_cast<uint32_t>(_nodes.size()));
+				nextCoordinates.push_back(coordinates[nodeIdx] * 2u + uvec3(childIdx >> 2, (childIdx >> 1) & 1, childIdx & 1));
+				_nodes.push_back(Node{ 0, level[nodeIdx], numNextEntries, numNextEntries + count });
+
+				numNextEntries += count;
+			}
 		}
-	} while (currNode < 8);
-}
 
+		nextEntries.resize(numNextEntries);
 
-/// [Node subclass]
+		#pragma omp parallel for schedule(dynamic)
+		for (int nodeIdx = 0; nodeIdx < numNodes; ++nodeIdx)
+		{
+			Node& node = _nodes[level[nodeIdx]];
+			uint32_t* offset = &offsets[nodeIdx * NUM_CHILDREN];
 
-Octree::OctreeNode::OctreeNode(uint8_t level, const AABB& aabb, Octree* root, Octree::OctreeNode* parent) :
-	_level(level), _aabb(aabb), _root(root), _parent(parent), _createdChildren(false)
-{
-	_child.resize(NUM_CHILDREN);
-	for (int i = 0; i < NUM_CHILDREN; ++i)
-	{
-		_child[i] = nullptr;
-	}
+			if (!node._children)
+			{
+				std::copy(entries.begin() + node._begin, entries.begin() + node._end, _indices.begin() + offset[0]);
+				node._end = offset[0] + (node._end - node._begin);
+				node._begin = offset[0];
+				continue;
+			}
 
-	_childAABB = _aabb.split(2);
-}
+			// Entries keep their Morton order within each child
+			for (uint32_t entryIdx = node._begin; entryIdx < node._end; ++entryIdx)
+			{
+				uint8_t mask = masks[entryIdx];
 
-Octree::OctreeNode::~OctreeNode()
-{
-	for (int i = 0; i < NUM_CHILDREN; ++i)
-	{
-		delete _child[i];
-	}
-}
+				while (mask)
+				{
+					const int childIdx = std::countr_zero(mask);
+					mask &= mask - 1;
 
-void Octree::OctreeNode::createChildren()
-{
-	if (!_createdChildren)
-	{
-		for (int i = 0; i < _childAABB.size(); ++i)
-		{
-			_child[i] = new OctreeNode(_level + 1, _childAABB[i], _root, this);
+					nextEntries[offset[childIdx]++] = entries[entryIdx];
+				}
+			}
 		}
 
-		_createdChildren = true;
+		entries.swap(nextEntries);
+		level.swap(nextLevel);
+		coordinates.swap(nextCoordinates);
 	}
 }
 
-int Octree::OctreeNode::getChildrenIndex(vec3& point)
+uint32_t Octree::computeMortonCode(const vec3& point) const
 {
-	vec3 center = _aabb.center();
-	int childrenIndex = 0;
+	const auto expandBits = [](uint32_t value)
+		{
+			value = (value * 0x00010001u) & 0xFF0000FFu;
+			value = (value * 0x00000101u) & 0x0F00F00Fu;
+			value = (value * 0x00000011u) & 0xC30C30C3u;
+			value = (value * 0x00000005u) & 0x49249249u;
 
-	if (point.y > center.y) childrenIndex += 4;				// X and Z are first explored
-	if (point.z > center.z) childrenIndex += 2;				// Z is explored in second place
-	if (point.x > center.x) childrenIndex += 1;
+			return value;
+		};
 
-	return childrenIndex;
-}
+	const vec3 size = _aabb.size();
+	uvec3 cell(0);
 
-std::vector<uint8_t> Octree::OctreeNode::getChildrenIndices(Triangle3D* triangle)
-{
-	std::vector<uint8_t> childrenIndices;
+	for (int axis = 0; axis < 3; ++axis)
+		if (size[axis] > .0f)
+			cell[axis] = static_cast<uint32_t>(glm::clamp((point[axis] - _aabb.min()[axis]) / size[axis] * 1024.0f, .0f, 1023.0f));
 
-	for (int i = 0; i < _childAABB.size(); ++i)
-	{
-		if (Intersections3D::intersect(*triangle, _childAABB[i]))
-		{
-			childrenIndices.push_back(i);
-		}
-	}
-
-	return childrenIndices;
+	return expandBits(cell.x) << 2 | expandBits(cell.y) << 1 | expandBits(cell.z);
 }
 
-size_t Octree::OctreeNode::getChildrenSize()
+AABB Octree::getNodeAABB(uint8_t level, const uvec3& coordinates) const
 {
-	size_t size = 0;
+	const vec3 nodeSize = _aabb.size() / static_cast<float>(1u << level);
+	const vec3 minPoint = _aabb.min() + nodeSize * vec3(coordinates);
 
-	for (int i = 0; i < _child.size(); ++i)
-	{
-		if (_child[i])
-		{
-			size += _child[i]->_content.size();
-		}
-	}
-
-	return size;
-}
\ No newline at end of file
+	return AABB(minPoint, minPoint + nodeSize);
+}
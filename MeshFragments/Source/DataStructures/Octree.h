@@ -3,9 +3,6 @@
 #include "Graphics/Core/Model3D.h"
 #include "Geometry/3D/Ray3D.h"
 #include "Geometry/3D/Triangle3D.h"
-#include "Geometry/3D/TriangleMesh.h"
-
-typedef std::list<std::list<Triangle3D*>> FaceListNode;
 
 /**
 *	@file OctreeTriangle.h
@@ -14,79 +11,56 @@ typedef std::list<std::list<Triangle3D*>> FaceListNode;
 */
 
 /**
-*	@brief Octree of a triangle mesh.
+*	@brief Linear octree of a triangle mesh. Nodes are stored contiguously in breadth-first order, the eight children of a node are
+*	consecutive and leaves refer to a range of triangle indices, so that neither construction nor traversal allocate per node. Triangles
+*	are sorted by the Morton code of their centroid and every level is split in parallel. A triangle is referenced by every leaf it overlaps.
 */
 class Octree
 {
-protected:
-	class OctreeNode;																//!< Anidated class to be defined below
+public:
+	const static uint8_t					MAX_LEVEL;								//!< Deepest level supported by the integer cell coordinates
+	const static int						NUM_CHILDREN;							//!< Octree ==> 8
 
-	// [Nodes references]
-	OctreeNode*								_root;									//!< Node where the traversal starts
+protected:
+	/**
+	*	@brief Node of the octree. Its cube is implicit, given by its level and the path from the root.
+	*/
+	struct Node
+	{
+		uint32_t							_children;								//!< Index of the first child, zero for leaves
+		uint32_t							_parent;
+		uint32_t							_begin, _end;							//!< Range of triangle indices of a leaf
+	};
 
+protected:
 	// [Tree data]
+	AABB									_aabb;									//!< Boundaries of the root
+	std::vector<uint32_t>					_faces;									//!< Face of each triangle, counted through every model component
+	std::vector<uint32_t>					_indices;								//!< Triangle indices of every leaf
 	uint8_t									_maxLevel;								//!< Higher priority than max triangles per node
 	uint8_t									_maxTrianglesPerNode;					//!< Maximum capacity of a node
-	std::vector<Triangle3D*>				_triangles;								//!< List of mesh triangles
+	std::vector<Node>						_nodes;									//!< Root is the first node
+	std::vector<Triangle3D>					_triangles;								//!< Mesh triangles in Morton order
 
 protected:
 	/**
-	*	@brief Computes the child index where the search should start from the current node. Octree traversal.
-	*/
-	int getFirstNode(const float tx0, const float ty0, const float tz0, const float txm, const float tym, const float tzm);
-
-	/**
-	*	@brief Obtains the metadata of each node in a recursive way (bounding box of each node).
-	*	@param node Node where we're searching.
-	*	@param aabb Retrieved aligned axis bounding boxes.
-	*/
-	void grabNodeData(OctreeNode* node, std::vector<AABB>& aabb);
-
-	/**
-	*	@brief Inserts a triangle at a certain node.
-	*	@param node Node where we're currently working.
-	*	@param parent Previous node.
-	*	@param triangle Triangle to be inserted.
+	*	@brief Splits the nodes of every level in parallel until they hold few enough triangles or reach the maximum level.
 	*/
-	void insert(OctreeNode* node, OctreeNode* parent, Triangle3D* triangle);
+	void build();
 
 	/**
-	*	@brief Finds the node where the triangle should be located. Warning: if the located node is null then the parent creates its children.
-	*	@param node Node where we're currently working.
-	*	@param parent Previous node.
-	*	@param triangle Triangle to be located.
-	*	@param foundNodes Nodes which may contain the triangle.
+	*	@return Morton code of a point of the root box, with 10 bits per axis.
 	*/
-	void locateNodeForInsertion(OctreeNode* node, OctreeNode* parent, Triangle3D* triangle, std::list<OctreeNode*>* foundNodes);
+	uint32_t computeMortonCode(const vec3& point) const;
 
 	/**
-	*	@brief Finds the nodes where the triangle should be. In case it's null we simply return it.
-	*	@param node Node where we're currently searching.
-	*	@param triangle Triangle to be searched.
-	*	@param foundNodes Nodes which may contain the triangle.
+	*	@return Bounding box of a node given by its level and integer coordinates within that level.
 	*/
-	void locateNode(OctreeNode* node, Triangle3D* triangle, std::list<OctreeNode*>* foundNodes);
-
-	/**
-	*	@brief Locates the node where the point should be. In case it's null we simply return it.
-	*/
-	OctreeNode* locateNode(OctreeNode* node, vec3& point);
-
-	/**
-	*	@brief Locates the node which comes after the current one. Octree traversal.
-	*/
-	int newNode(const float txm, const int x, const float tym, const int y, const float tzm, const int z);
-
-	/**
-	*	@brief Octree exploration through a ray.
-	*	@param face Faces which the ray intersects.
-	*	@param node Current node.
-	*/
-	void retrieveAABB(FaceListNode* face, const float tx0, const float ty0, const float tz0, const float tx1, const float ty1, const float tz1, unsigned char a, OctreeNode* node);
+	AABB getNodeAABB(uint8_t level, const uvec3& coordinates) const;
 
 public:
 	/**
-	*	@brief Constructor with no triangles by default.
+	*	@brief Constructor.
 	*	@param maxLevel Maximum depth.
 	*	@param maxTrianglesNode Maximum number of triangles per node even though maxLevel has more priority.
 	*	@param mesh Faces which must be saved in the octree.
@@ -106,91 +80,48 @@ public:
 	/**
 	*	@return AABB which marks the octree boundaries.
 	*/
-	virtual AABB getAABB() const { return _root->_aabb; }
+	virtual AABB getAABB() const { return _aabb; }
 
 	/**
-	*	@brief Returns the bounding boxes for each node of the octree (rendering purposes).
+	*	@brief Returns the bounding boxes for each non-empty leaf of the octree (rendering purposes).
 	*	@param aabb Bounding boxes which represents the octree.
 	*/
-	virtual void getAABBs(std::vector<AABB>& aabb);
+	virtual void getAABBs(std::vector<AABB>& aabb) const;
 
 	/**
-	*	@brief Computes the intersection with a ray.
-	*	@param result Triangles which can be intersected by the ray.
+	*	@return Face of a triangle, counted through every model component in order.
 	*/
-	void intersection(const Ray3D& ray, FaceListNode* face);
+	unsigned getFace(unsigned triangle) const { return _faces[triangle]; }
 
 	/**
-	*	@brief Unsupported assignment overriding.
+	*	@return Number of nodes of the octree.
 	*/
-	Octree& operator=(const Octree& orig) = delete;
+	size_t getNumNodes() const { return _nodes.size(); }
 
 	/**
-	*	@brief Includes new data on the tree.
-	*	@param modelComp Model component where that face is defined.
+	*	@return Triangle given by its index.
 	*/
-	void push_back(Triangle3D* triangle);
+	const Triangle3D& getTriangle(unsigned triangle) const { return _triangles[triangle]; }
 
-protected:
-	class OctreeNode
-	{
-	public:
-		const static int					NUM_CHILDREN = 8;				//!< Octree ==> 8
-
-	public:
-		// [Node data]
-		AABB _aabb;
-		std::vector<AABB>					_childAABB;						//!< Bounding boxes of our childs, which are contained in our _aabb
-		std::list<Triangle3D*>				_content;						//!< Triangles
-
-		// [Tree data]
-		Octree*								_root;							//!< Reference to global class
-		OctreeNode*							_parent;						//!< Previous node
-
-		// [Child data]
-		std::vector<OctreeNode*>			_child;							//!< Nodes which are behind this one
-		bool								_createdChildren;				//!< Child array is initialized from the start but node pointers are null
-		uint8_t								_level;							//!< Tree depth
-
-	public:
-		/**
-		*	@brief Constructor.
-		*	@param level Level where this node is located at the tree.
-		*	@param aabb Bounding box that represents the boundary of this node.
-		*	@param root Octree root.
-		*	@param parent Parent node. Null if this node is root.
-		*/
-		OctreeNode(uint8_t level, const AABB& aabb, Octree* root, OctreeNode* parent);
-
-		/**
-		*	@brief Destructor.
-		*/
-		~OctreeNode();
-
-		/**
-		*	@brief Initializes all the children pointers.
-		*/
-		void createChildren();
-
-		/**
-		*	@brief Searchs the octree node where the point should be located.
-		*/
-		int getChildrenIndex(vec3& point);
-
-		/**
-		*	@brief Searchs the octree nodes where the triangle should be linked.
-		*/
-		std::vector<uint8_t> getChildrenIndices(Triangle3D* triangle);
-
-		/**
-		*	@return Amount of points the childs contains.
-		*/
-		size_t getChildrenSize();
-
-		/**
-		*	@return True if the node is a leaf. 
-		*/
-		bool isLeaf() { return !_createdChildren; }
-	};
+	/**
+	*	@brief Retrieves the triangles of a leaf.
+	*	@return Number of triangle indices the pointer refers to.
+	*/
+	unsigned getTriangles(unsigned leaf, const unsigned*& triangles) const;
+
+	/**
+	*	@brief Finds the non-empty leaves crossed by a ray, from its origin onwards. Leaves are visited in ray order without a stack: from the
+	*	exit face of a leaf, the traversal steps into the neighbouring cell of the finest level, climbs through parent links until a node
+	*	contains it and descends again.
+	*	@param leaves Buffer where leaf indices are written in ray order.
+	*	@param capacity Size of the buffer. The traversal stops once it is full.
+	*	@return Number of leaves written.
+	*/
+	unsigned intersection(const Ray3D& ray, unsigned* leaves, unsigned capacity) const;
+
+	/**
+	*	@brief Unsupported assignment overriding.
+	*/
+	Octree& operator=(const Octree& orig) = delete;
 };
 
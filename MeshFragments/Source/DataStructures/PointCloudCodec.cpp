@@ -0,0 +1,281 @@
+#include "stdafx.h"
+#include "PointCloudCodec.h"
+
+// [Static members initialization]
+
+const char PointCloudCodec::MAGIC[4] = { 'P', 'C', 'O', 'C' };
+const uint16_t PointCloudCodec::VERSION = 1;
+const unsigned PointCloudCodec::DEFAULT_BITS = 14;
+const unsigned PointCloudCodec::MAX_BITS = 21;
+
+static_assert(sizeof(PointCloudCodec::Header) == 40, "Header must match the on-disk layout");
+
+/// [Public methods]
+
+uint16_t PointCloudCodec::packNormal(const vec3& normal)
+{
+	// Octahedral mapping: projection onto the octahedron |x| + |y| + |z| = 1, whose lower half is folded over the upper one
+	vec2 octahedron = vec2(normal.x, normal.y) / glm::max(glm::abs(normal.x) + glm::abs(normal.y) + glm::abs(normal.z), glm::epsilon<float>());
+	if (normal.z < .0f)
+		octahedron = (1.0f - glm::abs(vec2(octahedron.y, octahedron.x))) * vec2(octahedron.x >= .0f ? 1.0f : -1.0f, octahedron.y >= .0f ? 1.0f : -1.0f);
+
+	const uvec2 quantized = uvec2(glm::round(glm::clamp(octahedron * .5f + .5f, .0f, 1.0f) * 255.0f));
+
+	return static_cast<uint16_t>((quantized.x << 8) | quantized.y);
+}
+
+vec3 PointCloudCodec::unpackNormal(uint16_t normal)
+{
+	const vec2 octahedron = vec2(normal >> 8, normal & 0xFF) / 255.0f * 2.0f - 1.0f;
+	vec3 unfolded = vec3(octahedron.x, octahedron.y, 1.0f - glm::abs(octahedron.x) - glm::abs(octahedron.y));
+
+	if (unfolded.z < .0f)
+	{
+		const vec2 folded = (1.0f - glm::abs(vec2(unfolded.y, unfolded.x))) * vec2(unfolded.x >= .0f ? 1.0f : -1.0f, unfolded.y >= .0f ? 1.0f : -1.0f);
+		unfolded.x = folded.x;
+		unfolded.y = folded.y;
+	}
+
+	return glm::normalize(unfolded);
+}
+
+bool PointCloudCodec::read(const uint8_t* data, size_t size, std::vector<vec4>& points, std::vector<vec3>& normals, std::vector<uint8_t>& labels)
+{
+	if (size < sizeof(Header)) return false;
+
+	Header header;
+	std::memcpy(&header, data, sizeof(Header));
+	if (std::memcmp(header._magic, MAGIC, sizeof(MAGIC)) != 0 || header._version != VERSION || header._bits == 0 || header._bits > MAX_BITS)
+		return false;
+
+	// Normals and labels code one or two bytes per point, which bounds the number of points; duplicated positions alone do not
+	const uint64_t maxSymbols = static_cast<uint64_t>(size - sizeof(Header)) * RangeCoder::MAX_SYMBOLS_PER_BYTE;
+	const unsigned symbolsPerPoint = (header._flags & HAS_NORMALS ? 2 : 0) + (header._flags & HAS_LABELS ? 1 : 0);
+	if (static_cast<uint64_t>(header._numPoints) * symbolsPerPoint > maxSymbols)
+		return false;
+
+	RangeCoder::Decoder decoder(data + sizeof(Header), size - sizeof(Header));
+	Models models;
+	std::vector<uint64_t> codes;
+	codes.reserve(static_cast<size_t>(std::min(static_cast<uint64_t>(header._numPoints), maxSymbols)));
+
+	if (header._numPoints && (!decodeNode(decoder, models, 0, 0, header._bits, header._numPoints, codes) || codes.size() != header._numPoints))
+		return false;
+
+	const float maxValue = static_cast<float>((1u << header._bits) - 1);
+	const vec3 step = (header._max - header._min) / maxValue;
+
+	points.resize(header._numPoints);
+	for (size_t idx = 0; idx < codes.size(); ++idx)
+		points[idx] = vec4(header._min + vec3(decodeMorton(codes[idx])) * step, 1.0f);
+
+	normals.clear();
+	if (header._flags & HAS_NORMALS)
+	{
+		uint8_t previous[2] = { 0, 0 };
+
+		normals.resize(header._numPoints);
+		for (vec3& normal : normals)
+		{
+			for (int byteIdx = 0; byteIdx < 2; ++byteIdx)
+				previous[byteIdx] += decoder.decodeByte(models._normals[byteIdx]);
+			normal = unpackNormal(static_cast<uint16_t>((previous[0] << 8) | previous[1]));
+		}
+	}
+
+	labels.clear();
+	if (header._flags & HAS_LABELS)
+	{
+		uint8_t previous = 0;
+
+		labels.resize(header._numPoints);
+		for (uint8_t& label : labels)
+			previous = label = decoder.decodeByte(models._labels[previous != 0]);
+	}
+
+	return true;
+}
+
+bool PointCloudCodec::write(std::ostream& stream, const vec4* points, const vec3* normals, const uint8_t* labels, size_t numPoints, unsigned bits)
+{
+	if (bits == 0 || bits > MAX_BITS || numPoints > std::numeric_limits<uint32_t>::max()) return false;
+
+	Header header;
+	std::memcpy(header._magic, MAGIC, sizeof(MAGIC));
+	header._version = VERSION;
+	header._flags = (normals ? HAS_NORMALS : 0) | (labels ? HAS_LABELS : 0);
+	header._numPoints = static_cast<uint32_t>(numPoints);
+	header._bits = static_cast<uint8_t>(bits);
+	std::fill(std::begin(header._reserved), std::end(header._reserved), 0);
+	header._min = numPoints ? vec3(points[0]) : vec3(.0f);
+	header._max = header._min;
+
+	for (size_t idx = 1; idx < numPoints; ++idx)
+	{
+		header._min = glm::min(header._min, vec3(points[idx]));
+		header._max = glm::max(header._max, vec3(points[idx]));
+	}
+
+	// Quantize and sort by Morton code, keeping track of where each point comes from
+	const float maxValue = static_cast<float>((1u << bits) - 1);
+	const vec3 extent = header._max - header._min;
+	const vec3 scale = vec3(extent.x > .0f ? maxValue / extent.x : .0f, extent.y > .0f ? maxValue / extent.y : .0f, extent.z > .0f ? maxValue / extent.z : .0f);
+	std::vector<std::pair<uint64_t, uint32_t>> sortedPoints(numPoints);
+
+	for (size_t idx = 0; idx < numPoints; ++idx)
+	{
+		const uvec3 quantized = uvec3(glm::clamp(glm::round((vec3(points[idx]) - header._min) * scale), vec3(.0f), vec3(maxValue)));
+		sortedPoints[idx] = std::make_pair(encodeMorton(quantized), static_cast<uint32_t>(idx));
+	}
+
+	std::sort(sortedPoints.begin(), sortedPoints.end());
+
+	std::vector<uint64_t> codes(numPoints);
+	for (size_t idx = 0; idx < numPoints; ++idx)
+		codes[idx] = sortedPoints[idx].first;
+
+	std::vector<uint8_t> content;
+	RangeCoder::Encoder encoder(content);
+	Models models;
+
+	if (numPoints)
+		encodeNode(encoder, models, codes.data(), codes.data() + numPoints, 0, bits);
+
+	if (normals)
+	{
+		uint8_t previous[2] = { 0, 0 };
+
+		for (const auto& sortedPoint : sortedPoints)
+		{
+			const uint16_t normal = packNormal(normals[sortedPoint.second]);
+			const uint8_t current[2] = { static_cast<uint8_t>(normal >> 8), static_cast<uint8_t>(normal & 0xFF) };
+
+			for (int byteIdx = 0; byteIdx < 2; ++byteIdx)
+			{
+				encoder.encodeByte(models._normals[byteIdx], static_cast<uint8_t>(current[byteIdx] - previous[byteIdx]));
+				previous[byteIdx] = current[byteIdx];
+			}
+		}
+	}
+
+	if (labels)
+	{
+		uint8_t previous = 0;
+
+		for (const auto& sortedPoint : sortedPoints)
+		{
+			encoder.encodeByte(models._labels[previous != 0], labels[sortedPoint.second]);
+			previous = labels[sortedPoint.second];
+		}
+	}
+
+	encoder.finish();
+
+	stream.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+	stream.write(reinterpret_cast<const char*>(content.data()), content.size());
+
+	return !stream.fail();
+}
+
+/// [Protected methods]
+
+bool PointCloudCodec::decodeNode(RangeCoder::Decoder& decoder, Models& models, uint64_t prefix, unsigned depth, unsigned bits, size_t numPoints, std::vector<uint64_t>& codes)
+{
+	if (depth == bits)
+	{
+		const size_t count = static_cast<size_t>(decoder.decodeVarint(models._duplicates)) + 1;
+		if (count > numPoints - codes.size()) return false;
+
+		codes.insert(codes.end(), count, prefix);
+		return true;
+	}
+
+	if (decoder.decodeBit(models._single[depth]))
+	{
+		if (codes.size() == numPoints) return false;
+
+		for (unsigned level = depth; level < bits; ++level)
+			prefix = (prefix << 3) | decoder.decodeDirectBits(3);
+
+		codes.push_back(prefix);
+		return true;
+	}
+
+	const uint8_t occupancy = decoder.decodeByte(models._occupancy[depth]);
+	if (occupancy == 0) return false;
+
+	for (unsigned child = 0; child < 8; ++child)
+		if ((occupancy >> child) & 1)
+			if (!decodeNode(decoder, models, (prefix << 3) | child, depth + 1, bits, numPoints, codes))
+				return false;
+
+	return true;
+}
+
+void PointCloudCodec::encodeNode(RangeCoder::Encoder& encoder, Models& models, const uint64_t* begin, const uint64_t* end, unsigned depth, unsigned bits)
+{
+	// Every point of a leaf shares the same code
+	if (depth == bits)
+	{
+		encoder.encodeVarint(models._duplicates, static_cast<uint32_t>(end - begin - 1));
+		return;
+	}
+
+	const bool single = end - begin == 1;
+	encoder.encodeBit(models._single[depth], single);
+
+	if (single)
+	{
+		for (unsigned level = depth; level < bits; ++level)
+			encoder.encodeDirectBits(static_cast<uint32_t>((*begin >> (3 * (bits - 1 - level))) & 7), 3);
+
+		return;
+	}
+
+	// Children are contiguous ranges of the sorted codes
+	const unsigned shift = 3 * (bits - 1 - depth);
+	const uint64_t* childBegin[9];
+	const uint64_t* code = begin;
+	uint8_t occupancy = 0;
+
+	for (unsigned child = 0; child < 8; ++child)
+	{
+		childBegin[child] = code;
+		while (code != end && ((*code >> shift) & 7) == child)
+			++code;
+
+		if (code != childBegin[child])
+			occupancy |= 1 << child;
+	}
+
+	childBegin[8] = end;
+	encoder.encodeByte(models._occupancy[depth], occupancy);
+
+	for (unsigned child = 0; child < 8; ++child)
+		if (childBegin[child + 1] != childBegin[child])
+			encodeNode(encoder, models, childBegin[child], childBegin[child + 1], depth + 1, bits);
+}
+
+uint64_t PointCloudCodec::encodeMorton(const uvec3& position)
+{
+	uint64_t code = 0;
+	for (unsigned bit = 0; bit < MAX_BITS; ++bit)
+		code |= (static_cast<uint64_t>((position.x >> bit) & 1) << (3 * bit + 2)) | (static_cast<uint64_t>((position.y >> bit) & 1) << (3 * bit + 1)) |
+			(static_cast<uint64_t>((position.z >> bit) & 1) << (3 * bit));
+
+	return code;
+}
+
+uvec3 PointCloudCodec::decodeMorton(uint64_t code)
+{
+	uvec3 position(0);
+	for (unsigned bit = 0; bit < MAX_BITS; ++bit)
+	{
+		position.x |= static_cast<unsigned>((code >> (3 * bit + 2)) & 1) << bit;
+		position.y |= static_cast<unsigned>((code >> (3 * bit + 1)) & 1) << bit;
+		position.z |= static_cast<unsigned>((code >> (3 * bit)) & 1) << bit;
+	}
+
+	return position;
+}
+
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "Utilities/RangeCoder.h"
+
+/**
+*	@brief Lossy codec for point clouds with optional normals and fracture labels. Positions are quantized to the AABB of the cloud and
+*	sorted in Morton order, so that they form an octree whose occupancy bytes are range-coded depth-first. Nodes holding a single point
+*	store the remaining bits of its position directly. Attributes follow in the same order: normals as deltas of their octahedral
+*	encoding and labels conditioned on the previous one. Every model lives in the stack of the call, so the codec is reentrant.
+*
+*	Layout: Header | range-coded octree | range-coded normals (HAS_NORMALS) | range-coded labels (HAS_LABELS), as a single stream.
+*/
+class PointCloudCodec
+{
+public:
+	const static char		MAGIC[4];							//!< File signature
+	const static uint16_t	VERSION;							//!< Current version of the format
+	const static unsigned	DEFAULT_BITS;						//!< Quantization bits per axis unless otherwise specified
+	const static unsigned	MAX_BITS;							//!< Morton codes must fit in 64 bits
+
+	enum Flags : uint16_t { HAS_NORMALS = 1, HAS_LABELS = 2 };
+
+	struct Header
+	{
+		char		_magic[4];
+		uint16_t	_version;
+		uint16_t	_flags;
+		uint32_t	_numPoints;
+		uint8_t		_bits;										//!< Quantization bits per axis, and depth of the octree
+		uint8_t		_reserved[3];
+		vec3		_min, _max;									//!< AABB of the cloud
+	};
+
+protected:
+	/**
+	*	@brief Adaptive models of a stream.
+	*/
+	struct Models
+	{
+		RangeCoder::VarintModel	_duplicates;					//!< Extra points of leaves
+		RangeCoder::ByteModel	_labels[2];						//!< Conditioned on whether the previous label is zero
+		RangeCoder::ByteModel	_normals[2];					//!< One per byte of the octahedral encoding
+		RangeCoder::ByteModel	_occupancy[21];					//!< One per depth
+		uint16_t				_single[21];					//!< Probability of a node holding a single point, per depth
+
+		Models() { std::fill(std::begin(_single), std::end(_single), RangeCoder::INITIAL_PROBABILITY); }
+	};
+
+protected:
+	/**
+	*	@brief Decodes the subtree of a node whose Morton prefix is known.
+	*	@return False if the stream holds more points than numPoints.
+	*/
+	static bool decodeNode(RangeCoder::Decoder& decoder, Models& models, uint64_t prefix, unsigned depth, unsigned bits, size_t numPoints, std::vector<uint64_t>& codes);
+
+	/**
+	*	@brief Encodes the subtree of a node holding the sorted codes [begin, end).
+	*/
+	static void encodeNode(RangeCoder::Encoder& encoder, Models& models, const uint64_t* begin, const uint64_t* end, unsigned depth, unsigned bits);
+
+	/**
+	*	@return Morton code of a quantized position.
+	*/
+	static uint64_t encodeMorton(const uvec3& position);
+
+	/**
+	*	@return Quantized position of a Morton code.
+	*/
+	static uvec3 decodeMorton(uint64_t code);
+
+public:
+	/**
+	*	@brief Encodes a unit normal in 16 bits (octahedral mapping, 8 bits per coordinate).
+	*/
+	static uint16_t packNormal(const vec3& normal);
+
+	/**
+	*	@brief Decodes a normal encoded with packNormal.
+	*/
+	static vec3 unpackNormal(uint16_t normal);
+
+	/**
+	*	@brief Decodes a point cloud. Points are returned in Morton order, with their attributes in the same order.
+	*	@param normals Left empty if the cloud has no normals.
+	*	@param labels Left empty if the cloud has no labels.
+	*	@return False if the stream is not a valid point cloud.
+	*/
+	static bool read(const uint8_t* data, size_t size, std::vector<vec4>& points, std::vector<vec3>& normals, std::vector<uint8_t>& labels);
+
+	/**
+	*	@brief Encodes a point cloud and writes it with a single call.
+	*	@param normals Optional, one per point.
+	*	@param labels Optional, one per point.
+	*	@param bits Quantization bits per axis, up to MAX_BITS. The error of each coordinate is at most half the extent of the cloud
+	*	along that axis divided by 2^bits - 1.
+	*	@return Success of operation.
+	*/
+	static bool write(std::ostream& stream, const vec4* points, const vec3* normals, const uint8_t* labels, size_t numPoints, unsigned bits = DEFAULT_BITS);
+};
+
@@ -6,10 +6,22 @@
 template<typename T>
 class QuadStack
 {
+private:
+	struct ColumnInterval
+	{
+		T			_value;
+		uint16_t	_end;
+	};
+
+	typedef typename GStack<T>::Interval Interval;
+
 private:
 	uint16_t                            _width, _height, _depth;
-	std::vector<std::vector<GStack<T>>> _gStacks;
-	GStack<T>*							_quadStack;
+	std::vector<uint32_t>				_columnOffsets;				//!< First interval of each column, plus the total as the last element
+	std::vector<ColumnInterval>			_columns;					//!< Runs of every column along z, flattened as x * height + y
+	std::vector<uint16_t>				_heightfields;				//!< Pool of interval heightfields
+	std::vector<Interval>				_intervals;					//!< Pool of node intervals
+	std::vector<GStack<T>>				_nodes;						//!< Node arena in preorder, with the root at index 0
 
 private:
 	enum StorageUnit : long
@@ -20,28 +32,18 @@ private:
 	std::string storageUnitToStr(StorageUnit unit) { static std::vector<std::string> unitTitle{ "Bytes", "KBs", "MBs", "GBs" }; return unitTitle[std::log2(static_cast<float>(unit)) / 10]; }
 
 private:
+	bool areColumnsEqual(uint32_t column1, uint32_t column2) const;
 	void backgroundWriteImage(T* layer, const std::string& filename, const uint16_t width, const uint16_t height);
 	void buildQuadStack();
-	void compressQuadStack(GStack<T>* root, uint16_t depth);
-	void compressQuadStack(GStack<T>*& root, uint16_t depth, bool foo);
-	GStack<T>* createGStack(uint16_t x_start, uint16_t x_end, uint16_t y_start, uint16_t y_end, bool leafNode = false, GStack<T>* node = nullptr);
-	uint32_t flattenIndex(uint16_t x, uint16_t y);
-	uint32_t flattenIndex(uint16_t x, uint16_t y, uint16_t z);
-	std::vector<std::vector<GStack<T>>> matchGS(GStack<T>* root, std::vector<std::vector<uint8_t>>& iteratorCount, std::vector<std::vector<uint8_t>>& numLayers, float& scBest);
-	void recursiveSplitQuadtree(uint16_t x_start, uint16_t x_end, uint16_t y_start, uint16_t y_end, GStack<T>* root);
-
-	void getLeaves(GStack<T>* root, std::vector<GStack<T>*>& leaves)
-	{
-		if (!root)
-			return;
-
-		if (root->getNumIntervals())
-			leaves.push_back(root);
-
-		for (int x = 0; x < 2; ++x)
-			for (int y = 0; y < 2; ++y)
-				this->getLeaves(root->_children[x][y], leaves);
-	}
+	void compressQuadStack(uint32_t nodeIdx);
+	void createLeaf(uint32_t nodeIdx);
+	uint32_t createNode(uint16_t x_start, uint16_t x_end, uint16_t y_start, uint16_t y_end);
+	uint32_t findNode(const uvec2& minPoint, const uvec2& maxPoint);
+	uint32_t flattenIndex(uint16_t x, uint16_t y) const;
+	uint32_t flattenIndex(uint16_t x, uint16_t y, uint16_t z) const;
+	uint32_t getChild(uint32_t nodeIdx, uint16_t x, uint16_t y) const;
+	void mergeStacks(uint32_t nodeIdx);
+	void recursiveSplitQuadtree(uint32_t nodeIdx);
 
 public:
 	QuadStack();
@@ -49,38 +51,68 @@ public:
 	QuadStack(const QuadStack& cube) = delete;
 	QuadStack& operator=(const QuadStack& cube) = delete;
 
+	T at(uint16_t x, uint16_t y, uint16_t z) const;
 	void calculateCompression(StorageUnit unit = GIGABYTE);
 	void compress_x();
-	void compress_y();
+	void getColumn(uint16_t x, uint16_t y, std::vector<std::pair<T, uint16_t>>& intervals) const;
+	uvec3 getNumSubdivisions() const { return uvec3(_width, _height, _depth); }
 	bool loadCube(RegularGrid* voxelization);
 	bool openCheckpoint(const std::string& filename);
+	bool openCheckpoint(std::istream& fin);
 	void saveCheckpoint(const std::string& filename);
+	void saveCheckpoint(std::ostream& fout);
+	bool toRegularGrid(RegularGrid* voxelization) const;
 	bool writeBand(const std::string& filename, uint16_t layer = 0);
 };
 
 template<typename T>
-QuadStack<T>::QuadStack() : _width(0), _height(0), _depth(0), _quadStack(nullptr)
+QuadStack<T>::QuadStack() : _width(0), _height(0), _depth(0)
 {
 }
 
 template<typename T>
 QuadStack<T>::~QuadStack()
 {
-	delete _quadStack;
+}
+
+template<typename T>
+T QuadStack<T>::at(uint16_t x, uint16_t y, uint16_t z) const
+{
+	if (x >= _width or y >= _height or z >= _depth or _nodes.empty())
+		return static_cast<T>(VOXEL_EMPTY);
+
+	// Every interval stores the height where it ends, so the voxel belongs to the lowest end above z
+	T value = static_cast<T>(VOXEL_EMPTY);
+	uint16_t closestEnd = std::numeric_limits<uint16_t>::max();
+
+	for (uint32_t nodeIdx = 0; nodeIdx != GStack<T>::NONE; nodeIdx = this->getChild(nodeIdx, x, y))
+	{
+		const GStack<T>& node = _nodes[nodeIdx];
+		const uint32_t column = node.getColumnIndex(x, y);
+
+		for (uint32_t intervalIdx = node._firstInterval; intervalIdx < node._firstInterval + node._numIntervals; ++intervalIdx)
+		{
+			uint16_t end = _heightfields[_intervals[intervalIdx]._heightfield + column];
+			if (end > z and end <= closestEnd)
+			{
+				closestEnd = end;
+				value = _intervals[intervalIdx]._value;
+			}
+		}
+	}
+
+	return value;
 }
 
 template<typename T>
 void QuadStack<T>::calculateCompression(StorageUnit unit)
 {
 	size_t defaultOccupancy = sizeof(uint16_t) * _width * _depth * _height;
-	size_t compressedOccupancy = 0;
+	size_t compressedOccupancy = _columns.size() * sizeof(ColumnInterval) + _columnOffsets.size() * sizeof(uint32_t);
+	size_t quadStackOccupancy = 0;
 
-	for (int x = 0; x < _width; ++x)
-		#pragma omp parallel for reduction(+:compressedOccupancy)
-		for (int y = 0; y < _height; ++y)
-			compressedOccupancy += _gStacks[x][y].size();
-
-	size_t quadStackOccupancy = _quadStack->size();
+	for (const GStack<T>& node : _nodes)
+		quadStackOccupancy += node.size();
 
 	std::cout << "Default size: " << defaultOccupancy / static_cast<float>(unit) << " " << storageUnitToStr(unit) << std::endl;
 	std::cout << "Compressed size: " << compressedOccupancy / static_cast<float>(unit) << " " << storageUnitToStr(unit) << std::endl;
@@ -92,20 +124,26 @@ template<typename T>
 void QuadStack<T>::compress_x()
 {
 	this->buildQuadStack();
-	this->compressQuadStack(_quadStack, 0, true);
+	this->compressQuadStack(0);
 }
 
 template<typename T>
-void QuadStack<T>::compress_y()
+void QuadStack<T>::getColumn(uint16_t x, uint16_t y, std::vector<std::pair<T, uint16_t>>& intervals) const
 {
-	for (int x = 0; x < _width; ++x)
+	intervals.clear();
+	if (x >= _width or y >= _height or _nodes.empty())
+		return;
+
+	for (uint32_t nodeIdx = 0; nodeIdx != GStack<T>::NONE; nodeIdx = this->getChild(nodeIdx, x, y))
 	{
-		#pragma omp parallel for
-		for (int y = 0; y < _height; ++y)
-		{
-			_gStacks[x][y] = _gStacks[x][y].compress(x, y);
-		}
+		const GStack<T>& node = _nodes[nodeIdx];
+		const uint32_t column = node.getColumnIndex(x, y);
+
+		for (uint32_t intervalIdx = node._firstInterval; intervalIdx < node._firstInterval + node._numIntervals; ++intervalIdx)
+			intervals.emplace_back(_intervals[intervalIdx]._value, _heightfields[_intervals[intervalIdx]._heightfield + column]);
 	}
+
+	std::sort(intervals.begin(), intervals.end(), [](const std::pair<T, uint16_t>& a, const std::pair<T, uint16_t>& b) { return a.second < b.second; });
 }
 
 template<typename T>
@@ -120,22 +158,48 @@ bool QuadStack<T>::loadCube(RegularGrid* voxelization)
 		_depth = voxelizationSize.z;
 		if (!_width or !_height or !_depth) return false;
 
-		//printf("Size is %dx%dx%d\n", _width, _height, _depth);
+		// Columns are contiguous in the grid, so runs along z are counted first and then written in place
+		const RegularGrid::CellGrid* grid = voxelization->data();
+		_columnOffsets.assign(static_cast<size_t>(_width) * _height + 1, 0);
+
+		#pragma omp parallel for
+		for (int x = 0; x < _width; ++x)
+		{
+			for (uint16_t y = 0; y < _height; ++y)
+			{
+				const RegularGrid::CellGrid* column = grid + RegularGrid::getPositionIndex(x, y, 0, voxelizationSize);
+				uint32_t numRuns = 1;
+
+				for (uint16_t z = 1; z < _depth; ++z)
+					numRuns += static_cast<uint32_t>(column[z]._value != column[z - 1]._value);
+
+				_columnOffsets[this->flattenIndex(x, y) + 1] = numRuns;
+			}
+		}
 
-		static std::vector<std::vector<std::vector<T>>> materialMatrix;
-		voxelization->getData<T>(materialMatrix);
+		std::inclusive_scan(_columnOffsets.begin(), _columnOffsets.end(), _columnOffsets.begin());
+		_columns.resize(_columnOffsets.back());
 
-		_gStacks.resize(_width);
-		for (int w = 0; w < _width; ++w)
+		#pragma omp parallel for
+		for (int x = 0; x < _width; ++x)
 		{
-			_gStacks[w].resize(_height);
-			#pragma omp parallel for
-			for (int h = 0; h < _height; ++h)
+			for (uint16_t y = 0; y < _height; ++y)
 			{
-				_gStacks[w][h].loadMaterials(materialMatrix[w][h]);
+				const RegularGrid::CellGrid* column = grid + RegularGrid::getPositionIndex(x, y, 0, voxelizationSize);
+				ColumnInterval* run = &_columns[_columnOffsets[this->flattenIndex(x, y)]];
+
+				for (uint16_t z = 1; z < _depth; ++z)
+					if (column[z]._value != column[z - 1]._value)
+						*run++ = ColumnInterval{ static_cast<T>(column[z - 1]._value), z };
+
+				*run = ColumnInterval{ static_cast<T>(column[_depth - 1]._value), _depth };
 			}
 		}
 
+		_nodes.clear();
+		_intervals.clear();
+		_heightfields.clear();
+
 		return true;
 	}
 
@@ -145,35 +209,103 @@ bool QuadStack<T>::loadCube(RegularGrid* voxelization)
 template<typename T>
 inline bool QuadStack<T>::openCheckpoint(const std::string& filename)
 {
-	//std::ifstream fin(filename, std::ios::in | std::ios::binary);
-	//if (!fin.is_open())
-	//{
-	//    return false;
-	//}
+	std::ifstream fin(filename, std::ios::in | std::ios::binary);
+	if (!fin.is_open())
+	    return false;
+
+	bool success = this->openCheckpoint(fin);
+	fin.close();
+
+	return success;
+}
+
+template<typename T>
+inline bool QuadStack<T>::openCheckpoint(std::istream& fin)
+{
+	size_t tSize, numNodes;
+	fin.read((char*)&tSize, sizeof(size_t));
+	if (!fin or tSize != sizeof(T)) return false;
+
+	fin.read((char*)&_width, sizeof(uint16_t));
+	fin.read((char*)&_height, sizeof(uint16_t));
+	fin.read((char*)&_depth, sizeof(uint16_t));
+	fin.read((char*)&numNodes, sizeof(size_t));
+	if (!fin or !_width or !_height or !_depth) return false;
+
+	_columnOffsets.clear();
+	_columns.clear();
+	_nodes.clear();
+	_intervals.clear();
+	_heightfields.clear();
+	this->createNode(0, _width, 0, _height);
+
+	// The end of the stream bounds the intervals of every node, unless the stream cannot be sought
+	const std::streampos nodesBegin = fin.tellg();
+	std::streampos streamEnd = -1;
+	if (nodesBegin != std::streampos(-1) and fin.seekg(0, std::ios::end))
+	{
+		streamEnd = fin.tellg();
+		fin.seekg(nodesBegin);
+	}
+	fin.clear();
+
+	// Only nodes with intervals are stored; the quadtree nodes between them are rebuilt from their bounds
+	bool validNodes = true;
 
-	//size_t newSize;
-	//const size_t tSize = sizeof(T);
-	//fin.read((char*)&newSize, sizeof(size_t));
-	//if (tSize != newSize) return false;
+	for (size_t nodeIdx = 0; nodeIdx < numNodes and fin and validNodes; ++nodeIdx)
+	{
+		size_t numIntervals;
+		uvec2 maxPoints, minPoints;
+		fin.read((char*)&numIntervals, sizeof(size_t));
+		fin.read((char*)&maxPoints, sizeof(glm::uvec2));
+		fin.read((char*)&minPoints, sizeof(glm::uvec2));
+
+		uint32_t gStack = GStack<T>::NONE;
+		if (fin and minPoints.x < maxPoints.x and minPoints.y < maxPoints.y and maxPoints.x <= _width and maxPoints.y <= _height)
+			gStack = this->findNode(minPoints, maxPoints);
+
+		if (gStack == GStack<T>::NONE or _nodes[gStack]._numIntervals)
+		{
+			validNodes = false;
+			break;
+		}
 
-	//fin.read((char*)&_width, sizeof(uint16_t));
-	//fin.read((char*)&_height, sizeof(uint16_t));
-	//fin.read((char*)&_depth, sizeof(uint16_t));
+		// Heightfield sizes are also stored as bytes, but wide nodes overflow them, hence node bounds are used instead
+		const uint32_t numColumns = _nodes[gStack].getNumColumns();
+		_nodes[gStack]._firstInterval = static_cast<uint32_t>(_intervals.size());
 
-	//const size_t numCells = _width * _height * _depth;
+		// Intervals of a node do not overlap along the depth, and all of them must be within the stream
+		const size_t intervalSize = 2 * sizeof(uint8_t) + sizeof(T) + numColumns * sizeof(uint16_t);
+		if (numIntervals > _depth or (streamEnd != std::streampos(-1) and numIntervals * intervalSize > static_cast<size_t>(streamEnd - fin.tellg())))
+		{
+			validNodes = false;
+			break;
+		}
+
+		for (size_t interval = 0; interval < numIntervals and fin; ++interval)
+		{
+			uint8_t lengthWidth, lengthHeight;
+			T value;
 
-	//if (_cube) delete[] _cube;
-	//_cube = new T[numCells];
-	//fin.read((char*)&_cube[0], numCells * tSize);
+			fin.read((char*)&lengthWidth, sizeof(uint8_t));
+			fin.read((char*)&lengthHeight, sizeof(uint8_t));
+			fin.read((char*)&value, sizeof(T));
 
-	//if (_indices) delete[] _indices;
-	//_indices = new size_t[numCells];
-	//fin.read((char*)&_indices[0], numCells * sizeof(size_t));
+			_intervals.push_back(Interval{ value, static_cast<uint32_t>(_heightfields.size()) });
+			_heightfields.resize(_heightfields.size() + numColumns);
+			fin.read((char*)&_heightfields[_intervals.back()._heightfield], numColumns * sizeof(uint16_t));
+			++_nodes[gStack]._numIntervals;
+		}
+	}
 
-	//if (_colorLayer) delete[] _colorLayer;
-	//_colorLayer = new ColorLayers<T>[_width * _height];
+	if (!fin or !validNodes)
+	{
+		_nodes.clear();
+		_intervals.clear();
+		_heightfields.clear();
 
-	//fin.close();
+		return false;
+	}
 
 	return true;
 }
@@ -185,11 +317,15 @@ inline void QuadStack<T>::saveCheckpoint(const std::string& filename)
 	if (!fout.is_open())
 	    return;
 
-	const size_t numCells = _width * _height * _depth;
+	this->saveCheckpoint(fout);
+	fout.close();
+}
+
+template<typename T>
+inline void QuadStack<T>::saveCheckpoint(std::ostream& fout)
+{
 	const size_t tSize = sizeof(T);
-	std::vector<GStack<T>*> leaves;
-	this->getLeaves(_quadStack, leaves);
-	size_t numNodes = leaves.size();
+	size_t numNodes = std::count_if(_nodes.begin(), _nodes.end(), [](const GStack<T>& node) { return node._numIntervals > 0; });
 
 	fout.write((char*)&tSize, sizeof(size_t));
 	fout.write((char*)&_width, sizeof(uint16_t));
@@ -197,29 +333,61 @@ inline void QuadStack<T>::saveCheckpoint(const std::string& filename)
 	fout.write((char*)&_depth, sizeof(uint16_t));
 	fout.write((char*)&numNodes, sizeof(size_t));
 
-	for (GStack<T>* leaf : leaves)
+	// The arena is already in preorder
+	for (const GStack<T>& node : _nodes)
 	{
-		size_t numIntervals = leaf->getNumIntervals();
+		if (!node._numIntervals)
+			continue;
+
+		size_t numIntervals = node._numIntervals;
 		fout.write((char*)&numIntervals, sizeof(size_t));
-		fout.write((char*)&leaf->_maxPoints, sizeof(glm::uvec2));
-		fout.write((char*)&leaf->_minPoints, sizeof(glm::uvec2));
+		fout.write((char*)&node._maxPoints, sizeof(glm::uvec2));
+		fout.write((char*)&node._minPoints, sizeof(glm::uvec2));
 
-		for (size_t interval = 0; interval < numIntervals; ++interval)
-		{
-			uint8_t lengthWidth = leaf->_intervals[interval]._length.size();
-			uint8_t lengthHeight = leaf->_intervals[interval]._length[0].size();
+		uint8_t lengthWidth = static_cast<uint8_t>(node._maxPoints.x - node._minPoints.x);
+		uint8_t lengthHeight = static_cast<uint8_t>(node._maxPoints.y - node._minPoints.y);
 
+		for (uint32_t intervalIdx = node._firstInterval; intervalIdx < node._firstInterval + node._numIntervals; ++intervalIdx)
+		{
 			fout.write((char*)&lengthWidth, sizeof(uint8_t));
 			fout.write((char*)&lengthHeight, sizeof(uint8_t));
+			fout.write((char*)&_intervals[intervalIdx]._value, sizeof(T));
+			fout.write((char*)&_heightfields[_intervals[intervalIdx]._heightfield], node.getNumColumns() * sizeof(uint16_t));
+		}
+	}
+}
+
+template<typename T>
+bool QuadStack<T>::toRegularGrid(RegularGrid* voxelization) const
+{
+	const uvec3 numDivs = this->getNumSubdivisions();
+	if (_nodes.empty() or !voxelization or voxelization->getNumSubdivisions() != numDivs)
+		return false;
 
-			fout.write((char*)&leaf->_intervals[interval]._value, sizeof(T));
-			for (int x = 0; x < leaf->_intervals[interval]._length.size(); ++x)
-				for (int y = 0; y < leaf->_intervals[interval]._length[x].size(); ++y)
-					fout.write((char*)&leaf->_intervals[interval]._length[x][y], sizeof(uint16_t));
+	RegularGrid::CellGrid* grid = voxelization->data();
+
+	#pragma omp parallel for
+	for (int x = 0; x < _width; ++x)
+	{
+		std::vector<std::pair<T, uint16_t>> column;
+
+		for (uint16_t y = 0; y < _height; ++y)
+		{
+			this->getColumn(x, y, column);
+
+			uint16_t z = 0;
+			for (const std::pair<T, uint16_t>& interval : column)
+				for (; z < interval.second and z < _depth; ++z)
+					grid[RegularGrid::getPositionIndex(x, y, z, numDivs)]._value = static_cast<uint16_t>(interval.first);
+
+			for (; z < _depth; ++z)
+				grid[RegularGrid::getPositionIndex(x, y, z, numDivs)]._value = VOXEL_EMPTY;
 		}
 	}
 
-	fout.close();
+	voxelization->updateSSBO();
+
+	return true;
 }
 
 template<typename T>
@@ -233,6 +401,20 @@ bool QuadStack<T>::writeBand(const std::string& filename, uint16_t layer)
 	return true;
 }
 
+template<typename T>
+inline bool QuadStack<T>::areColumnsEqual(uint32_t column1, uint32_t column2) const
+{
+	const uint32_t numIntervals = _columnOffsets[column1 + 1] - _columnOffsets[column1];
+	if (numIntervals != _columnOffsets[column2 + 1] - _columnOffsets[column2])
+		return false;
+
+	for (uint32_t interval = 0; interval < numIntervals; ++interval)
+		if (_columns[_columnOffsets[column1] + interval]._value != _columns[_columnOffsets[column2] + interval]._value)
+			return false;
+
+	return true;
+}
+
 template<typename T>
 void QuadStack<T>::backgroundWriteImage(T* layer, const std::string& filename, const uint16_t width, const uint16_t height)
 {
@@ -250,157 +432,197 @@ void QuadStack<T>::backgroundWriteImage(T* layer, const std::string& filename, c
 template<typename T>
 inline void QuadStack<T>::buildQuadStack()
 {
-	_quadStack = this->createGStack(0, _width, 0, _height);
+	_nodes.clear();
+	_intervals.clear();
+	_heightfields.clear();
+
+	_nodes.reserve(static_cast<size_t>(_width) * _height / 2 + 1);
+	_intervals.reserve(_columns.size() / 2 + 1);
+	_heightfields.reserve(_columns.size());
 
-	this->recursiveSplitQuadtree(0, _width, 0, _height, _quadStack);
+	this->createNode(0, _width, 0, _height);
+	this->recursiveSplitQuadtree(0);
 }
 
 template<typename T>
-inline void QuadStack<T>::compressQuadStack(GStack<T>* root, uint16_t depth)
+inline void QuadStack<T>::compressQuadStack(uint32_t nodeIdx)
 {
-	if (!root->getNumChildren())
+	if (!_nodes[nodeIdx].getNumChildren())
 		return;
-	else
-	{
-		std::vector<GStack<T>*> children;
-		std::vector<GStack<T>*> newGStacks;
-		std::vector<GStack<T>*> temporalStacks;
-		uint32_t numIntervals = 0;
 
-		for (int x = 0; x < 2; ++x)
-		{
-			for (int y = 0; y < 2; ++y)
-			{
-				if (root->_children[x][y])
-				{
-					this->compressQuadStack(root->_children[x][y], depth + 1);
-					numIntervals += root->_children[x][y]->getNumIntervals();
-
-					children.push_back(root->_children[x][y]);
-					GStack<T>* gStack = new GStack<T>;
-					GStack<T>* tStack = new GStack<T>;
-					gStack->updateBoundaries(root->_children[x][y]);
-
-					newGStacks.push_back(gStack);
-					temporalStacks.push_back(tStack);
-				}
-			}
-		}
-
-		if (numIntervals)
-		{
-			uint16_t bestChoice = 0;
-			std::vector<uint16_t> iteratorCount(children.size(), 0);
+	for (int x = 0; x < 2; ++x)
+		for (int y = 0; y < 2; ++y)
+			if (_nodes[nodeIdx]._children[x][y] != GStack<T>::NONE)
+				this->compressQuadStack(_nodes[nodeIdx]._children[x][y]);
 
-			for (int layer = 0; layer < children[0]->getNumIntervals(); ++layer)
-			{
-				iteratorCount[0] = layer;
-				this->matchGS(children, newGStacks, temporalStacks, iteratorCount, 0);
-			}
-		}
-	}
+	this->mergeStacks(nodeIdx);
 }
 
 template<typename T>
-inline void QuadStack<T>::compressQuadStack(GStack<T>*& root, uint16_t depth, bool foo)
+inline void QuadStack<T>::createLeaf(uint32_t nodeIdx)
 {
-	if (!root or !root->getNumChildren())
-		return;
-	else
-	{
-		for (int x = 0; x < 2; ++x)
-			for (int y = 0; y < 2; ++y)
-				this->compressQuadStack(root->_children[x][y], depth + 1, foo);
+	GStack<T>& node = _nodes[nodeIdx];
+	const uint32_t firstColumn = this->flattenIndex(node._minPoints.x, node._minPoints.y);
+	const uint32_t numIntervals = _columnOffsets[firstColumn + 1] - _columnOffsets[firstColumn];
+	const uint32_t numColumns = node.getNumColumns();
+
+	node._firstInterval = static_cast<uint32_t>(_intervals.size());
+	node._numIntervals = numIntervals;
 
-		std::vector<GStack<T>*> children;
-		for (int x = 0; x < 2; ++x)
-			for (int y = 0; y < 2; ++y)
-				if (root->_children[x][y])
-					children.push_back(root->_children[x][y]);
+	for (uint32_t interval = 0; interval < numIntervals; ++interval)
+	{
+		const uint32_t heightfield = static_cast<uint32_t>(_heightfields.size());
+		_intervals.push_back(Interval{ _columns[_columnOffsets[firstColumn] + interval]._value, heightfield });
+		_heightfields.resize(_heightfields.size() + numColumns);
 
-		GStack<T>::mergeStacks(root, children);
+		for (uint16_t x = node._minPoints.x; x < node._maxPoints.x; ++x)
+			for (uint16_t y = node._minPoints.y; y < node._maxPoints.y; ++y)
+				_heightfields[heightfield + node.getColumnIndex(x, y)] = _columns[_columnOffsets[this->flattenIndex(x, y)] + interval]._end;
 	}
 }
 
 template<typename T>
-inline GStack<T>* QuadStack<T>::createGStack(uint16_t x_start, uint16_t x_end, uint16_t y_start, uint16_t y_end, bool leafNode, GStack<T>* node)
+inline uint32_t QuadStack<T>::createNode(uint16_t x_start, uint16_t x_end, uint16_t y_start, uint16_t y_end)
+{
+	_nodes.emplace_back(x_start, x_end, y_start, y_end);
+
+	return static_cast<uint32_t>(_nodes.size() - 1);
+}
+
+template<typename T>
+inline uint32_t QuadStack<T>::findNode(const uvec2& minPoint, const uvec2& maxPoint)
 {
-	GStack<T>* gStack = (node != nullptr) ? node : new GStack<T>;
-	gStack->updateBoundaries(x_start, y_start, x_end, y_end);
+	uint32_t nodeIdx = 0;
 
-	if (leafNode)
+	// Follows the same splits as recursiveSplitQuadtree, creating the missing nodes on the way
+	while (_nodes[nodeIdx]._minPoints != minPoint or _nodes[nodeIdx]._maxPoints != maxPoint)
 	{
-		size_t numIntervals = _gStacks[x_start][y_start].getNumLayers();
-		std::vector<std::vector<uint16_t>> matrix(x_end - x_start, std::vector<uint16_t>(y_end - y_start, 0));
+		const uvec2 nodeMin = _nodes[nodeIdx]._minPoints, nodeMax = _nodes[nodeIdx]._maxPoints;
+		const uint32_t size_x = nodeMax.x - nodeMin.x, endIndex_x = (size_x + 1) / 2;
+		const uint32_t size_y = nodeMax.y - nodeMin.y, endIndex_y = (size_y + 1) / 2;
+		const int childX = minPoint.x >= nodeMin.x + endIndex_x, childY = minPoint.y >= nodeMin.y + endIndex_y;
 
-		for (size_t layer = 0; layer < numIntervals; ++layer)
-		{
-			for (uint16_t x = x_start; x < x_end; ++x)
-			{
-				for (uint16_t y = y_start; y < y_end; ++y)
-				{
-					matrix[x - x_start][y - y_start] += _gStacks[x][y].getLength(layer);
-				}
-			}
+		if ((size_x <= 1 and size_y <= 1) or (childX and size_x <= 1) or (childY and size_y <= 1))
+			return GStack<T>::NONE;
 
-			gStack->createInterval(_gStacks[x_start][y_start].getValue(layer), matrix);
+		if (_nodes[nodeIdx]._children[childX][childY] == GStack<T>::NONE)
+		{
+			const uint32_t child = this->createNode(
+				childX ? nodeMin.x + endIndex_x : nodeMin.x, childX ? nodeMax.x : nodeMin.x + endIndex_x,
+				childY ? nodeMin.y + endIndex_y : nodeMin.y, childY ? nodeMax.y : nodeMin.y + endIndex_y);
+			_nodes[nodeIdx]._children[childX][childY] = child;
 		}
+
+		nodeIdx = _nodes[nodeIdx]._children[childX][childY];
 	}
 
-	return gStack;
+	return nodeIdx;
 }
 
 template<typename T>
-inline uint32_t QuadStack<T>::flattenIndex(uint16_t x, uint16_t y)
+inline uint32_t QuadStack<T>::flattenIndex(uint16_t x, uint16_t y) const
 {
-	return y * _width + x;
+	return x * _height + y;
 }
 
 template<typename T>
-uint32_t QuadStack<T>::flattenIndex(uint16_t x, uint16_t y, uint16_t z)
+uint32_t QuadStack<T>::flattenIndex(uint16_t x, uint16_t y, uint16_t z) const
 {
 	return z * _width * _height + y * _width + x;
 }
 
 template<typename T>
-inline std::vector<std::vector<GStack<T>>> QuadStack<T>::matchGS(GStack<T>* root, std::vector<std::vector<uint8_t>>& iteratorCount, std::vector<std::vector<uint8_t>>& numLayers, float& scBest)
+inline uint32_t QuadStack<T>::getChild(uint32_t nodeIdx, uint16_t x, uint16_t y) const
 {
-	std::vector<std::vector<GStack<T>>> g = std::vector<std::vector<GStack<T>>>(2, std::vector<GStack<T>>(2));
+	for (int childX = 0; childX < 2; ++childX)
+		for (int childY = 0; childY < 2; ++childY)
+		{
+			const uint32_t child = _nodes[nodeIdx]._children[childX][childY];
+			if (child != GStack<T>::NONE and _nodes[child].contains(x, y))
+				return child;
+		}
 
-	for (std::vector<GStack<T>>& stackArray : g)
+	return GStack<T>::NONE;
+}
+
+template<typename T>
+inline void QuadStack<T>::mergeStacks(uint32_t nodeIdx)
+{
+	std::vector<uint32_t> children;
+	for (int x = 0; x < 2; ++x)
+		for (int y = 0; y < 2; ++y)
+			if (_nodes[nodeIdx]._children[x][y] != GStack<T>::NONE)
+				children.push_back(_nodes[nodeIdx]._children[x][y]);
+
+	// Intervals found at the same position in every child are moved into the parent, whose intervals are appended contiguously
+	const uint32_t numColumns = _nodes[nodeIdx].getNumColumns();
+	_nodes[nodeIdx]._firstInterval = static_cast<uint32_t>(_intervals.size());
+	_nodes[nodeIdx]._numIntervals = 0;
+	uint32_t layer = 0;
+
+	while (std::all_of(children.begin(), children.end(), [&](uint32_t child) { return _nodes[child]._numIntervals > layer; }))
 	{
-		for (GStack<T>& gStack : stackArray)
+		const T value = _intervals[_nodes[children[0]]._firstInterval + layer]._value;
+		bool same = true;
+
+		for (size_t childIdx = 1; childIdx < children.size() and same; ++childIdx)
+			same = _intervals[_nodes[children[childIdx]]._firstInterval + layer]._value == value;
+
+		if (!same)
 		{
-			gStack.addWildcardInterval();
+			++layer;
+			continue;
 		}
-	}
 
-	return g;
+		const uint32_t heightfield = static_cast<uint32_t>(_heightfields.size());
+		_heightfields.resize(_heightfields.size() + numColumns);
+
+		for (uint32_t child : children)
+		{
+			GStack<T>& childNode = _nodes[child];
+			const uint32_t childHeightfield = _intervals[childNode._firstInterval + layer]._heightfield;
+
+			for (uint16_t x = childNode._minPoints.x; x < childNode._maxPoints.x; ++x)
+				for (uint16_t y = childNode._minPoints.y; y < childNode._maxPoints.y; ++y)
+					_heightfields[heightfield + _nodes[nodeIdx].getColumnIndex(x, y)] = _heightfields[childHeightfield + childNode.getColumnIndex(x, y)];
+
+			// Children keep their remaining intervals contiguous; the orphaned heightfield stays in the pool until the next build
+			std::copy(_intervals.begin() + childNode._firstInterval + layer + 1, _intervals.begin() + childNode._firstInterval + childNode._numIntervals,
+				_intervals.begin() + childNode._firstInterval + layer);
+			--childNode._numIntervals;
+		}
+
+		_intervals.push_back(Interval{ value, heightfield });
+		++_nodes[nodeIdx]._numIntervals;
+	}
 }
 
 template<typename T>
-inline void QuadStack<T>::recursiveSplitQuadtree(uint16_t x_start, uint16_t x_end, uint16_t y_start, uint16_t y_end, GStack<T>* root)
+inline void QuadStack<T>::recursiveSplitQuadtree(uint32_t nodeIdx)
 {
+	const uvec2 minPoint = _nodes[nodeIdx]._minPoints, maxPoint = _nodes[nodeIdx]._maxPoints;
+	const uint16_t x_start = minPoint.x, x_end = maxPoint.x, y_start = minPoint.y, y_end = maxPoint.y;
+
 	if ((x_end - x_start) <= 1 and (y_end - y_start) <= 1)
 	{
-		this->createGStack(x_start, x_end, y_start, y_end, true, root);
+		this->createLeaf(nodeIdx);
 		return;
 	}
 
 	bool areIdentical = true;
-	GStack<T>* firstStack = &_gStacks[x_start][y_start];
+	const uint32_t firstColumn = this->flattenIndex(x_start, y_start);
 
 	for (uint16_t x = x_start; x < x_end and areIdentical; ++x)
 	{
 		for (uint16_t y = y_start; y < y_end and areIdentical; ++y)
 		{
-			areIdentical &= firstStack->operator==(_gStacks[x][y]);
+			areIdentical &= this->areColumnsEqual(firstColumn, this->flattenIndex(x, y));
 		}
 	}
 
 	if (areIdentical)
 	{
-		this->createGStack(x_start, x_end, y_start, y_end, true, root);
+		this->createLeaf(nodeIdx);
 		return;
 	}
 	else
@@ -408,27 +630,32 @@ inline void QuadStack<T>::recursiveSplitQuadtree(uint16_t x_start, uint16_t x_en
 		size_t size_x = x_end - x_start, endIndex_x = (size_x + 1) / 2;
 		size_t size_y = y_end - y_start, endIndex_y = (size_y + 1) / 2;
 
+		// Children are created right before their own subtree, which keeps the arena in preorder
 		{
-			root->_children[0][0] = this->createGStack(x_start, x_start + endIndex_x, y_start, y_start + endIndex_y);
-			this->recursiveSplitQuadtree(x_start, x_start + endIndex_x, y_start, y_start + endIndex_y, root->_children[0][0]);
+			const uint32_t child = this->createNode(x_start, x_start + endIndex_x, y_start, y_start + endIndex_y);
+			_nodes[nodeIdx]._children[0][0] = child;
+			this->recursiveSplitQuadtree(child);
 		}
 
 		if (size_y > 1)
 		{
-			root->_children[0][1] = this->createGStack(x_start, x_start + endIndex_x, y_start + endIndex_y, y_end);
-			this->recursiveSplitQuadtree(x_start, x_start + endIndex_x, y_start + endIndex_y, y_end, root->_children[0][1]);
+			const uint32_t child = this->createNode(x_start, x_start + endIndex_x, y_start + endIndex_y, y_end);
+			_nodes[nodeIdx]._children[0][1] = child;
+			this->recursiveSplitQuadtree(child);
 		}
 
 		if (size_x > 1)
 		{
-			root->_children[1][0] = this->createGStack(x_start + endIndex_x, x_end, y_start, y_start + endIndex_y);
-			this->recursiveSplitQuadtree(x_start + endIndex_x, x_end, y_start, y_start + endIndex_y, root->_children[1][0]);
+			const uint32_t child = this->createNode(x_start + endIndex_x, x_end, y_start, y_start + endIndex_y);
+			_nodes[nodeIdx]._children[1][0] = child;
+			this->recursiveSplitQuadtree(child);
 		}
 
 		if (size_x > 1 and size_y > 1)
 		{
-			root->_children[1][1] = this->createGStack(x_start + endIndex_x, x_end, y_start + endIndex_y, y_end);
-			this->recursiveSplitQuadtree(x_start + endIndex_x, x_end, y_start + endIndex_y, y_end, root->_children[1][1]);
+			const uint32_t child = this->createNode(x_start + endIndex_x, x_end, y_start + endIndex_y, y_end);
+			_nodes[nodeIdx]._children[1][1] = child;
+			this->recursiveSplitQuadtree(child);
 		}
 	}
-}
\ No newline at end of file
+}
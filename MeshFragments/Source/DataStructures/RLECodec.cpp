@@ -0,0 +1,249 @@
+#include "stdafx.h"
+#include "RLECodec.h"
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define RLE_SSE2
+#endif
+
+// [Static members initialization]
+
+const char RLECodec::MAGIC[4] = { 'R', 'L', 'E', 'G' };
+const uint16_t RLECodec::VERSION = 2;
+const size_t RLECodec::ALIGNMENT = 8;
+
+static_assert(sizeof(RLECodec::Header) == 24, "Header must match the on-disk layout");
+static_assert(sizeof(RLECodec::Chunk) == 16, "Chunk must match the on-disk layout");
+
+/// [Reader]
+
+RLECodec::Reader::Reader() : _chunks(nullptr), _header{}
+{
+}
+
+bool RLECodec::Reader::decode(uint16_t* values) const
+{
+	if (!_chunks) return false;
+
+	const size_t sliceSize = static_cast<size_t>(_header._numDivs.y) * _header._numDivs.z;
+	bool success = true;
+
+	#pragma omp parallel for reduction(&&:success)
+	for (int x = 0; x < static_cast<int>(_header._numDivs.x); ++x)
+		if (!this->decodeSlice(x, values + x * sliceSize))
+			success = false;
+
+	return success;
+}
+
+bool RLECodec::Reader::decodeRegion(const uvec3& min, const uvec3& max, std::vector<uint16_t>& values) const
+{
+	if (!_chunks || glm::any(glm::greaterThan(max, _header._numDivs)) || glm::any(glm::greaterThanEqual(min, max)))
+		return false;
+
+	const uvec3 size = max - min;
+	values.resize(static_cast<size_t>(size.x) * size.y * size.z);
+	bool success = true;
+
+	#pragma omp parallel for reduction(&&:success)
+	for (int x = 0; x < static_cast<int>(size.x); ++x)
+		for (unsigned y = 0; y < size.y; ++y)
+			if (!this->decodeRow(min.x + x, min.y + y, min.z, max.z, values.data() + (static_cast<size_t>(x) * size.y + y) * size.z))
+				success = false;
+
+	return success;
+}
+
+bool RLECodec::Reader::decodeSlice(unsigned x, uint16_t* values) const
+{
+	if (!_chunks || x >= _header._numDivs.x) return false;
+
+	const Chunk& chunk = _chunks[x];
+	const uint8_t* data = _file.data() + chunk._offset + _header._numDivs.y * sizeof(RowIndex);
+	const uint32_t* lengths = reinterpret_cast<const uint32_t*>(data);
+	const uint16_t* runValues = reinterpret_cast<const uint16_t*>(data + chunk._numRuns * sizeof(uint32_t));
+	const size_t sliceSize = static_cast<size_t>(_header._numDivs.y) * _header._numDivs.z;
+	size_t position = 0;
+
+	for (uint32_t run = 0; run < chunk._numRuns; ++run)
+	{
+		if (position + lengths[run] > sliceSize) return false;
+
+		std::fill_n(values + position, lengths[run], runValues[run]);
+		position += lengths[run];
+	}
+
+	return position == sliceSize;
+}
+
+bool RLECodec::Reader::open(const std::string& filename)
+{
+	_chunks = nullptr;
+	if (!_file.open(filename) || _file.size() < sizeof(Header)) return false;
+
+	std::memcpy(&_header, _file.data(), sizeof(Header));
+	if (std::memcmp(_header._magic, MAGIC, sizeof(MAGIC)) != 0 || _header._version != VERSION || _header._numChunks != _header._numDivs.x)
+		return false;
+
+	if (sizeof(Header) + static_cast<size_t>(_header._numChunks) * sizeof(Chunk) > _file.size())
+		return false;
+
+	const Chunk* chunks = reinterpret_cast<const Chunk*>(_file.data() + sizeof(Header));
+	for (uint32_t chunkIdx = 0; chunkIdx < _header._numChunks; ++chunkIdx)
+	{
+		if (chunks[chunkIdx]._offset % ALIGNMENT != 0 || chunks[chunkIdx]._offset + getChunkSize(_header._numDivs.y, chunks[chunkIdx]._numRuns) > _file.size())
+			return false;
+	}
+
+	_chunks = chunks;
+
+	return true;
+}
+
+bool RLECodec::Reader::decodeRow(unsigned x, unsigned y, unsigned zmin, unsigned zmax, uint16_t* values) const
+{
+	const Chunk& chunk = _chunks[x];
+	const uint8_t* data = _file.data() + chunk._offset;
+	const RowIndex& row = reinterpret_cast<const RowIndex*>(data)[y];
+	const uint32_t* lengths = reinterpret_cast<const uint32_t*>(data + _header._numDivs.y * sizeof(RowIndex));
+	const uint16_t* runValues = reinterpret_cast<const uint16_t*>(data + _header._numDivs.y * sizeof(RowIndex) + chunk._numRuns * sizeof(uint32_t));
+
+	// The row index must point inside a run of the chunk, as the encoder never writes empty runs
+	if (zmax > _header._numDivs.z || row._run >= chunk._numRuns || row._skip >= lengths[row._run])
+		return false;
+
+	// Move to the run covering zmin
+	uint32_t run = row._run;
+	size_t skip = static_cast<size_t>(row._skip) + zmin;
+
+	while (run < chunk._numRuns && skip >= lengths[run])
+		skip -= lengths[run++];
+
+	// Runs may continue into the next rows, so only the part of each run that is left within [z, zmax) is written
+	for (unsigned z = zmin; z < zmax; ++run)
+	{
+		if (run >= chunk._numRuns || lengths[run] == 0) return false;
+
+		const size_t available = static_cast<size_t>(lengths[run]) - skip, remaining = zmax - z;
+		const unsigned count = static_cast<unsigned>(std::min(available, remaining));
+
+		std::fill_n(values + (z - zmin), count, runValues[run]);
+		z += count;
+		skip = 0;
+	}
+
+	return true;
+}
+
+/// [Public methods]
+
+bool RLECodec::write(std::ostream& stream, const uint16_t* values, const uvec3& numDivs)
+{
+	const size_t sliceSize = static_cast<size_t>(numDivs.y) * numDivs.z;
+	std::vector<std::vector<uint8_t>> slices(numDivs.x);
+	std::vector<uint32_t> numRuns(numDivs.x);
+
+	#pragma omp parallel for
+	for (int x = 0; x < static_cast<int>(numDivs.x); ++x)
+		numRuns[x] = encodeSlice(values + x * sliceSize, numDivs.y, numDivs.z, slices[x]);
+
+	Header header;
+	std::memcpy(header._magic, MAGIC, sizeof(MAGIC));
+	header._version = VERSION;
+	header._reserved = 0;
+	header._numDivs = numDivs;
+	header._numChunks = numDivs.x;
+
+	// Chunk table, with chunks placed right after it
+	std::vector<Chunk> chunks(numDivs.x);
+	size_t offset = sizeof(Header) + chunks.size() * sizeof(Chunk);
+	offset = (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+
+	for (unsigned x = 0; x < numDivs.x; ++x)
+	{
+		chunks[x] = Chunk{ offset, numRuns[x], 0 };
+		offset += slices[x].size();
+	}
+
+	std::vector<uint8_t> buffer(offset, 0);
+	std::memcpy(buffer.data(), &header, sizeof(Header));
+	if (!chunks.empty())
+		std::memcpy(buffer.data() + sizeof(Header), chunks.data(), chunks.size() * sizeof(Chunk));
+
+	#pragma omp parallel for
+	for (int x = 0; x < static_cast<int>(numDivs.x); ++x)
+		std::copy(slices[x].begin(), slices[x].end(), buffer.begin() + chunks[x]._offset);
+
+	stream.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+
+	return !stream.fail();
+}
+
+/// [Protected methods]
+
+uint32_t RLECodec::encodeSlice(const uint16_t* values, unsigned numRows, unsigned rowSize, std::vector<uint8_t>& chunk)
+{
+	std::vector<uint32_t> starts;
+	findRunStarts(values, numRows * rowSize, starts);
+
+	const uint32_t numRuns = static_cast<uint32_t>(starts.size());
+	chunk.assign(getChunkSize(numRows, numRuns), 0);
+
+	RowIndex* rows = reinterpret_cast<RowIndex*>(chunk.data());
+	uint32_t* lengths = reinterpret_cast<uint32_t*>(chunk.data() + numRows * sizeof(RowIndex));
+	uint16_t* runValues = reinterpret_cast<uint16_t*>(chunk.data() + numRows * sizeof(RowIndex) + numRuns * sizeof(uint32_t));
+
+	for (uint32_t run = 0; run < numRuns; ++run)
+	{
+		lengths[run] = (run + 1 < numRuns ? starts[run + 1] : numRows * rowSize) - starts[run];
+		runValues[run] = values[starts[run]];
+	}
+
+	uint32_t run = 0;
+	for (unsigned y = 0; y < numRows; ++y)
+	{
+		const uint32_t rowStart = y * rowSize;
+		while (run + 1 < numRuns && starts[run + 1] <= rowStart) ++run;
+
+		rows[y] = RowIndex{ run, rowStart - starts[run] };
+	}
+
+	return numRuns;
+}
+
+void RLECodec::findRunStarts(const uint16_t* values, unsigned size, std::vector<uint32_t>& starts)
+{
+	starts.clear();
+	if (size == 0) return;
+
+	starts.push_back(0);
+	unsigned idx = 1;
+
+#ifdef RLE_SSE2
+	// Compare eight voxels against their predecessors at once; each set bit pair of the mask is a run boundary
+	for (; idx + 8 <= size; idx += 8)
+	{
+		const __m128i current = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + idx));
+		const __m128i previous = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + idx - 1));
+		unsigned mask = ~static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi16(current, previous))) & 0xFFFF;
+
+		while (mask)
+		{
+			const int bit = std::countr_zero(mask);
+			starts.push_back(idx + bit / 2);
+			mask &= ~(3u << bit);
+		}
+	}
+#endif
+
+	for (; idx < size; ++idx)
+		if (values[idx] != values[idx - 1])
+			starts.push_back(idx);
+}
+
+size_t RLECodec::getChunkSize(unsigned numRows, uint32_t numRuns)
+{
+	const size_t size = numRows * sizeof(RowIndex) + numRuns * (sizeof(uint32_t) + sizeof(uint16_t));
+	return (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+}
+
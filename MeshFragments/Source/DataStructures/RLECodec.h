@@ -0,0 +1,119 @@
+#pragma once
+
+#include "Utilities/MemoryMappedFile.h"
+
+/**
+*	@brief Run-length codec for 16-bit voxel grids laid out as x * ny * nz + y * nz + z. Each x slice is an independent chunk, so that
+*	slices are encoded in parallel and any slice or region can be decoded without touching the rest of the file. Each chunk starts
+*	with a row index that locates the run covering the first voxel of every y row.
+*
+*	Layout: Header | Chunk[numChunks] | per chunk: RowIndex[ny] | lengths (uint32_t[numRuns]) | values (uint16_t[numRuns]) | padding.
+*/
+class RLECodec
+{
+public:
+	const static char		MAGIC[4];							//!< File signature
+	const static uint16_t	VERSION;							//!< Current version of the format
+	const static size_t		ALIGNMENT;							//!< Chunks start at multiples of this value
+
+	struct Header
+	{
+		char		_magic[4];
+		uint16_t	_version;
+		uint16_t	_reserved;
+		uvec3		_numDivs;									//!< Dimensions of the grid
+		uint32_t	_numChunks;									//!< One per x slice
+	};
+
+	struct Chunk
+	{
+		uint64_t	_offset;									//!< Offset of the chunk from the beginning of the file
+		uint32_t	_numRuns;
+		uint32_t	_reserved;
+	};
+
+	struct RowIndex
+	{
+		uint32_t	_run;										//!< Run covering the first voxel of the row
+		uint32_t	_skip;										//!< Voxels of that run belonging to previous rows
+	};
+
+	/**
+	*	@brief Random access to an encoded grid through a memory-mapped view of the file.
+	*/
+	class Reader
+	{
+	protected:
+		const Chunk*		_chunks;							//!< Chunk table of the mapped file
+		MemoryMappedFile	_file;								//!< Encoded grid
+		Header				_header;							//!< Copy of the file header
+
+	protected:
+		/**
+		*	@brief Decodes the voxels [zmin, zmax) of a row into values.
+		*	@return False if the chunk is corrupted.
+		*/
+		bool decodeRow(unsigned x, unsigned y, unsigned zmin, unsigned zmax, uint16_t* values) const;
+
+	public:
+		/**
+		*	@brief Constructor. A file must be opened before decoding.
+		*/
+		Reader();
+
+		/**
+		*	@brief Decodes the whole grid. Slices are decoded in parallel.
+		*	@param values Buffer with room for numDivs.x * numDivs.y * numDivs.z values.
+		*	@return Success of operation.
+		*/
+		bool decode(uint16_t* values) const;
+
+		/**
+		*	@brief Decodes the box [min, max) into values, which follows the same layout as the grid with the dimensions of the box.
+		*	@return Success of operation.
+		*/
+		bool decodeRegion(const uvec3& min, const uvec3& max, std::vector<uint16_t>& values) const;
+
+		/**
+		*	@brief Decodes a single x slice of ny * nz voxels.
+		*	@return Success of operation.
+		*/
+		bool decodeSlice(unsigned x, uint16_t* values) const;
+
+		/**
+		*	@return Dimensions of the encoded grid.
+		*/
+		uvec3 getNumSubdivisions() const { return _header._numDivs; }
+
+		/**
+		*	@brief Maps a file and validates its header and chunk table.
+		*	@return Success of operation.
+		*/
+		bool open(const std::string& filename);
+	};
+
+protected:
+	/**
+	*	@brief Encodes a slice of size voxels into chunk, starting with the row index.
+	*	@return Number of runs.
+	*/
+	static uint32_t encodeSlice(const uint16_t* values, unsigned numRows, unsigned rowSize, std::vector<uint8_t>& chunk);
+
+	/**
+	*	@brief Finds the beginning of each run within values. The first run always starts at 0.
+	*/
+	static void findRunStarts(const uint16_t* values, unsigned size, std::vector<uint32_t>& starts);
+
+	/**
+	*	@return Bytes of a chunk with the given number of runs, including padding.
+	*/
+	static size_t getChunkSize(unsigned numRows, uint32_t numRuns);
+
+public:
+	/**
+	*	@brief Encodes a grid and writes it with a single call.
+	*	@return Success of operation.
+	*/
+	static bool write(std::ostream& stream, const uint16_t* values, const uvec3& numDivs);
+};
+
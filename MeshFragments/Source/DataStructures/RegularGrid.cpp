@@ -8,13 +8,22 @@
 #include "Graphics/Core/FragmentationProcedure.h"
 #include "Graphics/Core/MarchingCubes.h"
 #include "Graphics/Core/OpenGLUtilities.h"
+#include "Graphics/Core/ParityVoxelizer.h"
 #include "Graphics/Core/ShaderList.h"
+#include "Graphics/Core/SurfaceVoxelizer.h"
 #include "Graphics/Core/Tetravoxelizer.h"
 #include "Graphics/Core/Voronoi.h"
+#include "Graphics/Core/WindingNumberVoxelizer.h"
+#include "DataStructures/BlockGridCodec.h"
 #include "DataStructures/QuadStack.h"
+#include "DataStructures/RLECodec.h"
+#include "DataStructures/VoxGridWriter.h"
+#include "DataStructures/VoxelizationCache.h"
 #include "tinyply.h"
 #include "Utilities/ChronoUtilities.h"
-#include "VoxWriter.h"
+#include "Utilities/ExportContainer.h"
+
+static_assert(sizeof(RegularGrid::CellGrid) == sizeof(uint16_t), "Cells are encoded as plain 16-bit values");
 
 /// Public methods
 
@@ -158,57 +167,155 @@ void RegularGrid::erode(FractureParameters::ErosionType fractureParams, uint32_t
 	ComputeShader::deleteBuffers(std::vector<GLuint>{ maskSSBO, noiseSSBO });
 }
 
-void RegularGrid::exportGrid(const std::string& filename, bool squared, FractureParameters::ExportGrid exportType)
+bool RegularGrid::exportGrid(const std::string& filename, bool squared, FractureParameters::ExportGrid exportType, ExportContainer* container)
 {
-	if (exportType == FractureParameters::RLE)
-		this->exportRLE(filename + "." + FractureParameters::ExportGrid_STR[exportType]);
-	else if (exportType == FractureParameters::QUADSTACK)
-		this->exportQuadStack(filename + "." + FractureParameters::ExportGrid_STR[exportType]);
-	else if (exportType == FractureParameters::UNCOMPRESSED_BINARY)
-		this->exportRawCompressed(filename + "." + FractureParameters::ExportGrid_STR[exportType], squared);
-	else
-		this->exportVox(filename + "." + FractureParameters::ExportGrid_STR[exportType], squared);
+	try
+	{
+		if (exportType == FractureParameters::LABEL_DELTA)
+			this->exportLabelDelta(filename, container);
+		else if (exportType == FractureParameters::RLE)
+			this->exportRLE(filename + "." + FractureParameters::ExportGrid_STR[exportType], container);
+		else if (exportType == FractureParameters::QUADSTACK)
+			this->exportQuadStack(filename + "." + FractureParameters::ExportGrid_STR[exportType], container);
+		else if (exportType == FractureParameters::UNCOMPRESSED_BINARY)
+			this->exportRawCompressed(filename + "." + FractureParameters::ExportGrid_STR[exportType], squared, container);
+		else
+			this->exportVox(filename + "." + FractureParameters::ExportGrid_STR[exportType], squared, container);
+	}
+	catch (const std::exception& exception)
+	{
+		std::cerr << "Export failed: " << exception.what() << std::endl;
+		return false;
+	}
+
+	return true;
 }
 
-void RegularGrid::fill(Model3D* model)
+void RegularGrid::fill(Model3D* model, const FractureParameters& fractParameters)
 {
+	const FractureParameters::VoxelizationMethod method = static_cast<FractureParameters::VoxelizationMethod>(fractParameters._voxelizationMethod);
 	bool activeVoxels = false;
-	Tetravoxelizer tetravoxelizer;
-	tetravoxelizer.initialize(_numDivs);
 
-	for (Model3D::ModelComponent* modelComponent: model->getModelComponents())
+	uint64_t cacheKey = 0;
+	std::string cacheFilename;
+	GridLabelDelta::Occupancy occupancy;
+
+	if (fractParameters._cacheVoxelization)
 	{
-		tetravoxelizer.initializeModel(modelComponent->_geometry, modelComponent->_topology, _aabb);
-		tetravoxelizer.compute(_voxelOpenGL);
-		tetravoxelizer.deleteModelResources();
+		cacheKey = VoxelizationCache::computeKey(model, _aabb, _numDivs, fractParameters);
+		cacheFilename = VoxelizationCache::getFilename(cacheKey);
 
-		#pragma omp parallel for
-		for (int y = 0; y < _numDivs.y; ++y)
+		if (VoxelizationCache::read(cacheFilename, cacheKey, _aabb, _numDivs, occupancy))
+		{
+			size_t voxel = 0;
+			bool occupied = false;
+
+			for (uint32_t run : occupancy._runs)
+			{
+				if (occupied)
+					for (size_t idx = voxel; idx < voxel + run; ++idx)
+						_grid[idx]._value = VOXEL_FREE;
+
+				voxel += run;
+				occupied = !occupied;
+			}
+
+			this->updateSSBO();
+			_labelOccupancy = GridLabelDelta::Occupancy();
+
+			return;
+		}
+	}
+
+	if (method != FractureParameters::GPU_TETRAHEDRA)
+	{
+		const size_t sliceSize = static_cast<size_t>(_numDivs.y) * _numDivs.z;
+
+		// CPU voxelizers share the layout of the grid
+		const auto markInside = [this, sliceSize, &activeVoxels]()
+			{
+				bool marked = false;
+
+				#pragma omp parallel for reduction(||:marked)
+				for (int x = 0; x < static_cast<int>(_numDivs.x); ++x)
+				{
+					for (size_t idx = x * sliceSize; idx < (x + 1) * sliceSize; ++idx)
+					{
+						if (_voxelOpenGL[idx])
+						{
+							_grid[idx]._value = VOXEL_FREE;
+							marked = true;
+						}
+					}
+				}
+
+				activeVoxels = activeVoxels || marked;
+			};
+
+		if (method == FractureParameters::CPU_WINDING_NUMBER)
+		{
+			// The winding number is evaluated over the triangles of every component at once
+			const TriangleBvh bvh(model);
+			WindingNumberVoxelizer::voxelize(bvh, _aabb, _numDivs, fractParameters._windingNumberAccuracy, _voxelOpenGL.data());
+			markInside();
+		}
+		else
+		{
+			for (Model3D::ModelComponent* modelComponent : model->getModelComponents())
+			{
+				ParityVoxelizer::voxelize(modelComponent->_geometry, modelComponent->_topology, _aabb, _numDivs, _voxelOpenGL.data());
+				markInside();
+			}
+		}
+	}
+	else
+	{
+		Tetravoxelizer tetravoxelizer;
+		tetravoxelizer.initialize(_numDivs);
+
+		for (Model3D::ModelComponent* modelComponent : model->getModelComponents())
 		{
-			glm::uint positionIndex;
-			for (int x = 0; x < _numDivs.x; ++x)
+			tetravoxelizer.initializeModel(modelComponent->_geometry, modelComponent->_topology, _aabb);
+			tetravoxelizer.compute(_voxelOpenGL);
+			tetravoxelizer.deleteModelResources();
+
+			#pragma omp parallel for reduction(||:activeVoxels)
+			for (int y = 0; y < _numDivs.y; ++y)
 			{
-				for (int z = 0; z < _numDivs.z; ++z)
+				glm::uint positionIndex;
+				for (int x = 0; x < _numDivs.x; ++x)
 				{
-					positionIndex = y * _numDivs.x * _numDivs.z + z * _numDivs.x + x;
-					if (_voxelOpenGL[positionIndex] == 1)
+					for (int z = 0; z < _numDivs.z; ++z)
 					{
-						this->set(x, y, z, VOXEL_FREE);
-						activeVoxels = true;
+						positionIndex = y * _numDivs.x * _numDivs.z + z * _numDivs.x + x;
+						if (_voxelOpenGL[positionIndex] == 1)
+						{
+							this->set(x, y, z, VOXEL_FREE);
+							activeVoxels = true;
+						}
 					}
 				}
 			}
 		}
+
+		tetravoxelizer.deleteResources();
 	}
 
-	tetravoxelizer.deleteResources();
 	this->updateSSBO();
+	_labelOccupancy = GridLabelDelta::Occupancy();
 
 	if (!activeVoxels)
 	{
-		this->fillNaive(model);
+		this->fillSurface(model, fractParameters._shellThickness);
 		this->updateSSBO();
 	}
+
+	if (fractParameters._cacheVoxelization)
+	{
+		GridLabelDelta::captureOccupancy(reinterpret_cast<const uint16_t*>(_grid.data()), _numDivs, occupancy);
+		if (!VoxelizationCache::write(cacheFilename, cacheKey, _aabb, occupancy))
+			std::cout << "Voxelization could not be cached in " << cacheFilename << std::endl;
+	}
 }
 
 void RegularGrid::fill(const Voronoi& voronoi)
@@ -270,6 +377,72 @@ uvec3 RegularGrid::getClosestEntryVoxel(const Model3D::RayGPUData& ray)
 	return this->rayTraversalAmanatidesWoo(ray);
 }
 
+std::vector<std::string> RegularGrid::getExportFilenames(const std::string& filename, FractureParameters::ExportGrid exportType)
+{
+	const std::string path = filename + "." + FractureParameters::ExportGrid_STR[exportType];
+	if (exportType != FractureParameters::VOX)
+		return { path };
+
+	std::vector<uint16_t> labels;
+	VoxGridWriter::collectLabels(reinterpret_cast<const uint16_t*>(_grid.data()), _numDivs, VOXEL_FREE + 1, labels);
+
+	const size_t numFiles = getNumVoxFiles(labels.size());
+	std::vector<std::string> filenames(numFiles);
+	for (size_t fileIdx = 0; fileIdx < numFiles; ++fileIdx)
+		filenames[fileIdx] = getVoxFilename(path, fileIdx, numFiles);
+
+	return filenames;
+}
+
+bool RegularGrid::importLabelDelta(const std::string& labelFilename)
+{
+	std::vector<uint16_t> grid;
+	uvec3 numDivs;
+	if (!GridLabelDelta::read(labelFilename, grid, numDivs)) return false;
+
+	this->resizeGrid(numDivs);
+	std::copy(grid.begin(), grid.end(), reinterpret_cast<uint16_t*>(_grid.data()));
+	this->updateSSBO();
+
+	return true;
+}
+
+bool RegularGrid::importRawCompressed(const std::string& filename)
+{
+	BlockGridCodec::Reader reader;
+	if (!reader.open(filename)) return false;
+
+	this->resizeGrid(reader.getNumSubdivisions());
+
+	if (!reader.decode(reinterpret_cast<uint16_t*>(_grid.data())))
+	{
+		this->cleanGrid();
+		return false;
+	}
+
+	this->updateSSBO();
+
+	return true;
+}
+
+bool RegularGrid::importRLE(const std::string& filename)
+{
+	RLECodec::Reader reader;
+	if (!reader.open(filename)) return false;
+
+	this->resizeGrid(reader.getNumSubdivisions());
+
+	if (!reader.decode(reinterpret_cast<uint16_t*>(_grid.data())))
+	{
+		this->cleanGrid();
+		return false;
+	}
+
+	this->updateSSBO();
+
+	return true;
+}
+
 void RegularGrid::insertPoint(const vec3& position, unsigned index)
 {
 	uvec3 gridIndex = getPositionIndex(position);
@@ -485,6 +658,12 @@ std::vector<Model3D*> RegularGrid::toTriangleMesh(FractureParameters& fractParam
 	return meshes;
 }
 
+void RegularGrid::traceRays(const std::vector<Model3D::RayGPUData>& rays, std::vector<GridRayTracer::RayHit>& hits, bool skipEmptySpace) const
+{
+	const GridRayTracer tracer(reinterpret_cast<const uint16_t*>(_grid.data()), _numDivs, _aabb, skipEmptySpace);
+	tracer.trace(rays, hits);
+}
+
 void RegularGrid::undoMask()
 {
 	uvec3 numDivs = this->getNumSubdivisions();
@@ -624,168 +803,99 @@ size_t RegularGrid::countValues(std::unordered_map<uint16_t, unsigned>& values)
 	return values.size();
 }
 
-void RegularGrid::exportRawCompressed(const std::string& filename, bool squared)
+void RegularGrid::exportRawCompressed(const std::string& filename, bool squared, ExportContainer* container)
 {
-	std::ofstream file(filename, std::ios::out | std::ios::binary);
-
-	if (file.is_open())
+	if (!squared)
 	{
-		if (!squared)
-		{
-			file.write(reinterpret_cast<char*>(&_numDivs), sizeof(glm::uvec3));
-			file.write(reinterpret_cast<char*>(&_grid), _numDivs.x * _numDivs.y * _numDivs.z * sizeof(uint16_t));
-		}
-		else
-		{
-			uvec3 end = _numDivs;
-			ivec3 currentPosition;
-			end.x = end.y = end.z = glm::max(end.x, glm::max(end.y, end.z));
-			uvec3 start = (end - _numDivs) / uvec3(2);
+		ExportContainer::write(container, filename, [this](std::ostream& file)
+			{
+				BlockGridCodec::write(file, reinterpret_cast<const uint16_t*>(_grid.data()), _numDivs);
+			});
 
-			file.write(reinterpret_cast<char*>(&end), sizeof(glm::uvec3));
+		return;
+	}
 
-			// Reset first
-			for (int x = 0; x < end.x; ++x)
-			{
-				for (int y = 0; y < end.y; ++y)
-				{
-					for (int z = 0; z < end.z; ++z)
-					{
-						currentPosition = ivec3(x, y, z) - ivec3(start);
+	// Centre the grid in a cube as large as its longest axis
+	const uvec3 end = uvec3(glm::max(_numDivs.x, glm::max(_numDivs.y, _numDivs.z)));
+	const uvec3 start = (end - _numDivs) / uvec3(2);
+	std::vector<uint16_t> cube(static_cast<size_t>(end.x) * end.y * end.z, VOXEL_EMPTY);
 
-						if (glm::all(glm::greaterThanEqual(currentPosition, ivec3(0))) && glm::all(glm::lessThan(currentPosition, ivec3(_numDivs))))
-							file.write(reinterpret_cast<char*>(&_grid[this->getPositionIndex(currentPosition.x, currentPosition.y, currentPosition.z)]), sizeof(uint16_t));
-						else
-						{
-							uint16_t empty = VOXEL_EMPTY;
-							file.write(reinterpret_cast<char*>(&empty), sizeof(uint16_t));
-						}
-					}
-				}
-			}
-		}
+	#pragma omp parallel for
+	for (int x = 0; x < static_cast<int>(_numDivs.x); ++x)
+	{
+		for (unsigned y = 0; y < _numDivs.y; ++y)
+		{
+			const CellGrid* row = _grid.data() + this->getPositionIndex(x, y, 0);
+			uint16_t* cubeRow = cube.data() + ((static_cast<size_t>(x) + start.x) * end.y + y + start.y) * end.z + start.z;
 
-		file.close();
+			for (unsigned z = 0; z < _numDivs.z; ++z)
+				cubeRow[z] = row[z]._value;
+		}
 	}
+
+	ExportContainer::write(container, filename, [&cube, end](std::ostream& file)
+		{
+			BlockGridCodec::write(file, cube.data(), end);
+		});
 }
 
-void RegularGrid::exportRLE(const std::string& filename)
+void RegularGrid::exportLabelDelta(const std::string& filename, ExportContainer* container)
 {
-	struct RLEData
-	{
-		uint16_t value;
-		uint32_t repetitions;
-	};
+	const uint16_t* grid = reinterpret_cast<const uint16_t*>(_grid.data());
+	const std::string labelFilename = filename + "." + FractureParameters::ExportGrid_STR[FractureParameters::LABEL_DELTA];
+	std::ostringstream labels(std::ios::out | std::ios::binary);
 
-	// Save in a binary file how many repetitions exist 
-	uint32_t size = _numDivs.x * _numDivs.y * _numDivs.z;
-	std::ofstream file(filename, std::ios::out | std::ios::binary);
-	std::vector<RLEData> rleData;
-
-	if (file.is_open())
+	if (_labelOccupancy.empty() || _labelOccupancy._numDivs != _numDivs || !GridLabelDelta::writeLabels(labels, grid, _labelOccupancy))
 	{
-		uint16_t value = std::numeric_limits<uint16_t>::max();
-		uint32_t repetitions = 0, idx = 0;
-
-		while (idx < size)
-		{
-			while (idx < size && _grid[idx]._value == value)
+		GridLabelDelta::captureOccupancy(grid, _numDivs, _labelOccupancy);
+		ExportContainer::write(container, GridLabelDelta::getOccupancyFilename(labelFilename, _labelOccupancy._checksum), [this](std::ostream& file)
 			{
-				++repetitions;
-				++idx;
-			}
+				GridLabelDelta::writeOccupancy(file, _labelOccupancy);
+			});
 
-			if (repetitions > 0)
-				rleData.push_back({ value, repetitions });
-
-			value = _grid[idx]._value;
-			repetitions = 0;
-		}
+		labels = std::ostringstream(std::ios::out | std::ios::binary);
+		GridLabelDelta::writeLabels(labels, grid, _labelOccupancy);
+	}
 
-		file.write(reinterpret_cast<char*>(&_numDivs), sizeof(glm::uvec3));
-		for (RLEData& data : rleData)
+	const std::string content = std::move(labels).str();
+	ExportContainer::write(container, labelFilename, [&content](std::ostream& file)
 		{
-			file.write(reinterpret_cast<char*>(&data.value), sizeof(uint16_t));
-			file.write(reinterpret_cast<char*>(&data.repetitions), sizeof(uint32_t));
-		}
+			file.write(content.data(), content.size());
+		});
+}
 
-		file.close();
-	}
+void RegularGrid::exportRLE(const std::string& filename, ExportContainer* container)
+{
+	ExportContainer::write(container, filename, [this](std::ostream& file)
+		{
+			RLECodec::write(file, reinterpret_cast<const uint16_t*>(_grid.data()), _numDivs);
+		});
 }
 
-void RegularGrid::exportQuadStack(const std::string& filename)
+void RegularGrid::exportQuadStack(const std::string& filename, ExportContainer* container)
 {
-	QuadStack<uint16_t>* quadStack = new QuadStack<uint16_t>();
+	const std::unique_ptr<QuadStack<uint16_t>> quadStack(new QuadStack<uint16_t>());
 	quadStack->loadCube(this);
-	quadStack->compress_y();
 	quadStack->compress_x();
 	//quadStack->calculateCompression();
-	quadStack->saveCheckpoint(filename);
-	delete quadStack;
+	ExportContainer::write(container, filename, [&quadStack](std::ostream& stream) { quadStack->saveCheckpoint(stream); });
 }
 
 void RegularGrid::exportUncompressed(const std::string& filename)
 {
-	std::ofstream file(filename, std::ios::out);
+	std::ofstream file(filename, std::ios::out | std::ios::binary);
 
 	if (file.is_open())
 	{
-		file.write(reinterpret_cast<char*>(&_numDivs), sizeof(glm::uvec3));
-		file.write(reinterpret_cast<char*>(&_grid), _numDivs.x * _numDivs.y * _numDivs.z * sizeof(uint16_t));
+		file.write(reinterpret_cast<const char*>(&_numDivs), sizeof(glm::uvec3));
+		file.write(reinterpret_cast<const char*>(_grid.data()), _grid.size() * sizeof(CellGrid));
 
 		file.close();
 	}
 }
 
-void RegularGrid::exportVox(const std::string& filename, bool squared)
+void RegularGrid::exportVox(const std::string& filename, bool squared, ExportContainer* container)
 {
-	vox::VoxWriter vox;
-	vox.ClearVoxels();
-	vox.ClearColors();
-
-	// Check if squared is required
-	if (squared)
-	{
-		uvec3 end = _numDivs;
-		ivec3 currentPosition;
-		end.x = end.y = end.z = glm::max(end.x, glm::max(end.y, end.z));
-		uvec3 start = (end - _numDivs) / uvec3(2);
-
-		// Reset first
-		for (int x = 0; x < end.x; ++x)
-		{
-			for (int y = 0; y < end.y; ++y)
-			{
-				for (int z = 0; z < end.z; ++z)
-				{
-					currentPosition = ivec3(x, y, z) - ivec3(start);
-
-					if (glm::all(glm::greaterThanEqual(currentPosition, ivec3(0))) && glm::all(glm::lessThan(currentPosition, ivec3(_numDivs))))
-						vox.AddVoxel(x, z, y, this->at(currentPosition.x, currentPosition.y, currentPosition.z));
-					else
-						vox.AddVoxel(x, z, y, VOXEL_EMPTY);
-				}
-			}
-		}
-	}
-	else
-	{
-		for (int x = 0; x < _numDivs.x; ++x)
-		{
-			unsigned positionIndex;
-
-			for (int y = 0; y < _numDivs.y; ++y)
-			{
-				for (int z = 0; z < _numDivs.z; ++z)
-				{
-					positionIndex = this->getPositionIndex(x, y, z);
-					if (_grid[positionIndex]._value > VOXEL_FREE)
-						vox.AddVoxel(x, z, y, _grid[positionIndex]._value - VOXEL_FREE);
-				}
-			}
-		}
-	}
-
 	// If path is empty then save in a file with random numbering
 	std::string filePath = filename;
 	if (filePath.empty())
@@ -793,24 +903,41 @@ void RegularGrid::exportVox(const std::string& filename, bool squared)
 	if (filePath.find(".vox") == std::string::npos)
 		filePath += std::to_string(RandomUtilities::getUniformRandomInt(0, 10e6)) + ".vox";
 
-	//vox.PrintStats();
-	vox.SaveToFile(filePath);
+	const uint16_t* values = reinterpret_cast<const uint16_t*>(_grid.data());
+	std::vector<uint16_t> labels;
+	VoxGridWriter::collectLabels(values, _numDivs, VOXEL_FREE + 1, labels);
+
+	// Palettes are limited, so fragments beyond them are written to additional files
+	const size_t numFiles = getNumVoxFiles(labels.size());
+
+	for (size_t fileIdx = 0; fileIdx < numFiles; ++fileIdx)
+	{
+		const auto firstLabel = labels.begin() + std::min(labels.size(), fileIdx * VoxGridWriter::MAX_PALETTE_SIZE);
+		const auto lastLabel = labels.begin() + std::min(labels.size(), (fileIdx + 1) * VoxGridWriter::MAX_PALETTE_SIZE);
+		const std::vector<uint16_t> fileLabels(firstLabel, lastLabel);
+		const std::string name = getVoxFilename(filePath, fileIdx, numFiles);
+
+		ExportContainer::write(container, name, [this, values, &fileLabels, squared](std::ostream& stream)
+			{
+				VoxGridWriter::write(stream, values, _numDivs, fileLabels, squared);
+			});
+	}
 }
 
-void RegularGrid::fillNaive(Model3D* model)
+void RegularGrid::fillSurface(Model3D* model, unsigned shellThickness)
 {
-	CADModel* cadModel = dynamic_cast<CADModel*>(model);
-	if (cadModel)
+	const size_t sliceSize = static_cast<size_t>(_numDivs.y) * _numDivs.z;
+
+	for (Model3D::ModelComponent* modelComponent : model->getModelComponents())
 	{
-		static const unsigned numVoxelizationSamples = cadModel->getAABB().volume() * 10000;
-		PointCloud3D* sampledPointCloud = cadModel->sampleCPU(numVoxelizationSamples, 0);
-		auto points = sampledPointCloud->getPoints();
+		SurfaceVoxelizer::voxelize(modelComponent->_geometry, modelComponent->_topology, _aabb, _numDivs, shellThickness, _voxelOpenGL.data());
 
 		#pragma omp parallel for
-		for (int idx = 0; idx < points->size(); ++idx)
+		for (int x = 0; x < static_cast<int>(_numDivs.x); ++x)
 		{
-			glm::uvec3 gridIndex = this->getPositionIndex(points->at(idx));
-			this->set(gridIndex.x, gridIndex.y, gridIndex.z, VOXEL_FREE);
+			for (size_t idx = x * sliceSize; idx < (x + 1) * sliceSize; ++idx)
+				if (_voxelOpenGL[idx])
+					_grid[idx]._value = VOXEL_FREE;
 		}
 	}
 }
@@ -828,6 +955,11 @@ void RegularGrid::getComputeShaders()
 	_undoMaskShader = ShaderList::getInstance()->getComputeShader(RendEnum::UNDO_MASK_SHADER);
 }
 
+size_t RegularGrid::getNumVoxFiles(size_t numLabels)
+{
+	return std::max(static_cast<size_t>(1), (numLabels + VoxGridWriter::MAX_PALETTE_SIZE - 1) / VoxGridWriter::MAX_PALETTE_SIZE);
+}
+
 uvec3 RegularGrid::getPositionIndex(const vec3& position)
 {
 	unsigned x = (position.x - _aabb.min().x) / _cellSize.x, y = (position.y - _aabb.min().y) / _cellSize.y, z = (position.z - _aabb.min().z) / _cellSize.z;
@@ -841,6 +973,11 @@ unsigned RegularGrid::getPositionIndex(int x, int y, int z) const
 	return x * _numDivs.y * _numDivs.z + y * _numDivs.z + z;
 }
 
+std::string RegularGrid::getVoxFilename(const std::string& filename, size_t fileIdx, size_t numFiles)
+{
+	return numFiles == 1 ? filename : filename.substr(0, filename.rfind(".vox")) + "_" + std::to_string(fileIdx) + ".vox";
+}
+
 unsigned RegularGrid::getVoxelCountEarlyExit() const
 {
 	for (const CellGrid& grid : _grid)
@@ -1023,6 +1160,18 @@ void RegularGrid::resetBuffer(GLuint ssbo, unsigned value, unsigned count) const
 	_resetCounterShader->execute(ComputeShader::getNumGroups(count), 1, 1, ComputeShader::getMaxGroupSize(), 1, 1);
 }
 
+void RegularGrid::resizeGrid(const uvec3& numDivs)
+{
+	if (numDivs == _numDivs)
+		return;
+
+	ComputeShader::deleteBuffers(std::vector<GLuint>{ _countSSBO, _ssbo });
+
+	_numDivs = numDivs;
+	if (glm::any(glm::notEqual(_cellSize, vec3(.0f)))) _cellSize = _aabb.size() / vec3(_numDivs);
+	this->buildGrid();
+}
+
 uint16_t RegularGrid::unmask(uint16_t value) const
 {
 	return value & uint16_t(~(1 << MASK_POSITION));
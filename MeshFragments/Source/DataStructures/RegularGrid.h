@@ -1,5 +1,7 @@
 #pragma once
 
+#include "DataStructures/GridLabelDelta.h"
+#include "DataStructures/GridRayTracer.h"
 #include "Graphics/Core/FractureParameters.h"
 #include "Graphics/Core/FragmentationProcedure.h"
 #include "Graphics/Core/Model3D.h"
@@ -8,6 +10,7 @@ class AABB;
 class MarchingCubes;
 class Texture;
 class Voronoi;
+class ExportContainer;
 
 #define VOXEL_EMPTY 0
 #define VOXEL_FREE 1
@@ -32,6 +35,7 @@ protected:
 	AABB						_aabb;					//!< Bounding box of the scene
 	vec3						_cellSize;				//!< Size of each grid cell
 	GLuint						_countSSBO;				//!< GPU buffer to save the number of occupied voxels per cell		
+	GridLabelDelta::Occupancy	_labelOccupancy;		//!< Occupancy that label exports refer to, captured after each voxelization
 	MarchingCubes*				_marchingCubes;			//!< Marching cubes algorithm
 	uvec3						_numDivs;				//!< Number of subdivisions of space between mininum and maximum point
 	GLuint						_ssbo;					//!< GPU buffer to save the grid
@@ -65,19 +69,25 @@ protected:
 	size_t countValues(std::unordered_map<uint16_t, unsigned>& values);
 
 	/**
-	*	@brief Exports the grid as a raw file.
+	*	@brief Exports the grid as a raw file split into independently compressed blocks (see BlockGridCodec).
+	*/
+	void exportRawCompressed(const std::string& filename, bool squared, ExportContainer* container);
+
+	/**
+	*	@brief Exports the labels of occupied voxels into a .vlbl file. The occupancy is written into a .vocc file named after its checksum
+	*	the first time after a voxelization, or whenever a non-empty voxel falls out of it.
 	*/
-	void exportRawCompressed(const std::string& filename, bool squared);
+	void exportLabelDelta(const std::string& filename, ExportContainer* container);
 
 	/**
-	*	@brief Exports the grid into a .rle file.
+	*	@brief Exports the grid into a .rle file, encoding each x slice as an independent chunk (see RLECodec).
 	*/
-	void exportRLE(const std::string& filename);
+	void exportRLE(const std::string& filename, ExportContainer* container);
 
 	/**
 	*	@brief Exports the grid into a .vox file.
 	*/
-	void exportQuadStack(const std::string& filename);
+	void exportQuadStack(const std::string& filename, ExportContainer* container);
 
 	/**
 	*	@brief Exports the grid as a raw file.
@@ -85,14 +95,25 @@ protected:
 	void exportUncompressed(const std::string& filename);
 
 	/**
-	*	@brief Exports the grid into a .vox file.
+	*	@brief Exports the grid into a .vox file, or into several ones named _0, _1... if its labels do not fit in a palette.
+	*/
+	void exportVox(const std::string& filename, bool squared, ExportContainer* container);
+
+	/**
+	*	@return Name of the fileIdx-th file of a .vox grid split into numFiles files.
 	*/
-	void exportVox(const std::string& filename, bool squared);
+	static std::string getVoxFilename(const std::string& filename, size_t fileIdx, size_t numFiles);
 
 	/**
-	*	@brief Fills the grid with the content of the model.
+	*	@return Number of .vox files needed to store a number of labels.
 	*/
-	void fillNaive(Model3D* model);
+	static size_t getNumVoxFiles(size_t numLabels);
+
+	/**
+	*	@brief Marks the voxels crossed by the surface of the model, which is the fallback for open meshes whose inside is empty.
+	*	@param shellThickness Voxels the surface is thickened by.
+	*/
+	void fillSurface(Model3D* model, unsigned shellThickness);
 
 	/**
 	*	@brief Retrieves compute shaders from the shader list.
@@ -134,6 +155,11 @@ protected:
 	*/
 	void resetBuffer(GLuint ssbo, unsigned value, unsigned count) const;
 
+	/**
+	*	@brief Rebuilds the grid with new dimensions, if they differ from the current ones. The content is not preserved.
+	*/
+	void resizeGrid(const uvec3& numDivs);
+
 	/**
 	*	@return
 	*/
@@ -182,14 +208,17 @@ public:
 	void erode(FractureParameters::ErosionType fractureParams, uint32_t convolutionSize, uint16_t numIterations, float erosionProbability, float erosionThreshold);
 
 	/**
-	*	@brief Exports fragments into several models in a PLY file.
+	*	@brief Exports fragments into several models in a PLY file. Grids are written synchronously, so write failures are reported here.
+	*	@return Success of operation.
 	*/
-	void exportGrid(const std::string& filename, bool squared = false, FractureParameters::ExportGrid exportType = FractureParameters::QUADSTACK);
+	bool exportGrid(const std::string& filename, bool squared = false, FractureParameters::ExportGrid exportType = FractureParameters::QUADSTACK, ExportContainer* container = nullptr);
 
 	/**
-	*	@brief
+	*	@brief Fills the voxels inside a model with VOXEL_FREE.
+	*	@param fractParameters Voxelization method and its settings, as well as the thickness of the surface voxelization used when no
+	*	voxel is found inside the model.
 	*/
-	void fill(Model3D* model);
+	void fill(Model3D* model, const FractureParameters& fractParameters);
 
 	/**
 	*	@brief
@@ -216,12 +245,36 @@ public:
 	*/
 	uvec3 getClosestEntryVoxel(const Model3D::RayGPUData& ray);
 
+	/**
+	*	@return Names of the files that exportGrid writes for the current content, in the order they are written.
+	*/
+	std::vector<std::string> getExportFilenames(const std::string& filename, FractureParameters::ExportGrid exportType);
+
 	/**
 	*	@brief Creates a new grid with the same content as the current one.
 	*/
 	template<typename T>
 	void getData(std::vector<std::vector<std::vector<T>>>& data);
 
+	/**
+	*	@brief Loads an iteration exported as labels over an occupancy, which is found next to the label file. The grid is resized if
+	*	they have different dimensions.
+	*	@return Success of operation.
+	*/
+	bool importLabelDelta(const std::string& labelFilename);
+
+	/**
+	*	@brief Loads a grid exported by exportRawCompressed. The grid is resized if the file has different dimensions.
+	*	@return Success of operation.
+	*/
+	bool importRawCompressed(const std::string& filename);
+
+	/**
+	*	@brief Loads a grid exported as .rle. The grid is resized if the file has different dimensions.
+	*	@return Success of operation.
+	*/
+	bool importRLE(const std::string& filename);
+
 	/**
 	*	@brief Inserts a new point in the grid.
 	*/
@@ -272,6 +325,13 @@ public:
 	*/
 	std::vector<Model3D*> toTriangleMesh(FractureParameters& fractParameters, std::vector<FragmentationProcedure::FragmentMetadata>& fragmentMetadata);
 
+	/**
+	*	@brief Finds the first non-empty voxel of a batch of rays on the CPU (see GridRayTracer). Batches traced over an unchanged grid
+	*	may rather share a GridRayTracer built over data(), as skipping empty space requires a pass over the whole grid.
+	*	@param skipEmptySpace Skips empty bricks of voxels, which pays off for sparse grids and long rays.
+	*/
+	void traceRays(const std::vector<Model3D::RayGPUData>& rays, std::vector<GridRayTracer::RayHit>& hits, bool skipEmptySpace = true) const;
+
 	/**
 	*	@brief Undo the detection of boundaries, thus removing the included mask.
 	*/
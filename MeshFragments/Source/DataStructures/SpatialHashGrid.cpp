@@ -0,0 +1,47 @@
+#include "stdafx.h"
+#include "SpatialHashGrid.h"
+
+/// [Public methods]
+
+SpatialHashGrid::SpatialHashGrid(const vec4* points, unsigned numPoints, float cellSize) :
+	_cellSize(cellSize), _numBuckets(1), _points(points)
+{
+	while (_numBuckets < numPoints * 2) _numBuckets <<= 1;
+
+	std::vector<unsigned> pointBucket(numPoints);
+	_bucketStart.resize(_numBuckets + 1, 0);
+	_pointIndex.resize(numPoints);
+
+	#pragma omp parallel for
+	for (int pointIdx = 0; pointIdx < numPoints; ++pointIdx)
+		pointBucket[pointIdx] = this->getBucket(this->getCell(vec3(points[pointIdx])));
+
+	// Counting sort of point indices by bucket
+	for (unsigned pointIdx = 0; pointIdx < numPoints; ++pointIdx)
+		++_bucketStart[pointBucket[pointIdx] + 1];
+
+	for (unsigned bucket = 0; bucket < _numBuckets; ++bucket)
+		_bucketStart[bucket + 1] += _bucketStart[bucket];
+
+	std::vector<unsigned> bucketOffset(_bucketStart.begin(), _bucketStart.end() - 1);
+	for (unsigned pointIdx = 0; pointIdx < numPoints; ++pointIdx)
+		_pointIndex[bucketOffset[pointBucket[pointIdx]]++] = pointIdx;
+}
+
+SpatialHashGrid::~SpatialHashGrid()
+{
+}
+
+/// [Protected methods]
+
+unsigned SpatialHashGrid::getBucket(const ivec3& cell) const
+{
+	const unsigned hash = (static_cast<unsigned>(cell.x) * 73856093u) ^ (static_cast<unsigned>(cell.y) * 19349663u) ^ (static_cast<unsigned>(cell.z) * 83492791u);
+
+	return hash & (_numBuckets - 1);
+}
+
+ivec3 SpatialHashGrid::getCell(const vec3& point) const
+{
+	return ivec3(glm::floor(point / _cellSize));
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+/**
+*	@brief Hashed uniform grid over a static set of points, used for fixed-radius neighbour queries.
+*	Points are bucketed by counting sort, so each bucket is a contiguous range of point indices.
+*/
+class SpatialHashGrid
+{
+protected:
+	float					_cellSize;				//!< Length of each cell edge
+	std::vector<unsigned>	_bucketStart;			//!< Start of each bucket in _pointIndex (numBuckets + 1 entries)
+	unsigned				_numBuckets;			//!< Power of two, so the hash can be masked
+	std::vector<unsigned>	_pointIndex;			//!< Point indices sorted by bucket
+	const vec4*				_points;				//!< Indexed points, not owned
+
+protected:
+	/**
+	*	@return Bucket of the cell with the given integer coordinates.
+	*/
+	unsigned getBucket(const ivec3& cell) const;
+
+	/**
+	*	@return Integer coordinates of the cell containing the point.
+	*/
+	ivec3 getCell(const vec3& point) const;
+
+public:
+	/**
+	*	@brief Builds the grid over numPoints points. The buffer must outlive the grid.
+	*/
+	SpatialHashGrid(const vec4* points, unsigned numPoints, float cellSize);
+
+	/**
+	*	@brief Destructor.
+	*/
+	virtual ~SpatialHashGrid();
+
+	/**
+	*	@brief Calls callback(index, distance2) for every point within radius of the given position, including the point itself if it belongs to the grid.
+	*	The radius must not be larger than the cell size.
+	*/
+	template<typename Callback>
+	void forEachNeighbour(const vec3& point, float radius, Callback callback) const;
+};
+
+template<typename Callback>
+inline void SpatialHashGrid::forEachNeighbour(const vec3& point, float radius, Callback callback) const
+{
+	// Only cells overlapping the bounding box of the query sphere are visited. As the radius is not larger than the cell size, the box
+	// spans at most three cells per axis, which is also enforced against rounding so that no more than 27 buckets are visited
+	assert(radius <= _cellSize);
+	const ivec3 minCell = this->getCell(point - vec3(radius)), maxCell = glm::min(this->getCell(point + vec3(radius)), minCell + ivec3(2));
+	const float radius2 = radius * radius;
+	unsigned visitedBuckets[27], numVisitedBuckets = 0;
+
+	for (int x = minCell.x; x <= maxCell.x; ++x)
+	{
+		for (int y = minCell.y; y <= maxCell.y; ++y)
+		{
+			for (int z = minCell.z; z <= maxCell.z; ++z)
+			{
+				const unsigned bucket = this->getBucket(ivec3(x, y, z));
+
+				// Different cells may share a bucket; each bucket must be traversed only once
+				if (std::find(visitedBuckets, visitedBuckets + numVisitedBuckets, bucket) != visitedBuckets + numVisitedBuckets) continue;
+				visitedBuckets[numVisitedBuckets++] = bucket;
+
+				for (unsigned idx = _bucketStart[bucket]; idx < _bucketStart[bucket + 1]; ++idx)
+				{
+					const unsigned pointIdx = _pointIndex[idx];
+					const float distance2 = glm::distance2(point, vec3(_points[pointIdx]));
+
+					if (distance2 <= radius2) callback(pointIdx, distance2);
+				}
+			}
+		}
+	}
+}
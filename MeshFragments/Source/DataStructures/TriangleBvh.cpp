@@ -0,0 +1,744 @@
+#include "stdafx.h"
+#include "TriangleBvh.h"
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <xmmintrin.h>
+#define BVH_SSE
+#endif
+
+// [Static members initialization]
+
+const int TriangleBvh::BIN_COUNT = 16;
+const unsigned TriangleBvh::MAX_LEAF_SIZE = 8;
+const int TriangleBvh::MAX_DEPTH = 64;
+const unsigned TriangleBvh::PARALLEL_BINNING_SIZE = 1 << 16;
+const float TriangleBvh::TRAVERSAL_COST = 1.0f;
+const int TriangleBvh::WIDTH = 4;
+
+/// [Public methods]
+
+TriangleBvh::TriangleBvh(Model3D* model)
+{
+	// Triangles of every component are gathered in a single list
+	std::vector<Model3D::ModelComponent*> modelComponents = model->getModelComponents();
+	std::vector<uint32_t> firstFace(modelComponents.size() + 1, 0);
+
+	for (size_t componentIdx = 0; componentIdx < modelComponents.size(); ++componentIdx)
+		firstFace[componentIdx + 1] = firstFace[componentIdx] + static_cast<uint32_t>(modelComponents[componentIdx]->_topology.size());
+
+	std::vector<Triangle> triangles(firstFace.back());
+	std::vector<Box> boxes(triangles.size());
+
+	for (size_t componentIdx = 0; componentIdx < modelComponents.size(); ++componentIdx)
+	{
+		const std::vector<Model3D::VertexGPUData>& vertices = modelComponents[componentIdx]->_geometry;
+		const std::vector<Model3D::FaceGPUData>& faces = modelComponents[componentIdx]->_topology;
+
+		#pragma omp parallel for
+		for (int faceIdx = 0; faceIdx < static_cast<int>(faces.size()); ++faceIdx)
+		{
+			const uint32_t triangleIdx = firstFace[componentIdx] + faceIdx;
+			Triangle& triangle = triangles[triangleIdx];
+
+			for (int vertexIdx = 0; vertexIdx < 3; ++vertexIdx)
+				triangle._vertices[vertexIdx] = vertices[faces[faceIdx]._vertices[vertexIdx]]._position;
+			triangle._primitive = Primitive{ static_cast<unsigned>(componentIdx), static_cast<unsigned>(faceIdx) };
+
+			boxes[triangleIdx]._min = glm::min(triangle._vertices[0], glm::min(triangle._vertices[1], triangle._vertices[2]));
+			boxes[triangleIdx]._max = glm::max(triangle._vertices[0], glm::max(triangle._vertices[1], triangle._vertices[2]));
+			boxes[triangleIdx]._triangle = triangleIdx;
+		}
+	}
+
+	if (triangles.empty())
+	{
+		// Boxes of empty slots are never hit, so queries over an empty root find nothing
+		_nodes.resize(1);
+		clear(_nodes[0]);
+
+		return;
+	}
+
+	for (size_t triangleIdx = 0; triangleIdx < triangles.size(); ++triangleIdx)
+		_aabb.update(AABB(boxes[triangleIdx]._min, boxes[triangleIdx]._max));
+
+	std::vector<BuildNode> buildNodes;
+	this->buildBinary(boxes, buildNodes);
+	this->collapse(buildNodes);
+
+	_triangles.resize(triangles.size());
+
+	#pragma omp parallel for
+	for (int triangleIdx = 0; triangleIdx < static_cast<int>(triangles.size()); ++triangleIdx)
+		_triangles[triangleIdx] = triangles[boxes[triangleIdx]._triangle];
+}
+
+TriangleBvh::~TriangleBvh()
+{
+}
+
+bool TriangleBvh::closestPoint(const vec3& point, float maxDistance, PointHit& hit) const
+{
+	struct Entry { uint32_t _node; float _distance2; };
+
+	Entry stack[WIDTH * MAX_DEPTH], children[WIDTH];
+	int stackSize = 0;
+	float bestDistance2 = maxDistance * maxDistance;
+	bool found = false;
+
+	stack[stackSize++] = Entry{ 0, .0f };
+
+	while (stackSize)
+	{
+		const Entry entry = stack[--stackSize];
+		if (entry._distance2 >= bestDistance2)
+			continue;
+
+		const Node& node = _nodes[entry._node];
+		float distances2[WIDTH];
+		int numChildren = 0;
+
+		distanceBoxes(node, point, distances2);
+
+		for (int childIdx = 0; childIdx < WIDTH; ++childIdx)
+		{
+			if (distances2[childIdx] >= bestDistance2)
+				continue;
+
+			if (!node._counts[childIdx])
+			{
+				children[numChildren++] = Entry{ node._children[childIdx], distances2[childIdx] };
+				continue;
+			}
+
+			for (uint32_t triangleIdx = node._children[childIdx]; triangleIdx < node._children[childIdx] + node._counts[childIdx]; ++triangleIdx)
+			{
+				const Triangle& triangle = _triangles[triangleIdx];
+				const vec3 surfacePoint = closestTrianglePoint(point, triangle._vertices[0], triangle._vertices[1], triangle._vertices[2]);
+				const float distance2 = glm::distance2(point, surfacePoint);
+
+				if (distance2 < bestDistance2)
+				{
+					bestDistance2 = distance2;
+					hit._point = surfacePoint;
+					hit._primitive = triangle._primitive;
+					found = true;
+				}
+			}
+		}
+
+		// Nearest children are popped first
+		std::sort(children, children + numChildren, [](const Entry& a, const Entry& b) { return a._distance2 > b._distance2; });
+		for (int childIdx = 0; childIdx < numChildren; ++childIdx)
+			stack[stackSize++] = children[childIdx];
+	}
+
+	if (found)
+		hit._distance = std::sqrt(bestDistance2);
+
+	return found;
+}
+
+bool TriangleBvh::intersect(const vec3& origin, const vec3& direction, float maxDistance, RayHit& hit) const
+{
+	struct Entry { uint32_t _node; float _distance; };
+
+	Entry stack[WIDTH * MAX_DEPTH], children[WIDTH];
+	int stackSize = 0;
+	const vec3 inverseDirection = 1.0f / direction;
+	bool found = false;
+
+	// Empty slots are only missed by rays of finite length
+	hit._distance = std::min(maxDistance, std::numeric_limits<float>::max());
+	stack[stackSize++] = Entry{ 0, .0f };
+
+	while (stackSize)
+	{
+		const Entry entry = stack[--stackSize];
+		if (entry._distance > hit._distance)
+			continue;
+
+		const Node& node = _nodes[entry._node];
+		float distances[WIDTH];
+		int numChildren = 0;
+		unsigned mask = intersectBoxes(node, origin, inverseDirection, hit._distance, distances);
+
+		while (mask)
+		{
+			const int childIdx = std::countr_zero(mask);
+			mask &= mask - 1;
+
+			if (!node._counts[childIdx])
+			{
+				children[numChildren++] = Entry{ node._children[childIdx], distances[childIdx] };
+				continue;
+			}
+
+			for (uint32_t triangleIdx = node._children[childIdx]; triangleIdx < node._children[childIdx] + node._counts[childIdx]; ++triangleIdx)
+				found |= intersectTriangle(_triangles[triangleIdx], origin, direction, hit);
+		}
+
+		// Nearest children are popped first
+		std::sort(children, children + numChildren, [](const Entry& a, const Entry& b) { return a._distance > b._distance; });
+		for (int childIdx = 0; childIdx < numChildren; ++childIdx)
+			stack[stackSize++] = children[childIdx];
+	}
+
+	return found;
+}
+
+void TriangleBvh::overlap(const AABB& aabb, std::vector<Primitive>& primitives) const
+{
+	const vec3 minPoint = aabb.min(), maxPoint = aabb.max(), centre = aabb.center(), halfSize = aabb.extent();
+	uint32_t stack[WIDTH * MAX_DEPTH];
+	int stackSize = 0;
+
+	stack[stackSize++] = 0;
+
+	while (stackSize)
+	{
+		const Node& node = _nodes[stack[--stackSize]];
+		unsigned mask = overlapBoxes(node, minPoint, maxPoint);
+
+		while (mask)
+		{
+			const int childIdx = std::countr_zero(mask);
+			mask &= mask - 1;
+
+			if (!node._counts[childIdx])
+			{
+				stack[stackSize++] = node._children[childIdx];
+				continue;
+			}
+
+			// Every triangle belongs to a single leaf
+			for (uint32_t triangleIdx = node._children[childIdx]; triangleIdx < node._children[childIdx] + node._counts[childIdx]; ++triangleIdx)
+				if (overlapTriangle(_triangles[triangleIdx], centre, halfSize))
+					primitives.push_back(_triangles[triangleIdx]._primitive);
+		}
+	}
+}
+
+/// [Protected methods]
+
+void TriangleBvh::buildBinary(std::vector<Box>& boxes, std::vector<BuildNode>& nodes)
+{
+	std::vector<uint32_t> level{ 0 }, nextLevel;
+	std::vector<Split> splits;
+	nodes.reserve(2 * boxes.size() / MAX_LEAF_SIZE + 1);
+	nodes.push_back(BuildNode{ _aabb.min(), _aabb.max(), 0, static_cast<uint32_t>(boxes.size()), 0 });
+
+	for (int depth = 0; !level.empty(); ++depth)
+	{
+		// Beyond half the maximum depth, median splits halve the nodes so that the rest of the depth is enough for 2^32 triangles
+		const bool medianSplit = depth >= MAX_DEPTH / 2;
+		splits.resize(level.size());
+
+		// Large nodes are binned by every thread, while the rest are split by a single thread each
+		for (size_t nodeIdx = 0; nodeIdx < level.size(); ++nodeIdx)
+		{
+			const BuildNode& node = nodes[level[nodeIdx]];
+			if (node._end - node._begin >= PARALLEL_BINNING_SIZE)
+				findSplit(node, medianSplit, true, boxes, splits[nodeIdx]);
+		}
+
+		#pragma omp parallel for schedule(dynamic)
+		for (int nodeIdx = 0; nodeIdx < static_cast<int>(level.size()); ++nodeIdx)
+		{
+			const BuildNode& node = nodes[level[nodeIdx]];
+			if (node._end - node._begin < PARALLEL_BINNING_SIZE)
+				findSplit(node, medianSplit, false, boxes, splits[nodeIdx]);
+		}
+
+		// Children of a level are appended in the same order as their parents
+		nextLevel.clear();
+		for (size_t nodeIdx = 0; nodeIdx < level.size(); ++nodeIdx)
+		{
+			const Split& split = splits[nodeIdx];
+			if (!split._middle)
+				continue;
+
+			const uint32_t begin = nodes[level[nodeIdx]]._begin, end = nodes[level[nodeIdx]]._end;
+			nodes[level[nodeIdx]]._children = static_cast<uint32_t>(nodes.size());
+			nextLevel.push_back(static_cast<uint32_t>(nodes.size()));
+			nextLevel.push_back(static_cast<uint32_t>(nodes.size() + 1));
+			nodes.push_back(BuildNode{ split._leftMin, split._leftMax, begin, split._middle, 0 });
+			nodes.push_back(BuildNode{ split._rightMin, split._rightMax, split._middle, end, 0 });
+		}
+
+		level.swap(nextLevel);
+	}
+}
+
+void TriangleBvh::collapse(const std::vector<BuildNode>& nodes)
+{
+	// Wide nodes are appended in breadth-first order, each one paired with the binary node it was collapsed from
+	std::vector<uint32_t> binaryNode{ 0 };
+	_nodes.clear();
+	_nodes.reserve(nodes.size() / 2 + 1);
+	_nodes.resize(1);
+
+	for (size_t wideIdx = 0; wideIdx < _nodes.size(); ++wideIdx)
+	{
+		const BuildNode& root = nodes[binaryNode[wideIdx]];
+		uint32_t slots[4];
+		int numSlots = 0;
+
+		if (!root._children)
+		{
+			// Only the root of a hierarchy with a single leaf
+			slots[numSlots++] = binaryNode[wideIdx];
+		}
+		else
+		{
+			slots[numSlots++] = root._children;
+			slots[numSlots++] = root._children + 1;
+
+			while (numSlots < WIDTH)
+			{
+				int largestSlot = -1;
+				float largestArea = -1.0f;
+
+				for (int slotIdx = 0; slotIdx < numSlots; ++slotIdx)
+				{
+					const BuildNode& child = nodes[slots[slotIdx]];
+					const float area = surfaceArea(child._min, child._max);
+
+					if (child._children && area > largestArea)
+					{
+						largestSlot = slotIdx;
+						largestArea = area;
+					}
+				}
+
+				if (largestSlot < 0)
+					break;
+
+				const uint32_t children = nodes[slots[largestSlot]]._children;
+				slots[largestSlot] = children;
+				slots[numSlots++] = children + 1;
+			}
+		}
+
+		Node node;
+		clear(node);
+
+		for (int slotIdx = 0; slotIdx < numSlots; ++slotIdx)
+		{
+			const BuildNode& child = nodes[slots[slotIdx]];
+
+			node._minX[slotIdx] = child._min.x; node._minY[slotIdx] = child._min.y; node._minZ[slotIdx] = child._min.z;
+			node._maxX[slotIdx] = child._max.x; node._maxY[slotIdx] = child._max.y; node._maxZ[slotIdx] = child._max.z;
+
+			if (child._children)
+			{
+				node._children[slotIdx] = static_cast<uint32_t>(_nodes.size());
+				binaryNode.push_back(slots[slotIdx]);
+				_nodes.emplace_back();
+			}
+			else
+			{
+				node._children[slotIdx] = child._begin;
+				node._counts[slotIdx] = child._end - child._begin;
+			}
+		}
+
+		_nodes[wideIdx] = node;
+	}
+}
+
+void TriangleBvh::findSplit(const BuildNode& node, bool medianSplit, bool parallel, std::vector<Box>& boxes, Split& split)
+{
+	struct Bin
+	{
+		vec3		_min = vec3(INFINITY), _max = vec3(-INFINITY);
+		uint32_t	_count = 0;
+	};
+
+	const uint32_t numTriangles = node._end - node._begin;
+	split._middle = 0;
+
+	if (numTriangles <= 1 || (medianSplit && numTriangles <= MAX_LEAF_SIZE))
+		return;
+
+	// Centroids are doubled, i.e. min + max
+	vec3 centroidMin(INFINITY), centroidMax(-INFINITY);
+	const auto boundCentroids = [&boxes](uint32_t begin, uint32_t end, vec3& minPoint, vec3& maxPoint)
+		{
+			for (uint32_t idx = begin; idx < end; ++idx)
+			{
+				minPoint = glm::min(minPoint, boxes[idx]._min + boxes[idx]._max);
+				maxPoint = glm::max(maxPoint, boxes[idx]._min + boxes[idx]._max);
+			}
+		};
+
+	// Large nodes are processed in chunks by every thread
+	const int numChunks = parallel ? static_cast<int>((numTriangles + PARALLEL_BINNING_SIZE / 4 - 1) / (PARALLEL_BINNING_SIZE / 4)) : 1;
+	const auto chunkBegin = [&node, numChunks](int chunkIdx) { return node._begin + static_cast<uint32_t>(static_cast<uint64_t>(node._end - node._begin) * chunkIdx / numChunks); };
+
+	if (parallel)
+	{
+		std::vector<vec3> chunkMin(numChunks, vec3(INFINITY)), chunkMax(numChunks, vec3(-INFINITY));
+
+		#pragma omp parallel for
+		for (int chunkIdx = 0; chunkIdx < numChunks; ++chunkIdx)
+			boundCentroids(chunkBegin(chunkIdx), chunkBegin(chunkIdx + 1), chunkMin[chunkIdx], chunkMax[chunkIdx]);
+
+		for (int chunkIdx = 0; chunkIdx < numChunks; ++chunkIdx)
+		{
+			centroidMin = glm::min(centroidMin, chunkMin[chunkIdx]);
+			centroidMax = glm::max(centroidMax, chunkMax[chunkIdx]);
+		}
+	}
+	else
+	{
+		boundCentroids(node._begin, node._end, centroidMin, centroidMax);
+	}
+
+	const vec3 extent = centroidMax - centroidMin;
+	vec3 scale(.0f);
+	for (int axis = 0; axis < 3; ++axis)
+		if (extent[axis] > .0f) scale[axis] = BIN_COUNT / extent[axis];
+	int bestAxis = -1, bestBin = 0;
+
+	if (!medianSplit && (extent.x > .0f || extent.y > .0f || extent.z > .0f))
+	{
+		const auto binCentroids = [&](uint32_t begin, uint32_t end, Bin* bins)
+			{
+				for (uint32_t idx = begin; idx < end; ++idx)
+				{
+					const Box& box = boxes[idx];
+					const vec3 centroid = box._min + box._max;
+
+					for (int axis = 0; axis < 3; ++axis)
+					{
+						Bin& bin = bins[axis * BIN_COUNT + std::min(BIN_COUNT - 1, static_cast<int>((centroid[axis] - centroidMin[axis]) * scale[axis]))];
+						bin._min = glm::min(bin._min, box._min);
+						bin._max = glm::max(bin._max, box._max);
+						++bin._count;
+					}
+				}
+			};
+
+		Bin bins[3 * BIN_COUNT];
+
+		if (parallel)
+		{
+			std::vector<Bin> chunkBins(static_cast<size_t>(numChunks) * 3 * BIN_COUNT);
+
+			#pragma omp parallel for
+			for (int chunkIdx = 0; chunkIdx < numChunks; ++chunkIdx)
+				binCentroids(chunkBegin(chunkIdx), chunkBegin(chunkIdx + 1), &chunkBins[static_cast<size_t>(chunkIdx) * 3 * BIN_COUNT]);
+
+			for (int chunkIdx = 0; chunkIdx < numChunks; ++chunkIdx)
+			{
+				for (int binIdx = 0; binIdx < 3 * BIN_COUNT; ++binIdx)
+				{
+					const Bin& chunkBin = chunkBins[static_cast<size_t>(chunkIdx) * 3 * BIN_COUNT + binIdx];
+					bins[binIdx]._min = glm::min(bins[binIdx]._min, chunkBin._min);
+					bins[binIdx]._max = glm::max(bins[binIdx]._max, chunkBin._max);
+					bins[binIdx]._count += chunkBin._count;
+				}
+			}
+		}
+		else
+		{
+			binCentroids(node._begin, node._end, bins);
+		}
+
+		// Cost of each plane as the sum of the triangles of both sides weighted by their surface area
+		float bestCost = std::numeric_limits<float>::max();
+
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			if (extent[axis] <= .0f)
+				continue;
+
+			const Bin* axisBins = &bins[axis * BIN_COUNT];
+			float rightCost[BIN_COUNT];
+			Bin accumulated;
+
+			for (int binIdx = BIN_COUNT - 1; binIdx > 0; --binIdx)
+			{
+				accumulated._min = glm::min(accumulated._min, axisBins[binIdx]._min);
+				accumulated._max = glm::max(accumulated._max, axisBins[binIdx]._max);
+				accumulated._count += axisBins[binIdx]._count;
+				rightCost[binIdx] = accumulated._count ? surfaceArea(accumulated._min, accumulated._max) * accumulated._count : -1.0f;
+			}
+
+			accumulated = Bin();
+			for (int binIdx = 0; binIdx < BIN_COUNT - 1; ++binIdx)
+			{
+				accumulated._min = glm::min(accumulated._min, axisBins[binIdx]._min);
+				accumulated._max = glm::max(accumulated._max, axisBins[binIdx]._max);
+				accumulated._count += axisBins[binIdx]._count;
+
+				if (!accumulated._count || rightCost[binIdx + 1] < .0f)
+					continue;
+
+				const float cost = surfaceArea(accumulated._min, accumulated._max) * accumulated._count + rightCost[binIdx + 1];
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					bestAxis = axis;
+					bestBin = binIdx;
+				}
+			}
+		}
+
+		const float nodeArea = surfaceArea(node._min, node._max);
+		if (bestAxis >= 0 && numTriangles <= MAX_LEAF_SIZE && (nodeArea <= .0f || TRAVERSAL_COST + bestCost / nodeArea >= static_cast<float>(numTriangles)))
+			return;
+
+		if (bestAxis >= 0)
+		{
+			const std::vector<Box>::iterator middle = std::partition(boxes.begin() + node._begin, boxes.begin() + node._end, [&](const Box& box)
+				{
+					const float centroid = box._min[bestAxis] + box._max[bestAxis];
+					return std::min(BIN_COUNT - 1, static_cast<int>((centroid - centroidMin[bestAxis]) * scale[bestAxis])) <= bestBin;
+				});
+
+			split._middle = static_cast<uint32_t>(middle - boxes.begin());
+			split._leftMin = split._rightMin = vec3(INFINITY);
+			split._leftMax = split._rightMax = vec3(-INFINITY);
+
+			for (int binIdx = 0; binIdx < BIN_COUNT; ++binIdx)
+			{
+				const Bin& bin = bins[bestAxis * BIN_COUNT + binIdx];
+				vec3& minPoint = binIdx <= bestBin ? split._leftMin : split._rightMin;
+				vec3& maxPoint = binIdx <= bestBin ? split._leftMax : split._rightMax;
+
+				minPoint = glm::min(minPoint, bin._min);
+				maxPoint = glm::max(maxPoint, bin._max);
+			}
+
+			return;
+		}
+	}
+
+	if (numTriangles <= MAX_LEAF_SIZE)
+		return;
+
+	// Median split along the widest centroid axis, which also separates triangles sharing a centroid
+	const int axis = extent.x >= extent.y ? (extent.x >= extent.z ? 0 : 2) : (extent.y >= extent.z ? 1 : 2);
+	split._middle = node._begin + numTriangles / 2;
+
+	std::nth_element(boxes.begin() + node._begin, boxes.begin() + split._middle, boxes.begin() + node._end, [axis](const Box& a, const Box& b)
+		{
+			const float centroidA = a._min[axis] + a._max[axis], centroidB = b._min[axis] + b._max[axis];
+			return centroidA < centroidB || (centroidA == centroidB && a._triangle < b._triangle);
+		});
+
+	split._leftMin = split._rightMin = vec3(INFINITY);
+	split._leftMax = split._rightMax = vec3(-INFINITY);
+
+	for (uint32_t idx = node._begin; idx < node._end; ++idx)
+	{
+		vec3& minPoint = idx < split._middle ? split._leftMin : split._rightMin;
+		vec3& maxPoint = idx < split._middle ? split._leftMax : split._rightMax;
+
+		minPoint = glm::min(minPoint, boxes[idx]._min);
+		maxPoint = glm::max(maxPoint, boxes[idx]._max);
+	}
+}
+
+void TriangleBvh::clear(Node& node)
+{
+	for (int childIdx = 0; childIdx < WIDTH; ++childIdx)
+	{
+		node._minX[childIdx] = node._minY[childIdx] = node._minZ[childIdx] = INFINITY;
+		node._maxX[childIdx] = node._maxY[childIdx] = node._maxZ[childIdx] = INFINITY;
+		node._children[childIdx] = node._counts[childIdx] = 0;
+	}
+}
+
+vec3 TriangleBvh::closestTrianglePoint(const vec3& point, const vec3& a, const vec3& b, const vec3& c)
+{
+	// Voronoi regions of the triangle, as in Ericson, Real-Time Collision Detection, 5.1.5
+	const vec3 ab = b - a, ac = c - a, ap = point - a;
+	const float d1 = glm::dot(ab, ap), d2 = glm::dot(ac, ap);
+	if (d1 <= .0f && d2 <= .0f) return a;
+
+	const vec3 bp = point - b;
+	const float d3 = glm::dot(ab, bp), d4 = glm::dot(ac, bp);
+	if (d3 >= .0f && d4 <= d3) return b;
+
+	const float vc = d1 * d4 - d3 * d2;
+	if (vc <= .0f && d1 >= .0f && d3 <= .0f) return a + ab * (d1 / (d1 - d3));
+
+	const vec3 cp = point - c;
+	const float d5 = glm::dot(ab, cp), d6 = glm::dot(ac, cp);
+	if (d6 >= .0f && d5 <= d6) return c;
+
+	const float vb = d5 * d2 - d1 * d6;
+	if (vb <= .0f && d2 >= .0f && d6 <= .0f) return a + ac * (d2 / (d2 - d6));
+
+	const float va = d3 * d6 - d5 * d4;
+	if (va <= .0f && (d4 - d3) >= .0f && (d5 - d6) >= .0f) return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+	// Degenerate triangles fall back to their first vertex
+	const float sum = va + vb + vc;
+	if (sum <= .0f) return a;
+
+	return a + ab * (vb / sum) + ac * (vc / sum);
+}
+
+unsigned TriangleBvh::intersectBoxes(const Node& node, const vec3& origin, const vec3& inverseDirection, float maxDistance, float* distances)
+{
+#ifdef BVH_SSE
+	const __m128 originX = _mm_set1_ps(origin.x), originY = _mm_set1_ps(origin.y), originZ = _mm_set1_ps(origin.z);
+	const __m128 inverseX = _mm_set1_ps(inverseDirection.x), inverseY = _mm_set1_ps(inverseDirection.y), inverseZ = _mm_set1_ps(inverseDirection.z);
+
+	const __m128 x0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node._minX), originX), inverseX), x1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node._maxX), originX), inverseX);
+	const __m128 y0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node._minY), originY), inverseY), y1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node._maxY), originY), inverseY);
+	const __m128 z0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node._minZ), originZ), inverseZ), z1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node._maxZ), originZ), inverseZ);
+
+	const __m128 tNear = _mm_max_ps(_mm_max_ps(_mm_min_ps(x0, x1), _mm_min_ps(y0, y1)), _mm_max_ps(_mm_min_ps(z0, z1), _mm_setzero_ps()));
+	const __m128 tFar = _mm_min_ps(_mm_min_ps(_mm_max_ps(x0, x1), _mm_max_ps(y0, y1)), _mm_min_ps(_mm_max_ps(z0, z1), _mm_set1_ps(maxDistance)));
+
+	_mm_storeu_ps(distances, tNear);
+
+	return static_cast<unsigned>(_mm_movemask_ps(_mm_cmple_ps(tNear, tFar)));
+#else
+	unsigned mask = 0;
+
+	for (int childIdx = 0; childIdx < WIDTH; ++childIdx)
+	{
+		const float x0 = (node._minX[childIdx] - origin.x) * inverseDirection.x, x1 = (node._maxX[childIdx] - origin.x) * inverseDirection.x;
+		const float y0 = (node._minY[childIdx] - origin.y) * inverseDirection.y, y1 = (node._maxY[childIdx] - origin.y) * inverseDirection.y;
+		const float z0 = (node._minZ[childIdx] - origin.z) * inverseDirection.z, z1 = (node._maxZ[childIdx] - origin.z) * inverseDirection.z;
+
+		const float tNear = std::max(std::max(std::min(x0, x1), std::min(y0, y1)), std::max(std::min(z0, z1), .0f));
+		const float tFar = std::min(std::min(std::max(x0, x1), std::max(y0, y1)), std::min(std::max(z0, z1), maxDistance));
+
+		distances[childIdx] = tNear;
+		mask |= static_cast<unsigned>(tNear <= tFar) << childIdx;
+	}
+
+	return mask;
+#endif
+}
+
+bool TriangleBvh::intersectTriangle(const Triangle& triangle, const vec3& origin, const vec3& direction, RayHit& hit)
+{
+	// Moller-Trumbore
+	const vec3 edge1 = triangle._vertices[1] - triangle._vertices[0], edge2 = triangle._vertices[2] - triangle._vertices[0];
+	const vec3 p = glm::cross(direction, edge2);
+	const float determinant = glm::dot(edge1, p);
+
+	if (determinant == .0f)
+		return false;
+
+	const float inverseDeterminant = 1.0f / determinant;
+	const vec3 s = origin - triangle._vertices[0];
+	const float u = glm::dot(s, p) * inverseDeterminant;
+
+	if (u < .0f || u > 1.0f)
+		return false;
+
+	const vec3 q = glm::cross(s, edge1);
+	const float v = glm::dot(direction, q) * inverseDeterminant;
+
+	if (v < .0f || u + v > 1.0f)
+		return false;
+
+	const float distance = glm::dot(edge2, q) * inverseDeterminant;
+	if (distance < .0f || distance >= hit._distance)
+		return false;
+
+	hit._distance = distance;
+	hit._barycentric = vec2(u, v);
+	hit._primitive = triangle._primitive;
+
+	return true;
+}
+
+void TriangleBvh::distanceBoxes(const Node& node, const vec3& point, float* distances2)
+{
+#ifdef BVH_SSE
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 pointX = _mm_set1_ps(point.x), pointY = _mm_set1_ps(point.y), pointZ = _mm_set1_ps(point.z);
+
+	const __m128 x = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_load_ps(node._minX), pointX), _mm_sub_ps(pointX, _mm_load_ps(node._maxX))), zero);
+	const __m128 y = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_load_ps(node._minY), pointY), _mm_sub_ps(pointY, _mm_load_ps(node._maxY))), zero);
+	const __m128 z = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_load_ps(node._minZ), pointZ), _mm_sub_ps(pointZ, _mm_load_ps(node._maxZ))), zero);
+
+	_mm_storeu_ps(distances2, _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+#else
+	for (int childIdx = 0; childIdx < WIDTH; ++childIdx)
+	{
+		const float x = std::max(std::max(node._minX[childIdx] - point.x, point.x - node._maxX[childIdx]), .0f);
+		const float y = std::max(std::max(node._minY[childIdx] - point.y, point.y - node._maxY[childIdx]), .0f);
+		const float z = std::max(std::max(node._minZ[childIdx] - point.z, point.z - node._maxZ[childIdx]), .0f);
+
+		distances2[childIdx] = x * x + y * y + z * z;
+	}
+#endif
+}
+
+unsigned TriangleBvh::overlapBoxes(const Node& node, const vec3& minPoint, const vec3& maxPoint)
+{
+#ifdef BVH_SSE
+	__m128 overlap = _mm_and_ps(_mm_cmple_ps(_mm_load_ps(node._minX), _mm_set1_ps(maxPoint.x)), _mm_cmpge_ps(_mm_load_ps(node._maxX), _mm_set1_ps(minPoint.x)));
+	overlap = _mm_and_ps(overlap, _mm_and_ps(_mm_cmple_ps(_mm_load_ps(node._minY), _mm_set1_ps(maxPoint.y)), _mm_cmpge_ps(_mm_load_ps(node._maxY), _mm_set1_ps(minPoint.y))));
+	overlap = _mm_and_ps(overlap, _mm_and_ps(_mm_cmple_ps(_mm_load_ps(node._minZ), _mm_set1_ps(maxPoint.z)), _mm_cmpge_ps(_mm_load_ps(node._maxZ), _mm_set1_ps(minPoint.z))));
+
+	return static_cast<unsigned>(_mm_movemask_ps(overlap));
+#else
+	unsigned mask = 0;
+
+	for (int childIdx = 0; childIdx < WIDTH; ++childIdx)
+	{
+		const bool overlap = node._minX[childIdx] <= maxPoint.x && node._maxX[childIdx] >= minPoint.x &&
+							 node._minY[childIdx] <= maxPoint.y && node._maxY[childIdx] >= minPoint.y &&
+							 node._minZ[childIdx] <= maxPoint.z && node._maxZ[childIdx] >= minPoint.z;
+		mask |= static_cast<unsigned>(overlap) << childIdx;
+	}
+
+	return mask;
+#endif
+}
+
+bool TriangleBvh::overlapTriangle(const Triangle& triangle, const vec3& centre, const vec3& halfSize)
+{
+	const vec3 vertices[3] = { triangle._vertices[0] - centre, triangle._vertices[1] - centre, triangle._vertices[2] - centre };
+	const vec3 edges[3] = { vertices[1] - vertices[0], vertices[2] - vertices[1], vertices[0] - vertices[2] };
+
+	// Coordinate axes
+	const vec3 minPoint = glm::min(vertices[0], glm::min(vertices[1], vertices[2])), maxPoint = glm::max(vertices[0], glm::max(vertices[1], vertices[2]));
+	if (glm::any(glm::greaterThan(minPoint, halfSize)) || glm::any(glm::lessThan(maxPoint, -halfSize)))
+		return false;
+
+	// Triangle normal
+	const vec3 normal = glm::cross(edges[0], edges[1]);
+	if (std::abs(glm::dot(normal, vertices[0])) > glm::dot(halfSize, glm::abs(normal)))
+		return false;
+
+	// Cross products of edges and coordinate axes
+	for (int edgeIdx = 0; edgeIdx < 3; ++edgeIdx)
+	{
+		for (int axisIdx = 0; axisIdx < 3; ++axisIdx)
+		{
+			vec3 unit(.0f);
+			unit[axisIdx] = 1.0f;
+
+			const vec3 axis = glm::cross(edges[edgeIdx], unit);
+			const float p0 = glm::dot(axis, vertices[0]), p1 = glm::dot(axis, vertices[1]), p2 = glm::dot(axis, vertices[2]);
+			const float radius = glm::dot(halfSize, glm::abs(axis));
+
+			if (std::min(p0, std::min(p1, p2)) > radius || std::max(p0, std::max(p1, p2)) < -radius)
+				return false;
+		}
+	}
+
+	return true;
+}
+
+float TriangleBvh::surfaceArea(const vec3& minPoint, const vec3& maxPoint)
+{
+	const vec3 size = maxPoint - minPoint;
+	if (size.x < .0f || size.y < .0f || size.z < .0f)
+		return .0f;
+
+	return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
@@ -0,0 +1,209 @@
+#pragma once
+
+#include "Graphics/Core/Model3D.h"
+
+/**
+*	@brief CPU bounding volume hierarchy over the triangles of a model, for ray, closest-point and box queries that cannot wait for the GPU
+*	hierarchy of Bvh, and as the clusters of WindingNumberVoxelizer. A binary hierarchy is built level by level with a binned surface area heuristic, where large nodes are binned in
+*	parallel and the nodes of a level are split in parallel otherwise. It is then collapsed into nodes of four children whose boxes are
+*	stored as structures of arrays, so that the four boxes of a node are tested at once with SSE and a node fills two cache lines.
+*/
+class TriangleBvh
+{
+	friend class WindingNumberVoxelizer;
+
+public:
+	const static int		BIN_COUNT;						//!< Bins per axis of the surface area heuristic
+	const static unsigned	MAX_LEAF_SIZE;					//!< Maximum number of triangles of a leaf
+	const static int		MAX_DEPTH;						//!< Depth of the binary hierarchy, which bounds the traversal stacks
+	const static unsigned	PARALLEL_BINNING_SIZE;			//!< Number of triangles from which a node is binned in parallel
+	const static float		TRAVERSAL_COST;					//!< Cost of visiting a node relative to testing a triangle
+	const static int		WIDTH;							//!< Children per node
+
+public:
+	/**
+	*	@brief Triangle of a model component.
+	*/
+	struct Primitive
+	{
+		unsigned	_componentIdx;
+		unsigned	_faceIdx;
+	};
+
+	/**
+	*	@brief Closest intersection of a ray.
+	*/
+	struct RayHit
+	{
+		float		_distance;								//!< Ray parameter, in units of the ray direction
+		vec2		_barycentric;							//!< Weights of the second and third vertices of the face
+		Primitive	_primitive;
+	};
+
+	/**
+	*	@brief Closest surface point to a query point.
+	*/
+	struct PointHit
+	{
+		vec3		_point;
+		float		_distance;
+		Primitive	_primitive;
+	};
+
+protected:
+	/**
+	*	@brief Bounds of a triangle, sorted in place while the binary hierarchy is built.
+	*/
+	struct Box
+	{
+		vec3		_min, _max;
+		uint32_t	_triangle;
+	};
+
+	/**
+	*	@brief Node of the binary hierarchy. Children of a node are stored contiguously.
+	*/
+	struct BuildNode
+	{
+		vec3		_min, _max;
+		uint32_t	_begin, _end;							//!< Range of triangles
+		uint32_t	_children;								//!< Index of the first child, zero for leaves
+	};
+
+	/**
+	*	@brief Node with four children. Leaf children point to a range of triangles and empty slots have a box that is never hit.
+	*/
+	struct alignas(64) Node
+	{
+		float		_minX[4], _minY[4], _minZ[4];
+		float		_maxX[4], _maxY[4], _maxZ[4];
+		uint32_t	_children[4];							//!< Index of the child node, or first triangle of a leaf
+		uint32_t	_counts[4];								//!< Number of triangles of a leaf, zero for inner nodes and empty slots
+	};
+
+	/**
+	*	@brief Triangle sorted as the leaves.
+	*/
+	struct Triangle
+	{
+		vec3		_vertices[3];
+		Primitive	_primitive;
+	};
+
+	/**
+	*	@brief Split of a node of the binary hierarchy.
+	*/
+	struct Split
+	{
+		uint32_t	_middle;								//!< First triangle of the right child, zero if the node is a leaf
+		vec3		_leftMin, _leftMax;
+		vec3		_rightMin, _rightMax;
+	};
+
+protected:
+	AABB						_aabb;						//!< Bounds of every triangle
+	std::vector<Node>			_nodes;						//!< Root is the first node
+	std::vector<Triangle>		_triangles;
+
+protected:
+	/**
+	*	@brief Builds the binary hierarchy and sorts the boxes of the triangles as its leaves.
+	*/
+	void buildBinary(std::vector<Box>& boxes, std::vector<BuildNode>& nodes);
+
+	/**
+	*	@brief Collapses the binary hierarchy by opening, for every node, the child with the largest surface until it has four children.
+	*/
+	void collapse(const std::vector<BuildNode>& nodes);
+
+	/**
+	*	@brief Splits a node at the best plane among those of the centroid bins of every axis. Nodes at the maximum SAH depth are split at
+	*	their median centroid instead, so that the depth of the hierarchy stays bounded.
+	*	@param parallel Bins the triangles of the node with every thread.
+	*/
+	static void findSplit(const BuildNode& node, bool medianSplit, bool parallel, std::vector<Box>& boxes, Split& split);
+
+	/**
+	*	@brief Turns every child of a node into an empty slot.
+	*/
+	static void clear(Node& node);
+
+	/**
+	*	@return True if a child of a node is another node, rather than a leaf or an empty slot.
+	*/
+	static bool isInner(const Node& node, int childIdx) { return !node._counts[childIdx] && node._minX[childIdx] != INFINITY; }
+
+	/**
+	*	@return Closest point of a triangle to a point.
+	*/
+	static vec3 closestTrianglePoint(const vec3& point, const vec3& a, const vec3& b, const vec3& c);
+
+	/**
+	*	@return Mask of the children whose box is hit by a ray within [0, maxDistance], and the entry distance of each one.
+	*/
+	static unsigned intersectBoxes(const Node& node, const vec3& origin, const vec3& inverseDirection, float maxDistance, float* distances);
+
+	/**
+	*	@return True if a ray hits a triangle closer than hit._distance, which is then updated.
+	*/
+	static bool intersectTriangle(const Triangle& triangle, const vec3& origin, const vec3& direction, RayHit& hit);
+
+	/**
+	*	@brief Computes the squared distance from a point to the box of each child.
+	*/
+	static void distanceBoxes(const Node& node, const vec3& point, float* distances2);
+
+	/**
+	*	@return Mask of the children whose box overlaps a box.
+	*/
+	static unsigned overlapBoxes(const Node& node, const vec3& minPoint, const vec3& maxPoint);
+
+	/**
+	*	@return True if a triangle overlaps a box given by its centre and half size, following the separating axis test of Akenine-Moller.
+	*/
+	static bool overlapTriangle(const Triangle& triangle, const vec3& centre, const vec3& halfSize);
+
+	/**
+	*	@return Surface area of a box, or zero if it is empty.
+	*/
+	static float surfaceArea(const vec3& minPoint, const vec3& maxPoint);
+
+public:
+	/**
+	*	@brief Builds the hierarchy over every triangle of every component of a model, in the space of its vertices.
+	*/
+	TriangleBvh(Model3D* model);
+
+	/**
+	*	@brief Destructor.
+	*/
+	virtual ~TriangleBvh();
+
+	/**
+	*	@brief Finds the closest surface point within a distance of a point.
+	*	@return False if the surface is farther than maxDistance.
+	*/
+	bool closestPoint(const vec3& point, float maxDistance, PointHit& hit) const;
+
+	/**
+	*	@return Bounds of every triangle.
+	*/
+	AABB getAABB() const { return _aabb; }
+
+	/**
+	*	@return Number of nodes of the hierarchy.
+	*/
+	size_t getNumNodes() const { return _nodes.size(); }
+
+	/**
+	*	@brief Finds the closest intersection of a ray within [0, maxDistance].
+	*	@return False if no triangle is hit.
+	*/
+	bool intersect(const vec3& origin, const vec3& direction, float maxDistance, RayHit& hit) const;
+
+	/**
+	*	@brief Appends the triangles that overlap a box, without duplicates.
+	*/
+	void overlap(const AABB& aabb, std::vector<Primitive>& primitives) const;
+};
+
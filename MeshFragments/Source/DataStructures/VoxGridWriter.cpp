@@ -0,0 +1,221 @@
+#include "stdafx.h"
+#include "VoxGridWriter.h"
+
+// [Static members initialization]
+
+const char VoxGridWriter::MAGIC[4] = { 'V', 'O', 'X', ' ' };
+const int32_t VoxGridWriter::VERSION = 150;
+const unsigned VoxGridWriter::MAX_MODEL_SIZE = 256;
+const unsigned VoxGridWriter::MAX_PALETTE_SIZE = 255;
+
+/// [Public methods]
+
+void VoxGridWriter::collectLabels(const uint16_t* values, const uvec3& numDivs, uint16_t minLabel, std::vector<uint16_t>& labels)
+{
+	const size_t sliceSize = static_cast<size_t>(numDivs.y) * numDivs.z;
+	std::vector<uint8_t> present(std::numeric_limits<uint16_t>::max() + 1, 0);
+
+	#pragma omp parallel
+	{
+		std::vector<uint8_t> localPresent(present.size(), 0);
+
+		#pragma omp for
+		for (int x = 0; x < static_cast<int>(numDivs.x); ++x)
+		{
+			const uint16_t* slice = values + x * sliceSize;
+			for (size_t idx = 0; idx < sliceSize; ++idx)
+				localPresent[slice[idx]] = 1;
+		}
+
+		#pragma omp critical
+		for (size_t label = minLabel; label < present.size(); ++label)
+			present[label] |= localPresent[label];
+	}
+
+	labels.clear();
+	for (size_t label = minLabel; label < present.size(); ++label)
+		if (present[label])
+			labels.push_back(static_cast<uint16_t>(label));
+}
+
+bool VoxGridWriter::write(std::ostream& stream, const uint16_t* values, const uvec3& numDivs, const std::vector<uint16_t>& labels, bool squared)
+{
+	if (labels.size() > MAX_PALETTE_SIZE) return false;
+
+	std::vector<uint8_t> palette(std::numeric_limits<uint16_t>::max() + 1, 0);
+	for (size_t labelIdx = 0; labelIdx < labels.size(); ++labelIdx)
+		palette[labels[labelIdx]] = static_cast<uint8_t>(labelIdx + 1);
+
+	// Scene extent and tiles are defined in file axes, (x, z, y) of the grid
+	const uvec3 gridExtent = squared ? uvec3(glm::max(numDivs.x, glm::max(numDivs.y, numDivs.z))) : numDivs;
+	const uvec3 offset = (gridExtent - numDivs) / uvec3(2);
+	const uvec3 extent = uvec3(gridExtent.x, gridExtent.z, gridExtent.y);
+	const uvec3 numTiles = (extent + uvec3(MAX_MODEL_SIZE - 1)) / uvec3(MAX_MODEL_SIZE);
+
+	std::vector<Model> models;
+	for (unsigned tx = 0; tx < numTiles.x; ++tx)
+	{
+		for (unsigned ty = 0; ty < numTiles.y; ++ty)
+		{
+			for (unsigned tz = 0; tz < numTiles.z; ++tz)
+			{
+				Model model;
+				model._origin = uvec3(tx, ty, tz) * uvec3(MAX_MODEL_SIZE);
+				model._size = glm::min(extent - model._origin, uvec3(MAX_MODEL_SIZE));
+				buildModel(values, numDivs, offset, palette, model);
+
+				models.push_back(std::move(model));
+			}
+		}
+	}
+
+	std::vector<uint8_t> content;
+	for (const Model& model : models)
+	{
+		appendChunk(content, "SIZE", 3 * sizeof(int32_t));
+		for (int axis = 0; axis < 3; ++axis)
+			appendInt(content, static_cast<int32_t>(model._size[axis]));
+
+		appendChunk(content, "XYZI", static_cast<uint32_t>(sizeof(int32_t) + model._voxels.size()));
+		appendInt(content, static_cast<int32_t>(model._voxels.size() / 4));
+		content.insert(content.end(), model._voxels.begin(), model._voxels.end());
+	}
+
+	// Scene graph: root transform -> group -> transform and shape per model
+	const std::vector<std::pair<std::string, std::string>> noAttributes;
+	const int32_t numModels = static_cast<int32_t>(models.size());
+
+	appendChunk(content, "nTRN", 5 * sizeof(int32_t) + 2 * getDictionarySize(noAttributes));
+	appendInt(content, 0);
+	appendDictionary(content, noAttributes);
+	appendInt(content, 1);
+	appendInt(content, -1);
+	appendInt(content, -1);
+	appendInt(content, 1);
+	appendDictionary(content, noAttributes);
+
+	appendChunk(content, "nGRP", (2 + numModels) * sizeof(int32_t) + getDictionarySize(noAttributes));
+	appendInt(content, 1);
+	appendDictionary(content, noAttributes);
+	appendInt(content, numModels);
+	for (int32_t modelIdx = 0; modelIdx < numModels; ++modelIdx)
+		appendInt(content, 2 + modelIdx * 2);
+
+	for (int32_t modelIdx = 0; modelIdx < numModels; ++modelIdx)
+	{
+		// Models are placed by their centre; the scene is centred on the ground plane
+		const Model& model = models[modelIdx];
+		const ivec3 translation = ivec3(model._origin + model._size / uvec3(2)) - ivec3(extent.x / 2, extent.y / 2, 0);
+		const std::vector<std::pair<std::string, std::string>> frame = {
+			{ "_t", std::to_string(translation.x) + " " + std::to_string(translation.y) + " " + std::to_string(translation.z) } };
+
+		appendChunk(content, "nTRN", 5 * sizeof(int32_t) + getDictionarySize(noAttributes) + getDictionarySize(frame));
+		appendInt(content, 2 + modelIdx * 2);
+		appendDictionary(content, noAttributes);
+		appendInt(content, 3 + modelIdx * 2);
+		appendInt(content, -1);
+		appendInt(content, 0);
+		appendInt(content, 1);
+		appendDictionary(content, frame);
+
+		appendChunk(content, "nSHP", 3 * sizeof(int32_t) + 2 * getDictionarySize(noAttributes));
+		appendInt(content, 3 + modelIdx * 2);
+		appendDictionary(content, noAttributes);
+		appendInt(content, 1);
+		appendInt(content, modelIdx);
+		appendDictionary(content, noAttributes);
+	}
+
+	std::vector<uint8_t> header;
+	header.insert(header.end(), MAGIC, MAGIC + sizeof(MAGIC));
+	appendInt(header, VERSION);
+	appendChunk(header, "MAIN", 0, static_cast<uint32_t>(content.size()));
+
+	stream.write(reinterpret_cast<const char*>(header.data()), header.size());
+	stream.write(reinterpret_cast<const char*>(content.data()), content.size());
+
+	return !stream.fail();
+}
+
+/// [Protected methods]
+
+void VoxGridWriter::appendChunk(std::vector<uint8_t>& buffer, const char id[4], uint32_t contentSize, uint32_t childrenSize)
+{
+	buffer.insert(buffer.end(), id, id + 4);
+	appendInt(buffer, static_cast<int32_t>(contentSize));
+	appendInt(buffer, static_cast<int32_t>(childrenSize));
+}
+
+void VoxGridWriter::appendDictionary(std::vector<uint8_t>& buffer, const std::vector<std::pair<std::string, std::string>>& dictionary)
+{
+	appendInt(buffer, static_cast<int32_t>(dictionary.size()));
+
+	for (const auto& pair : dictionary)
+	{
+		appendInt(buffer, static_cast<int32_t>(pair.first.size()));
+		buffer.insert(buffer.end(), pair.first.begin(), pair.first.end());
+		appendInt(buffer, static_cast<int32_t>(pair.second.size()));
+		buffer.insert(buffer.end(), pair.second.begin(), pair.second.end());
+	}
+}
+
+void VoxGridWriter::appendInt(std::vector<uint8_t>& buffer, int32_t value)
+{
+	const uint32_t bits = static_cast<uint32_t>(value);
+	for (int byte = 0; byte < 4; ++byte)
+		buffer.push_back(static_cast<uint8_t>(bits >> (byte * 8)));
+}
+
+void VoxGridWriter::buildModel(const uint16_t* values, const uvec3& numDivs, const uvec3& offset, const std::vector<uint8_t>& palette, Model& model)
+{
+	// Grid range covered by the model, where file axes (x, y, z) are grid axes (x, z, y)
+	const ivec3 origin = ivec3(model._origin.x, model._origin.z, model._origin.y) - ivec3(offset);
+	const ivec3 size = ivec3(model._size.x, model._size.z, model._size.y);
+	const ivec3 min = glm::max(origin, ivec3(0)), max = glm::min(origin + size, ivec3(numDivs));
+
+	model._voxels.clear();
+	if (glm::any(glm::greaterThanEqual(min, max))) return;
+
+	std::vector<std::vector<uint8_t>> slices(max.x - min.x);
+
+	#pragma omp parallel for
+	for (int x = min.x; x < max.x; ++x)
+	{
+		std::vector<uint8_t>& slice = slices[x - min.x];
+
+		for (int y = min.y; y < max.y; ++y)
+		{
+			const uint16_t* row = values + (static_cast<size_t>(x) * numDivs.y + y) * numDivs.z;
+
+			for (int z = min.z; z < max.z; ++z)
+			{
+				const uint8_t colour = palette[row[z]];
+				if (colour)
+				{
+					slice.push_back(static_cast<uint8_t>(x - origin.x));
+					slice.push_back(static_cast<uint8_t>(z - origin.z));
+					slice.push_back(static_cast<uint8_t>(y - origin.y));
+					slice.push_back(colour);
+				}
+			}
+		}
+	}
+
+	size_t numBytes = 0;
+	for (const std::vector<uint8_t>& slice : slices)
+		numBytes += slice.size();
+
+	model._voxels.reserve(numBytes);
+	for (const std::vector<uint8_t>& slice : slices)
+		model._voxels.insert(model._voxels.end(), slice.begin(), slice.end());
+}
+
+uint32_t VoxGridWriter::getDictionarySize(const std::vector<std::pair<std::string, std::string>>& dictionary)
+{
+	uint32_t size = sizeof(int32_t);
+	for (const auto& pair : dictionary)
+		size += static_cast<uint32_t>(2 * sizeof(int32_t) + pair.first.size() + pair.second.size());
+
+	return size;
+}
+
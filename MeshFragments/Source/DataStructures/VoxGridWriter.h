@@ -0,0 +1,71 @@
+#pragma once
+
+/**
+*	@brief Direct MagicaVoxel writer for 16-bit voxel grids laid out as x * ny * nz + y * nz + z. Grid axes (x, y, z) are stored as
+*	(x, z, y) in the file. Grids larger than a model are split into tiles of up to MAX_MODEL_SIZE voxels per axis, each of them a model
+*	with its own transform within a single scene, and labels are mapped to the palette indices 1..MAX_PALETTE_SIZE.
+*
+*	Layout: "VOX " 150 | MAIN { SIZE XYZI per model | nTRN (root) | nGRP | nTRN nSHP per model }.
+*/
+class VoxGridWriter
+{
+public:
+	const static char		MAGIC[4];							//!< File signature
+	const static int32_t	VERSION;							//!< Version of the format expected by MagicaVoxel
+	const static unsigned	MAX_MODEL_SIZE;						//!< Maximum voxels of a model per axis
+	const static unsigned	MAX_PALETTE_SIZE;					//!< Colour indices available for labels, as 0 is reserved
+
+protected:
+	/**
+	*	@brief Voxels of a model, as (x, y, z, colour index) tuples in model coordinates.
+	*/
+	struct Model
+	{
+		uvec3					_origin;						//!< Position of the model within the scene, in file axes
+		uvec3					_size;
+		std::vector<uint8_t>	_voxels;
+	};
+
+protected:
+	/**
+	*	@brief Appends a chunk header.
+	*/
+	static void appendChunk(std::vector<uint8_t>& buffer, const char id[4], uint32_t contentSize, uint32_t childrenSize = 0);
+
+	/**
+	*	@brief Appends a dictionary of string pairs.
+	*/
+	static void appendDictionary(std::vector<uint8_t>& buffer, const std::vector<std::pair<std::string, std::string>>& dictionary);
+
+	/**
+	*	@brief Appends a little-endian 32-bit integer.
+	*/
+	static void appendInt(std::vector<uint8_t>& buffer, int32_t value);
+
+	/**
+	*	@brief Collects the voxels of a model. Grid slices are scanned in parallel.
+	*	@param offset Position of the grid within the scene, in grid axes.
+	*	@param palette Colour index of every label, where 0 discards the voxel.
+	*/
+	static void buildModel(const uint16_t* values, const uvec3& numDivs, const uvec3& offset, const std::vector<uint8_t>& palette, Model& model);
+
+	/**
+	*	@return Bytes of a dictionary.
+	*/
+	static uint32_t getDictionarySize(const std::vector<std::pair<std::string, std::string>>& dictionary);
+
+public:
+	/**
+	*	@brief Gathers the distinct labels of a grid that are not below minLabel, sorted in ascending order.
+	*/
+	static void collectLabels(const uint16_t* values, const uvec3& numDivs, uint16_t minLabel, std::vector<uint16_t>& labels);
+
+	/**
+	*	@brief Writes the voxels of a grid whose label belongs to labels, which is mapped in order to the colour indices 1..labels.size().
+	*	@param labels Up to MAX_PALETTE_SIZE labels.
+	*	@param squared Centres the grid in a cube as large as its longest axis.
+	*	@return Success of operation.
+	*/
+	static bool write(std::ostream& stream, const uint16_t* values, const uvec3& numDivs, const std::vector<uint16_t>& labels, bool squared);
+};
+
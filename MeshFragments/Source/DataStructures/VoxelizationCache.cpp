@@ -0,0 +1,123 @@
+#include "stdafx.h"
+#include "VoxelizationCache.h"
+
+#include "Utilities/HashUtilities.h"
+#include "Utilities/MemoryMappedFile.h"
+
+// [Static members initialization]
+
+const char VoxelizationCache::MAGIC[4] = { 'V', 'X', 'C', 'H' };
+const uint16_t VoxelizationCache::VERSION = 1;
+const std::string VoxelizationCache::EXTENSION = "vxc";
+const std::string VoxelizationCache::FOLDER = "Cache/Voxelization/";
+
+static_assert(sizeof(VoxelizationCache::Header) == 56, "Header must match the on-disk layout");
+
+/// [Public methods]
+
+uint64_t VoxelizationCache::computeKey(Model3D* model, const AABB& aabb, const uvec3& numDivs, const FractureParameters& fractParameters)
+{
+	uint64_t key = VERSION;
+	std::vector<vec3> positions;
+
+	// Only positions and faces take part in voxelizations
+	for (Model3D::ModelComponent* modelComponent : model->getModelComponents())
+	{
+		positions.resize(modelComponent->_geometry.size());
+
+		#pragma omp parallel for
+		for (int vertexIdx = 0; vertexIdx < static_cast<int>(positions.size()); ++vertexIdx)
+			positions[vertexIdx] = modelComponent->_geometry[vertexIdx]._position;
+
+		key = HashUtilities::hash(positions.data(), positions.size() * sizeof(vec3), key);
+		key = HashUtilities::hash(modelComponent->_topology.data(), modelComponent->_topology.size() * sizeof(Model3D::FaceGPUData), key);
+	}
+
+	const vec3 bounds[2] = { aabb.min(), aabb.max() };
+	const int32_t settings[2] = { fractParameters._voxelizationMethod, fractParameters._shellThickness };
+
+	key = HashUtilities::hash(bounds, sizeof(bounds), key);
+	key = HashUtilities::hash(&numDivs, sizeof(uvec3), key);
+	key = HashUtilities::hash(settings, sizeof(settings), key);
+	if (fractParameters._voxelizationMethod == FractureParameters::CPU_WINDING_NUMBER)
+		key = HashUtilities::hash(&fractParameters._windingNumberAccuracy, sizeof(float), key);
+
+	return key;
+}
+
+std::string VoxelizationCache::getFilename(uint64_t key)
+{
+	char name[17];
+	std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(key));
+
+	return FOLDER + name + "." + EXTENSION;
+}
+
+bool VoxelizationCache::read(const std::string& filename, uint64_t key, const AABB& aabb, const uvec3& numDivs, GridLabelDelta::Occupancy& occupancy)
+{
+	MemoryMappedFile file;
+	if (!file.open(filename) || file.size() < sizeof(Header))
+		return false;
+
+	Header header;
+	std::memcpy(&header, file.data(), sizeof(Header));
+
+	if (std::memcmp(header._magic, MAGIC, sizeof(MAGIC)) != 0 || header._version != VERSION || header._key != key ||
+		header._minPoint != aabb.min() || header._maxPoint != aabb.max() || header._numDivs != numDivs)
+		return false;
+
+	return GridLabelDelta::readOccupancy(file.data() + sizeof(Header), file.size() - sizeof(Header), occupancy) && occupancy._numDivs == numDivs;
+}
+
+bool VoxelizationCache::write(const std::string& filename, uint64_t key, const AABB& aabb, const GridLabelDelta::Occupancy& occupancy)
+{
+	const std::filesystem::path path(filename);
+	std::error_code error;
+
+	if (path.has_parent_path())
+		std::filesystem::create_directories(path.parent_path(), error);
+
+	// Temporary names are unique per thread and time, so that writers never share them
+	const size_t suffix = std::hash<std::thread::id>()(std::this_thread::get_id()) ^ static_cast<size_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+	const std::string temporaryFilename = filename + "." + std::to_string(suffix) + ".tmp";
+
+	Header header;
+	std::memcpy(header._magic, MAGIC, sizeof(MAGIC));
+	header._version = VERSION;
+	header._reserved = 0;
+	header._key = key;
+	header._minPoint = aabb.min();
+	header._maxPoint = aabb.max();
+	header._numDivs = occupancy._numDivs;
+	header._padding = 0;
+
+	{
+		std::ofstream stream(temporaryFilename, std::ios::out | std::ios::binary);
+		if (!stream.is_open())
+			return false;
+
+		stream.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+		const bool written = GridLabelDelta::writeOccupancy(stream, occupancy);
+		stream.close();
+
+		// Flushing may still fail, e.g., if the disk is full, and a truncated cache must never replace a valid one
+		if (!written || !stream.good())
+		{
+			std::filesystem::remove(temporaryFilename, error);
+
+			return false;
+		}
+	}
+
+	// Replacing a file written by another process with the same key is harmless, as both hold the same voxelization
+	std::filesystem::rename(temporaryFilename, filename, error);
+	if (error)
+	{
+		std::filesystem::remove(temporaryFilename, error);
+
+		return false;
+	}
+
+	return true;
+}
+
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "DataStructures/GridLabelDelta.h"
+#include "Graphics/Core/FractureParameters.h"
+#include "Graphics/Core/Model3D.h"
+
+/**
+*	@brief On-disk cache of voxelizations, so that models revisited at the same resolution are not voxelized again. Files are named after
+*	a key that hashes the triangles of the model, its bounding box, the grid dimensions and the voxelization settings, and they are written
+*	to a temporary file that is renamed afterwards, so that concurrent processes sharing the folder never read a partial file. Caching is
+*	opt-in (see FractureParameters::_cacheVoxelization) since files are never evicted.
+*
+*	Layout: Header | occupancy in the format of GridLabelDelta (range-coded runs of empty and occupied voxels).
+*/
+class VoxelizationCache
+{
+public:
+	const static char			MAGIC[4];						//!< Signature of cache files
+	const static uint16_t		VERSION;						//!< Current version of the format
+	const static std::string	EXTENSION;						//!< Extension of cache files, without dot
+	const static std::string	FOLDER;							//!< Folder shared by every cache file
+
+	struct Header
+	{
+		char		_magic[4];
+		uint16_t	_version;
+		uint16_t	_reserved;
+		uint64_t	_key;
+		vec3		_minPoint, _maxPoint;					//!< Bounding box of the grid
+		uvec3		_numDivs;
+		uint32_t	_padding;
+	};
+
+public:
+	/**
+	*	@return Key of the voxelization of a model, which covers every input that changes its result.
+	*/
+	static uint64_t computeKey(Model3D* model, const AABB& aabb, const uvec3& numDivs, const FractureParameters& fractParameters);
+
+	/**
+	*	@return Path of the cache file of a key.
+	*/
+	static std::string getFilename(uint64_t key);
+
+	/**
+	*	@brief Reads a cached occupancy.
+	*	@return False if the file does not exist, is corrupted or belongs to a different voxelization.
+	*/
+	static bool read(const std::string& filename, uint64_t key, const AABB& aabb, const uvec3& numDivs, GridLabelDelta::Occupancy& occupancy);
+
+	/**
+	*	@brief Writes an occupancy through a temporary file, which replaces the cache file once it is complete.
+	*	@return Success of operation.
+	*/
+	static bool write(const std::string& filename, uint64_t key, const AABB& aabb, const GridLabelDelta::Occupancy& occupancy);
+};
+
@@ -1,7 +1,19 @@
 #include "stdafx.h"
 #include "PointCloud3D.h"
 
-#include "happly.h"
+#include "DataStructures/PointCloudCodec.h"
+#include "DataStructures/SpatialHashGrid.h"
+#include "Utilities/ExportPool.h"
+#include "Utilities/ExportContainer.h"
+#include "Utilities/MemoryMappedFile.h"
+#include "Utilities/RandomUtilities.h"
+
+// [Static members initialization]
+
+const float PointCloud3D::ELIMINATION_ALPHA = 8.0f;
+const float PointCloud3D::ELIMINATION_BETA = 0.65f;
+const float PointCloud3D::ELIMINATION_GAMMA = 1.5f;
+const size_t PointCloud3D::WRITE_BUFFER_SIZE = 1 << 20;
 
 /// [Public methods]
 
@@ -43,7 +55,7 @@ PointCloud3D::PointCloud3D(int numPoints, float radius)
 }
 
 PointCloud3D::PointCloud3D(const PointCloud3D& pointCloud) :
-	_points(pointCloud._points), _aabb(pointCloud._aabb)
+	_points(pointCloud._points), _color(pointCloud._color), _normals(pointCloud._normals), _fractureLabels(pointCloud._fractureLabels), _aabb(pointCloud._aabb)
 {
 }
 
@@ -58,6 +70,19 @@ vec3 PointCloud3D::getPoint(const int index) const
 	return _points[index];
 }
 
+void PointCloud3D::eliminate(unsigned numPoints, float surfaceArea)
+{
+	numPoints = std::min(numPoints, static_cast<unsigned>(_points.size()));
+	if (numPoints == 0) return;
+
+	this->eliminateSamples(static_cast<unsigned>(_points.size()), numPoints, surfaceArea);
+	this->resizePoints(numPoints);
+
+	// Progressive ordering: halving the prefix each time leaves the most evenly spaced points at the front
+	for (unsigned levelPoints = numPoints; levelPoints > 1; levelPoints /= 2)
+		this->eliminateSamples(levelPoints, levelPoints / 2, surfaceArea);
+}
+
 void PointCloud3D::joinPointCloud(PointCloud3D* pointCloud)
 {
 	if (pointCloud && pointCloud->_points.size())
@@ -69,12 +94,31 @@ void PointCloud3D::joinPointCloud(PointCloud3D* pointCloud)
 	}
 }
 
+bool PointCloud3D::loadCompressed(const std::string& filename)
+{
+	MemoryMappedFile file;
+	std::vector<vec4> points;
+	std::vector<vec3> normals;
+	std::vector<uint8_t> fractureLabels;
+
+	if (!file.open(filename) || !PointCloudCodec::read(file.data(), file.size(), points, normals, fractureLabels))
+		return false;
+
+	this->clear();
+	this->push_back(points.data(), normals.empty() ? nullptr : normals.data(), fractureLabels.empty() ? nullptr : fractureLabels.data(), static_cast<unsigned>(points.size()));
+
+	return true;
+}
+
 PointCloud3D& PointCloud3D::operator=(const PointCloud3D& pointCloud)
 {
 	if (this != &pointCloud)
 	{
-		_points = pointCloud._points;
-		_aabb	= pointCloud._aabb;
+		_points			= pointCloud._points;
+		_color			= pointCloud._color;
+		_normals		= pointCloud._normals;
+		_fractureLabels = pointCloud._fractureLabels;
+		_aabb			= pointCloud._aabb;
 	}
 
 	return *this;
@@ -82,6 +126,7 @@ PointCloud3D& PointCloud3D::operator=(const PointCloud3D& pointCloud)
 
 void PointCloud3D::push_back(const vec3& point)
 {
+	_exportBuffer.reset();
 	_points.push_back(vec4(point, 1.0f));
 	_aabb.update(point);
 }
@@ -96,82 +141,281 @@ void PointCloud3D::push_back(const vec4* points, unsigned numPoints)
 	}
 }
 
-std::thread* PointCloud3D::save(const std::string& filename, FractureParameters::ExportPointCloudExtension pointCloudExtension)
+void PointCloud3D::push_back(const vec4* points, const vec3* normals, const uint8_t* fractureLabels, unsigned numPoints)
 {
-	const std::string extensionStr = FractureParameters::ExportPointCloud_STR[pointCloudExtension];
-	std::thread* thread;
+	this->push_back(points, numPoints);
+
+	if (normals) _normals.insert(_normals.end(), normals, normals + numPoints);
+	if (fractureLabels) _fractureLabels.insert(_fractureLabels.end(), fractureLabels, fractureLabels + numPoints);
+}
+
+std::future<void> PointCloud3D::save(const std::string& filename, FractureParameters::ExportPointCloudExtension pointCloudExtension, size_t numPoints, ExportContainer* container)
+{
+	const std::string path = filename + "." + FractureParameters::ExportPointCloud_STR[pointCloudExtension];
+	const SharedPointBuffer points = this->getExportBuffer();
+
+	numPoints = std::min(numPoints, points->_points.size());
 
-#if TESTING_FORMAT_MODE
-	std::vector<vec4> points = _points;
-	if (pointCloudExtension == FractureParameters::ExportPointCloudExtension::PLY)
-		thread = new std::thread(&PointCloud3D::savePLY, this, filename + "." + extensionStr, std::move(points));
-	else if (pointCloudExtension == FractureParameters::ExportPointCloudExtension::XYZ)
-		thread = new std::thread(&PointCloud3D::saveXYZ, this, filename + "." + extensionStr, std::move(points));
-	else
-		thread = new std::thread(&PointCloud3D::saveCompressed, this, filename + "." + extensionStr, std::move(points));
-#else
 	if (pointCloudExtension == FractureParameters::ExportPointCloudExtension::PLY)
-		thread = new std::thread(&PointCloud3D::savePLY, this, filename + "." + extensionStr, std::move(_points));
+		return ExportPool::getInstance()->submit([path, points, numPoints, container]() { PointCloud3D::savePLY(path, points, numPoints, container); });
 	else if (pointCloudExtension == FractureParameters::ExportPointCloudExtension::XYZ)
-		thread = new std::thread(&PointCloud3D::saveXYZ, this, filename + "." + extensionStr, std::move(_points));
-	else
-		thread = new std::thread(&PointCloud3D::saveCompressed, this, filename + "." + extensionStr, std::move(_points));
-#endif 
+		return ExportPool::getInstance()->submit([path, points, numPoints, container]() { PointCloud3D::saveXYZ(path, points, numPoints, container); });
 
-	return thread;
+	return ExportPool::getInstance()->submit([path, points, numPoints, container]() { PointCloud3D::saveCompressed(path, points, numPoints, container); });
+}
+
+void PointCloud3D::shuffle(size_t prefixLength)
+{
+	const size_t numPoints = _points.size();
+
+	// Partial Fisher-Yates: each position of the prefix is drawn uniformly from the points not placed yet
+	for (size_t idx = 0; idx < prefixLength && idx + 1 < numPoints; ++idx)
+		this->swapPoints(idx, RandomUtilities::getUniformRandomIndex(idx, numPoints - 1));
 }
 
 void PointCloud3D::subselect(unsigned numPoints)
 {
 	if (numPoints >= _points.size()) return;
 
-	std::shuffle(_points.begin(), _points.end(), std::mt19937(std::random_device()()));
-	_points.resize(numPoints);
+	this->shuffle(numPoints);
+	this->resizePoints(numPoints);
 }
 
 // Protected methods
 
-void PointCloud3D::saveCompressed(const std::string& filename, const std::vector<glm::vec4>&& points)
+void PointCloud3D::eliminateSamples(unsigned numPoints, unsigned targetPoints, float surfaceArea)
 {
-	pcl::io::compression_Profiles_e compressionProfile = pcl::io::HIGH_RES_OFFLINE_COMPRESSION_WITHOUT_COLOR;
-	auto encoder = new pcl::io::OctreePointCloudCompression<pcl::PointXYZ>(compressionProfile, false);
-	pcl::PointCloud<pcl::PointXYZ>::Ptr cloud(new pcl::PointCloud<pcl::PointXYZ>());
+	if (targetPoints >= numPoints || targetPoints == 0) return;
+
+	// Points interact within twice the disk radius of the maximal packing of targetPoints disks over the surface
+	const float maxDistance = 2.0f * glm::sqrt(surfaceArea / (2.0f * glm::sqrt(3.0f) * targetPoints));
+	const float minDistance = maxDistance * (1.0f - glm::pow(static_cast<float>(targetPoints) / numPoints, ELIMINATION_GAMMA)) * ELIMINATION_BETA;
+	const SpatialHashGrid grid(_points.data(), numPoints, maxDistance);
+
+	// Neighbour lists, stored in consecutive ranges
+	std::vector<unsigned> neighbourStart(numPoints + 1, 0);
+	std::vector<unsigned> neighbourIndex;
+	std::vector<float> neighbourWeight, weight(numPoints, .0f);
+
+	#pragma omp parallel for
+	for (int pointIdx = 0; pointIdx < numPoints; ++pointIdx)
+	{
+		unsigned count = 0;
+		grid.forEachNeighbour(vec3(_points[pointIdx]), maxDistance, [&](unsigned neighbourIdx, float distance2) { count += neighbourIdx != static_cast<unsigned>(pointIdx); });
+		neighbourStart[pointIdx + 1] = count;
+	}
+
+	std::partial_sum(neighbourStart.begin(), neighbourStart.end(), neighbourStart.begin());
+	neighbourIndex.resize(neighbourStart[numPoints]);
+	neighbourWeight.resize(neighbourStart[numPoints]);
+
+	#pragma omp parallel for
+	for (int pointIdx = 0; pointIdx < numPoints; ++pointIdx)
+	{
+		unsigned offset = neighbourStart[pointIdx];
+		grid.forEachNeighbour(vec3(_points[pointIdx]), maxDistance, [&](unsigned neighbourIdx, float distance2)
+			{
+				if (neighbourIdx == static_cast<unsigned>(pointIdx)) return;
+
+				const float distance = glm::max(glm::sqrt(distance2), minDistance);
+				neighbourIndex[offset] = neighbourIdx;
+				neighbourWeight[offset] = glm::pow(1.0f - distance / maxDistance, ELIMINATION_ALPHA);
+				weight[pointIdx] += neighbourWeight[offset++];
+			});
+	}
+
+	// Max-heap with lazy updates: outdated entries are discarded when popped
+	std::vector<std::pair<float, unsigned>> heap(numPoints);
+	std::vector<uint8_t> eliminated(numPoints, 0);
+	std::vector<unsigned> eliminationOrder;
+	eliminationOrder.reserve(numPoints - targetPoints);
 
-	for (const vec4& point : points)
-		cloud->push_back(pcl::PointXYZ(point.x, point.y, point.z));
+	for (unsigned pointIdx = 0; pointIdx < numPoints; ++pointIdx)
+		heap[pointIdx] = std::make_pair(weight[pointIdx], pointIdx);
+	std::make_heap(heap.begin(), heap.end());
+
+	while (eliminationOrder.size() < numPoints - targetPoints)
+	{
+		std::pop_heap(heap.begin(), heap.end());
+		const auto [pointWeight, pointIdx] = heap.back();
+		heap.pop_back();
 
-	std::stringstream compressedData;
-	encoder->encodePointCloud(cloud, compressedData);
+		if (eliminated[pointIdx] || pointWeight != weight[pointIdx]) continue;
 
-	std::ofstream file(filename, std::ios::out | std::ios::binary);
-	if (!file.is_open()) return;
+		eliminated[pointIdx] = 1;
+		eliminationOrder.push_back(pointIdx);
+
+		for (unsigned neighbour = neighbourStart[pointIdx]; neighbour < neighbourStart[pointIdx + 1]; ++neighbour)
+		{
+			const unsigned neighbourIdx = neighbourIndex[neighbour];
+			if (eliminated[neighbourIdx]) continue;
+
+			weight[neighbourIdx] -= neighbourWeight[neighbour];
+			heap.push_back(std::make_pair(weight[neighbourIdx], neighbourIdx));
+			std::push_heap(heap.begin(), heap.end());
+		}
+	}
 
-	file.write(compressedData.str().c_str(), compressedData.str().length());
-	file.close();
+	// Survivors first, then the eliminated points from the last to the first one
+	std::vector<unsigned> order;
+	order.reserve(numPoints);
+	for (unsigned pointIdx = 0; pointIdx < numPoints; ++pointIdx)
+		if (!eliminated[pointIdx]) order.push_back(pointIdx);
+	order.insert(order.end(), eliminationOrder.rbegin(), eliminationOrder.rend());
 
-	delete encoder;
+	this->reorderPoints(order);
 }
 
-void PointCloud3D::savePLY(const std::string& filename, const std::vector<glm::vec4>&& points)
+PointCloud3D::SharedPointBuffer PointCloud3D::getExportBuffer()
 {
-	std::vector<std::array<double, 3>> vertices(points.size());
-	#pragma omp parallel for
-	for (int idx = 0; idx < points.size(); ++idx)
-		vertices[idx] = { points[idx].x, points[idx].z, points[idx].y };
+	if (!_exportBuffer)
+	{
+		std::shared_ptr<PointBuffer> buffer = std::make_shared<PointBuffer>();
+		const bool hasNormals = this->hasNormals(), hasFractureLabels = this->hasFractureLabels();
+
+#if TESTING_FORMAT_MODE
+		buffer->_points = _points;
+		if (hasNormals) buffer->_normals = _normals;
+		if (hasFractureLabels) buffer->_fractureLabels = _fractureLabels;
+#else
+		buffer->_points = std::move(_points);
+		if (hasNormals) buffer->_normals = std::move(_normals);
+		if (hasFractureLabels) buffer->_fractureLabels = std::move(_fractureLabels);
+
+		_points.clear();
+		_normals.clear();
+		_fractureLabels.clear();
+#endif
+
+		_exportBuffer = buffer;
+	}
 
-	happly::PLYData plyOut;
-	plyOut.addVertexPositions(vertices);
-	plyOut.write(filename, happly::DataFormat::Binary);
+	return _exportBuffer;
 }
 
-void PointCloud3D::saveXYZ(const std::string& filename, const std::vector<glm::vec4>&& points)
+void PointCloud3D::reorderPoints(const std::vector<unsigned>& order)
 {
-	std::ofstream file(filename);
-	if (!file.is_open()) return;
+	const size_t numPoints = _points.size();
+	const auto reorder = [&](auto& values)
+	{
+		if (values.size() != numPoints) return;
+
+		std::remove_reference_t<decltype(values)> reordered(order.size());
+		for (size_t idx = 0; idx < order.size(); ++idx)
+			reordered[idx] = values[order[idx]];
+		std::copy(reordered.begin(), reordered.end(), values.begin());
+	};
+
+	reorder(_color);
+	reorder(_normals);
+	reorder(_fractureLabels);
+	reorder(_points);
+	_exportBuffer.reset();
+}
+
+void PointCloud3D::resizePoints(size_t numPoints)
+{
+	if (_color.size() == _points.size()) _color.resize(numPoints);
+	if (_normals.size() == _points.size()) _normals.resize(numPoints);
+	if (_fractureLabels.size() == _points.size()) _fractureLabels.resize(numPoints);
+	_points.resize(numPoints);
+	_exportBuffer.reset();
+}
+
+void PointCloud3D::swapPoints(size_t index1, size_t index2)
+{
+	if (_color.size() == _points.size()) std::swap(_color[index1], _color[index2]);
+	if (_normals.size() == _points.size()) std::swap(_normals[index1], _normals[index2]);
+	if (_fractureLabels.size() == _points.size()) std::swap(_fractureLabels[index1], _fractureLabels[index2]);
+	std::swap(_points[index1], _points[index2]);
+	_exportBuffer.reset();
+}
 
-	for (const vec4& point : points)
-		file << point.x << " " << point.y << " " << point.z << std::endl;
+void PointCloud3D::saveCompressed(const std::string& filename, SharedPointBuffer buffer, size_t numPoints, ExportContainer* container)
+{
+	ExportContainer::write(container, filename, [&buffer, numPoints](std::ostream& stream)
+		{
+			PointCloudCodec::write(stream, buffer->_points.data(), buffer->_normals.empty() ? nullptr : buffer->_normals.data(),
+				buffer->_fractureLabels.empty() ? nullptr : buffer->_fractureLabels.data(), numPoints);
+		});
+}
 
-	file.close();
+void PointCloud3D::savePLY(const std::string& filename, SharedPointBuffer buffer, size_t numPoints, ExportContainer* container)
+{
+	const bool hasNormals = !buffer->_normals.empty(), hasLabels = !buffer->_fractureLabels.empty();
+	const size_t recordSize = 3 * sizeof(float) + (hasNormals ? 3 * sizeof(float) : 0) + (hasLabels ? sizeof(uint8_t) : 0);
+
+	std::string header = "ply\nformat binary_little_endian 1.0\nelement vertex " + std::to_string(numPoints) + "\n";
+	header += "property float x\nproperty float y\nproperty float z\n";
+	if (hasNormals)
+		header += "property float nx\nproperty float ny\nproperty float nz\n";
+	if (hasLabels)
+		header += "property uchar fracture\n";
+	header += "end_header\n";
+
+	ExportContainer::write(container, filename, [&buffer, &header, numPoints, recordSize, hasNormals, hasLabels](std::ostream& stream)
+		{
+			const size_t pointsPerBlock = std::max(static_cast<size_t>(1), WRITE_BUFFER_SIZE / recordSize);
+			std::vector<char> block(std::min(numPoints, pointsPerBlock) * recordSize);
+
+			stream.write(header.data(), header.size());
+
+			for (size_t first = 0; first < numPoints; first += pointsPerBlock)
+			{
+				const size_t last = std::min(numPoints, first + pointsPerBlock);
+				char* record = block.data();
+
+				// Records are packed as in the header, swapping y and z
+				for (size_t idx = first; idx < last; ++idx)
+				{
+					const vec4& point = buffer->_points[idx];
+					const float position[3] = { point.x, point.z, point.y };
+					std::memcpy(record, position, sizeof(position));
+					record += sizeof(position);
+
+					if (hasNormals)
+					{
+						const vec3& normal = buffer->_normals[idx];
+						const float components[3] = { normal.x, normal.z, normal.y };
+						std::memcpy(record, components, sizeof(components));
+						record += sizeof(components);
+					}
+
+					if (hasLabels)
+						*record++ = static_cast<char>(buffer->_fractureLabels[idx]);
+				}
+
+				stream.write(block.data(), record - block.data());
+			}
+		});
 }
 
+void PointCloud3D::saveXYZ(const std::string& filename, SharedPointBuffer buffer, size_t numPoints, ExportContainer* container)
+{
+	const std::vector<vec4>& points = buffer->_points;
+
+	ExportContainer::write(container, filename, [&points, numPoints](std::ostream& file)
+		{
+			// Three shortest round-trip floats and their separators always fit in MAX_LINE_LENGTH characters
+			const size_t MAX_LINE_LENGTH = 3 * 16 + 3;
+			std::vector<char> text(WRITE_BUFFER_SIZE + MAX_LINE_LENGTH);
+			char* end = text.data();
+
+			for (size_t idx = 0; idx < numPoints; ++idx)
+			{
+				for (int axis = 0; axis < 3; ++axis)
+				{
+					end = std::to_chars(end, text.data() + text.size(), points[idx][axis]).ptr;
+					*end++ = axis < 2 ? ' ' : '\n';
+				}
+
+				if (end - text.data() >= static_cast<std::ptrdiff_t>(WRITE_BUFFER_SIZE))
+				{
+					file.write(text.data(), end - text.data());
+					end = text.data();
+				}
+			}
+
+			file.write(text.data(), end - text.data());
+		});
+}
@@ -2,9 +2,8 @@
 
 #include "Geometry/3D/AABB.h"
 #include "Graphics/Core/FractureParameters.h"
-#include "pcl/point_cloud.h"
-#include "pcl/point_types.h"
-#include "pcl/compression/octree_pointcloud_compression.h"
+
+class ExportContainer;
 
 /**
 *	@file PointCloud3D.h
@@ -17,15 +16,65 @@
 */
 class PointCloud3D
 {
+public:
+	/**
+	*	@brief Points and attributes handed to the saving threads. Attributes are either empty or have one value per point.
+	*/
+	struct PointBuffer
+	{
+		std::vector<vec4>		_points;				//!< Positions
+		std::vector<vec3>		_normals;				//!< Surface normals
+		std::vector<uint8_t>	_fractureLabels;		//!< 1 for points on the fracture surface, 0 for points on the original surface
+	};
+
+	typedef std::shared_ptr<const PointBuffer> SharedPointBuffer;
+
+protected:
+	const static float		ELIMINATION_ALPHA;			//!< Exponent of the weight function of sample elimination
+	const static float		ELIMINATION_BETA;			//!< Weight limiting: fraction of the maximum radius under which distances are clamped
+	const static float		ELIMINATION_GAMMA;			//!< Weight limiting: exponent applied to the ratio of output and input samples
+	const static size_t		WRITE_BUFFER_SIZE;			//!< Bytes formatted before each write of the point cloud writers
+
+protected:
 	std::vector<vec4>		_points;					//!< Point cloud
 	std::vector<float>		_color;						//!< Vertex-wise colouring of point cloud
+	std::vector<vec3>		_normals;					//!< Point-wise normals, empty if unknown
+	std::vector<uint8_t>	_fractureLabels;			//!< Point-wise mark of fracture-surface points, empty if unknown
 	AABB					_aabb;						//!< Boundaries
+	SharedPointBuffer		_exportBuffer;				//!< Points handed to the saving threads, shared by every prefix that is saved
 
 protected:
-	// Parallel saving
-	void saveCompressed(const std::string& filename, const std::vector<glm::vec4>&& points);
-	void savePLY(const std::string& filename, const std::vector<glm::vec4>&& points);
-	void saveXYZ(const std::string& filename, const std::vector<glm::vec4>&& points);
+	/**
+	*	@brief Returns the buffer shared with the saving threads, moving the points into it the first time.
+	*/
+	SharedPointBuffer getExportBuffer();
+
+	/**
+	*	@brief Weighted sample elimination (Yuksel, 2015) over the first numPoints points. The survivors are moved to the first targetPoints 
+	*	positions, followed by the eliminated points in reverse elimination order.
+	*	@param surfaceArea Area of the sampled surface, which determines the neighbourhood radius.
+	*/
+	void eliminateSamples(unsigned numPoints, unsigned targetPoints, float surfaceArea);
+
+	/**
+	*	@brief Moves the point order[i] to the i-th position, together with its attributes. The order may cover just a prefix of the cloud.
+	*/
+	void reorderPoints(const std::vector<unsigned>& order);
+
+	/**
+	*	@brief Keeps the first numPoints points and their attributes.
+	*/
+	void resizePoints(size_t numPoints);
+
+	/**
+	*	@brief Swaps two points together with their attributes.
+	*/
+	void swapPoints(size_t index1, size_t index2);
+
+	// Parallel saving. Only the first numPoints points of the buffer are written, either to a file or to a container entry
+	static void saveCompressed(const std::string& filename, SharedPointBuffer buffer, size_t numPoints, ExportContainer* container);
+	static void savePLY(const std::string& filename, SharedPointBuffer buffer, size_t numPoints, ExportContainer* container);
+	static void saveXYZ(const std::string& filename, SharedPointBuffer buffer, size_t numPoints, ExportContainer* container);
 
 public:
 	/**
@@ -57,7 +106,7 @@ public:
 	/**
 	*	@brief Removes all the points.
 	*/
-	void clear() { _points.clear(); }
+	void clear() { _points.clear(); _color.clear(); _normals.clear(); _fractureLabels.clear(); _exportBuffer.reset(); }
 
 	/**
 	*	@brief 
@@ -69,6 +118,16 @@ public:
 	*/
 	std::vector<float>* getColors() { return &_color; }
 
+	/**
+	*	@return Fracture-surface labels, one per point.
+	*/
+	std::vector<uint8_t>* getFractureLabels() { return &_fractureLabels; }
+
+	/**
+	*	@return Normal vectors, one per point.
+	*/
+	std::vector<vec3>* getNormals() { return &_normals; }
+
 	/**
 	*	@brief Returns the number of points in the cloud.
 	*/
@@ -84,11 +143,27 @@ public:
 	*/
 	std::vector<vec4>* getPoints() { return &_points; }
 
+	/**
+	*	@return True if every point has a fracture-surface label.
+	*/
+	bool hasFractureLabels() const { return !_points.empty() && _fractureLabels.size() == _points.size(); }
+
+	/**
+	*	@return True if every point has a normal.
+	*/
+	bool hasNormals() const { return !_points.empty() && _normals.size() == _points.size(); }
+
 	/**
 	*	@brief Modifies this point cloud as it now contains the points included in the new point cloud.
 	*/
 	void joinPointCloud(PointCloud3D* pointCloud);
 
+	/**
+	*	@brief Replaces the content of the cloud with a point cloud saved as .binp (see PointCloudCodec). Points are loaded in Morton order.
+	*	@return Success of operation.
+	*/
+	bool loadCompressed(const std::string& filename);
+
 	/**
 	*	@brief Assigment operator.
 	*/
@@ -105,9 +180,31 @@ public:
 	void push_back(const vec4* points, unsigned numPoints);
 
 	/**
-	*	@brief Saves the point cloud according to the required extension. Performed in a different thread.
+	*	@brief Adds a new buffer of points with their normals and fracture-surface labels.
+	*/
+	void push_back(const vec4* points, const vec3* normals, const uint8_t* fractureLabels, unsigned numPoints);
+
+	/**
+	*	@brief Saves the point cloud according to the required extension. Performed by the export pool.
+	*	@param numPoints Only the first numPoints points are saved. Once the points are randomly ordered (see shuffle), every prefix 
+	*	is a subsample of the whole cloud, so several resolutions can be saved from the same buffer without copying it.
+	*	@param container If not null, the point cloud is written as an entry of the container.
+	*	@return Future which is ready once the file is written.
+	*/
+	std::future<void> save(const std::string& filename, FractureParameters::ExportPointCloudExtension pointCloudExtension, size_t numPoints = std::numeric_limits<size_t>::max(), ExportContainer* container = nullptr);
+
+	/**
+	*	@brief Reduces the cloud to numPoints points with blue-noise distribution by eliminating the samples with the densest neighbourhood. 
+	*	The remaining points are progressively ordered, so that every prefix is also evenly spaced over the surface.
+	*	@param surfaceArea Area of the sampled surface.
+	*/
+	void eliminate(unsigned numPoints, float surfaceArea);
+
+	/**
+	*	@brief Randomly orders the first prefixLength points (partial Fisher-Yates), drawing them uniformly from the whole cloud. 
+	*	Uses the seeded generator from RandomUtilities so that datasets are reproducible.
 	*/
-	std::thread* save(const std::string& filename, FractureParameters::ExportPointCloudExtension pointCloudExtension);
+	void shuffle(size_t prefixLength = std::numeric_limits<size_t>::max());
 
 	/**
 	*	@brief Number of points that this cloud contains.
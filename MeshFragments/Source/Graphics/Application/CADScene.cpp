@@ -2,6 +2,7 @@
 #include "CADScene.h"
 
 #include "DataStructures/FragmentGraph.h"
+#include "DataStructures/FragmentShardWriter.h"
 #include "DataStructures/WingedTriangleMesh.h"
 #include "Geometry/3D/PointCloud3D.h"
 #include "Graphics/Application/TextureList.h"
@@ -16,8 +17,10 @@
 #include "Graphics/Core/Voronoi.h"
 #include "progressbar.hpp"
 #include "Utilities/ChronoUtilities.h"
+#include "Utilities/ExportPool.h"
 #include "Utilities/FileManagement.h"
 #include "Utilities/ResourceTracker.h"
+#include "Utilities/ZipArchive.h"
 
 /// Initialization of static attributes
 const std::string CADScene::INTERACTIVE_APP_FOLDER = "Output/";
@@ -27,7 +30,7 @@ const std::string CADScene::TARGET_PATH = "D:/allopezr/Research/serapis.obj";
 // [Public methods]
 
 CADScene::CADScene() :
-	_aabbRenderer(nullptr), _fragmentBoundaries(nullptr), _generateDataset(false), _mesh(nullptr), _meshGrid(nullptr), _pointCloud(nullptr), _pointCloudRenderer(nullptr)
+	_aabbRenderer(nullptr), _fragmentBoundaries(nullptr), _generateDataset(false), _mesh(nullptr), _meshGrid(nullptr), _pointCloud(nullptr), _pointCloudRenderer(nullptr), _shardModel(0), _shardWriter(nullptr)
 {
 	_aabbRenderer = new AABBSet();
 	_aabbRenderer->load();
@@ -39,6 +42,9 @@ CADScene::CADScene() :
 
 CADScene::~CADScene()
 {
+	this->closeExportArchives();
+	delete _shardWriter;
+
 	delete _aabbRenderer;
 	delete _fragmentBoundaries;
 	delete _mesh;
@@ -53,17 +59,22 @@ void CADScene::exportFragments(const FractureParameters& fractureParameters, con
 	const std::string folder = INTERACTIVE_APP_FOLDER + _mesh->getShortName() + "/";
 	if (!std::filesystem::exists(folder)) std::filesystem::create_directory(folder);
 
+	std::vector<std::future<void>> pendingExports;
+
 	for (int idx = 0; idx < _fractureMeshes.size(); ++idx)
-		dynamic_cast<CADModel*>(_fractureMeshes[idx])->save(folder + "mesh_" + std::to_string(idx), static_cast<FractureParameters::ExportMeshExtension>(fractureParameters._exportMeshExtension));
+		pendingExports.push_back(dynamic_cast<CADModel*>(_fractureMeshes[idx])->save(folder + "mesh_" + std::to_string(idx), static_cast<FractureParameters::ExportMeshExtension>(fractureParameters._exportMeshExtension)));
 
 	for (int idx = 0; idx < _fractureMeshes.size(); ++idx)
 	{
 		for (int targetCount : fractureParameters._targetTriangles)
 		{
 			dynamic_cast<CADModel*>(_fractureMeshes[idx])->simplify(targetCount);
-			dynamic_cast<CADModel*>(_fractureMeshes[idx])->save(folder + "mesh_" + std::to_string(idx) + "_" + std::to_string(targetCount), static_cast<FractureParameters::ExportMeshExtension>(fractureParameters._exportMeshExtension));
+			pendingExports.push_back(dynamic_cast<CADModel*>(_fractureMeshes[idx])->save(folder + "mesh_" + std::to_string(idx) + "_" + std::to_string(targetCount), static_cast<FractureParameters::ExportMeshExtension>(fractureParameters._exportMeshExtension)));
 		}
 	}
+
+	const unsigned failedExports = ExportPool::collect(pendingExports);
+	if (failedExports) std::cout << failedExports << " exports failed" << std::endl;
 }
 
 void CADScene::exportGrid(const FractureParameters& fractureParameters)
@@ -86,14 +97,24 @@ void CADScene::exportGrid(FractureParameters& fractureParameters, const std::str
 		{
 			fractureParameters._exportGridExtension = static_cast<FractureParameters::ExportGrid>(gridFormat);
 		#endif
-			_meshGrid->exportGrid(folder + meshName + "_grid_" + std::to_string(maxDimension) + "r", true, static_cast<FractureParameters::ExportGrid>(fractureParameters._exportGridExtension));
+			const std::string filename = folder + meshName + "_grid_" + std::to_string(maxDimension) + "r";
+
+			if (_shardWriter)
+			{
+				FragmentationProcedure::FragmentMetadata metadata{};
+				metadata._type = FragmentationProcedure::VOXEL;
+				metadata._voxelizationSize = fractureParameters._voxelizationSize;
+				this->expectGridShardEntries(metadata, filename, 0, 0, static_cast<FractureParameters::ExportGrid>(fractureParameters._exportGridExtension));
+			}
+
+			_meshGrid->exportGrid(filename, true, static_cast<FractureParameters::ExportGrid>(fractureParameters._exportGridExtension), this->getExportContainer(FractureParameters::ExportGrid_STR[fractureParameters._exportGridExtension]));
 		#if TESTING_FORMAT_MODE
 		}
 		#endif
 	}
 }
 
-void CADScene::exportMesh(FractureParameters& fractureParameters, const std::string& folder)
+void CADScene::exportMesh(FractureParameters& fractureParameters, const std::string& folder, std::vector<std::future<void>>* pendingExports)
 {
 	const std::string meshName = _mesh->getShortName();
 
@@ -104,7 +125,18 @@ void CADScene::exportMesh(FractureParameters& fractureParameters, const std::str
 		{
 			fractureParameters._exportMeshExtension = static_cast<FractureParameters::ExportMeshExtension>(meshFormat);
 		#endif
-			_mesh->save(folder + meshName, static_cast<FractureParameters::ExportMeshExtension>(fractureParameters._exportMeshExtension));
+			if (_shardWriter)
+			{
+				FragmentationProcedure::FragmentMetadata metadata{};
+				metadata._type = FragmentationProcedure::MESH;
+				metadata._vesselName = folder + meshName + "." + FractureParameters::ExportMesh_STR[fractureParameters._exportMeshExtension];
+				metadata._numVertices = _mesh->getNumVertices();
+				metadata._numFaces = _mesh->getNumFaces();
+				this->expectShardEntry(metadata, 0, 0, FragmentShard::WHOLE_MODEL, fractureParameters._exportMeshExtension, 0);
+			}
+
+			std::future<void> future = _mesh->save(folder + meshName, static_cast<FractureParameters::ExportMeshExtension>(fractureParameters._exportMeshExtension), false, this->getExportContainer(FractureParameters::ExportMesh_STR[fractureParameters._exportMeshExtension]));
+			if (pendingExports) pendingExports->push_back(std::move(future));
 		#if TESTING_FORMAT_MODE
 		}
 		#endif
@@ -119,7 +151,18 @@ void CADScene::exportMesh(FractureParameters& fractureParameters, const std::str
 			{
 				fractureParameters._exportMeshExtension = static_cast<FractureParameters::ExportMeshExtension>(meshFormat);
 			#endif
-				_mesh->save(folder + meshName + "_" + std::to_string(numTriangles) + "t", static_cast<FractureParameters::ExportMeshExtension>(fractureParameters._exportMeshExtension));
+				if (_shardWriter)
+				{
+					FragmentationProcedure::FragmentMetadata metadata{};
+					metadata._type = FragmentationProcedure::MESH;
+					metadata._vesselName = folder + meshName + "_" + std::to_string(numTriangles) + "t." + FractureParameters::ExportMesh_STR[fractureParameters._exportMeshExtension];
+					metadata._numVertices = _mesh->getNumVertices();
+					metadata._numFaces = _mesh->getNumFaces();
+					this->expectShardEntry(metadata, 0, 0, FragmentShard::WHOLE_MODEL, fractureParameters._exportMeshExtension, numTriangles);
+				}
+
+				std::future<void> future = _mesh->save(folder + meshName + "_" + std::to_string(numTriangles) + "t", static_cast<FractureParameters::ExportMeshExtension>(fractureParameters._exportMeshExtension), false, this->getExportContainer(FractureParameters::ExportMesh_STR[fractureParameters._exportMeshExtension]));
+				if (pendingExports) pendingExports->push_back(std::move(future));
 			#if TESTING_FORMAT_MODE
 			}
 			#endif
@@ -132,38 +175,58 @@ void CADScene::exportPointClouds(const FractureParameters& fractureParameters)
 	const std::string folder = INTERACTIVE_APP_FOLDER + _mesh->getShortName() + "/";
 	if (!std::filesystem::exists(folder)) std::filesystem::create_directory(folder);
 
+	if (fractureParameters._targetPoints.empty()) return;
+
+	std::vector<std::future<void>> pendingExports;
+
 	for (int idx = 0; idx < _fragmentMetadata.size(); ++idx)
 	{
+		// Smaller clouds are prefixes of the largest one
+		const int maxTargetPoints = *std::max_element(fractureParameters._targetPoints.begin(), fractureParameters._targetPoints.end());
+		PointCloud3D* pc = dynamic_cast<CADModel*>(_fractureMeshes[idx])->sampleSurface(maxTargetPoints, fractureParameters._pointCloudSeedingRandom, fractureParameters._pointCloudSampling);
 		for (int targetCount : fractureParameters._targetPoints)
-		{
-			PointCloud3D* pc = dynamic_cast<CADModel*>(_fractureMeshes[idx])->sampleCPU(targetCount, fractureParameters._pointCloudSeedingRandom);
-			pc->save(folder + std::to_string(targetCount), static_cast<FractureParameters::ExportPointCloudExtension>(fractureParameters._exportPointCloudExtension));
-			delete pc;
-		}
+			pendingExports.push_back(pc->save(folder + std::to_string(targetCount), static_cast<FractureParameters::ExportPointCloudExtension>(fractureParameters._exportPointCloudExtension), targetCount));
+		delete pc;
 	}
+
+	const unsigned failedExports = ExportPool::collect(pendingExports);
+	if (failedExports) std::cout << failedExports << " exports failed" << std::endl;
 }
 
-void CADScene::exportPointCloud(FractureParameters& fractureParameters, const std::string& folder)
+void CADScene::exportPointCloud(FractureParameters& fractureParameters, const std::string& folder, std::vector<std::future<void>>* pendingExports)
 {
 	if (!fractureParameters._targetPoints.empty())
 	{
 		const std::string meshName = _mesh->getShortName();
 
+		const int maxTargetPoints = *std::max_element(fractureParameters._targetPoints.begin(), fractureParameters._targetPoints.end());
+		PointCloud3D* pointCloud = _mesh->sampleSurface(maxTargetPoints, fractureParameters._pointCloudSeedingRandom, fractureParameters._pointCloudSampling);
+		const size_t numSampledPoints = pointCloud->getNumPoints();
+
 		for (int targetPoints : fractureParameters._targetPoints)
 		{
-			PointCloud3D* pointCloud = _mesh->sampleCPU(targetPoints, fractureParameters._pointCloudSeedingRandom);
 			#if TESTING_FORMAT_MODE
 			for (int pointCloudFormat = 0; pointCloudFormat < FractureParameters::NUM_POINT_CLOUD_EXTENSIONS; ++pointCloudFormat)
 			{
 				fractureParameters._exportPointCloudExtension = static_cast<FractureParameters::ExportPointCloudExtension>(pointCloudFormat);
 			#endif
-				pointCloud->save(folder + meshName + "_" + std::to_string(targetPoints) + "p", static_cast<FractureParameters::ExportPointCloudExtension>(fractureParameters._exportPointCloudExtension));
+				if (_shardWriter)
+				{
+					FragmentationProcedure::FragmentMetadata metadata{};
+					metadata._type = FragmentationProcedure::POINT_CLOUD;
+					metadata._vesselName = folder + meshName + "_" + std::to_string(targetPoints) + "p." + FractureParameters::ExportPointCloud_STR[fractureParameters._exportPointCloudExtension];
+					metadata._numPoints = static_cast<uint32_t>(std::min(numSampledPoints, static_cast<size_t>(targetPoints)));
+					this->expectShardEntry(metadata, 0, 0, FragmentShard::WHOLE_MODEL, fractureParameters._exportPointCloudExtension, targetPoints);
+				}
+
+				std::future<void> future = pointCloud->save(folder + meshName + "_" + std::to_string(targetPoints) + "p", static_cast<FractureParameters::ExportPointCloudExtension>(fractureParameters._exportPointCloudExtension), targetPoints, this->getExportContainer(FractureParameters::ExportPointCloud_STR[fractureParameters._exportPointCloudExtension]));
+				if (pendingExports) pendingExports->push_back(std::move(future));
 			#if TESTING_FORMAT_MODE
 			}
 			#endif
-
-			delete pointCloud;
 		}
+
+		delete pointCloud;
 	}
 }
 
@@ -232,6 +295,14 @@ void CADScene::generateDataset(FragmentationProcedure& fractureProcedure, const
 	tracker->track(10000);
 
 	this->_generateDataset = true;
+	ExportPool::getInstance()->configure(fractureProcedure._exportThreads, fractureProcedure._exportQueueSize);
+
+	if (fractureProcedure._storageContainer == FragmentationProcedure::SHARDS)
+	{
+		_shardWriter = new FragmentShardWriter();
+		if (!_shardWriter->open(fractureProcedure._currentDestinationFolder + "fragments"))
+			throw std::runtime_error("Failed to create the sharded dataset in " + fractureProcedure._currentDestinationFolder);
+	}
 
 	tracker->recordEvent(ResourceTracker::MEMORY_ALLOCATION);
 	this->allocateMemoryDataset(fractureProcedure);
@@ -239,7 +310,8 @@ void CADScene::generateDataset(FragmentationProcedure& fractureProcedure, const
 	for (const std::string& path : fileList)
 	{
 		std::vector<FragmentationProcedure::FragmentMetadata> modelMetadata;
-		std::vector<std::thread*> threads;
+		std::vector<std::future<void>> pendingExports;
+		unsigned failedGridExports = 0;
 
 		tracker->recordEvent(ResourceTracker::MODEL_LOAD);
 		this->loadModel(path);
@@ -249,6 +321,10 @@ void CADScene::generateDataset(FragmentationProcedure& fractureProcedure, const
 		const std::string meshFile = meshFolder + modelName + "_";
 		if (!std::filesystem::exists(meshFolder)) std::filesystem::create_directory(meshFolder);
 
+		// Every file of the model is stored in a single archive per extension, or in the shards of the whole dataset
+		if (fractureProcedure._storageContainer == FragmentationProcedure::ZIP_ARCHIVES) _exportArchivePrefix = meshFile;
+		if (_shardWriter) _shardModel = _shardWriter->addModel(modelName);
+
 		// Calculate size of voxelization according to model size
 		const AABB aabb = _mesh->getAABB();
 		fractureProcedure._fractureParameters._voxelizationSize = glm::ceil(aabb.size() * vec3(fractureProcedure._fractureParameters._voxelPerMetricUnit));
@@ -271,7 +347,7 @@ void CADScene::generateDataset(FragmentationProcedure& fractureProcedure, const
 		
 		tracker->recordEvent(ResourceTracker::VOXELIZATION);
 		_meshGrid->setAABB(_mesh->getAABB(), fractureProcedure._fractureParameters._voxelizationSize);
-		_meshGrid->fill(_mesh);
+		_meshGrid->fill(_mesh, fractureProcedure._fractureParameters);
 		tracker->recordEvent(ResourceTracker::MEMORY_ALLOCATION);
 		_meshGrid->resetMarchingCubes();
 
@@ -279,10 +355,10 @@ void CADScene::generateDataset(FragmentationProcedure& fractureProcedure, const
 		tracker->recordEvent(ResourceTracker::STORAGE);
 
 		if (fractureProcedure._fractureParameters._exportPointCloud)
-			this->exportPointCloud(fractureProcedure._fractureParameters, meshFolder);
+			this->exportPointCloud(fractureProcedure._fractureParameters, meshFolder, &pendingExports);
 
 		if (fractureProcedure._fractureParameters._exportMesh)
-			this->exportMesh(fractureProcedure._fractureParameters, meshFolder);
+			this->exportMesh(fractureProcedure._fractureParameters, meshFolder, &pendingExports);
 
 		if (fractureProcedure._fractureParameters._exportGrid)
 			this->exportGrid(fractureProcedure._fractureParameters, meshFolder);
@@ -329,13 +405,15 @@ void CADScene::generateDataset(FragmentationProcedure& fractureProcedure, const
 					{
 						fractureProcedure._fractureParameters._exportGridExtension = static_cast<FractureParameters::ExportGrid>(gridFormat);
 						#endif
-						_meshGrid->exportGrid(itFile, true, static_cast<FractureParameters::ExportGrid>(fractureProcedure._fractureParameters._exportGridExtension));
-
 						FragmentationProcedure::FragmentMetadata metadata;
 						metadata._type = FragmentationProcedure::VOXEL;
 						metadata._vesselName = itFile + "." + FractureParameters::ExportGrid_STR[fractureProcedure._fractureParameters._exportGridExtension];
 						metadata._voxelizationSize = fractureProcedure._fractureParameters._voxelizationSize;
 						localMetadata.push_back(metadata);
+
+						this->expectGridShardEntries(metadata, itFile, numFragments, iteration, static_cast<FractureParameters::ExportGrid>(fractureProcedure._fractureParameters._exportGridExtension));
+						if (!_meshGrid->exportGrid(itFile, true, static_cast<FractureParameters::ExportGrid>(fractureProcedure._fractureParameters._exportGridExtension), this->getExportContainer(FractureParameters::ExportGrid_STR[fractureProcedure._fractureParameters._exportGridExtension])))
+							++failedGridExports;
 					#if TESTING_FORMAT_MODE
 					}
 					#endif
@@ -348,11 +426,15 @@ void CADScene::generateDataset(FragmentationProcedure& fractureProcedure, const
 					std::string simplificationFilename;
 
 					// Point clouds
-					if (fractureProcedure._fractureParameters._exportPointCloud)
+					if (fractureProcedure._fractureParameters._exportPointCloud && !fractureProcedure._fractureParameters._targetPoints.empty())
 					{
-						for (int targetCount : fractureProcedure._fractureParameters._targetPoints)
+						// Single sampling pass with the largest target; the remaining ones are saved as prefixes of the same buffer
+						const std::vector<int>& targetPoints = fractureProcedure._fractureParameters._targetPoints;
+						PointCloud3D* pointCloud = cadModel->sampleSurface(*std::max_element(targetPoints.begin(), targetPoints.end()), fractureProcedure._fractureParameters._pointCloudSeedingRandom, fractureProcedure._fractureParameters._pointCloudSampling);
+						const size_t numSampledPoints = pointCloud->getNumPoints();
+
+						for (int targetCount : targetPoints)
 						{
-							PointCloud3D* pointCloud = dynamic_cast<CADModel*>(fracture)->sampleCPU(targetCount, fractureProcedure._fractureParameters._pointCloudSeedingRandom);
 							simplificationFilename = filename + "_" + std::to_string(targetCount) + "p";
 
 							#if TESTING_FORMAT_MODE
@@ -363,16 +445,17 @@ void CADScene::generateDataset(FragmentationProcedure& fractureProcedure, const
 								FragmentationProcedure::FragmentMetadata metadata;
 								metadata._type = FragmentationProcedure::POINT_CLOUD;
 								metadata._vesselName = simplificationFilename + "." + FractureParameters::ExportPointCloud_STR[fractureProcedure._fractureParameters._exportPointCloudExtension];
-								metadata._numPoints = pointCloud->getNumPoints();
+								metadata._numPoints = std::min(numSampledPoints, static_cast<size_t>(targetCount));
 								localMetadata.push_back(metadata);
 
-								threads.push_back(pointCloud->save(simplificationFilename, static_cast<FractureParameters::ExportPointCloudExtension>(fractureProcedure._fractureParameters._exportPointCloudExtension)));
+								this->expectShardEntry(metadata, numFragments, iteration, idx, fractureProcedure._fractureParameters._exportPointCloudExtension, targetCount);
+								pendingExports.push_back(pointCloud->save(simplificationFilename, static_cast<FractureParameters::ExportPointCloudExtension>(fractureProcedure._fractureParameters._exportPointCloudExtension), targetCount, this->getExportContainer(FractureParameters::ExportPointCloud_STR[fractureProcedure._fractureParameters._exportPointCloudExtension])));
 							#if TESTING_FORMAT_MODE
 							}
 							#endif
-
-							delete pointCloud;
 						}
+
+						delete pointCloud;
 					}
 
 					// Triangles
@@ -382,6 +465,7 @@ void CADScene::generateDataset(FragmentationProcedure& fractureProcedure, const
 						{
 							for (int targetCount : fractureProcedure._fractureParameters._targetTriangles)
 							{
+								const bool isLastTarget = targetCount == fractureProcedure._fractureParameters._targetTriangles.back();
 								cadModel->simplify(targetCount);
 
 								#if TESTING_FORMAT_MODE
@@ -396,7 +480,10 @@ void CADScene::generateDataset(FragmentationProcedure& fractureProcedure, const
 									fragmentMetadata[idx]._numFaces = fracture->getNumFaces();
 									localMetadata.push_back(fragmentMetadata[idx]);
 
-									threads.push_back(cadModel->save(simplificationFilename, static_cast<FractureParameters::ExportMeshExtension>(fractureProcedure._fractureParameters._exportMeshExtension)));
+									this->expectShardEntry(fragmentMetadata[idx], numFragments, iteration, idx, fractureProcedure._fractureParameters._exportMeshExtension, targetCount);
+
+									// The fragment is not needed after its last export, so its buffers are moved into the job
+									pendingExports.push_back(cadModel->save(simplificationFilename, static_cast<FractureParameters::ExportMeshExtension>(fractureProcedure._fractureParameters._exportMeshExtension), isLastTarget && !TESTING_FORMAT_MODE, this->getExportContainer(FractureParameters::ExportMesh_STR[fractureProcedure._fractureParameters._exportMeshExtension])));
 								#if TESTING_FORMAT_MODE
 								}
 								#endif
@@ -414,7 +501,8 @@ void CADScene::generateDataset(FragmentationProcedure& fractureProcedure, const
 								fragmentMetadata[idx]._numFaces = cadModel->getNumFaces();
 								localMetadata.push_back(fragmentMetadata[idx]);
 
-								threads.push_back(cadModel->save(filename, static_cast<FractureParameters::ExportMeshExtension>(fractureProcedure._fractureParameters._exportMeshExtension)));
+								this->expectShardEntry(fragmentMetadata[idx], numFragments, iteration, idx, fractureProcedure._fractureParameters._exportMeshExtension, 0);
+								pendingExports.push_back(cadModel->save(filename, static_cast<FractureParameters::ExportMeshExtension>(fractureProcedure._fractureParameters._exportMeshExtension), !TESTING_FORMAT_MODE, this->getExportContainer(FractureParameters::ExportMesh_STR[fractureProcedure._fractureParameters._exportMeshExtension])));
 							#if TESTING_FORMAT_MODE
 							}
 							#endif
@@ -427,6 +515,7 @@ void CADScene::generateDataset(FragmentationProcedure& fractureProcedure, const
 				numGeneratedFragments += _fractureMeshes.size();
 				modelMetadata.insert(modelMetadata.end(), localMetadata.begin(), localMetadata.end());
 				fragmentMetadata.clear();
+				ExportPool::collect(pendingExports, false);
 
 				this->eraseFragmentContent();
 			}
@@ -435,64 +524,13 @@ void CADScene::generateDataset(FragmentationProcedure& fractureProcedure, const
 		}
 
 		tracker->recordEvent(ResourceTracker::NULL_EVENT);
-		this->exportMetadata(meshFile, modelMetadata, std::to_string(maxDimension));
-
-		progressbar threadBar(threads.size());
-		std::cout << "Waiting threads to finish..." << std::endl;
-		for (int threadIdx = 0; threadIdx < threads.size(); ++threadIdx)
-		{
-			threadBar.update();
-			if (!threads[threadIdx]) continue;
-			threads[threadIdx]->join();
-			delete threads[threadIdx];
-		}
-
-		std::cout << std::endl;
+		if (!_shardWriter) this->exportMetadata(meshFile, modelMetadata, std::to_string(maxDimension));
 
-		if (fractureProcedure._compressResultingFiles)
-		{		
-			if (fractureProcedure._fractureParameters._exportGrid)
-			{
-				#if TESTING_FORMAT_MODE
-				for (int gridFormat = 0; gridFormat < FractureParameters::NUM_GRID_EXTENSIONS; ++gridFormat)
-				{
-					fractureProcedure._fractureParameters._exportGridExtension = static_cast<FractureParameters::ExportGrid>(gridFormat);
-				#endif
-					std::thread zipGrid(&CADScene::launchZipingProcess, this, meshFolder, FractureParameters::ExportGrid_STR[fractureProcedure._fractureParameters._exportGridExtension]);
-					zipGrid.detach();
-				#if TESTING_FORMAT_MODE
-				}
-				#endif
-			}
-
-			if (fractureProcedure._fractureParameters._exportMesh)
-			{
-				#if TESTING_FORMAT_MODE
-				for (int meshFormat = 0; meshFormat < FractureParameters::NUM_EXPORT_MESH_EXTENSIONS; ++meshFormat)
-				{
-					fractureProcedure._fractureParameters._exportMeshExtension = static_cast<FractureParameters::ExportMeshExtension>(meshFormat);
-				#endif
-					std::thread zipMesh(&CADScene::launchZipingProcess, this, meshFolder, FractureParameters::ExportMesh_STR[fractureProcedure._fractureParameters._exportMeshExtension]);
-					zipMesh.detach();
-				#if TESTING_FORMAT_MODE
-				}
-				#endif
-			}
+		std::cout << "Waiting for " << pendingExports.size() << " exports to finish..." << std::endl;
+		const unsigned failedExports = ExportPool::collect(pendingExports) + failedGridExports;
+		if (failedExports) std::cout << modelName << " - " << failedExports << " exports failed" << std::endl;
 
-			if (fractureProcedure._fractureParameters._exportPointCloud)
-			{
-				#if TESTING_FORMAT_MODE
-				for (int pointCloudFormat = 0; pointCloudFormat < FractureParameters::NUM_POINT_CLOUD_EXTENSIONS; ++pointCloudFormat)
-				{
-					fractureProcedure._fractureParameters._exportPointCloudExtension = static_cast<FractureParameters::ExportPointCloudExtension>(pointCloudFormat);
-				#endif
-					std::thread zipPointCloud(&CADScene::launchZipingProcess, this, meshFolder, FractureParameters::ExportPointCloud_STR[fractureProcedure._fractureParameters._exportPointCloudExtension]);
-					zipPointCloud.detach();
-				#if TESTING_FORMAT_MODE
-				}
-				#endif
-			}
-		}
+		this->closeExportArchives();
 
 		//if (!fractureProcedure._onlineFolder.empty())
 		//{
@@ -503,6 +541,14 @@ void CADScene::generateDataset(FragmentationProcedure& fractureProcedure, const
 		//}
 	}
 
+	if (_shardWriter)
+	{
+		if (!_shardWriter->close())
+			std::cout << "Index of the sharded dataset could not be written" << std::endl;
+		delete _shardWriter;
+		_shardWriter = nullptr;
+	}
+
 	tracker->closeStream();
 }
 
@@ -556,10 +602,23 @@ void CADScene::allocateMeshGrid(FractureParameters& fractParameters)
 	}
 
 	_meshGrid->setAABB(aabb, fractParameters._voxelizationSize);
-	_meshGrid->fill(_mesh);
+	_meshGrid->fill(_mesh, fractParameters);
 	_meshGrid->resetMarchingCubes();
 }
 
+void CADScene::closeExportArchives()
+{
+	for (auto& archive : _exportArchives)
+	{
+		if (archive.second->isOpen() && !archive.second->close())
+			std::cout << "Archive " << _exportArchivePrefix << archive.first << " could not be finalised" << std::endl;
+		delete archive.second;
+	}
+
+	_exportArchives.clear();
+	_exportArchivePrefix.clear();
+}
+
 void CADScene::eraseFragmentContent()
 {
 	delete _pointCloud;
@@ -690,17 +749,50 @@ std::string CADScene::fractureModel(FractureParameters& fractParameters)
 	return "";
 }
 
-void CADScene::launchZipingProcess(const std::string& folder, const std::string& extension)
+void CADScene::expectShardEntry(const FragmentationProcedure::FragmentMetadata& metadata, int numFragments, int iteration, int fragmentId, int format, unsigned lod)
+{
+	if (!_shardWriter) return;
+
+	FragmentShard::Key key;
+	key._model = _shardModel;
+	key._numFragments = static_cast<uint16_t>(numFragments);
+	key._iteration = static_cast<uint16_t>(iteration);
+	key._fragmentId = static_cast<uint16_t>(fragmentId);
+	key._type = static_cast<uint8_t>(metadata._type);
+	key._format = static_cast<uint8_t>(format);
+	key._lod = lod;
+
+	_shardWriter->expect(std::filesystem::path(metadata._vesselName).filename().string(), key, metadata);
+}
+
+void CADScene::expectGridShardEntries(FragmentationProcedure::FragmentMetadata metadata, const std::string& filename, int numFragments, int iteration, FractureParameters::ExportGrid format)
 {
-	// Time sleep	
-	//std::this_thread::sleep_for(std::chrono::seconds(60));
+	if (!_shardWriter) return;
+
+	const std::vector<std::string> filenames = _meshGrid->getExportFilenames(filename, format);
+	for (size_t fileIdx = 0; fileIdx < filenames.size(); ++fileIdx)
+	{
+		metadata._vesselName = filenames[fileIdx];
+		this->expectShardEntry(metadata, numFragments, iteration, FragmentShard::WHOLE_MODEL, format, static_cast<unsigned>(fileIdx));
+	}
+}
+
+ExportContainer* CADScene::getExportContainer(const std::string& extension)
+{
+	if (_shardWriter) return _shardWriter;
+	if (_exportArchivePrefix.empty()) return nullptr;
+
+	auto it = _exportArchives.find(extension);
+	if (it != _exportArchives.end()) return it->second;
+
+	// An archive that failed to open is kept, so that every export into it fails and is counted by ExportPool::collect
+	ZipArchive* archive = new ZipArchive();
+	if (!archive->open(_exportArchivePrefix + extension + ".zip"))
+		std::cout << "Archive " << _exportArchivePrefix << extension << " could not be created" << std::endl;
 
-	const std::string currentPath = std::filesystem::current_path().string();
-	const std::string systemUnit = currentPath.substr(0, currentPath.find_first_of("/\\"));
-	const std::string cd = "cd " + currentPath;
-	const std::string command = cd + " && " + systemUnit + " && " + "Bash\\zip.bat " + folder + " " + folder.substr(0, folder.find_first_of("/\\")) + " " + extension + " >nul";
+	_exportArchives[extension] = archive;
 
-	std::system(command.c_str());	
+	return archive;
 }
 
 void CADScene::loadDefaultCamera(Camera* camera)
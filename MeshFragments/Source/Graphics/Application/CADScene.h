@@ -12,6 +12,9 @@ class DrawPointCloud;
 class FractureParameters;
 class FragmentationProcedure;
 class PointCloud3D;
+class ExportContainer;
+class FragmentShardWriter;
+class ZipArchive;
 
 
 #define NEW_LIGHT "!"
@@ -55,9 +58,13 @@ protected:
 	DrawLines*					_fragmentBoundaries;			//!<
 	FractureParameters			_fractParameters;				//!< 
 	std::vector<Model3D*>		_fractureMeshes;				//!<
+	std::unordered_map<std::string, ZipArchive*> _exportArchives;	//!< Open archives of the current model, indexed by file extension
+	std::string					_exportArchivePrefix;			//!< Path prefix of the archives; files are written individually if empty
 	std::vector<Material*>		_fragmentMaterials;				//!< Material for each fragment, built with marching cubes
 	FragmentMetadataBuffer		_fragmentMetadata;				//!< Metadata of the current fragmentation procedure
 	std::vector<Texture*>		_fragmentTextures;				//!< Texture for each fragment, built with marching cubes
+	uint32_t					_shardModel;					//!< Identifier of the current model in the sharded dataset
+	FragmentShardWriter*		_shardWriter;					//!< Sharded dataset being generated, if any
 	bool						_generateDataset;
 	std::vector<uvec4>			_impactSeeds;					//!< Seeds obtained by impacting the user's ray to the voxelization
 	CADModel*					_mesh;							//!< Mesh to be fractured
@@ -76,6 +83,11 @@ protected:
 	*/
 	void allocateMeshGrid(FractureParameters& fractParameters);
 
+	/**
+	*	@brief Finalises the archives of the current model.
+	*/
+	void closeExportArchives();
+
 	/**
 	*	@brief Erase content from a previous fragmentation process.
 	*/
@@ -92,9 +104,20 @@ protected:
 	std::string fractureModel(FractureParameters& fractParameters);
 
 	/**
-	*	@brief Saves the whole folder into another one.
+	*	@brief Registers the key and metadata of a file before exporting it into the sharded dataset. Does nothing if no dataset is open.
+	*/
+	void expectShardEntry(const FragmentationProcedure::FragmentMetadata& metadata, int numFragments, int iteration, int fragmentId, int format, unsigned lod);
+
+	/**
+	*	@brief Registers every file that exporting the grid as filename writes. Grids split into several files are told apart by the
+	*	index of each file, stored as its LOD.
+	*/
+	void expectGridShardEntries(FragmentationProcedure::FragmentMetadata metadata, const std::string& filename, int numFragments, int iteration, FractureParameters::ExportGrid format);
+
+	/**
+	*	@return Container where files with the given extension are stored, opening it if needed, or nullptr if files are written individually.
 	*/
-	void launchZipingProcess(const std::string& folder, const std::string& extension);
+	ExportContainer* getExportContainer(const std::string& extension);
 
 	/**
 	*	@brief Loads a camera with code-defined values.
@@ -218,8 +241,9 @@ public:
 
 	/**
 	*	@brief Exports the starting mesh into the specified folder and extension.
+	*	@param pendingExports Receives the export jobs so that their failures can be collected, if not null.
 	*/
-	void exportMesh(FractureParameters& fractureParameters, const std::string& folder);
+	void exportMesh(FractureParameters& fractureParameters, const std::string& folder, std::vector<std::future<void>>* pendingExports = nullptr);
 
 	/**
 	*	@brief 
@@ -228,8 +252,9 @@ public:
 
 	/**
 	*	@brief Exports current mesh as a point cloud of variable number of points.
+	*	@param pendingExports Receives the export jobs so that their failures can be collected, if not null.
 	*/
-	void exportPointCloud(FractureParameters& fractureParameters, const std::string& folder);
+	void exportPointCloud(FractureParameters& fractureParameters, const std::string& folder, std::vector<std::future<void>>* pendingExports = nullptr);
 
 	/**
 	*	@brief Fractures voxelized model.
@@ -5,19 +5,33 @@
 #include <CGAL/Surface_mesh_simplification/edge_collapse.h>
 #include <CGAL/Surface_mesh_simplification/Policies/Edge_collapse/Face_count_stop_predicate.h>
 #include "CGALInterface.h"
+#include "DataStructures/SpatialHashGrid.h"
 #include "Graphics/Application/MaterialList.h"
+#include "Graphics/Core/MeshReader.h"
+#include "Graphics/Core/QuantizedMesh.h"
 #include "Graphics/Core/ShaderList.h"
 #include "Graphics/Core/VAO.h"
 #include "Simplify.h"
 #include "Utilities/FileManagement.h"
 #include "Utilities/ChronoUtilities.h"
+#include "Utilities/ExportPool.h"
+#include "Utilities/ExportContainer.h"
+#include "Utilities/HashUtilities.h"
+#include "Utilities/MemoryMappedFile.h"
 
 // Initialization of static attributes
 std::unordered_map<std::string, std::unique_ptr<Material>> CADModel::_cadMaterials;
 std::unordered_map<std::string, std::unique_ptr<Texture>> CADModel::_cadTextures;
 
 const std::string CADModel::BINARY_EXTENSION = ".bin";
+const char CADModel::CACHE_MAGIC[4] = { 'C', 'A', 'D', 'C' };
+const uint16_t CADModel::CACHE_VERSION = 2;
+const unsigned CADModel::IMPORT_FLAGS = aiProcess_JoinIdenticalVertices | aiProcess_Triangulate | aiProcess_GenSmoothNormals;
+const std::string CADModel::QUANTIZED_EXTENSION = ".binq";
 const float CADModel::MODEL_NORMALIZATION_SCALE = .499999f;
+const unsigned CADModel::BLUE_NOISE_OVERSAMPLING = 5;
+
+static_assert(sizeof(CADModel::CacheHeader) == 48, "Header must match the on-disk layout");
 
 /// [Public methods]
 
@@ -102,46 +116,54 @@ void CADModel::insert(vec4* vertices, unsigned numVertices, uvec4* faces, unsign
 
 	unsigned baseTopologyIndex = modelComponent->_topology.size();
 	modelComponent->_topology.resize(modelComponent->_topology.size() + numFaces);
+	_fractureFaces.resize(modelComponent->_topology.size(), uint8_t(0));
 #pragma omp parallel for
 	for (int idx = 0; idx < numFaces; ++idx)
 		modelComponent->_topology[baseTopologyIndex + idx] =
 		Model3D::FaceGPUData{
 			uvec3(faces[idx].x + baseGeometryIndex, faces[idx].y + baseGeometryIndex, faces[idx].z + baseGeometryIndex) };
+
+	// The fourth component is the boundary mark computed by MarchingCubes::markBoundaryTriangles
+#pragma omp parallel for
+	for (int idx = 0; idx < numFaces; ++idx)
+		_fractureFaces[baseTopologyIndex + idx] = faces[idx].w > 0;
 }
 
 bool CADModel::load()
 {
 	std::string binaryFile = _filename.substr(0, _filename.find_last_of('.')) + BINARY_EXTENSION;
 
-	if ((_useBinary && !GENERATE_DATASET) && std::filesystem::exists(binaryFile))
+	if (std::filesystem::path(_filename).extension() == QUANTIZED_EXTENSION)
 	{
-		this->loadModelFromBinaryFile(binaryFile);
+		if (!this->loadModelFromQuantizedFile(_filename)) return false;
 	}
-	else
+	else if (!(_useBinary && this->loadModelFromBinaryFile(binaryFile)))
 	{
-		_scene = _assimpImporter.ReadFile(_filename, aiProcess_JoinIdenticalVertices | aiProcess_Triangulate | aiProcess_GenSmoothNormals);
-
-		if (!_scene || _scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !_scene->mRootNode)
+		if (!(MeshReader::isSupported(_filename) && this->loadModelFromMeshFile(_filename)))
 		{
-			std::cout << "ERROR::ASSIMP::" << _assimpImporter.GetErrorString() << std::endl;
-			return this;
-		}
+			_scene = _assimpImporter.ReadFile(_filename, IMPORT_FLAGS);
+
+			if (!_scene || _scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !_scene->mRootNode)
+			{
+				std::cout << "ERROR::ASSIMP::" << _assimpImporter.GetErrorString() << std::endl;
+				return this;
+			}
 
-		std::string shortName = _scene->GetShortFilename(_filename.c_str());
-		std::string folder = _filename.substr(0, _filename.length() - shortName.length());
+			std::string shortName = _scene->GetShortFilename(_filename.c_str());
+			std::string folder = _filename.substr(0, _filename.length() - shortName.length());
 
-		this->processNode(_scene->mRootNode, _scene, folder);
-		this->fuseComponents();
+			this->processNode(_scene->mRootNode, _scene, folder);
+			this->fuseComponents();
+		}
 
 		if (_fuseVertices)
 		{
 			for (Model3D::ModelComponent* modelComp : _modelComp)
 			{
-				std::vector<int> mapping(_modelComp[0]->_geometry.size());
-				std::iota(mapping.begin(), mapping.end(), 0);
+				std::vector<int> mapping(modelComp->_geometry.size());
 
-				this->fuseVertices(mapping);
-				this->remapVertices(_modelComp[0], mapping);
+				this->fuseVertices(modelComp, mapping);
+				this->remapVertices(modelComp, mapping);
 			}
 		}
 
@@ -283,10 +305,22 @@ PointCloud3D* CADModel::sampleCPU(unsigned maxSamples, int randomFunction)
 
 		// Data in common for the two branchs
 		int pointIndex = 0;
+		std::vector<vec3> vertexNormals;
+		const bool labelFaces = _fractureFaces.size() == component->_topology.size();
+		this->getVertexNormals(component, vertexNormals);
+
+		const auto interpolateNormal = [&](int faceIdx, const vec2& randomFactors) -> vec3
+		{
+			const uvec3 vertices = component->_topology[faceIdx]._vertices;
+			return glm::normalize(
+				vertexNormals[vertices.x] * (1.0f - randomFactors.x - randomFactors.y) + vertexNormals[vertices.y] * randomFactors.x + vertexNormals[vertices.z] * randomFactors.y);
+		};
 
 		if (maxSamples > component->_topology.size())
 		{
 			std::vector<vec4> newPoint(maxSamples * 2);
+			std::vector<vec3> newNormal(maxSamples * 2);
+			std::vector<uint8_t> newLabel(maxSamples * 2);
 
 			#pragma omp parallel for
 			for (int index = 0; index < component->_topology.size(); ++index)
@@ -314,16 +348,22 @@ PointCloud3D* CADModel::sampleCPU(unsigned maxSamples, int randomFunction)
 
 					vec3 point = v1 + u * randomFactors.x + v * randomFactors.y;
 					newPoint[i] = vec4(point, 1.0f);
+					newNormal[i] = interpolateNormal(index, randomFactors);
+					newLabel[i] = labelFaces ? _fractureFaces[index] : uint8_t(0);
 				}
 			}
 
 			newPoint.resize(pointIndex);
-			pointCloud->push_back(newPoint.data(), newPoint.size());
+			pointCloud->push_back(newPoint.data(), newNormal.data(), labelFaces ? newLabel.data() : nullptr, newPoint.size());
+			// Random order either way, so that any prefix of the cloud is a subsample of it
 			if (pointIndex > maxSamples) pointCloud->subselect(maxSamples);
+			else pointCloud->shuffle();
 		}
 		else
 		{
 			std::vector<vec4> newPoint(maxSamples);
+			std::vector<vec3> newNormal(maxSamples);
+			std::vector<uint8_t> newLabel(maxSamples);
 
 			// Randomly select which faces are active
 			int activeFaces = 0, randomFace;
@@ -358,28 +398,53 @@ PointCloud3D* CADModel::sampleCPU(unsigned maxSamples, int randomFunction)
 
 					vec3 point = v1 + u * randomFactors.x + v * randomFactors.y;
 					newPoint[newPointIndex] = vec4(point, 1.0f);
+					newNormal[newPointIndex] = interpolateNormal(index, randomFactors);
+					newLabel[newPointIndex] = labelFaces ? _fractureFaces[index] : uint8_t(0);
 				}
 			}
 
-			pointCloud->push_back(newPoint.data(), newPoint.size());
+			pointCloud->push_back(newPoint.data(), newNormal.data(), labelFaces ? newLabel.data() : nullptr, newPoint.size());
+			pointCloud->shuffle();
 		}
 	}
 
 	return pointCloud;
 }
 
-std::thread* CADModel::save(const std::string& filename, FractureParameters::ExportMeshExtension meshExtension)
+PointCloud3D* CADModel::sampleBlueNoise(unsigned maxSamples, int randomFunction)
+{
+	if (_modelComp.empty()) return nullptr;
+
+	float sumArea = .0f, maxArea = .0f;
+	std::vector<float> triangleArea;
+	this->getSortedTriangleAreas(_modelComp[0], triangleArea, sumArea, maxArea);
+
+	PointCloud3D* pointCloud = this->sampleCPU(maxSamples * BLUE_NOISE_OVERSAMPLING, randomFunction);
+	pointCloud->eliminate(maxSamples, sumArea);
+
+	return pointCloud;
+}
+
+PointCloud3D* CADModel::sampleSurface(unsigned maxSamples, int randomFunction, int samplingMethod)
+{
+	if (samplingMethod == FractureParameters::BLUE_NOISE_SAMPLING)
+		return this->sampleBlueNoise(maxSamples, randomFunction);
+
+	return this->sampleCPU(maxSamples, randomFunction);
+}
+
+std::future<void> CADModel::save(const std::string& filename, FractureParameters::ExportMeshExtension meshExtension, bool moveData, ExportContainer* container)
 {
 	const std::string meshExtensionStr = FractureParameters::ExportMesh_STR[meshExtension];
-	std::thread* thread = nullptr;
-	Model3D::ModelComponent* component = _modelComp[0]->copyComponent(!TESTING_FORMAT_MODE && !GENERATE_DATASET);
+	const std::string path = filename + "." + meshExtensionStr;
+	Model3D::ModelComponent* component = _modelComp[0]->copyComponent(moveData);
 
 	if (meshExtension == FractureParameters::ExportMeshExtension::BINARY_MESH)
-		thread = new std::thread(&CADModel::saveBinary, this, filename + "." + meshExtensionStr, component);
-	else
-		thread = new std::thread(&CADModel::saveAssimp, this, filename + "." + meshExtensionStr, meshExtensionStr, component);
+		return ExportPool::getInstance()->submit([path, component, container]() { CADModel::saveBinary(path, component, container); });
+	else if (meshExtension == FractureParameters::ExportMeshExtension::QUANTIZED_MESH)
+		return ExportPool::getInstance()->submit([path, component, container]() { CADModel::saveQuantized(path, component, container); });
 
-	return thread;
+	return ExportPool::getInstance()->submit([path, meshExtensionStr, component, container]() { CADModel::saveAssimp(path, meshExtensionStr, component, container); });
 }
 
 void CADModel::simplify(unsigned numFaces, bool verbose)
@@ -406,6 +471,7 @@ void CADModel::simplify(unsigned numFaces, bool verbose)
 			}
 
 			Simplify::simplify_mesh(numFaces, 5.0);
+			_fractureFaces.clear();							// Faces are no longer the ones classified by marching cubes
 
 			modelComponent->_geometry.resize(Simplify::vertices.size());
 			modelComponent->_topology.resize(Simplify::triangles.size());
@@ -460,6 +526,8 @@ void CADModel::transformGeometry(const mat4& mMatrix)
 
 void CADModel::computeMeshData(ModelComponent* component)
 {
+	std::vector<vec3> faceNormal(component->_topology.size());
+
 	#pragma omp parallel for
 	for (int faceIdx = 0; faceIdx < component->_topology.size(); ++faceIdx)
 	{
@@ -467,15 +535,16 @@ void CADModel::computeMeshData(ModelComponent* component)
 			v2 = component->_geometry[component->_topology[faceIdx]._vertices.y]._position,
 			v3 = component->_geometry[component->_topology[faceIdx]._vertices.z]._position;
 		glm::vec3 u = v2 - v1, v = v3 - v1;
-		v1 = glm::normalize(glm::cross(u, v));
+		faceNormal[faceIdx] = glm::normalize(glm::cross(u, v));
+	}
 
+	// Accumulated sequentially, as a critical section per corner is slower than a single pass on large meshes
+	for (size_t faceIdx = 0; faceIdx < component->_topology.size(); ++faceIdx)
+	{
 		for (int i = 0; i < 3; ++i)
 		{
-			#pragma omp critical
-			{
-				component->_geometry[component->_topology[faceIdx]._vertices[i]]._normal += v1;
-				component->_geometry[component->_topology[faceIdx]._vertices[i]]._padding1 += 1.0f;
-			}
+			component->_geometry[component->_topology[faceIdx]._vertices[i]]._normal += faceNormal[faceIdx];
+			component->_geometry[component->_topology[faceIdx]._vertices[i]]._padding1 += 1.0f;
 		}
 	}
 
@@ -487,6 +556,25 @@ void CADModel::computeMeshData(ModelComponent* component)
 	}
 }
 
+void CADModel::getVertexNormals(Model3D::ModelComponent* component, std::vector<vec3>& normals)
+{
+	normals.assign(component->_geometry.size(), vec3(.0f));
+
+	// Unnormalized cross products, so that larger faces weigh more
+	for (const Model3D::FaceGPUData& face : component->_topology)
+	{
+		const vec3 v1 = component->_geometry[face._vertices.x]._position, v2 = component->_geometry[face._vertices.y]._position, v3 = component->_geometry[face._vertices.z]._position;
+		const vec3 faceNormal = glm::cross(v2 - v1, v3 - v1);
+
+		for (int i = 0; i < 3; ++i)
+			normals[face._vertices[i]] += faceNormal;
+	}
+
+	#pragma omp parallel for
+	for (int vertexIdx = 0; vertexIdx < normals.size(); ++vertexIdx)
+		if (glm::length2(normals[vertexIdx]) > .0f) normals[vertexIdx] = glm::normalize(normals[vertexIdx]);
+}
+
 Material* CADModel::createMaterial(ModelComponent* modelComp)
 {
 	static const std::string nullMaterialName = "None";
@@ -565,32 +653,85 @@ void CADModel::fuseComponents()
 	_modelComp.push_back(newModelComponent);
 }
 
-void CADModel::fuseVertices(std::vector<int>& mapping)
+void CADModel::fuseVertices(Model3D::ModelComponent* modelComponent, std::vector<int>& mapping)
 {
-	Model3D::ModelComponent* modelComp = _modelComp[0];
+	const int numVertices = static_cast<int>(modelComponent->_geometry.size());
+	const float epsilon = glm::epsilon<float>();
+	std::vector<vec4> positions(numVertices);
+	float maxCoordinate = .0f;
 
-	for (unsigned vertexIdx = 0; vertexIdx < modelComp->_geometry.size(); ++vertexIdx)
+	for (int vertexIdx = 0; vertexIdx < numVertices; ++vertexIdx)
 	{
-		if (mapping[vertexIdx] != vertexIdx)
-			continue;
+		positions[vertexIdx] = vec4(modelComponent->_geometry[vertexIdx]._position, 1.0f);
+		maxCoordinate = glm::max(maxCoordinate, glm::max(glm::abs(positions[vertexIdx].x), glm::max(glm::abs(positions[vertexIdx].y), glm::abs(positions[vertexIdx].z))));
+	}
 
-#pragma omp parallel for
-		for (int j = vertexIdx + 1; j < modelComp->_geometry.size(); ++j)
-		{
-			if (mapping[vertexIdx] == vertexIdx && glm::distance(modelComp->_geometry[vertexIdx]._position, modelComp->_geometry[j]._position) < glm::epsilon<float>())
+	// Cells must not be smaller than the welding distance, but their integer coordinates must not overflow either
+	const SpatialHashGrid grid(positions.data(), numVertices, glm::max(epsilon, maxCoordinate / static_cast<float>(1 << 20)));
+
+	#pragma omp parallel for
+	for (int vertexIdx = 0; vertexIdx < numVertices; ++vertexIdx)
+	{
+		unsigned representative = vertexIdx;
+		grid.forEachNeighbour(vec3(positions[vertexIdx]), epsilon, [&representative, epsilon](unsigned neighbourIdx, float distance2)
 			{
-				// Remap
-				mapping[j] = vertexIdx;
-			}
-		}
+				if (neighbourIdx < representative && distance2 < epsilon * epsilon)
+					representative = neighbourIdx;
+			});
+
+		mapping[vertexIdx] = representative;
+	}
+
+	// Representatives always have lower indices, so a single ascending pass collapses chains of close vertices
+	for (int vertexIdx = 0; vertexIdx < numVertices; ++vertexIdx)
+		mapping[vertexIdx] = mapping[mapping[vertexIdx]];
+}
+
+uint64_t CADModel::hashFile(const std::string& filename)
+{
+	MemoryMappedFile file;
+	if (!file.open(filename)) return 0;
+
+	return HashUtilities::hash(file.data(), file.size());
+}
+
+bool CADModel::loadModelFromMeshFile(const std::string& filename)
+{
+	ModelComponent* component = new ModelComponent();
+	if (!MeshReader::read(filename, component->_geometry, component->_topology, &component->_aabb))
+	{
+		delete component;
+		return false;
 	}
+
+	_modelComp.push_back(component);
+	_aabb.update(component->_aabb);
+	component->_material = this->createMaterial(component);
+	this->computeMeshData(component);
+
+	return true;
+}
+
+bool CADModel::loadModelFromQuantizedFile(const std::string& filename)
+{
+	if (_modelComp.empty()) _modelComp.push_back(new ModelComponent());
+
+	Model3D::ModelComponent* component = _modelComp[0];
+	if (!QuantizedMesh::read(filename, component->_geometry, component->_topology, &component->_aabb)) 
+		return false;
+
+	_aabb = component->_aabb;
+	component->_material = this->createMaterial(component);
+	this->computeMeshData(component);
+
+	return true;
 }
 
 bool CADModel::loadModelFromBinaryFile(const std::string& binaryFile)
 {
-	bool success;
+	const bool success = this->readBinary(binaryFile, _modelComp);
 
-	if (success = this->readBinary(binaryFile, _modelComp))
+	if (success)
 	{
 		for (ModelComponent* modelComp : _modelComp)
 		{
@@ -598,6 +739,13 @@ bool CADModel::loadModelFromBinaryFile(const std::string& binaryFile)
 			modelComp->setName(modelComp->_name);
 		}
 	}
+	else
+	{
+		// A stale or corrupted cache may leave partially read components behind
+		for (ModelComponent* modelComp : _modelComp)
+			delete modelComp;
+		_modelComp.clear();
+	}
 
 	return success;
 }
@@ -681,110 +829,116 @@ void CADModel::processNode(aiNode* node, const aiScene* scene, const std::string
 
 bool CADModel::readBinary(const std::string& filename, const std::vector<Model3D::ModelComponent*>& modelComp)
 {
-	std::ifstream fin(filename, std::ios::in | std::ios::binary);
-	if (!fin.is_open()) return false;
+	MemoryMappedFile file;
+	if (!file.open(filename) || file.size() < sizeof(CacheHeader)) return false;
 
-	size_t numModelComps, numVertices, numTriangles, numIndices;
+	const uint8_t* data = file.data(), *end = data + file.size();
+	CacheHeader header;
+	std::memcpy(&header, data, sizeof(CacheHeader));
+	data += sizeof(CacheHeader);
 
-	fin.read((char*)&numModelComps, sizeof(size_t));
-	while (_modelComp.size() < numModelComps)
-	{
+	if (std::memcmp(header._magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 || header._version != CACHE_VERSION || header._importFlags != IMPORT_FLAGS ||
+		header._options != (_fuseVertices ? CACHE_FUSED_VERTICES : 0u) || header._sourcePathLength > static_cast<size_t>(end - data))
+		return false;
+
+	// The source must be the file that was cached, or at least have the same content
+	std::error_code error;
+	const uint64_t sourceSize = std::filesystem::file_size(_filename, error);
+	if (error || sourceSize != header._sourceSize) return false;
+
+	const int64_t sourceTime = std::filesystem::last_write_time(_filename, error).time_since_epoch().count();
+	const std::string sourcePath(reinterpret_cast<const char*>(data), header._sourcePathLength);
+	data += header._sourcePathLength;
+
+	if (error || sourceTime != header._sourceTime || sourcePath != std::filesystem::absolute(_filename).generic_string())
+		if (hashFile(_filename) != header._sourceHash)
+			return false;
+
+	auto readBytes = [&data, end](void* destination, size_t size) -> bool
+		{
+			if (size > static_cast<size_t>(end - data)) return false;
+			if (size) std::memcpy(destination, data, size);
+			data += size;
+
+			return true;
+		};
+
+	auto readString = [&readBytes](std::string& string) -> bool
+		{
+			uint64_t length;
+			if (!readBytes(&length, sizeof(uint64_t)) || length > std::numeric_limits<uint32_t>::max()) return false;
+
+			string.resize(length);
+			return readBytes(string.data(), length);
+		};
+
+	while (_modelComp.size() < header._numComponents)
 		_modelComp.push_back(new ModelComponent());
-	}
 
-	for (Model3D::ModelComponent* component : modelComp)
+	for (unsigned componentIdx = 0; componentIdx < header._numComponents; ++componentIdx)
 	{
-		fin.read((char*)&numVertices, sizeof(size_t));
+		Model3D::ModelComponent* component = _modelComp[componentIdx];
+		uint64_t numVertices, numFaces;
+
+		// Vertices and faces are copied in bulk from the mapped file
+		if (!readBytes(&numVertices, sizeof(uint64_t)) || numVertices > static_cast<size_t>(end - data) / sizeof(Model3D::VertexGPUData)) return false;
 		component->_geometry.resize(numVertices);
-		if (numVertices)
-			fin.read((char*)&component->_geometry[0], numVertices * sizeof(Model3D::VertexGPUData));
-
-		fin.read((char*)&numTriangles, sizeof(size_t));
-		component->_topology.resize(numTriangles);
-		if (numTriangles)
-			fin.read((char*)&component->_topology[0], numTriangles * sizeof(Model3D::FaceGPUData));
-
-		fin.read((char*)&numIndices, sizeof(size_t));
-		component->_triangleMesh.resize(numIndices);
-		if (numIndices)
-			fin.read((char*)&component->_triangleMesh[0], numIndices * sizeof(GLuint));
-
-		fin.read((char*)&numIndices, sizeof(size_t));
-		component->_pointCloud.resize(numIndices);
-		if (numIndices)
-			fin.read((char*)&component->_pointCloud[0], numIndices * sizeof(GLuint));
-
-		fin.read((char*)&numIndices, sizeof(size_t));
-		component->_wireframe.resize(numIndices);
-		if (numIndices) 
-			fin.read((char*)&component->_wireframe[0], numIndices * sizeof(GLuint));
-
-		size_t length;
-		fin.read((char*)&length, sizeof(size_t));
-		component->_name.resize(length);
-		if (length) 
-			fin.read((char*)&component->_name[0], length);
-
-		fin.read((char*)&component->_aabb, sizeof(AABB));
-
-		// Recover material description
-		fin.read((char*)&length, sizeof(size_t));
-		component->_materialDescription._rootFolder.resize(length);
-		if (length) 
-			fin.read((char*)&component->_materialDescription._rootFolder[0], length);
-
-		fin.read((char*)&length, sizeof(size_t));
-		component->_materialDescription._name.resize(length);
-		if (length) 
-			fin.read((char*)&component->_materialDescription._name[0], length);
-
-		for (int textureLayer = 0; textureLayer < Texture::NUM_TEXTURE_TYPES; textureLayer += 1)
-		{
-			fin.read((char*)&length, sizeof(size_t));
-			component->_materialDescription._textureImage[textureLayer].resize(length);
-			if (length) 
-				fin.read((char*)&component->_materialDescription._textureImage[textureLayer][0], length);
-			fin.read((char*)&component->_materialDescription._textureColor[textureLayer], sizeof(vec4));
-		}
-		fin.read((char*)&component->_materialDescription._ns, sizeof(float));
+		readBytes(component->_geometry.data(), numVertices * sizeof(Model3D::VertexGPUData));
 
-		component->_material = this->createMaterial(component);
-	}
+		if (!readBytes(&numFaces, sizeof(uint64_t)) || numFaces > static_cast<size_t>(end - data) / sizeof(Model3D::FaceGPUData)) return false;
+		component->_topology.resize(numFaces);
+		readBytes(component->_topology.data(), numFaces * sizeof(Model3D::FaceGPUData));
 
-	fin.read((char*)&_aabb, sizeof(AABB));
-	fin.close();
+		if (!readString(component->_name) || !readBytes(&component->_aabb, sizeof(AABB))) return false;
 
-	return true;
+		Material::MaterialDescription& material = component->_materialDescription;
+		if (!readString(material._rootFolder) || !readString(material._name)) return false;
+
+		for (int textureLayer = 0; textureLayer < Texture::NUM_TEXTURE_TYPES; ++textureLayer)
+			if (!readString(material._textureImage[textureLayer]) || !readBytes(&material._textureColor[textureLayer], sizeof(vec4))) return false;
+
+		if (!readBytes(&material._ns, sizeof(float))) return false;
+	}
+
+	return readBytes(&_aabb, sizeof(AABB));
 }
 
 void CADModel::remapVertices(Model3D::ModelComponent* modelComponent, std::vector<int>& mapping)
 {
-	unsigned erasedVertices = 0, startingSize = modelComponent->_geometry.size();
-	std::vector<unsigned> newMapping(startingSize);
+	const size_t numVertices = modelComponent->_geometry.size();
+	std::vector<unsigned> newMapping(numVertices);
+	unsigned numKeptVertices = 0;
 
-	for (size_t vertexIdx = 0; vertexIdx < startingSize; ++vertexIdx)
+	for (int vertexIdx = 0; vertexIdx < static_cast<int>(numVertices); ++vertexIdx)
 	{
-		newMapping[vertexIdx] = vertexIdx - erasedVertices;
+		if (mapping[vertexIdx] != vertexIdx) continue;
 
-		if (mapping[vertexIdx] != vertexIdx)
-		{
-			modelComponent->_geometry.erase(modelComponent->_geometry.begin() + vertexIdx - erasedVertices);
-			++erasedVertices;
-		}
+		newMapping[vertexIdx] = numKeptVertices;
+		modelComponent->_geometry[numKeptVertices++] = modelComponent->_geometry[vertexIdx];
 	}
 
+	modelComponent->_geometry.resize(numKeptVertices);
+
+	// Faces which collapse into a segment or a point are dropped
+	size_t numKeptFaces = 0;
+
 	for (FaceGPUData& face : modelComponent->_topology)
 	{
 		for (int i = 0; i < 3; ++i)
-		{
 			face._vertices[i] = newMapping[mapping[face._vertices[i]]];
-		}
+
+		if (face._vertices.x != face._vertices.y && face._vertices.y != face._vertices.z && face._vertices.x != face._vertices.z)
+			modelComponent->_topology[numKeptFaces++] = face;
 	}
+
+	modelComponent->_topology.resize(numKeptFaces);
 }
 
-void CADModel::saveAssimp(const std::string& filename, const std::string& extension, Model3D::ModelComponent* component)
+void CADModel::saveAssimp(const std::string& filename, const std::string& extension, Model3D::ModelComponent* component, ExportContainer* container)
 {
-	aiScene* scene = new aiScene;
+	// Owned here so that they are released even if writing throws
+	const std::unique_ptr<Model3D::ModelComponent> componentOwner(component);
+	const std::unique_ptr<aiScene> scene(new aiScene);
 	scene->mRootNode = new aiNode();
 
 	scene->mMaterials = new aiMaterial * [1];
@@ -830,92 +984,103 @@ void CADModel::saveAssimp(const std::string& filename, const std::string& extens
 	}
 
 	Assimp::Exporter exporter;
-	exporter.Export(scene, extension, filename);
+	const aiExportDataBlob* blob = exporter.ExportToBlob(scene.get(), extension);
+	if (!blob)
+		throw std::runtime_error("Failed to export " + filename + ": " + exporter.GetErrorString());
 
-	delete component;
-	delete scene;
+	// Only the main blob is kept; auxiliary files such as .mtl describe materials that fragments do not have
+	ExportContainer::write(container, filename, [blob](std::ostream& stream) { stream.write(static_cast<const char*>(blob->data), blob->size); });
 }
 
-void CADModel::saveBinary(const std::string& filename, Model3D::ModelComponent* component)
+void CADModel::saveBinary(const std::string& filename, Model3D::ModelComponent* component, ExportContainer* container)
 {
-	std::ofstream fout(filename, std::ios::out | std::ios::binary);
-	if (!fout.is_open())
-		return;
+	const std::unique_ptr<Model3D::ModelComponent> componentOwner(component);
 
-	const uint32_t numVertices = component->_geometry.size();
-	fout.write((char*)&numVertices, sizeof(uint32_t));
-	if (numVertices) fout.write((char*)&component->_geometry[0], numVertices * sizeof(Model3D::VertexGPUData));
+	ExportContainer::write(container, filename, [component](std::ostream& fout)
+		{
+			const uint32_t numVertices = component->_geometry.size();
+			fout.write((char*)&numVertices, sizeof(uint32_t));
+			if (numVertices) fout.write((char*)&component->_geometry[0], numVertices * sizeof(Model3D::VertexGPUData));
+
+			const uint32_t numTriangles = component->_topology.size();
+			fout.write((char*)&numTriangles, sizeof(uint32_t));
+			if (numTriangles) fout.write((char*)&component->_topology[0], numTriangles * sizeof(Model3D::FaceGPUData));
+		});
+}
 
-	const uint32_t numTriangles = component->_topology.size();
-	fout.write((char*)&numTriangles, sizeof(uint32_t));
-	if (numTriangles) fout.write((char*)&component->_topology[0], numTriangles * sizeof(Model3D::FaceGPUData));
+void CADModel::saveQuantized(const std::string& filename, Model3D::ModelComponent* component, ExportContainer* container)
+{
+	const std::unique_ptr<Model3D::ModelComponent> componentOwner(component);
 
-	delete component;
-	fout.close();
+	ExportContainer::write(container, filename, [component](std::ostream& stream) { QuantizedMesh::write(stream, component->_geometry, component->_topology); });
 }
 
 bool CADModel::writeBinary(const std::string& path)
 {
-	std::ofstream fout(path, std::ios::out | std::ios::binary);
-	if (!fout.is_open())
-	{
-		return false;
-	}
+	std::error_code error;
+	const std::string sourcePath = std::filesystem::absolute(_filename).generic_string();
+
+	CacheHeader header;
+	std::memcpy(header._magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	header._version = CACHE_VERSION;
+	header._reserved = 0;
+	header._importFlags = IMPORT_FLAGS;
+	header._options = _fuseVertices ? CACHE_FUSED_VERTICES : 0u;
+	header._sourceSize = std::filesystem::file_size(_filename, error);
+	if (error) return false;
+	header._sourceTime = std::filesystem::last_write_time(_filename, error).time_since_epoch().count();
+	if (error) return false;
+	header._sourceHash = hashFile(_filename);
+	header._numComponents = static_cast<uint32_t>(_modelComp.size());
+	header._sourcePathLength = static_cast<uint32_t>(sourcePath.size());
+
+	std::vector<uint8_t> buffer;
+	auto appendBytes = [&buffer](const void* source, size_t size)
+		{
+			buffer.insert(buffer.end(), static_cast<const uint8_t*>(source), static_cast<const uint8_t*>(source) + size);
+		};
+
+	auto appendString = [&appendBytes](const std::string& string)
+		{
+			const uint64_t length = string.size();
+			appendBytes(&length, sizeof(uint64_t));
+			appendBytes(string.data(), string.size());
+		};
 
-	size_t numIndices;
-	const size_t numModelComps = _modelComp.size();
-	fout.write((char*)&numModelComps, sizeof(size_t));
+	appendBytes(&header, sizeof(CacheHeader));
+	appendBytes(sourcePath.data(), sourcePath.size());
 
 	for (Model3D::ModelComponent* component : _modelComp)
 	{
-		const size_t numVertices = component->_geometry.size();
-		fout.write((char*)&numVertices, sizeof(size_t));
-		if (numVertices) fout.write((char*)&component->_geometry[0], numVertices * sizeof(Model3D::VertexGPUData));
-
-		const size_t numTriangles = component->_topology.size();
-		fout.write((char*)&numTriangles, sizeof(size_t));
-		if (numTriangles) fout.write((char*)&component->_topology[0], numTriangles * sizeof(Model3D::FaceGPUData));
-
-		numIndices = component->_triangleMesh.size();
-		fout.write((char*)&numIndices, sizeof(size_t));
-		if (numIndices) fout.write((char*)&component->_triangleMesh[0], numIndices * sizeof(GLuint));
-
-		numIndices = component->_pointCloud.size();
-		fout.write((char*)&numIndices, sizeof(size_t));
-		if (numIndices) fout.write((char*)&component->_pointCloud[0], numIndices * sizeof(GLuint));
+		const uint64_t numVertices = component->_geometry.size(), numFaces = component->_topology.size();
+		appendBytes(&numVertices, sizeof(uint64_t));
+		appendBytes(component->_geometry.data(), numVertices * sizeof(Model3D::VertexGPUData));
+		appendBytes(&numFaces, sizeof(uint64_t));
+		appendBytes(component->_topology.data(), numFaces * sizeof(Model3D::FaceGPUData));
 
-		numIndices = component->_wireframe.size();
-		fout.write((char*)&numIndices, sizeof(size_t));
-		if (numIndices) fout.write((char*)&component->_wireframe[0], numIndices * sizeof(GLuint));
+		appendString(component->_name);
+		appendBytes(&component->_aabb, sizeof(AABB));
 
-		size_t nameLength = component->_name.size();
-		fout.write((char*)&nameLength, sizeof(size_t));
-		if (nameLength) fout.write((char*)&component->_name[0], nameLength);
+		const Material::MaterialDescription& material = component->_materialDescription;
+		appendString(material._rootFolder);
+		appendString(material._name);
 
-		fout.write((char*)(&component->_aabb), sizeof(AABB));
-
-		// Write material description
-		size_t rootFolderLength = component->_materialDescription._rootFolder.size(), length;
-		fout.write((char*)&rootFolderLength, sizeof(size_t));
-		if (rootFolderLength) fout.write((char*)&component->_materialDescription._rootFolder[0], rootFolderLength);
-
-		nameLength = component->_materialDescription._name.size();
-		fout.write((char*)&nameLength, sizeof(size_t));
-		if (nameLength) fout.write((char*)&component->_materialDescription._name[0], nameLength);
-
-		for (int textureLayer = 0; textureLayer < Texture::NUM_TEXTURE_TYPES; textureLayer += 1)
+		for (int textureLayer = 0; textureLayer < Texture::NUM_TEXTURE_TYPES; ++textureLayer)
 		{
-			length = component->_materialDescription._textureImage[textureLayer].size();
-			fout.write((char*)&length, sizeof(size_t));
-			if (length) fout.write((char*)&component->_materialDescription._textureImage[textureLayer][0], length);
-			fout.write((char*)&component->_materialDescription._textureColor[textureLayer], sizeof(vec4));
+			appendString(material._textureImage[textureLayer]);
+			appendBytes(&material._textureColor[textureLayer], sizeof(vec4));
 		}
-		fout.write((char*)&component->_materialDescription._ns, sizeof(float));
+
+		appendBytes(&material._ns, sizeof(float));
 	}
 
-	fout.write((char*)&_aabb, sizeof(AABB));
+	appendBytes(&_aabb, sizeof(AABB));
 
+	std::ofstream fout(path, std::ios::out | std::ios::binary);
+	if (!fout.is_open()) return false;
+
+	fout.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
 	fout.close();
 
-	return true;
-}
\ No newline at end of file
+	return !fout.fail();
+}
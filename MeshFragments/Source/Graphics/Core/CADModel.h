@@ -9,6 +9,8 @@
 #include "Geometry/3D/Triangle3D.h"
 #include "Graphics/Core/Model3D.h"
 
+class ExportContainer;
+
 /**
 *	@file CADModel.h
 *	@authors Alfonso Lpez Ruiz (alr00048@red.ujaen.es)
@@ -26,13 +28,39 @@ protected:
 
 public:
 	const static std::string BINARY_EXTENSION;					//!< File extension for binary models
+	const static char CACHE_MAGIC[4];							//!< Signature of binary models
+	const static uint16_t CACHE_VERSION;						//!< Current version of binary models
+	const static unsigned IMPORT_FLAGS;							//!< Assimp post-processing applied to source models
+	const static std::string QUANTIZED_EXTENSION;				//!< File extension for quantized meshes, which are loaded without Assimp
 	const static float MODEL_NORMALIZATION_SCALE;				//!< Scale to normalize the model
+	const static unsigned BLUE_NOISE_OVERSAMPLING;				//!< Ratio between candidate and output points of blue-noise sampling
+
+	enum CacheOptions : uint32_t { CACHE_FUSED_VERTICES = 1 };
+
+	/**
+	*	@brief Header of binary models. A cache is only valid for the source file and import options it was built from; the source is
+	*	identified by its path, size and modification time, or by its size and content hash if it was touched or moved.
+	*/
+	struct CacheHeader
+	{
+		char		_magic[4];
+		uint16_t	_version;
+		uint16_t	_reserved;
+		uint32_t	_importFlags;							//!< Assimp post-processing
+		uint32_t	_options;								//!< CacheOptions
+		uint64_t	_sourceSize;
+		int64_t		_sourceTime;							//!< Last write time of the source
+		uint64_t	_sourceHash;							//!< See hashFile
+		uint32_t	_numComponents;
+		uint32_t	_sourcePathLength;						//!< Bytes of the source path that follows the header
+	};
 
 protected:
 	AABB				_aabb;									//!< Boundaries 
 	Assimp::Importer	_assimpImporter;						//!< Assimp importer
 	Assimp::Exporter	_assimpExporter;						//!< 
 	std::string			_filename;								//!< File path (without extension)
+	std::vector<uint8_t> _fractureFaces;						//!< Per-face mark of triangles on the fracture surface, as classified by marching cubes
 	bool				_fuseVertices;							//!< Fuse vertices which are too close
 	const aiScene*		_scene;									//!< Scene from assimp library	
 	bool				_useBinary;								//!< Use binary file instead of original obj models
@@ -54,15 +82,31 @@ protected:
 	void fuseComponents();
 
 	/**
-	*	@brief Combines similar vertices.
+	*	@brief Maps every vertex to the lowest-indexed vertex closer than epsilon, found through a spatial hash of the positions.
+	*	@param mapping Output, one entry per vertex.
+	*/
+	void fuseVertices(Model3D::ModelComponent* modelComponent, std::vector<int>& mapping);
+
+	/**
+	*	@brief Computes area-weighted vertex normals from the topology of the component.
+	*/
+	void getVertexNormals(Model3D::ModelComponent* component, std::vector<vec3>& normals);
+
+	/**
+	*	@brief Fills the content of model component with a quantized mesh (see QuantizedMesh).
 	*/
-	void fuseVertices(std::vector<int>& mapping);
+	bool loadModelFromQuantizedFile(const std::string& filename);
 
 	/**
 	*	@brief Fills the content of model component with binary file data.
 	*/
 	bool loadModelFromBinaryFile(const std::string& binaryFile);
 
+	/**
+	*	@brief Fills the content of a model component with an OBJ or PLY file parsed without Assimp (see MeshReader).
+	*/
+	bool loadModelFromMeshFile(const std::string& filename);
+
 	/**
 	*	@brief Processes mesh as loaded by Assimp.
 	*/
@@ -74,27 +118,39 @@ protected:
 	void processNode(aiNode* node, const aiScene* scene, const std::string& folder);
 
 	/**
-	*	@brief Loads the CAD model from a binary file, if possible.
+	*	@return 64-bit hash of the content of a file, or 0 if it cannot be read.
+	*/
+	static uint64_t hashFile(const std::string& filename);
+
+	/**
+	*	@brief Loads the normalized and welded geometry of the model from a binary file through a memory-mapped view.
+	*	@return False if the file is not valid for the current source model and options, which are checked before reading any component.
 	*/
 	bool readBinary(const std::string& filename, const std::vector<Model3D::ModelComponent*>& modelComp);
 
 	/**
-	*	@brief Remaps vertices to merge them.
+	*	@brief Removes the vertices merged by fuseVertices and the faces that become degenerate.
 	*/
 	void remapVertices(Model3D::ModelComponent* modelComponent, std::vector<int>& mapping);
 
 	/**
 	*	@brief Saves current model using assimp.
+	*	@param container If not null, the model is stored as an entry of the container rather than as a file.
 	*/
-	void saveAssimp(const std::string& filename, const std::string& extension, Model3D::ModelComponent* component);
+	static void saveAssimp(const std::string& filename, const std::string& extension, Model3D::ModelComponent* component, ExportContainer* container);
 
 	/**
 	*	@brief Saves current model using the binary writer of C++.
 	*/
-	void saveBinary(const std::string& filename, Model3D::ModelComponent* component);
+	static void saveBinary(const std::string& filename, Model3D::ModelComponent* component, ExportContainer* container);
 
 	/**
-	*	@brief Writes the model to a binary file in order to fasten the following executions.
+	*	@brief Saves current model as a quantized and entropy-coded mesh.
+	*/
+	static void saveQuantized(const std::string& filename, Model3D::ModelComponent* component, ExportContainer* container);
+
+	/**
+	*	@brief Writes the model to a binary file in order to fasten the following executions, keyed by the source file and options.
 	*	@return Success of writing process.
 	*/
 	bool writeBinary(const std::string& path);
@@ -166,14 +222,29 @@ public:
 	PointCloud3D* sample(unsigned maxSamples, int randomFunction);
 
 	/**
-	*	@brief Samples the mesh as a set of points.
+	*	@brief Samples the mesh as a set of points. Points are randomly ordered, hence the first n points of the cloud are also a valid sampling of n points.
+	*	Each point carries the normal interpolated from the triangle vertices and, for fragments, whether it lies on the fracture surface.
 	*/
 	PointCloud3D* sampleCPU(unsigned maxSamples, int randomFunction);
 
 	/**
-	*	@brief Saves the model using assimp.
+	*	@brief Samples the mesh with blue-noise distribution, i.e., evenly spaced points. A uniform sampling of BLUE_NOISE_OVERSAMPLING times 
+	*	the target size is reduced to exactly maxSamples points by weighted sample elimination. As with sampleCPU, every prefix of the resulting cloud is a valid sampling.
+	*/
+	PointCloud3D* sampleBlueNoise(unsigned maxSamples, int randomFunction);
+
+	/**
+	*	@brief Samples the mesh with the given method (see FractureParameters::PointCloudSampling).
+	*/
+	PointCloud3D* sampleSurface(unsigned maxSamples, int randomFunction, int samplingMethod);
+
+	/**
+	*	@brief Queues the model to be written by the export pool.
+	*	@param moveData If true, the geometry and topology are moved into the job rather than copied, leaving the model empty.
+	*	@param container If not null, the model is written as an entry of the container.
+	*	@return Future which is ready once the file is written.
 	*/
-	std::thread* save(const std::string& filename, FractureParameters::ExportMeshExtension meshExtension);
+	std::future<void> save(const std::string& filename, FractureParameters::ExportMeshExtension meshExtension, bool moveData = false, ExportContainer* container = nullptr);
 
 	/**
 	*	@brief
@@ -30,19 +30,26 @@ public:
 	enum NeighbourhoodType { VON_NEUMANN, MOORE, NUM_NEIGHBOURHOODS };
 	inline static const char* Neighbourhood_STR[NUM_NEIGHBOURHOODS] = { "Von Neumann", "Moore" };
 
-	enum ExportMeshExtension { OBJ, STL, BINARY_MESH, NUM_EXPORT_MESH_EXTENSIONS };
-	inline static const char* ExportMesh_STR[NUM_EXPORT_MESH_EXTENSIONS] = { "obj", "stl", "binm" };
+	enum ExportMeshExtension { OBJ, STL, BINARY_MESH, QUANTIZED_MESH, NUM_EXPORT_MESH_EXTENSIONS };
+	inline static const char* ExportMesh_STR[NUM_EXPORT_MESH_EXTENSIONS] = { "obj", "stl", "binm", "binq" };
 
-	enum ExportGrid { RLE, QUADSTACK, VOX, UNCOMPRESSED_BINARY, NUM_GRID_EXTENSIONS };
-	inline static const char* ExportGrid_STR[NUM_GRID_EXTENSIONS] = { "rle", "qstack", "vox", "bing"};
+	enum ExportGrid { RLE, QUADSTACK, VOX, UNCOMPRESSED_BINARY, LABEL_DELTA, NUM_GRID_EXTENSIONS };
+	inline static const char* ExportGrid_STR[NUM_GRID_EXTENSIONS] = { "rle", "qstack", "vox", "bing", "vlbl" };
 
 	enum ExportPointCloudExtension { PLY, XYZ, COMPRESSED_POINT_CLOUD, NUM_POINT_CLOUD_EXTENSIONS };
 	inline static const char* ExportPointCloud_STR[NUM_POINT_CLOUD_EXTENSIONS] = { "ply", "xyz", "binp" };
+
+	enum PointCloudSampling { UNIFORM_SAMPLING, BLUE_NOISE_SAMPLING, NUM_POINT_CLOUD_SAMPLINGS };
+	inline static const char* PointCloudSampling_STR[NUM_POINT_CLOUD_SAMPLINGS] = { "Uniform", "Blue Noise" };
+
+	enum VoxelizationMethod { GPU_TETRAHEDRA, CPU_PARITY, CPU_WINDING_NUMBER, NUM_VOXELIZATION_METHODS };
+	inline static const char* Voxelization_STR[NUM_VOXELIZATION_METHODS] = { "GPU Tetrahedra", "CPU Parity", "CPU Winding Number" };
 	 
 public:
 	int				_biasFocus;
 	int				_biasSeeds;
 	float			_boundaryMCWeight, _boundaryMCIterations;
+	bool			_cacheVoxelization;
 	int				_clampVoxelMetricUnit;
 	bool			_erode;
 	int				_erosionConvolution;
@@ -61,14 +68,18 @@ public:
 	int				_numExtraSeeds;
 	int				_numImpacts;
 	int				_numSeeds;
+	int				_pointCloudSampling;
 	int				_pointCloudSeedingRandom;
 	bool			_removeIsolatedRegions;
 	int				_seed;
 	int				_seedingRandom;
+	int				_shellThickness;
 	std::vector<int> _targetPoints;
 	std::vector<int> _targetTriangles;
 	int				_voxelPerMetricUnit;
+	int				_voxelizationMethod;
 	ivec3			_voxelizationSize;
+	float			_windingNumberAccuracy;
 
 	// Rendering during the build procedure
 	bool			_renderGrid;
@@ -92,6 +103,7 @@ public:
 		_biasSeeds(32),
 		_boundaryMCIterations(0.048f),
 		_boundaryMCWeight(0.2f),
+		_cacheVoxelization(false),
 		_clampVoxelMetricUnit(200),
 		_erode(false),
 		_erosionConvolution(ELLIPSE),
@@ -111,15 +123,19 @@ public:
 		_numExtraSeeds(16),
 		_numImpacts(0),
 		_numSeeds(8),
+		_pointCloudSampling(UNIFORM_SAMPLING),
 		_pointCloudSeedingRandom(STD_UNIFORM),
 		_removeIsolatedRegions(true),
 		_seed(80),
 		_seedingRandom(STD_UNIFORM),
+		_shellThickness(0),
 		_biasFocus(5),
 		_targetPoints({ 1024 }),
 		_targetTriangles({ 10000 }),
 		_voxelPerMetricUnit(20),
+		_voxelizationMethod(CPU_PARITY),
 		_voxelizationSize(128),
+		_windingNumberAccuracy(2.0f),
 
 		_renderGrid(true),
 		_renderMesh(true),
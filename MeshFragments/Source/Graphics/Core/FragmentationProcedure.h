@@ -5,7 +5,9 @@
 
 struct FragmentationProcedure
 {
-	bool				_compressResultingFiles = true;
+	enum StorageContainer { INDIVIDUAL_FILES, ZIP_ARCHIVES, SHARDS };
+
+	StorageContainer	_storageContainer = ZIP_ARCHIVES;				//!< Individual files, one archive per model and extension, or a sharded dataset (opt-in)
 	std::string			_currentDestinationFolder = "";
 
 	FractureParameters	_fractureParameters;
@@ -13,6 +15,8 @@ struct FragmentationProcedure
 	ivec2				_iterationInterval = ivec2(25, 15);
 	std::string			_folder = "D:/allopezr/Datasets/Vessels_200/";
 	std::string			_destinationFolder = "D:/allopezr/Fragments/Vessels_200_ours/";
+	size_t				_exportQueueSize = 64;							//!< Pending exports before the fragmentation waits for the writers
+	unsigned			_exportThreads = 0;								//!< Writer threads; zero uses every hardware thread
 	size_t				_maxFragmentsModel = /*std::numeric_limits<size_t>::max()*/1000;
 	std::string			_onlineFolder = "E:/Online_Testing/";
 	std::string			_startVessel = "";
@@ -54,7 +58,7 @@ struct FragmentationProcedure
 		_fractureParameters._exportPointCloud = true;
 
 		_fractureParameters._exportGridExtension = FractureParameters::RLE;
-		_fractureParameters._exportMeshExtension = FractureParameters::BINARY_MESH;
+		_fractureParameters._exportMeshExtension = FractureParameters::QUANTIZED_MESH;
 		_fractureParameters._exportPointCloudExtension = FractureParameters::ExportPointCloudExtension::COMPRESSED_POINT_CLOUD;
 	}
 };
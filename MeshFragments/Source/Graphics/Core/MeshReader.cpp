@@ -0,0 +1,665 @@
+#include "stdafx.h"
+#include "MeshReader.h"
+
+#include "Utilities/MemoryMappedFile.h"
+
+// [Static members initialization]
+
+const size_t MeshReader::MIN_BLOCK_SIZE = 1 << 20;
+const unsigned MeshReader::BLOCKS_PER_THREAD = 4;
+
+/// [PLYElement]
+
+int MeshReader::PLYElement::findProperty(const std::string& name) const
+{
+	for (size_t propertyIdx = 0; propertyIdx < _properties.size(); ++propertyIdx)
+		if (_properties[propertyIdx]._name == name)
+			return static_cast<int>(propertyIdx);
+
+	return -1;
+}
+
+bool MeshReader::PLYElement::hasLists() const
+{
+	for (const PLYProperty& property : _properties)
+		if (property._countType != PLY_INVALID)
+			return true;
+
+	return false;
+}
+
+/// [Public methods]
+
+bool MeshReader::isSupported(const std::string& filename)
+{
+	std::string extension = std::filesystem::path(filename).extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char character) { return std::tolower(character); });
+
+	return extension == ".obj" || extension == ".ply";
+}
+
+bool MeshReader::read(const std::string& filename, std::vector<Model3D::VertexGPUData>& geometry, std::vector<Model3D::FaceGPUData>& topology, AABB* aabb)
+{
+	geometry.clear();
+	topology.clear();
+
+	MemoryMappedFile file;
+	if (!isSupported(filename) || !file.open(filename)) return false;
+
+	std::string extension = std::filesystem::path(filename).extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char character) { return std::tolower(character); });
+
+	const char* text = reinterpret_cast<const char*>(file.data());
+	AABB bounds;
+	PLYHeader header;
+	bool success;
+
+	if (extension == ".obj")
+		success = readOBJ(text, file.size(), geometry, topology, bounds);
+	else
+	{
+		success = parsePLYHeader(text, file.size(), header);
+
+		if (success && header._format == PLY_ASCII)
+			success = readPLYASCII(text, file.size(), header, geometry, topology, bounds);
+		else if (success)
+			success = readPLYBinary(file.data(), file.size(), header, geometry, topology, bounds);
+	}
+
+	success = success && !topology.empty() && geometry.size() <= std::numeric_limits<uint32_t>::max();
+
+	if (success)
+	{
+		// Indices are only known to be valid once every block has been merged
+		const uint32_t numVertices = static_cast<uint32_t>(geometry.size());
+		int numInvalidFaces = 0;
+
+		#pragma omp parallel for reduction(+:numInvalidFaces)
+		for (int faceIdx = 0; faceIdx < static_cast<int>(topology.size()); ++faceIdx)
+		{
+			const uvec3& face = topology[faceIdx]._vertices;
+			if (std::max(face.x, std::max(face.y, face.z)) >= numVertices)
+				++numInvalidFaces;
+		}
+
+		success = numInvalidFaces == 0;
+	}
+
+	if (!success)
+	{
+		geometry.clear();
+		topology.clear();
+
+		return false;
+	}
+
+	if (aabb) *aabb = bounds;
+
+	return true;
+}
+
+/// [Protected methods]
+
+unsigned MeshReader::getNumBlocks(size_t size)
+{
+	const size_t maxBlocks = static_cast<size_t>(std::max(std::thread::hardware_concurrency(), 1u)) * BLOCKS_PER_THREAD;
+
+	return static_cast<unsigned>(std::clamp(size / MIN_BLOCK_SIZE, size_t(1), maxBlocks));
+}
+
+MeshReader::PLYType MeshReader::getPLYType(const std::string& name)
+{
+	if (name == "char" || name == "int8") return PLY_INT8;
+	if (name == "uchar" || name == "uint8") return PLY_UINT8;
+	if (name == "short" || name == "int16") return PLY_INT16;
+	if (name == "ushort" || name == "uint16") return PLY_UINT16;
+	if (name == "int" || name == "int32") return PLY_INT32;
+	if (name == "uint" || name == "uint32") return PLY_UINT32;
+	if (name == "float" || name == "float32") return PLY_FLOAT32;
+	if (name == "double" || name == "float64") return PLY_FLOAT64;
+
+	return PLY_INVALID;
+}
+
+size_t MeshReader::getTypeSize(PLYType type)
+{
+	switch (type)
+	{
+	case PLY_INT8: case PLY_UINT8: return 1;
+	case PLY_INT16: case PLY_UINT16: return 2;
+	case PLY_INT32: case PLY_UINT32: case PLY_FLOAT32: return 4;
+	case PLY_FLOAT64: return 8;
+	default: return 0;
+	}
+}
+
+void MeshReader::insertPolygon(const std::vector<uint32_t>& polygon, const std::vector<uint8_t>& relative, Block& block)
+{
+	for (size_t vertexIdx = 2; vertexIdx < polygon.size(); ++vertexIdx)
+	{
+		const size_t corners[3] = { 0, vertexIdx - 1, vertexIdx };
+
+		for (int corner = 0; corner < 3 && !relative.empty(); ++corner)
+			if (relative[corners[corner]])
+				block._relativeIndices.push_back(block._faces.size() * 3 + corner);
+
+		block._faces.push_back(uvec3(polygon[corners[0]], polygon[corners[1]], polygon[corners[2]]));
+	}
+}
+
+bool MeshReader::mergeBlocks(std::vector<Block>& blocks, std::vector<Model3D::VertexGPUData>& geometry, std::vector<Model3D::FaceGPUData>& topology, AABB& aabb)
+{
+	std::vector<size_t> vertexOffset(blocks.size() + 1, geometry.size()), faceOffset(blocks.size() + 1, topology.size());
+
+	for (size_t blockIdx = 0; blockIdx < blocks.size(); ++blockIdx)
+	{
+		if (!blocks[blockIdx]._valid) return false;
+
+		vertexOffset[blockIdx + 1] = vertexOffset[blockIdx] + blocks[blockIdx]._vertices.size();
+		faceOffset[blockIdx + 1] = faceOffset[blockIdx] + blocks[blockIdx]._faces.size();
+		aabb.update(blocks[blockIdx]._aabb);
+	}
+
+	geometry.resize(vertexOffset.back());
+	topology.resize(faceOffset.back());
+
+	#pragma omp parallel for
+	for (int blockIdx = 0; blockIdx < static_cast<int>(blocks.size()); ++blockIdx)
+	{
+		Block& block = blocks[blockIdx];
+
+		for (size_t vertexIdx = 0; vertexIdx < block._vertices.size(); ++vertexIdx)
+			geometry[vertexOffset[blockIdx] + vertexIdx] = Model3D::VertexGPUData{ block._vertices[vertexIdx] };
+
+		for (size_t faceIdx = 0; faceIdx < block._faces.size(); ++faceIdx)
+			topology[faceOffset[blockIdx] + faceIdx] = Model3D::FaceGPUData{ block._faces[faceIdx] };
+
+		// Relative indices are stored modulo 2^32, so that they wrap into the preceding blocks
+		for (size_t index : block._relativeIndices)
+			topology[faceOffset[blockIdx] + index / 3]._vertices[index % 3] += static_cast<uint32_t>(vertexOffset[blockIdx]);
+
+		block = Block();
+	}
+
+	return true;
+}
+
+bool MeshReader::parseFloat(const char*& cursor, const char* end, float& value)
+{
+	double result;
+
+	cursor = skipBlanks(cursor, end);
+	if (cursor < end && *cursor == '+') ++cursor;
+
+	const std::from_chars_result parsing = std::from_chars(cursor, end, result);
+	if (parsing.ec != std::errc()) return false;
+
+	cursor = parsing.ptr;
+	value = static_cast<float>(result);
+
+	return true;
+}
+
+bool MeshReader::parseInt(const char*& cursor, const char* end, int64_t& value)
+{
+	cursor = skipBlanks(cursor, end);
+	if (cursor < end && *cursor == '+') ++cursor;
+
+	const std::from_chars_result parsing = std::from_chars(cursor, end, value);
+	if (parsing.ec != std::errc()) return false;
+
+	cursor = parsing.ptr;
+
+	return true;
+}
+
+void MeshReader::parseOBJBlock(const char* begin, const char* end, Block& block)
+{
+	std::vector<uint32_t> polygon;
+	std::vector<uint8_t> relative;
+	const char* cursor = begin;
+
+	while (cursor < end && block._valid)
+	{
+		const char* lineEnd = static_cast<const char*>(std::memchr(cursor, '\n', end - cursor));
+		if (!lineEnd) lineEnd = end;
+
+		cursor = skipBlanks(cursor, lineEnd);
+
+		if (lineEnd - cursor > 1 && (cursor[1] == ' ' || cursor[1] == '\t'))
+		{
+			if (cursor[0] == 'v')
+			{
+				vec3 position;
+				++cursor;
+
+				if (parseFloat(cursor, lineEnd, position.x) && parseFloat(cursor, lineEnd, position.y) && parseFloat(cursor, lineEnd, position.z))
+				{
+					block._vertices.push_back(position);
+					block._aabb.update(position);
+				}
+				else
+					block._valid = false;
+			}
+			else if (cursor[0] == 'f')
+			{
+				int64_t index;
+				polygon.clear();
+				relative.clear();
+				++cursor;
+
+				while ((cursor = skipBlanks(cursor, lineEnd)) < lineEnd)
+				{
+					if (!parseInt(cursor, lineEnd, index) || index == 0 || std::abs(index) > std::numeric_limits<uint32_t>::max())
+					{
+						block._valid = false;
+						break;
+					}
+
+					// Negative indices count backwards from the last vertex, which may belong to a preceding block
+					if (index > 0)
+						polygon.push_back(static_cast<uint32_t>(index - 1));
+					else
+						polygon.push_back(static_cast<uint32_t>(static_cast<int64_t>(block._vertices.size()) + index));
+					relative.push_back(index < 0);
+
+					// Texture and normal indices are not read
+					while (cursor < lineEnd && *cursor != ' ' && *cursor != '\t' && *cursor != '\r') ++cursor;
+				}
+
+				insertPolygon(polygon, relative, block);
+			}
+		}
+
+		cursor = lineEnd + 1;
+	}
+}
+
+bool MeshReader::parsePLYHeader(const char* data, size_t size, PLYHeader& header)
+{
+	const std::string_view view(data, size);
+	const size_t headerEnd = view.find("end_header");
+	if (headerEnd == std::string_view::npos) return false;
+
+	const size_t dataOffset = view.find('\n', headerEnd);
+	if (dataOffset == std::string_view::npos) return false;
+
+	std::istringstream stream(std::string(view.substr(0, headerEnd)));
+	std::string line, keyword;
+	bool formatFound = false;
+
+	std::getline(stream, line);
+	if (line.rfind("ply", 0) != 0) return false;
+
+	header._elements.clear();
+	header._dataOffset = dataOffset + 1;
+
+	while (std::getline(stream, line))
+	{
+		std::istringstream tokens(line);
+		if (!(tokens >> keyword)) continue;
+
+		if (keyword == "format")
+		{
+			std::string format;
+			tokens >> format;
+
+			if (format == "ascii") header._format = PLY_ASCII;
+			else if (format == "binary_little_endian") header._format = PLY_BINARY_LITTLE_ENDIAN;
+			else if (format == "binary_big_endian") header._format = PLY_BINARY_BIG_ENDIAN;
+			else return false;
+
+			formatFound = true;
+		}
+		else if (keyword == "element")
+		{
+			PLYElement element;
+			if (!(tokens >> element._name >> element._count)) return false;
+
+			header._elements.push_back(std::move(element));
+		}
+		else if (keyword == "property")
+		{
+			PLYProperty property;
+			std::string type, countType;
+
+			if (header._elements.empty() || !(tokens >> type)) return false;
+
+			if (type == "list")
+			{
+				if (!(tokens >> countType >> type)) return false;
+
+				property._countType = getPLYType(countType);
+				if (property._countType == PLY_INVALID || property._countType == PLY_FLOAT32 || property._countType == PLY_FLOAT64) return false;
+			}
+
+			property._type = getPLYType(type);
+			if (property._type == PLY_INVALID || !(tokens >> property._name)) return false;
+
+			header._elements.back()._properties.push_back(std::move(property));
+		}
+	}
+
+	return formatFound;
+}
+
+bool MeshReader::readOBJ(const char* data, size_t size, std::vector<Model3D::VertexGPUData>& geometry, std::vector<Model3D::FaceGPUData>& topology, AABB& aabb)
+{
+	const std::vector<size_t> boundaries = splitLines(data, size);
+	std::vector<Block> blocks(boundaries.size() - 1);
+
+	#pragma omp parallel for schedule(dynamic)
+	for (int blockIdx = 0; blockIdx < static_cast<int>(blocks.size()); ++blockIdx)
+		parseOBJBlock(data + boundaries[blockIdx], data + boundaries[blockIdx + 1], blocks[blockIdx]);
+
+	return mergeBlocks(blocks, geometry, topology, aabb);
+}
+
+bool MeshReader::readPLYASCII(const char* data, size_t size, const PLYHeader& header, std::vector<Model3D::VertexGPUData>& geometry, std::vector<Model3D::FaceGPUData>& topology, AABB& aabb)
+{
+	// Lines of every element follow each other, so the element of a line is given by its number
+	std::vector<size_t> elementLine(header._elements.size() + 1, 0);
+	int vertexElement = -1, faceElement = -1;
+
+	for (size_t elementIdx = 0; elementIdx < header._elements.size(); ++elementIdx)
+	{
+		elementLine[elementIdx + 1] = elementLine[elementIdx] + header._elements[elementIdx]._count;
+
+		if (header._elements[elementIdx]._name == "vertex") vertexElement = static_cast<int>(elementIdx);
+		else if (header._elements[elementIdx]._name == "face") faceElement = static_cast<int>(elementIdx);
+	}
+
+	if (vertexElement < 0 || faceElement < 0) return false;
+
+	const PLYElement& vertices = header._elements[vertexElement], & faces = header._elements[faceElement];
+	const int coordinates[3] = { vertices.findProperty("x"), vertices.findProperty("y"), vertices.findProperty("z") };
+	int indices = faces.findProperty("vertex_indices");
+	if (indices < 0) indices = faces.findProperty("vertex_index");
+
+	if (coordinates[0] < 0 || coordinates[1] < 0 || coordinates[2] < 0 || indices < 0 || faces._properties[indices]._countType == PLY_INVALID)
+		return false;
+
+	const char* body = data + header._dataOffset;
+	const size_t bodySize = size - header._dataOffset;
+	const std::vector<size_t> boundaries = splitLines(body, bodySize);
+	const int numBlocks = static_cast<int>(boundaries.size() - 1);
+
+	// First line of every block
+	std::vector<size_t> blockLine(numBlocks + 1, 0);
+
+	#pragma omp parallel for
+	for (int blockIdx = 0; blockIdx < numBlocks; ++blockIdx)
+		blockLine[blockIdx + 1] = std::count(body + boundaries[blockIdx], body + boundaries[blockIdx + 1], '\n');
+
+	for (int blockIdx = 0; blockIdx < numBlocks; ++blockIdx)
+		blockLine[blockIdx + 1] += blockLine[blockIdx];
+
+	const size_t numLines = blockLine.back() + (bodySize && body[bodySize - 1] != '\n');
+	if (numLines < std::max(elementLine[vertexElement + 1], elementLine[faceElement + 1])) return false;
+
+	geometry.resize(vertices._count);
+	std::vector<Block> blocks(numBlocks);
+
+	#pragma omp parallel for schedule(dynamic)
+	for (int blockIdx = 0; blockIdx < numBlocks; ++blockIdx)
+	{
+		Block& block = blocks[blockIdx];
+		std::vector<uint32_t> polygon;
+		const char* cursor = body + boundaries[blockIdx], *end = body + boundaries[blockIdx + 1];
+		size_t line = blockLine[blockIdx];
+		int64_t count, index;
+		float value;
+
+		while (cursor < end && block._valid)
+		{
+			const char* lineEnd = static_cast<const char*>(std::memchr(cursor, '\n', end - cursor));
+			if (!lineEnd) lineEnd = end;
+
+			const bool isVertex = line >= elementLine[vertexElement] && line < elementLine[vertexElement + 1];
+			const bool isFace = line >= elementLine[faceElement] && line < elementLine[faceElement + 1];
+			const PLYElement& element = isVertex ? vertices : faces;
+			vec3 position;
+
+			for (int propertyIdx = 0; (isVertex || isFace) && block._valid && propertyIdx < static_cast<int>(element._properties.size()); ++propertyIdx)
+			{
+				if (element._properties[propertyIdx]._countType != PLY_INVALID)
+				{
+					const bool isIndices = isFace && propertyIdx == indices;
+					block._valid = parseInt(cursor, lineEnd, count) && count >= 0;
+					polygon.clear();
+
+					for (int64_t valueIdx = 0; valueIdx < count && block._valid; ++valueIdx)
+					{
+						if (isIndices)
+						{
+							block._valid = parseInt(cursor, lineEnd, index) && index >= 0 && index <= std::numeric_limits<uint32_t>::max();
+							polygon.push_back(static_cast<uint32_t>(index));
+						}
+						else
+							block._valid = parseFloat(cursor, lineEnd, value);
+					}
+
+					if (isIndices && block._valid) insertPolygon(polygon, {}, block);
+				}
+				else
+				{
+					block._valid = parseFloat(cursor, lineEnd, value);
+
+					for (int axis = 0; axis < 3 && isVertex; ++axis)
+						if (propertyIdx == coordinates[axis])
+							position[axis] = value;
+				}
+			}
+
+			if (isVertex && block._valid)
+			{
+				geometry[line - elementLine[vertexElement]] = Model3D::VertexGPUData{ position };
+				block._aabb.update(position);
+			}
+
+			cursor = lineEnd + 1;
+			++line;
+		}
+	}
+
+	return mergeBlocks(blocks, geometry, topology, aabb);
+}
+
+bool MeshReader::readPLYBinary(const uint8_t* data, size_t size, const PLYHeader& header, std::vector<Model3D::VertexGPUData>& geometry, std::vector<Model3D::FaceGPUData>& topology, AABB& aabb)
+{
+	const bool bigEndian = header._format == PLY_BINARY_BIG_ENDIAN;
+	const uint8_t* cursor = data + header._dataOffset, *end = data + size;
+	bool verticesFound = false, facesFound = false;
+
+	for (const PLYElement& element : header._elements)
+	{
+		const bool isVertex = element._name == "vertex", isFace = element._name == "face";
+
+		if (!element.hasLists())
+		{
+			std::vector<size_t> offsets;
+			size_t stride = 0;
+
+			for (const PLYProperty& property : element._properties)
+			{
+				offsets.push_back(stride);
+				stride += getTypeSize(property._type);
+			}
+
+			if (stride && element._count > static_cast<size_t>(end - cursor) / stride) return false;
+
+			if (isVertex)
+			{
+				const int coordinates[3] = { element.findProperty("x"), element.findProperty("y"), element.findProperty("z") };
+				if (coordinates[0] < 0 || coordinates[1] < 0 || coordinates[2] < 0) return false;
+
+				const int numBlocks = static_cast<int>(getNumBlocks(element._count * stride));
+				const size_t blockSize = (element._count + numBlocks - 1) / numBlocks;
+				std::vector<AABB> blockAABB(numBlocks);
+				geometry.resize(element._count);
+
+				#pragma omp parallel for
+				for (int blockIdx = 0; blockIdx < numBlocks; ++blockIdx)
+				{
+					const size_t lastVertex = std::min(element._count, (blockIdx + 1) * blockSize);
+
+					for (size_t vertexIdx = blockIdx * blockSize; vertexIdx < lastVertex; ++vertexIdx)
+					{
+						const uint8_t* record = cursor + vertexIdx * stride;
+						vec3 position;
+
+						for (int axis = 0; axis < 3; ++axis)
+							position[axis] = static_cast<float>(readPLYValue(record + offsets[coordinates[axis]], element._properties[coordinates[axis]]._type, bigEndian));
+
+						geometry[vertexIdx] = Model3D::VertexGPUData{ position };
+						blockAABB[blockIdx].update(position);
+					}
+				}
+
+				for (const AABB& block : blockAABB)
+					aabb.update(block);
+				verticesFound = true;
+			}
+
+			cursor += element._count * stride;
+		}
+		else
+		{
+			if (isVertex) return false;
+
+			// Records have variable size, so they are walked once to find where every block starts
+			const size_t blockSize = std::max(element._count / getNumBlocks(end - cursor), size_t(1));
+			std::vector<const uint8_t*> blockStart;
+
+			for (size_t recordIdx = 0; recordIdx < element._count; ++recordIdx)
+			{
+				if (recordIdx % blockSize == 0) blockStart.push_back(cursor);
+
+				for (const PLYProperty& property : element._properties)
+				{
+					size_t numValues = 1;
+
+					if (property._countType != PLY_INVALID)
+					{
+						if (getTypeSize(property._countType) > static_cast<size_t>(end - cursor)) return false;
+
+						const double count = readPLYValue(cursor, property._countType, bigEndian);
+						if (count < 0) return false;
+
+						numValues = static_cast<size_t>(count);
+						cursor += getTypeSize(property._countType);
+					}
+
+					if (numValues > static_cast<size_t>(end - cursor) / getTypeSize(property._type)) return false;
+					cursor += numValues * getTypeSize(property._type);
+				}
+			}
+
+			if (isFace)
+			{
+				int indices = element.findProperty("vertex_indices");
+				if (indices < 0) indices = element.findProperty("vertex_index");
+				if (indices < 0 || element._properties[indices]._countType == PLY_INVALID) return false;
+
+				std::vector<Block> blocks(blockStart.size());
+
+				#pragma omp parallel for schedule(dynamic)
+				for (int blockIdx = 0; blockIdx < static_cast<int>(blocks.size()); ++blockIdx)
+				{
+					std::vector<uint32_t> polygon;
+					const uint8_t* record = blockStart[blockIdx];
+					const size_t lastRecord = std::min(element._count, (blockIdx + 1) * blockSize);
+
+					for (size_t recordIdx = blockIdx * blockSize; recordIdx < lastRecord; ++recordIdx)
+					{
+						for (int propertyIdx = 0; propertyIdx < static_cast<int>(element._properties.size()); ++propertyIdx)
+						{
+							const PLYProperty& property = element._properties[propertyIdx];
+							const size_t typeSize = getTypeSize(property._type);
+							size_t numValues = 1;
+
+							if (property._countType != PLY_INVALID)
+							{
+								numValues = static_cast<size_t>(readPLYValue(record, property._countType, bigEndian));
+								record += getTypeSize(property._countType);
+							}
+
+							if (propertyIdx == indices)
+							{
+								polygon.resize(numValues);
+								for (size_t valueIdx = 0; valueIdx < numValues; ++valueIdx)
+								{
+									const double index = readPLYValue(record + valueIdx * typeSize, property._type, bigEndian);
+									if (index < 0 || index > std::numeric_limits<uint32_t>::max()) blocks[blockIdx]._valid = false;
+
+									polygon[valueIdx] = static_cast<uint32_t>(index);
+								}
+
+								insertPolygon(polygon, {}, blocks[blockIdx]);
+							}
+
+							record += numValues * typeSize;
+						}
+					}
+				}
+
+				if (!mergeBlocks(blocks, geometry, topology, aabb)) return false;
+				facesFound = true;
+			}
+		}
+	}
+
+	return verticesFound && facesFound;
+}
+
+double MeshReader::readPLYValue(const uint8_t* data, PLYType type, bool bigEndian)
+{
+	uint8_t bytes[8];
+	const size_t typeSize = getTypeSize(type);
+
+	if (bigEndian)
+		std::reverse_copy(data, data + typeSize, bytes);
+	else
+		std::memcpy(bytes, data, typeSize);
+
+	switch (type)
+	{
+	case PLY_INT8: { int8_t value; std::memcpy(&value, bytes, sizeof(value)); return value; }
+	case PLY_UINT8: { uint8_t value; std::memcpy(&value, bytes, sizeof(value)); return value; }
+	case PLY_INT16: { int16_t value; std::memcpy(&value, bytes, sizeof(value)); return value; }
+	case PLY_UINT16: { uint16_t value; std::memcpy(&value, bytes, sizeof(value)); return value; }
+	case PLY_INT32: { int32_t value; std::memcpy(&value, bytes, sizeof(value)); return value; }
+	case PLY_UINT32: { uint32_t value; std::memcpy(&value, bytes, sizeof(value)); return value; }
+	case PLY_FLOAT32: { float value; std::memcpy(&value, bytes, sizeof(value)); return value; }
+	case PLY_FLOAT64: { double value; std::memcpy(&value, bytes, sizeof(value)); return value; }
+	default: return .0;
+	}
+}
+
+const char* MeshReader::skipBlanks(const char* cursor, const char* end)
+{
+	while (cursor < end && (*cursor == ' ' || *cursor == '\t' || *cursor == '\r')) ++cursor;
+
+	return cursor;
+}
+
+std::vector<size_t> MeshReader::splitLines(const char* data, size_t size)
+{
+	const unsigned numBlocks = getNumBlocks(size);
+	std::vector<size_t> boundaries{ 0 };
+
+	for (unsigned blockIdx = 1; blockIdx < numBlocks; ++blockIdx)
+	{
+		const size_t offset = std::max(boundaries.back(), size * blockIdx / numBlocks);
+		const char* newline = static_cast<const char*>(std::memchr(data + offset, '\n', size - offset));
+		if (!newline) break;
+
+		const size_t lineStart = newline - data + 1;
+		if (lineStart < size) boundaries.push_back(lineStart);
+	}
+
+	boundaries.push_back(size);
+
+	return boundaries;
+}
+
@@ -0,0 +1,159 @@
+#pragma once
+
+#include "Graphics/Core/Model3D.h"
+
+/**
+*	@brief Native reader of OBJ and PLY (ASCII and binary) meshes, which avoids Assimp for large models. Files are memory-mapped and split
+*	at line or record boundaries so that every thread parses its own block, and blocks are merged afterwards by offsetting their indices.
+*	Only positions and faces are read; polygons are triangulated as fans and normals are left to the caller.
+*/
+class MeshReader
+{
+public:
+	const static size_t		MIN_BLOCK_SIZE;					//!< Minimum bytes parsed by a thread
+	const static unsigned	BLOCKS_PER_THREAD;				//!< Blocks per hardware thread, so that uneven blocks are balanced
+
+protected:
+	/**
+	*	@brief Vertices and triangles parsed from a block of the file.
+	*/
+	struct Block
+	{
+		std::vector<vec3>		_vertices;
+		std::vector<uvec3>		_faces;
+		std::vector<size_t>		_relativeIndices;			//!< Flattened indices of _faces given relative to the first vertex of the block
+		AABB					_aabb;
+		bool					_valid = true;
+	};
+
+	enum PLYFormat : uint8_t { PLY_ASCII, PLY_BINARY_LITTLE_ENDIAN, PLY_BINARY_BIG_ENDIAN };
+	enum PLYType : uint8_t { PLY_INT8, PLY_UINT8, PLY_INT16, PLY_UINT16, PLY_INT32, PLY_UINT32, PLY_FLOAT32, PLY_FLOAT64, PLY_INVALID };
+
+	struct PLYProperty
+	{
+		std::string		_name;
+		PLYType			_type;
+		PLYType			_countType = PLY_INVALID;			//!< Type of the length of list properties, invalid otherwise
+	};
+
+	struct PLYElement
+	{
+		std::string					_name;
+		size_t						_count;
+		std::vector<PLYProperty>	_properties;
+
+		/**
+		*	@return Index of a property, or -1 if it is not found.
+		*/
+		int findProperty(const std::string& name) const;
+
+		/**
+		*	@return True if any property is a list, so that records have no fixed size.
+		*/
+		bool hasLists() const;
+	};
+
+	struct PLYHeader
+	{
+		PLYFormat					_format;
+		std::vector<PLYElement>		_elements;
+		size_t						_dataOffset;			//!< First byte after end_header
+	};
+
+protected:
+	/**
+	*	@return Number of blocks a file of the given size is split into.
+	*/
+	static unsigned getNumBlocks(size_t size);
+
+	/**
+	*	@return PLY scalar type of a type name, or PLY_INVALID if it is unknown.
+	*/
+	static PLYType getPLYType(const std::string& name);
+
+	/**
+	*	@return Size of a PLY scalar type.
+	*/
+	static size_t getTypeSize(PLYType type);
+
+	/**
+	*	@brief Appends the triangles of a polygon as a fan around its first vertex.
+	*	@param relative Flags the polygon indices that are relative to the block, if not empty.
+	*/
+	static void insertPolygon(const std::vector<uint32_t>& polygon, const std::vector<uint8_t>& relative, Block& block);
+
+	/**
+	*	@brief Appends the vertices and faces of all blocks to the mesh, offsetting relative indices by the vertices of the preceding blocks.
+	*	@return False if any block is invalid.
+	*/
+	static bool mergeBlocks(std::vector<Block>& blocks, std::vector<Model3D::VertexGPUData>& geometry, std::vector<Model3D::FaceGPUData>& topology, AABB& aabb);
+
+	/**
+	*	@brief Parses a float, skipping leading blanks.
+	*	@return Success of operation.
+	*/
+	static bool parseFloat(const char*& cursor, const char* end, float& value);
+
+	/**
+	*	@brief Parses an integer, skipping leading blanks.
+	*	@return Success of operation.
+	*/
+	static bool parseInt(const char*& cursor, const char* end, int64_t& value);
+
+	/**
+	*	@brief Parses the vertices and faces of a block of an OBJ file.
+	*/
+	static void parseOBJBlock(const char* begin, const char* end, Block& block);
+
+	/**
+	*	@brief Parses the header of a PLY file.
+	*	@return False if the header is malformed.
+	*/
+	static bool parsePLYHeader(const char* data, size_t size, PLYHeader& header);
+
+	/**
+	*	@brief Reads an OBJ file.
+	*/
+	static bool readOBJ(const char* data, size_t size, std::vector<Model3D::VertexGPUData>& geometry, std::vector<Model3D::FaceGPUData>& topology, AABB& aabb);
+
+	/**
+	*	@brief Reads the body of an ASCII PLY file, whose lines are assigned to elements by their line number.
+	*/
+	static bool readPLYASCII(const char* data, size_t size, const PLYHeader& header, std::vector<Model3D::VertexGPUData>& geometry, std::vector<Model3D::FaceGPUData>& topology, AABB& aabb);
+
+	/**
+	*	@brief Reads the body of a binary PLY file. Records of fixed size are decoded in parallel right away, while variable records are
+	*	first walked to find the start of every block.
+	*/
+	static bool readPLYBinary(const uint8_t* data, size_t size, const PLYHeader& header, std::vector<Model3D::VertexGPUData>& geometry, std::vector<Model3D::FaceGPUData>& topology, AABB& aabb);
+
+	/**
+	*	@brief Reads a binary PLY scalar.
+	*/
+	static double readPLYValue(const uint8_t* data, PLYType type, bool bigEndian);
+
+	/**
+	*	@return First character that is not a blank, i.e. a space, tab or carriage return.
+	*/
+	static const char* skipBlanks(const char* cursor, const char* end);
+
+	/**
+	*	@brief Splits a text into blocks that start at the beginning of a line.
+	*	@return Offsets of the blocks, followed by the size of the text.
+	*/
+	static std::vector<size_t> splitLines(const char* data, size_t size);
+
+public:
+	/**
+	*	@return True if the extension of a file is read natively.
+	*/
+	static bool isSupported(const std::string& filename);
+
+	/**
+	*	@brief Reads a mesh through a memory-mapped view of the file.
+	*	@param aabb Optional output for the bounds of the mesh.
+	*	@return False if the file cannot be parsed, leaving the mesh empty, so that it can be read by other means.
+	*/
+	static bool read(const std::string& filename, std::vector<Model3D::VertexGPUData>& geometry, std::vector<Model3D::FaceGPUData>& topology, AABB* aabb = nullptr);
+};
+
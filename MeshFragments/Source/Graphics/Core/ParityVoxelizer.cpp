@@ -0,0 +1,195 @@
+#include "stdafx.h"
+#include "ParityVoxelizer.h"
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define PARITY_SSE2
+#endif
+
+// [Static members initialization]
+
+const int ParityVoxelizer::MAX_COORDINATE_BITS = 14;
+
+/// [Public methods]
+
+void ParityVoxelizer::voxelize(const std::vector<Model3D::VertexGPUData>& vertices, const std::vector<Model3D::FaceGPUData>& faces, const AABB& aabb, const uvec3& numDivs, uint8_t* inside)
+{
+	const size_t sliceSize = static_cast<size_t>(numDivs.y) * numDivs.z;
+	std::fill(inside, inside + sliceSize * numDivs.x, 0);
+
+	// Sub-voxel bits, so that projected coordinates stay below 2^MAX_COORDINATE_BITS
+	const unsigned maxDivs = glm::max(numDivs.x, glm::max(numDivs.y, numDivs.z));
+	const int precision = std::max(1, MAX_COORDINATE_BITS - static_cast<int>(std::bit_width(maxDivs)));
+	const vec3 scale = vec3(numDivs) / aabb.size(), minPoint = aabb.min();
+
+	std::vector<Triangle> triangles(faces.size());
+	std::vector<uint8_t> valid(faces.size());
+
+	#pragma omp parallel for
+	for (int faceIdx = 0; faceIdx < static_cast<int>(faces.size()); ++faceIdx)
+	{
+		vec3 triangle[3];
+		for (int vertexIdx = 0; vertexIdx < 3; ++vertexIdx)
+			triangle[vertexIdx] = (vertices[faces[faceIdx]._vertices[vertexIdx]]._position - minPoint) * scale;
+
+		valid[faceIdx] = setupTriangle(triangle, precision, numDivs, triangles[faceIdx]);
+	}
+
+	// Bin triangles by the rows they cover
+	std::vector<uint32_t> rowStart(numDivs.x + 1, 0);
+	for (size_t faceIdx = 0; faceIdx < faces.size(); ++faceIdx)
+		if (valid[faceIdx])
+			for (int x = triangles[faceIdx]._rows.x; x <= triangles[faceIdx]._rows.y; ++x)
+				++rowStart[x + 1];
+
+	for (unsigned x = 0; x < numDivs.x; ++x)
+		rowStart[x + 1] += rowStart[x];
+
+	std::vector<uint32_t> bins(rowStart.back()), binSize(numDivs.x, 0);
+	for (size_t faceIdx = 0; faceIdx < faces.size(); ++faceIdx)
+		if (valid[faceIdx])
+			for (int x = triangles[faceIdx]._rows.x; x <= triangles[faceIdx]._rows.y; ++x)
+				bins[rowStart[x] + binSize[x]++] = static_cast<uint32_t>(faceIdx);
+
+	#pragma omp parallel for schedule(dynamic)
+	for (int x = 0; x < static_cast<int>(numDivs.x); ++x)
+	{
+		uint8_t* slab = inside + x * sliceSize;
+
+		for (uint32_t binIdx = rowStart[x]; binIdx < rowStart[x + 1]; ++binIdx)
+			rasterizeRow(triangles[bins[binIdx]], x, precision, numDivs, slab);
+
+		// Crossings are turned into parity by accumulating them along each column
+		for (unsigned y = 0; y < numDivs.y; ++y)
+		{
+			uint8_t* column = slab + y * numDivs.z, parity = 0;
+
+			for (unsigned z = 0; z < numDivs.z; ++z)
+			{
+				parity ^= column[z];
+				column[z] = parity;
+			}
+		}
+	}
+}
+
+/// [Protected methods]
+
+void ParityVoxelizer::flip(const Triangle& triangle, double rowDepth, int y, const uvec3& numDivs, uint8_t* slab)
+{
+	// First voxel whose centre lies above the crossing
+	const double depth = rowDepth + triangle._depth[2] * (y + .5);
+	const double z = std::floor(depth - .5) + 1.0;
+
+	if (z < static_cast<double>(numDivs.z))
+		slab[static_cast<size_t>(y) * numDivs.z + static_cast<size_t>(std::max(z, .0))] ^= 1;
+}
+
+void ParityVoxelizer::rasterizeRow(const Triangle& triangle, int x, int precision, const uvec3& numDivs, uint8_t* slab)
+{
+	const int unit = 1 << precision, half = unit >> 1;
+	const int px = x * unit + half, py = triangle._columns.x * unit + half;
+	const double rowDepth = triangle._depth[0] + triangle._depth[1] * (x + .5);
+	int edge[3], step[3];
+
+	for (int edgeIdx = 0; edgeIdx < 3; ++edgeIdx)
+	{
+		const ivec2& a = triangle._vertices[edgeIdx], & b = triangle._vertices[(edgeIdx + 1) % 3];
+		edge[edgeIdx] = static_cast<int>(static_cast<int64_t>(b.x - a.x) * (py - a.y) - static_cast<int64_t>(b.y - a.y) * (px - a.x));
+		step[edgeIdx] = (b.x - a.x) * unit;
+	}
+
+#ifdef PARITY_SSE2
+	const __m128i zero = _mm_setzero_si128();
+	__m128i edges[3], steps[3], owned[3];
+
+	for (int edgeIdx = 0; edgeIdx < 3; ++edgeIdx)
+	{
+		edges[edgeIdx] = _mm_set_epi32(edge[edgeIdx] + 3 * step[edgeIdx], edge[edgeIdx] + 2 * step[edgeIdx], edge[edgeIdx] + step[edgeIdx], edge[edgeIdx]);
+		steps[edgeIdx] = _mm_set1_epi32(4 * step[edgeIdx]);
+		owned[edgeIdx] = _mm_set1_epi32(triangle._owned[edgeIdx]);
+	}
+
+	for (int y = triangle._columns.x; y <= triangle._columns.y; y += 4)
+	{
+		__m128i covered = _mm_set1_epi32(-1);
+		for (int edgeIdx = 0; edgeIdx < 3; ++edgeIdx)
+		{
+			const __m128i inner = _mm_or_si128(_mm_cmpgt_epi32(edges[edgeIdx], zero), _mm_and_si128(_mm_cmpeq_epi32(edges[edgeIdx], zero), owned[edgeIdx]));
+			covered = _mm_and_si128(covered, inner);
+			edges[edgeIdx] = _mm_add_epi32(edges[edgeIdx], steps[edgeIdx]);
+		}
+
+		unsigned mask = static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(covered)));
+		mask &= (1u << std::min(4, triangle._columns.y - y + 1)) - 1;
+
+		while (mask)
+		{
+			flip(triangle, rowDepth, y + std::countr_zero(mask), numDivs, slab);
+			mask &= mask - 1;
+		}
+	}
+#else
+	for (int y = triangle._columns.x; y <= triangle._columns.y; ++y)
+	{
+		bool covered = true;
+		for (int edgeIdx = 0; edgeIdx < 3; ++edgeIdx)
+		{
+			covered &= edge[edgeIdx] > 0 || (edge[edgeIdx] == 0 && triangle._owned[edgeIdx]);
+			edge[edgeIdx] += step[edgeIdx];
+		}
+
+		if (covered) flip(triangle, rowDepth, y, numDivs, slab);
+	}
+#endif
+}
+
+bool ParityVoxelizer::setupTriangle(const vec3* vertices, int precision, const uvec3& numDivs, Triangle& triangle)
+{
+	const int unit = 1 << precision, half = unit >> 1;
+	int order[3] = { 0, 1, 2 };
+
+	for (int vertexIdx = 0; vertexIdx < 3; ++vertexIdx)
+		triangle._vertices[vertexIdx] = ivec2(static_cast<int>(std::lround(vertices[vertexIdx].x * unit)), static_cast<int>(std::lround(vertices[vertexIdx].y * unit)));
+
+	// Counter-clockwise order, so that inner points have positive edge functions
+	const ivec2 u = triangle._vertices[1] - triangle._vertices[0], v = triangle._vertices[2] - triangle._vertices[0];
+	const int64_t area = static_cast<int64_t>(u.x) * v.y - static_cast<int64_t>(u.y) * v.x;
+	if (area == 0) return false;
+
+	if (area < 0)
+	{
+		std::swap(triangle._vertices[1], triangle._vertices[2]);
+		std::swap(order[1], order[2]);
+	}
+
+	// Top-left rule: an edge shared by two triangles belongs to exactly one of them
+	for (int edgeIdx = 0; edgeIdx < 3; ++edgeIdx)
+	{
+		const ivec2 edge = triangle._vertices[(edgeIdx + 1) % 3] - triangle._vertices[edgeIdx];
+		triangle._owned[edgeIdx] = (edge.y < 0 || (edge.y == 0 && edge.x > 0)) ? -1 : 0;
+	}
+
+	// Voxel centres (i * unit + half) within the bounds of the projection
+	const ivec2 minPoint = glm::min(triangle._vertices[0], glm::min(triangle._vertices[1], triangle._vertices[2]));
+	const ivec2 maxPoint = glm::max(triangle._vertices[0], glm::max(triangle._vertices[1], triangle._vertices[2]));
+	auto firstCentre = [unit, half](int coordinate) { return static_cast<int>(std::ceil(static_cast<double>(coordinate - half) / unit)); };
+	auto lastCentre = [unit, half](int coordinate) { return static_cast<int>(std::floor(static_cast<double>(coordinate - half) / unit)); };
+
+	triangle._rows = ivec2(std::max(firstCentre(minPoint.x), 0), std::min(lastCentre(maxPoint.x), static_cast<int>(numDivs.x) - 1));
+	triangle._columns = ivec2(std::max(firstCentre(minPoint.y), 0), std::min(lastCentre(maxPoint.y), static_cast<int>(numDivs.y) - 1));
+	if (triangle._rows.x > triangle._rows.y || triangle._columns.x > triangle._columns.y) return false;
+
+	// Depth is interpolated from the original vertices rather than the projected ones
+	const vec3& a = vertices[order[0]];
+	const double ux = vertices[order[1]].x - a.x, uy = vertices[order[1]].y - a.y, uz = vertices[order[1]].z - a.z;
+	const double vx = vertices[order[2]].x - a.x, vy = vertices[order[2]].y - a.y, vz = vertices[order[2]].z - a.z;
+	const double nx = uy * vz - uz * vy, ny = uz * vx - ux * vz, nz = ux * vy - uy * vx;
+
+	triangle._depth[1] = nz != .0 ? -nx / nz : .0;
+	triangle._depth[2] = nz != .0 ? -ny / nz : .0;
+	triangle._depth[0] = a.z - triangle._depth[1] * a.x - triangle._depth[2] * a.y;
+
+	return true;
+}
+
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Graphics/Core/Model3D.h"
+
+/**
+*	@brief CPU solid voxelizer. A ray is cast along z through the centre of every (x, y) column of the grid, and voxels whose centre has an
+*	odd number of surface crossings below it are inside. Triangles are projected onto the xy plane in fixed point and binned by x row, so
+*	that rows are processed in parallel. Voxel centres are tested against edge functions with a top-left rule, so that shared edges and
+*	vertices are crossed exactly once and closed meshes give a watertight parity.
+*/
+class ParityVoxelizer
+{
+public:
+	const static int	MAX_COORDINATE_BITS;			//!< Bits of fixed-point projected coordinates, so that edge functions fit in 32 bits
+
+protected:
+	/**
+	*	@brief Projected triangle ready to be rasterized.
+	*/
+	struct Triangle
+	{
+		ivec2		_vertices[3];						//!< Fixed-point projection, in counter-clockwise order
+		int			_owned[3];							//!< All bits set if points on the edge from each vertex to the next one are covered
+		double		_depth[3];							//!< Plane z = depth[0] + depth[1] * x + depth[2] * y, in voxel units
+		ivec2		_rows;								//!< First and last x covered by the triangle
+		ivec2		_columns;							//!< First and last y covered by the triangle
+	};
+
+protected:
+	/**
+	*	@brief Toggles the parity of the voxel column (x, y) above a crossing of the triangle.
+	*/
+	static void flip(const Triangle& triangle, double rowDepth, int y, const uvec3& numDivs, uint8_t* slab);
+
+	/**
+	*	@brief Flips the columns of an x row whose centre is covered by a triangle. Edge functions are evaluated for four columns at once.
+	*/
+	static void rasterizeRow(const Triangle& triangle, int x, int precision, const uvec3& numDivs, uint8_t* slab);
+
+	/**
+	*	@brief Projects a triangle given in grid coordinates.
+	*	@return False if the projection is degenerate or does not cover any voxel centre.
+	*/
+	static bool setupTriangle(const vec3* vertices, int precision, const uvec3& numDivs, Triangle& triangle);
+
+public:
+	/**
+	*	@brief Computes which voxels of a grid are inside a mesh.
+	*	@param inside Buffer of numDivs.x * numDivs.y * numDivs.z flags laid out as x * ny * nz + y * nz + z, which are set to 1 for inner voxels.
+	*/
+	static void voxelize(const std::vector<Model3D::VertexGPUData>& vertices, const std::vector<Model3D::FaceGPUData>& faces, const AABB& aabb, const uvec3& numDivs, uint8_t* inside);
+};
+
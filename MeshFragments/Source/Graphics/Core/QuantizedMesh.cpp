@@ -0,0 +1,184 @@
+#include "stdafx.h"
+#include "QuantizedMesh.h"
+
+#include "Utilities/MemoryMappedFile.h"
+#include "Utilities/RangeCoder.h"
+
+// [Static members initialization]
+
+const char QuantizedMesh::MAGIC[4] = { 'Q', 'M', 'S', 'H' };
+const uint16_t QuantizedMesh::VERSION = 1;
+const uint16_t QuantizedMesh::POSITION_BITS = 16;
+
+static_assert(sizeof(QuantizedMesh::Header) == 48, "Header must match the on-disk layout");
+
+/// [Public methods]
+
+bool QuantizedMesh::read(const std::string& filename, std::vector<Model3D::VertexGPUData>& geometry, std::vector<Model3D::FaceGPUData>& topology, AABB* aabb)
+{
+	MemoryMappedFile file;
+	if (!file.open(filename) || file.size() < sizeof(Header)) return false;
+
+	Header header;
+	std::memcpy(&header, file.data(), sizeof(Header));
+
+	if (std::memcmp(header._magic, MAGIC, sizeof(MAGIC)) != 0 || header._version != VERSION || header._positionBits != POSITION_BITS)
+		return false;
+
+	if (sizeof(Header) + static_cast<size_t>(header._positionBytes) + header._indexBytes > file.size())
+		return false;
+
+	// Counts beyond what the streams can hold would only allocate memory before decoding fails
+	if (static_cast<uint64_t>(header._numVertices) * 3 > static_cast<uint64_t>(header._positionBytes) * RangeCoder::MAX_SYMBOLS_PER_BYTE ||
+		static_cast<uint64_t>(header._numFaces) * 3 > static_cast<uint64_t>(header._indexBytes) * RangeCoder::MAX_SYMBOLS_PER_BYTE)
+		return false;
+
+	geometry.resize(header._numVertices);
+	topology.resize(header._numFaces);
+
+	const uint8_t* positionStream = file.data() + sizeof(Header);
+	const uint8_t* indexStream = positionStream + header._positionBytes;
+
+	decodePositions(positionStream, header, geometry);
+	if (!decodeIndices(indexStream, header, topology))
+	{
+		geometry.clear();
+		topology.clear();
+
+		return false;
+	}
+
+	if (aabb) *aabb = AABB(header._minPoint, header._maxPoint);
+
+	return true;
+}
+
+bool QuantizedMesh::write(const std::string& filename, const std::vector<Model3D::VertexGPUData>& geometry, const std::vector<Model3D::FaceGPUData>& topology)
+{
+	std::ofstream fout(filename, std::ios::out | std::ios::binary);
+	if (!fout.is_open()) return false;
+
+	QuantizedMesh::write(fout, geometry, topology);
+	fout.close();
+
+	return !fout.fail();
+}
+
+bool QuantizedMesh::write(std::ostream& fout, const std::vector<Model3D::VertexGPUData>& geometry, const std::vector<Model3D::FaceGPUData>& topology)
+{
+	Header header;
+	std::memcpy(header._magic, MAGIC, sizeof(MAGIC));
+	header._version = VERSION;
+	header._positionBits = POSITION_BITS;
+	header._numVertices = static_cast<uint32_t>(geometry.size());
+	header._numFaces = static_cast<uint32_t>(topology.size());
+	header._minPoint = geometry.empty() ? vec3(.0f) : geometry[0]._position;
+	header._maxPoint = header._minPoint;
+
+	for (const Model3D::VertexGPUData& vertex : geometry)
+	{
+		header._minPoint = glm::min(header._minPoint, vertex._position);
+		header._maxPoint = glm::max(header._maxPoint, vertex._position);
+	}
+
+	std::vector<uint8_t> positionStream, indexStream;
+	encodePositions(geometry, header, positionStream);
+	encodeIndices(topology, indexStream);
+
+	header._positionBytes = static_cast<uint32_t>(positionStream.size());
+	header._indexBytes = static_cast<uint32_t>(indexStream.size());
+
+	fout.write((char*)&header, sizeof(Header));
+	fout.write((char*)positionStream.data(), positionStream.size());
+	fout.write((char*)indexStream.data(), indexStream.size());
+
+	return !fout.fail();
+}
+
+/// [Protected methods]
+
+void QuantizedMesh::decodePositions(const uint8_t* stream, const Header& header, std::vector<Model3D::VertexGPUData>& geometry)
+{
+	const float maxValue = static_cast<float>((1 << header._positionBits) - 1);
+	const vec3 extent = glm::max(header._maxPoint - header._minPoint, vec3(glm::epsilon<float>()));
+	const vec3 step = extent / maxValue;
+
+	RangeCoder::Decoder decoder(stream, header._positionBytes);
+	RangeCoder::VarintModel models[3];
+	ivec3 previous(0);
+
+	for (Model3D::VertexGPUData& vertex : geometry)
+	{
+		for (int axis = 0; axis < 3; ++axis)
+			previous[axis] += RangeCoder::zigzagDecode(decoder.decodeVarint(models[axis]));
+
+		vertex = Model3D::VertexGPUData{ header._minPoint + vec3(previous) * step };
+	}
+}
+
+bool QuantizedMesh::decodeIndices(const uint8_t* stream, const Header& header, std::vector<Model3D::FaceGPUData>& topology)
+{
+	RangeCoder::Decoder decoder(stream, header._indexBytes);
+	RangeCoder::VarintModel models[3];
+	int32_t previous = 0;
+
+	for (Model3D::FaceGPUData& face : topology)
+	{
+		ivec3 indices;
+		indices.x = previous + RangeCoder::zigzagDecode(decoder.decodeVarint(models[0]));
+		indices.y = indices.x + RangeCoder::zigzagDecode(decoder.decodeVarint(models[1]));
+		indices.z = indices.x + RangeCoder::zigzagDecode(decoder.decodeVarint(models[2]));
+		previous = indices.x;
+
+		for (int i = 0; i < 3; ++i)
+			if (indices[i] < 0 || static_cast<uint32_t>(indices[i]) >= header._numVertices) return false;
+
+		face = Model3D::FaceGPUData{ uvec3(indices) };
+	}
+
+	return true;
+}
+
+void QuantizedMesh::encodePositions(const std::vector<Model3D::VertexGPUData>& geometry, const Header& header, std::vector<uint8_t>& stream)
+{
+	const float maxValue = static_cast<float>((1 << header._positionBits) - 1);
+	const vec3 extent = glm::max(header._maxPoint - header._minPoint, vec3(glm::epsilon<float>()));
+
+	RangeCoder::Encoder encoder(stream);
+	RangeCoder::VarintModel models[3];
+	ivec3 previous(0);
+
+	stream.reserve(geometry.size() * 3);
+
+	for (const Model3D::VertexGPUData& vertex : geometry)
+	{
+		const ivec3 quantized = ivec3(glm::round(glm::clamp((vertex._position - header._minPoint) / extent, .0f, 1.0f) * maxValue));
+
+		for (int axis = 0; axis < 3; ++axis)
+			encoder.encodeVarint(models[axis], RangeCoder::zigzagEncode(quantized[axis] - previous[axis]));
+		previous = quantized;
+	}
+
+	encoder.finish();
+}
+
+void QuantizedMesh::encodeIndices(const std::vector<Model3D::FaceGPUData>& topology, std::vector<uint8_t>& stream)
+{
+	RangeCoder::Encoder encoder(stream);
+	RangeCoder::VarintModel models[3];
+	int32_t previous = 0;
+
+	stream.reserve(topology.size() * 2);
+
+	for (const Model3D::FaceGPUData& face : topology)
+	{
+		const ivec3 indices = ivec3(face._vertices);
+
+		encoder.encodeVarint(models[0], RangeCoder::zigzagEncode(indices.x - previous));
+		encoder.encodeVarint(models[1], RangeCoder::zigzagEncode(indices.y - indices.x));
+		encoder.encodeVarint(models[2], RangeCoder::zigzagEncode(indices.z - indices.x));
+		previous = indices.x;
+	}
+
+	encoder.finish();
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "Graphics/Core/Model3D.h"
+
+/**
+*	@brief Compact mesh container. Positions are quantized to 16 bits relative to the mesh bounding box, while positions and indices are
+*	delta-coded against a prediction and entropy-coded with an adaptive range coder. Normals are not stored, as they are derived from the topology.
+*
+*	Layout: Header | position stream (positionBytes) | index stream (indexBytes).
+*/
+class QuantizedMesh
+{
+public:
+	const static char		MAGIC[4];						//!< File signature
+	const static uint16_t	VERSION;						//!< Current version of the format
+	const static uint16_t	POSITION_BITS;					//!< Quantization bits per coordinate
+
+	struct Header
+	{
+		char		_magic[4];
+		uint16_t	_version;
+		uint16_t	_positionBits;
+		uint32_t	_numVertices;
+		uint32_t	_numFaces;
+		vec3		_minPoint;								//!< Bounds of the mesh, used to dequantize positions
+		vec3		_maxPoint;
+		uint32_t	_positionBytes;							//!< Size of the position stream
+		uint32_t	_indexBytes;							//!< Size of the index stream
+	};
+
+protected:
+	/**
+	*	@brief Codes quantized positions as differences with the previous vertex.
+	*/
+	static void encodePositions(const std::vector<Model3D::VertexGPUData>& geometry, const Header& header, std::vector<uint8_t>& stream);
+
+	/**
+	*	@brief Codes the first index of each face as a difference with the first index of the previous face, and the other two as
+	*	differences with the first one.
+	*/
+	static void encodeIndices(const std::vector<Model3D::FaceGPUData>& topology, std::vector<uint8_t>& stream);
+
+	/**
+	*	@brief Decodes the position stream into the vertex array.
+	*/
+	static void decodePositions(const uint8_t* stream, const Header& header, std::vector<Model3D::VertexGPUData>& geometry);
+
+	/**
+	*	@brief Decodes the index stream into the face array.
+	*	@return False if any index is out of range.
+	*/
+	static bool decodeIndices(const uint8_t* stream, const Header& header, std::vector<Model3D::FaceGPUData>& topology);
+
+public:
+	/**
+	*	@brief Reads a mesh through a memory-mapped view of the file, decoding directly into the vertex and face arrays.
+	*	@param aabb Optional output for the bounds of the mesh.
+	*	@return Success of operation.
+	*/
+	static bool read(const std::string& filename, std::vector<Model3D::VertexGPUData>& geometry, std::vector<Model3D::FaceGPUData>& topology, AABB* aabb = nullptr);
+
+	/**
+	*	@brief Writes a mesh. Only positions and faces are kept.
+	*	@return Success of operation.
+	*/
+	static bool write(const std::string& filename, const std::vector<Model3D::VertexGPUData>& geometry, const std::vector<Model3D::FaceGPUData>& topology);
+
+	/**
+	*	@brief Writes a mesh into a binary stream.
+	*	@return Success of operation.
+	*/
+	static bool write(std::ostream& stream, const std::vector<Model3D::VertexGPUData>& geometry, const std::vector<Model3D::FaceGPUData>& topology);
+};
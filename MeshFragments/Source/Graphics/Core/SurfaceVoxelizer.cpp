@@ -0,0 +1,271 @@
+#include "stdafx.h"
+#include "SurfaceVoxelizer.h"
+
+// [Static members initialization]
+
+const int SurfaceVoxelizer::BRICK_SIZE = 8;
+const double SurfaceVoxelizer::MARGIN = 1e-6;
+
+/// [Public methods]
+
+void SurfaceVoxelizer::voxelize(const std::vector<Model3D::VertexGPUData>& vertices, const std::vector<Model3D::FaceGPUData>& faces, const AABB& aabb, const uvec3& numDivs, unsigned thickness, uint8_t* surface)
+{
+	const size_t numCells = static_cast<size_t>(numDivs.x) * numDivs.y * numDivs.z;
+	std::fill(surface, surface + numCells, 0);
+
+	const vec3 scale = vec3(numDivs) / aabb.size(), minPoint = aabb.min();
+	const ivec3 numBricks = (ivec3(numDivs) + BRICK_SIZE - 1) / BRICK_SIZE;
+	const int numFaces = static_cast<int>(faces.size());
+
+	std::vector<Triangle> triangles(faces.size());
+	std::vector<uint32_t> faceStart(faces.size() + 1, 0);
+
+	// Bricks overlapped by each triangle are first counted, so that they can be listed in parallel afterwards
+	auto forEachBrick = [&](const Triangle& triangle, auto&& callback)
+	{
+		const ivec3 minBrick = triangle._minCell / BRICK_SIZE, maxBrick = triangle._maxCell / BRICK_SIZE;
+		if (minBrick == maxBrick)
+		{
+			callback(static_cast<uint32_t>((minBrick.x * numBricks.y + minBrick.y) * numBricks.z + minBrick.z));
+			return;
+		}
+
+		Axes axes;
+		setupAxes(triangle, axes);
+
+		for (int x = minBrick.x; x <= maxBrick.x; ++x)
+			for (int y = minBrick.y; y <= maxBrick.y; ++y)
+				for (int z = minBrick.z; z <= maxBrick.z; ++z)
+				{
+					const double centre[3] = { (x + .5) * BRICK_SIZE, (y + .5) * BRICK_SIZE, (z + .5) * BRICK_SIZE };
+					if (overlaps(axes, centre, BRICK_SIZE * .5))
+						callback(static_cast<uint32_t>((x * numBricks.y + y) * numBricks.z + z));
+				}
+	};
+
+	#pragma omp parallel for
+	for (int faceIdx = 0; faceIdx < numFaces; ++faceIdx)
+	{
+		Triangle& triangle = triangles[faceIdx];
+		vec3 minCoord(std::numeric_limits<float>::max()), maxCoord(-std::numeric_limits<float>::max());
+
+		for (int vertexIdx = 0; vertexIdx < 3; ++vertexIdx)
+		{
+			const vec3 position = (vertices[faces[faceIdx]._vertices[vertexIdx]]._position - minPoint) * scale;
+			for (int axis = 0; axis < 3; ++axis)
+				triangle._vertices[vertexIdx][axis] = position[axis];
+
+			minCoord = glm::min(minCoord, position);
+			maxCoord = glm::max(maxCoord, position);
+		}
+
+		// Voxels whose boundary merely touches the triangle are included as well
+		triangle._minCell = glm::max(ivec3(glm::ceil(minCoord)) - 1, ivec3(0));
+		triangle._maxCell = glm::min(ivec3(glm::floor(maxCoord)), ivec3(numDivs) - 1);
+
+		if (glm::any(glm::greaterThan(triangle._minCell, triangle._maxCell)))
+			continue;
+
+		forEachBrick(triangle, [&](uint32_t) { ++faceStart[faceIdx + 1]; });
+	}
+
+	for (size_t faceIdx = 0; faceIdx < faces.size(); ++faceIdx)
+		faceStart[faceIdx + 1] += faceStart[faceIdx];
+
+	std::vector<uint32_t> faceBricks(faceStart.back());
+
+	#pragma omp parallel for
+	for (int faceIdx = 0; faceIdx < numFaces; ++faceIdx)
+	{
+		if (faceStart[faceIdx] == faceStart[faceIdx + 1])
+			continue;
+
+		uint32_t binIdx = faceStart[faceIdx];
+		forEachBrick(triangles[faceIdx], [&](uint32_t brickIdx) { faceBricks[binIdx++] = brickIdx; });
+	}
+
+	// Counting sort of (face, brick) pairs by brick
+	const size_t totalBricks = static_cast<size_t>(numBricks.x) * numBricks.y * numBricks.z;
+	std::vector<uint32_t> brickStart(totalBricks + 1, 0);
+	for (uint32_t brickIdx : faceBricks)
+		++brickStart[brickIdx + 1];
+
+	for (size_t brickIdx = 0; brickIdx < totalBricks; ++brickIdx)
+		brickStart[brickIdx + 1] += brickStart[brickIdx];
+
+	std::vector<uint32_t> bins(faceBricks.size()), binSize(totalBricks, 0);
+	for (size_t faceIdx = 0; faceIdx < faces.size(); ++faceIdx)
+		for (uint32_t pairIdx = faceStart[faceIdx]; pairIdx < faceStart[faceIdx + 1]; ++pairIdx)
+			bins[brickStart[faceBricks[pairIdx]] + binSize[faceBricks[pairIdx]]++] = static_cast<uint32_t>(faceIdx);
+
+	// Bricks do not share voxels, hence they are written without synchronization
+	#pragma omp parallel for schedule(dynamic)
+	for (int brickIdx = 0; brickIdx < static_cast<int>(totalBricks); ++brickIdx)
+	{
+		const ivec3 brick(brickIdx / (numBricks.y * numBricks.z), (brickIdx / numBricks.z) % numBricks.y, brickIdx % numBricks.z);
+		const ivec3 brickMin = brick * BRICK_SIZE, brickMax = glm::min(brickMin + BRICK_SIZE, ivec3(numDivs)) - 1;
+
+		for (uint32_t binIdx = brickStart[brickIdx]; binIdx < brickStart[brickIdx + 1]; ++binIdx)
+			rasterize(triangles[bins[binIdx]], brickMin, brickMax, numDivs, surface);
+	}
+
+	if (thickness)
+		dilate(numDivs, thickness, surface);
+}
+
+/// [Protected methods]
+
+void SurfaceVoxelizer::dilate(const uvec3& numDivs, unsigned thickness, uint8_t* surface)
+{
+	const size_t strides[3] = { static_cast<size_t>(numDivs.y) * numDivs.z, numDivs.z, 1 };
+	const size_t numCells = strides[0] * numDivs.x;
+
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		const int length = static_cast<int>(numDivs[axis]), numLines = static_cast<int>(numCells / length);
+		const size_t stride = strides[axis];
+
+		#pragma omp parallel
+		{
+			std::vector<int> nearest(length);
+
+			#pragma omp for
+			for (int lineIdx = 0; lineIdx < numLines; ++lineIdx)
+			{
+				// Lines along x start at the first slice, lines along y at the first row of each slice and lines along z are contiguous
+				size_t start = lineIdx;
+				if (axis == 1)
+					start = (lineIdx / numDivs.z) * strides[0] + lineIdx % numDivs.z;
+				else if (axis == 2)
+					start = static_cast<size_t>(lineIdx) * numDivs.z;
+
+				uint8_t* line = surface + start;
+
+				// Distance to the closest marked voxel, first looking backward and then forward
+				int last = std::numeric_limits<int>::min() / 2;
+				for (int idx = 0; idx < length; ++idx)
+				{
+					if (line[idx * stride]) last = idx;
+					nearest[idx] = idx - last;
+				}
+
+				last = std::numeric_limits<int>::max() / 2;
+				for (int idx = length - 1; idx >= 0; --idx)
+				{
+					if (line[idx * stride]) last = idx;
+					line[idx * stride] = std::min(nearest[idx], last - idx) <= static_cast<int>(thickness);
+				}
+			}
+		}
+	}
+}
+
+bool SurfaceVoxelizer::overlaps(const Axes& axes, const double* centre, double halfSize)
+{
+	for (int axisIdx = 0; axisIdx < 13; ++axisIdx)
+	{
+		const double* axis = axes._axes[axisIdx];
+		const double projection = axis[0] * centre[0] + axis[1] * centre[1] + axis[2] * centre[2], radius = axes._radius[axisIdx] * (halfSize + MARGIN);
+
+		if (projection + radius < axes._min[axisIdx] || projection - radius > axes._max[axisIdx])
+			return false;
+	}
+
+	return true;
+}
+
+void SurfaceVoxelizer::rasterize(const Triangle& triangle, const ivec3& brickMin, const ivec3& brickMax, const uvec3& numDivs, uint8_t* surface)
+{
+	const ivec3 minCell = glm::max(triangle._minCell, brickMin), maxCell = glm::min(triangle._maxCell, brickMax);
+	if (glm::any(glm::greaterThan(minCell, maxCell)))
+		return;
+
+	Axes axes;
+	setupAxes(triangle, axes);
+
+	const size_t strides[3] = { static_cast<size_t>(numDivs.y) * numDivs.z, numDivs.z, 1 };
+	const int d = axes._dominantAxis, u = (d + 1) % 3, v = (d + 2) % 3;
+	const double* normal = axes._axes[3];
+	double centre[3];
+
+	for (int i = minCell[u]; i <= maxCell[u]; ++i)
+	{
+		centre[u] = i + .5;
+
+		for (int j = minCell[v]; j <= maxCell[v]; ++j)
+		{
+			centre[v] = j + .5;
+
+			// Voxels of the column within reach of the triangle plane
+			int first = minCell[d], last = maxCell[d];
+			if (normal[d] != .0)
+			{
+				const double offset = normal[u] * centre[u] + normal[v] * centre[v];
+				double low = (axes._min[3] - axes._radius[3] * (.5 + MARGIN) - offset) / normal[d], high = (axes._max[3] + axes._radius[3] * (.5 + MARGIN) - offset) / normal[d];
+				if (low > high) std::swap(low, high);
+
+				first = std::max(first, static_cast<int>(std::ceil(low - .5)) - 1);
+				last = std::min(last, static_cast<int>(std::floor(high - .5)) + 1);
+			}
+
+			for (int k = first; k <= last; ++k)
+			{
+				centre[d] = k + .5;
+
+				if (overlaps(axes, centre, .5))
+				{
+					const int cell[3] = { static_cast<int>(centre[0]), static_cast<int>(centre[1]), static_cast<int>(centre[2]) };
+					surface[cell[0] * strides[0] + cell[1] * strides[1] + cell[2]] = 1;
+				}
+			}
+		}
+	}
+}
+
+void SurfaceVoxelizer::setupAxes(const Triangle& triangle, Axes& axes)
+{
+	const double(*vertex)[3] = triangle._vertices;
+	double edges[3][3];
+
+	for (int edgeIdx = 0; edgeIdx < 3; ++edgeIdx)
+		for (int coord = 0; coord < 3; ++coord)
+			edges[edgeIdx][coord] = vertex[(edgeIdx + 1) % 3][coord] - vertex[edgeIdx][coord];
+
+	// Coordinate axes, normal and the nine cross products of edges and coordinate axes
+	for (int axisIdx = 0; axisIdx < 3; ++axisIdx)
+		for (int coord = 0; coord < 3; ++coord)
+			axes._axes[axisIdx][coord] = axisIdx == coord ? 1.0 : .0;
+
+	axes._axes[3][0] = edges[0][1] * edges[1][2] - edges[0][2] * edges[1][1];
+	axes._axes[3][1] = edges[0][2] * edges[1][0] - edges[0][0] * edges[1][2];
+	axes._axes[3][2] = edges[0][0] * edges[1][1] - edges[0][1] * edges[1][0];
+
+	for (int edgeIdx = 0; edgeIdx < 3; ++edgeIdx)
+	{
+		const double* edge = edges[edgeIdx];
+		double* xAxis = axes._axes[4 + edgeIdx * 3], * yAxis = axes._axes[5 + edgeIdx * 3], * zAxis = axes._axes[6 + edgeIdx * 3];
+
+		xAxis[0] = .0;			xAxis[1] = -edge[2];	xAxis[2] = edge[1];
+		yAxis[0] = edge[2];		yAxis[1] = .0;			yAxis[2] = -edge[0];
+		zAxis[0] = -edge[1];	zAxis[1] = edge[0];		zAxis[2] = .0;
+	}
+
+	for (int axisIdx = 0; axisIdx < 13; ++axisIdx)
+	{
+		const double* axis = axes._axes[axisIdx];
+		axes._min[axisIdx] = std::numeric_limits<double>::max();
+		axes._max[axisIdx] = -std::numeric_limits<double>::max();
+		axes._radius[axisIdx] = std::abs(axis[0]) + std::abs(axis[1]) + std::abs(axis[2]);
+
+		for (int vertexIdx = 0; vertexIdx < 3; ++vertexIdx)
+		{
+			const double projection = axis[0] * vertex[vertexIdx][0] + axis[1] * vertex[vertexIdx][1] + axis[2] * vertex[vertexIdx][2];
+			axes._min[axisIdx] = std::min(axes._min[axisIdx], projection);
+			axes._max[axisIdx] = std::max(axes._max[axisIdx], projection);
+		}
+	}
+
+	const double* normal = axes._axes[3];
+	axes._dominantAxis = std::abs(normal[0]) >= std::abs(normal[1]) ? (std::abs(normal[0]) >= std::abs(normal[2]) ? 0 : 2) : (std::abs(normal[1]) >= std::abs(normal[2]) ? 1 : 2);
+}
+
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "Graphics/Core/Model3D.h"
+
+/**
+*	@brief CPU conservative voxelizer, which marks every voxel touched by the surface of a mesh, whether it is closed or not. Triangles
+*	are binned into bricks of voxels and bricks are processed in parallel. Within a brick, the voxels of a triangle are enumerated as short
+*	runs along the dominant axis of its normal, and every voxel is checked with the separating axis test of Akenine-Moller, so that the
+*	cost is linear in the surface area and the result does not depend on the number of threads.
+*/
+class SurfaceVoxelizer
+{
+public:
+	const static int	BRICK_SIZE;							//!< Voxels per side of a brick
+	const static double	MARGIN;								//!< Voxel units boxes are grown by, so that rounding never drops a touching voxel
+
+protected:
+	/**
+	*	@brief Triangle in grid coordinates, where voxel (x, y, z) spans [x, x + 1] x [y, y + 1] x [z, z + 1].
+	*/
+	struct Triangle
+	{
+		double		_vertices[3][3];
+		ivec3		_minCell;								//!< First voxel of the bounding box
+		ivec3		_maxCell;								//!< Last voxel of the bounding box
+	};
+
+	/**
+	*	@brief Separating axes of a triangle and the projection of the triangle on each of them.
+	*/
+	struct Axes
+	{
+		double		_axes[13][3];							//!< Coordinate axes, triangle normal and cross products of edges and coordinate axes
+		double		_min[13], _max[13];						//!< Projection interval of the triangle
+		double		_radius[13];							//!< Projection radius of a box with half size 1
+		int			_dominantAxis;							//!< Largest component of the normal
+	};
+
+protected:
+	/**
+	*	@brief Dilates the marked voxels by a number of voxels in every direction (Chebyshev distance). The dilation is separable, so each
+	*	axis is swept in parallel over its lines.
+	*/
+	static void dilate(const uvec3& numDivs, unsigned thickness, uint8_t* surface);
+
+	/**
+	*	@brief Tests whether a box given by its centre and half size overlaps a triangle.
+	*/
+	static bool overlaps(const Axes& axes, const double* centre, double halfSize);
+
+	/**
+	*	@brief Marks the voxels of a brick overlapped by a triangle.
+	*/
+	static void rasterize(const Triangle& triangle, const ivec3& brickMin, const ivec3& brickMax, const uvec3& numDivs, uint8_t* surface);
+
+	/**
+	*	@brief Computes the separating axes of a triangle.
+	*/
+	static void setupAxes(const Triangle& triangle, Axes& axes);
+
+public:
+	/**
+	*	@brief Computes which voxels of a grid are overlapped by the triangles of a mesh.
+	*	@param thickness Voxels the surface is thickened by, so that thin shells remain connected.
+	*	@param surface Buffer of numDivs.x * numDivs.y * numDivs.z flags laid out as x * ny * nz + y * nz + z, which are set to 1 for surface voxels.
+	*/
+	static void voxelize(const std::vector<Model3D::VertexGPUData>& vertices, const std::vector<Model3D::FaceGPUData>& faces, const AABB& aabb, const uvec3& numDivs, unsigned thickness, uint8_t* surface);
+};
+
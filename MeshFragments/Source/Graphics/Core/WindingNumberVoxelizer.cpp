@@ -0,0 +1,210 @@
+#include "stdafx.h"
+#include "WindingNumberVoxelizer.h"
+
+// [Static members initialization]
+
+const unsigned WindingNumberVoxelizer::TILE_SIZE = 4;
+
+/// [Public methods]
+
+void WindingNumberVoxelizer::voxelize(const TriangleBvh& bvh, const AABB& aabb, const uvec3& numDivs, float accuracy, uint8_t* inside)
+{
+	const size_t sliceSize = static_cast<size_t>(numDivs.y) * numDivs.z;
+	std::fill(inside, inside + sliceSize * numDivs.x, 0);
+
+	if (bvh._triangles.empty())
+		return;
+
+	std::vector<Cluster> clusters;
+	computeMoments(bvh, clusters);
+
+	const vec3 cellSize = aabb.size() / vec3(numDivs), minPoint = aabb.min();
+	const uvec3 numTiles = (numDivs + uvec3(TILE_SIZE - 1)) / uvec3(TILE_SIZE);
+	const int tilesPerSlab = static_cast<int>(numTiles.y * numTiles.z);
+
+	// Below one, the dipole could be used from within the bounding sphere of a cluster
+	accuracy = std::max(accuracy, 1.0f);
+
+	#pragma omp parallel for schedule(dynamic)
+	for (int tileIdx = 0; tileIdx < static_cast<int>(numTiles.x) * tilesPerSlab; ++tileIdx)
+	{
+		const uvec3 tileMin = uvec3(tileIdx / tilesPerSlab, (tileIdx / numTiles.z) % numTiles.y, tileIdx % numTiles.z) * TILE_SIZE;
+		const uvec3 tileMax = glm::min(tileMin + uvec3(TILE_SIZE), numDivs);
+		const vec3 tileCentre = minPoint + cellSize * (vec3(tileMin) + vec3(tileMax)) * .5f;
+		const float tileRadius = glm::length(cellSize * vec3(tileMax - tileMin)) * .5f;
+
+		vec3 points[TILE_SIZE * TILE_SIZE * TILE_SIZE];
+		double windingNumbers[TILE_SIZE * TILE_SIZE * TILE_SIZE];
+		int numPoints = 0;
+
+		for (unsigned x = tileMin.x; x < tileMax.x; ++x)
+			for (unsigned y = tileMin.y; y < tileMax.y; ++y)
+				for (unsigned z = tileMin.z; z < tileMax.z; ++z)
+					points[numPoints++] = minPoint + cellSize * vec3(x + .5f, y + .5f, z + .5f);
+
+		computeWindingNumbers(bvh, clusters, points, numPoints, tileCentre, tileRadius, accuracy, windingNumbers);
+
+		numPoints = 0;
+		for (unsigned x = tileMin.x; x < tileMax.x; ++x)
+			for (unsigned y = tileMin.y; y < tileMax.y; ++y)
+				for (unsigned z = tileMin.z; z < tileMax.z; ++z)
+					inside[x * sliceSize + y * numDivs.z + z] = std::abs(windingNumbers[numPoints++]) >= .5;
+	}
+}
+
+/// [Protected methods]
+
+void WindingNumberVoxelizer::computeMoments(const TriangleBvh& bvh, std::vector<Cluster>& clusters)
+{
+	const std::vector<TriangleBvh::Node>& nodes = bvh._nodes;
+	const std::vector<TriangleBvh::Triangle>& triangles = bvh._triangles;
+	clusters.assign(nodes.size() * TriangleBvh::WIDTH, Cluster{ vec3(.0f), .0f, vec3(.0f), .0f });
+
+	// Leaves are independent from each other
+	#pragma omp parallel for
+	for (int clusterIdx = 0; clusterIdx < static_cast<int>(clusters.size()); ++clusterIdx)
+	{
+		const TriangleBvh::Node& node = nodes[clusterIdx / TriangleBvh::WIDTH];
+		const int childIdx = clusterIdx % TriangleBvh::WIDTH;
+		if (!node._counts[childIdx])
+			continue;
+
+		Cluster& cluster = clusters[clusterIdx];
+		const uint32_t begin = node._children[childIdx], end = begin + node._counts[childIdx];
+		vec3 weightedCentre(.0f);
+
+		for (uint32_t idx = begin; idx < end; ++idx)
+		{
+			const vec3* triangle = triangles[idx]._vertices;
+			const vec3 areaNormal = glm::cross(triangle[1] - triangle[0], triangle[2] - triangle[0]) * .5f;
+			const float area = glm::length(areaNormal);
+
+			cluster._dipole += areaNormal;
+			cluster._area += area;
+			weightedCentre += (triangle[0] + triangle[1] + triangle[2]) * (area / 3.0f);
+		}
+
+		// Degenerate leaves fall back to their first vertex
+		cluster._centre = cluster._area > .0f ? weightedCentre / cluster._area : triangles[begin]._vertices[0];
+		for (uint32_t idx = begin; idx < end; ++idx)
+			for (int vertexIdx = 0; vertexIdx < 3; ++vertexIdx)
+				cluster._radius = std::max(cluster._radius, glm::distance(cluster._centre, triangles[idx]._vertices[vertexIdx]));
+	}
+
+	// Nodes are stored after their parent, and the first child of a node is never an empty slot
+	for (int nodeIdx = static_cast<int>(nodes.size()) - 1; nodeIdx >= 0; --nodeIdx)
+	{
+		const TriangleBvh::Node& node = nodes[nodeIdx];
+
+		for (int childIdx = 0; childIdx < TriangleBvh::WIDTH; ++childIdx)
+		{
+			if (!TriangleBvh::isInner(node, childIdx))
+				continue;
+
+			Cluster& cluster = clusters[nodeIdx * TriangleBvh::WIDTH + childIdx];
+			const TriangleBvh::Node& child = nodes[node._children[childIdx]];
+			const Cluster* childClusters = &clusters[node._children[childIdx] * TriangleBvh::WIDTH];
+			vec3 weightedCentre(.0f);
+
+			for (int grandchildIdx = 0; grandchildIdx < TriangleBvh::WIDTH; ++grandchildIdx)
+			{
+				cluster._dipole += childClusters[grandchildIdx]._dipole;
+				cluster._area += childClusters[grandchildIdx]._area;
+				weightedCentre += childClusters[grandchildIdx]._centre * childClusters[grandchildIdx]._area;
+			}
+
+			cluster._centre = cluster._area > .0f ? weightedCentre / cluster._area : childClusters[0]._centre;
+			for (int grandchildIdx = 0; grandchildIdx < TriangleBvh::WIDTH; ++grandchildIdx)
+				if (child._counts[grandchildIdx] || TriangleBvh::isInner(child, grandchildIdx))
+					cluster._radius = std::max(cluster._radius, glm::distance(cluster._centre, childClusters[grandchildIdx]._centre) + childClusters[grandchildIdx]._radius);
+		}
+	}
+}
+
+double WindingNumberVoxelizer::solidAngle(const vec3& a, const vec3& b, const vec3& c, const vec3& point)
+{
+	// Van Oosterom and Strackee formula
+	const double ax = a.x - point.x, ay = a.y - point.y, az = a.z - point.z;
+	const double bx = b.x - point.x, by = b.y - point.y, bz = b.z - point.z;
+	const double cx = c.x - point.x, cy = c.y - point.y, cz = c.z - point.z;
+	const double lengthA = std::sqrt(ax * ax + ay * ay + az * az), lengthB = std::sqrt(bx * bx + by * by + bz * bz), lengthC = std::sqrt(cx * cx + cy * cy + cz * cz);
+
+	const double determinant = ax * (by * cz - bz * cy) - ay * (bx * cz - bz * cx) + az * (bx * cy - by * cx);
+	const double denominator = lengthA * lengthB * lengthC + (ax * bx + ay * by + az * bz) * lengthC + (bx * cx + by * cy + bz * cz) * lengthA + (cx * ax + cy * ay + cz * az) * lengthB;
+
+	return 2.0 * std::atan2(determinant, denominator);
+}
+
+void WindingNumberVoxelizer::computeWindingNumbers(const TriangleBvh& bvh, const std::vector<Cluster>& clusters, const vec3* points, int numPoints, const vec3& centre, float radius, float accuracy, double* windingNumbers)
+{
+	uint32_t stack[TriangleBvh::WIDTH * TriangleBvh::MAX_DEPTH];
+	int stackSize = 0;
+
+	std::fill(windingNumbers, windingNumbers + numPoints, .0);
+	stack[stackSize++] = 0;
+
+	auto addDipole = [windingNumbers](const Cluster& cluster, const vec3& point, int pointIdx)
+	{
+		const vec3 direction = cluster._centre - point;
+		const float distance = glm::length(direction);
+		windingNumbers[pointIdx] += glm::dot(direction, cluster._dipole) / (static_cast<double>(distance) * distance * distance);
+	};
+
+	// Clusters far from the whole group are expanded to first order around its centre
+	double localValue = .0, localGradient[3] = { .0, .0, .0 };
+
+	while (stackSize)
+	{
+		const uint32_t nodeIdx = stack[--stackSize];
+		const TriangleBvh::Node& node = bvh._nodes[nodeIdx];
+
+		for (int childIdx = 0; childIdx < TriangleBvh::WIDTH; ++childIdx)
+		{
+			const bool isLeaf = node._counts[childIdx] > 0;
+			if (!isLeaf && !TriangleBvh::isInner(node, childIdx))
+				continue;
+
+			const Cluster& cluster = clusters[nodeIdx * TriangleBvh::WIDTH + childIdx];
+			const vec3 direction = cluster._centre - centre;
+			const double distance = glm::length(direction);
+
+			if (distance > accuracy * (cluster._radius + radius))
+			{
+				const double invDistance3 = 1.0 / (distance * distance * distance), projection = glm::dot(direction, cluster._dipole);
+				localValue += projection * invDistance3;
+
+				for (int axis = 0; axis < 3; ++axis)
+					localGradient[axis] += 3.0 * projection * direction[axis] * invDistance3 / (distance * distance) - cluster._dipole[axis] * invDistance3;
+			}
+			else if (isLeaf)
+			{
+				// Far field for single points: the cluster behaves as a dipole located at its centre
+				for (int pointIdx = 0; pointIdx < numPoints; ++pointIdx)
+				{
+					if (glm::distance(cluster._centre, points[pointIdx]) > accuracy * cluster._radius)
+					{
+						addDipole(cluster, points[pointIdx], pointIdx);
+						continue;
+					}
+
+					for (uint32_t idx = node._children[childIdx]; idx < node._children[childIdx] + node._counts[childIdx]; ++idx)
+					{
+						const vec3* triangle = bvh._triangles[idx]._vertices;
+						windingNumbers[pointIdx] += solidAngle(triangle[0], triangle[1], triangle[2], points[pointIdx]);
+					}
+				}
+			}
+			else
+			{
+				stack[stackSize++] = node._children[childIdx];
+			}
+		}
+	}
+
+	for (int pointIdx = 0; pointIdx < numPoints; ++pointIdx)
+	{
+		const vec3 offset = points[pointIdx] - centre;
+		windingNumbers[pointIdx] += localValue + localGradient[0] * offset.x + localGradient[1] * offset.y + localGradient[2] * offset.z;
+		windingNumbers[pointIdx] /= 4.0 * glm::pi<double>();
+	}
+}
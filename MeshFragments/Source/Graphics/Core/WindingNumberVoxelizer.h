@@ -0,0 +1,59 @@
+#pragma once
+
+#include "DataStructures/TriangleBvh.h"
+
+/**
+*	@brief CPU solid voxelizer based on the generalized winding number, which degrades gracefully with holes, self-intersections and
+*	non-manifold surfaces. Triangles are clustered by the children of the nodes of a TriangleBvh, each one with its area-weighted normal
+*	(dipole), so that clusters far enough from a voxel centre are evaluated as a single dipole instead of summing the solid angle of every
+*	triangle.
+*
+*	Barill, G., Dickson, N. G., Schmidt, R., Levin, D. I. W., Jacobson, A., Fast Winding Numbers for Soups and Clouds. ACM Transactions on
+*	Graphics, 37(4), 2018.
+*/
+class WindingNumberVoxelizer
+{
+public:
+	const static unsigned	TILE_SIZE;						//!< Voxels per side of the tiles that share a traversal of the hierarchy
+
+protected:
+	/**
+	*	@brief Moments of the triangles below a child of a node of the hierarchy.
+	*/
+	struct Cluster
+	{
+		vec3		_centre;								//!< Area-weighted centroid of the triangles
+		float		_radius;								//!< Distance from the centre to the farthest vertex
+		vec3		_dipole;								//!< Sum of area-weighted normals
+		float		_area;
+	};
+
+protected:
+	/**
+	*	@brief Computes the cluster of every child of the hierarchy, indexed as node * TriangleBvh::WIDTH + child, from the leaves up.
+	*/
+	static void computeMoments(const TriangleBvh& bvh, std::vector<Cluster>& clusters);
+
+	/**
+	*	@return Solid angle of a triangle as seen from a point.
+	*/
+	static double solidAngle(const vec3& a, const vec3& b, const vec3& c, const vec3& point);
+
+	/**
+	*	@brief Computes the generalized winding number of a group of points within a sphere, which share a single traversal of the
+	*	hierarchy. Nodes are only opened while they are near some point of the group.
+	*	@param accuracy Distance to a cluster, relative to its radius, beyond which it is approximated by its dipole.
+	*/
+	static void computeWindingNumbers(const TriangleBvh& bvh, const std::vector<Cluster>& clusters, const vec3* points, int numPoints, const vec3& centre, float radius, float accuracy, double* windingNumbers);
+
+public:
+	/**
+	*	@brief Computes which voxels of a grid are inside the triangles of a hierarchy, i.e. their centre has a winding number of magnitude
+	*	0.5 or greater, so that either orientation of the mesh is accepted.
+	*	@param accuracy Distance to a cluster of triangles, relative to its radius, beyond which it is approximated. Larger values are
+	*	more accurate and slower.
+	*	@param inside Buffer of numDivs.x * numDivs.y * numDivs.z flags laid out as x * ny * nz + y * nz + z, which are set to 1 for inner voxels.
+	*/
+	static void voxelize(const TriangleBvh& bvh, const AABB& aabb, const uvec3& numDivs, float accuracy, uint8_t* inside);
+};
+
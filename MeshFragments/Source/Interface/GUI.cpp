@@ -232,6 +232,11 @@ void GUI::showFractureSettings()
 			if (ImGui::BeginTabItem("General settings"))
 			{
 				ImGui::SliderInt("Grid Subdivisions", &_fractureParameters->_voxelizationSize[0], 1, _fractureParameters->_clampVoxelMetricUnit);
+				ImGui::Combo("Voxelization", &_fractureParameters->_voxelizationMethod, FractureParameters::Voxelization_STR, IM_ARRAYSIZE(FractureParameters::Voxelization_STR));
+				if (_fractureParameters->_voxelizationMethod == FractureParameters::CPU_WINDING_NUMBER)
+					ImGui::SliderFloat("Winding Number Accuracy", &_fractureParameters->_windingNumberAccuracy, 1.0f, 4.0f);
+				ImGui::SliderInt("Shell Thickness", &_fractureParameters->_shellThickness, 0, 8);
+				ImGui::Checkbox("Cache Voxelization", &_fractureParameters->_cacheVoxelization);
 
 				int maxSeeds = std::pow(2, fracturer::Seeder::VOXEL_ID_POSITION) / 2;
 
@@ -292,6 +297,7 @@ void GUI::showFractureSettings()
 				if (ImGui::Button("Export Fracture Meshes"))
 					_scene->exportFragments(*_fractureParameters, FractureParameters::ExportMesh_STR[_fractureParameters->_exportMeshExtension]);
 
+				ImGui::Combo("Point Cloud Sampling", &_fractureParameters->_pointCloudSampling, FractureParameters::PointCloudSampling_STR, IM_ARRAYSIZE(FractureParameters::PointCloudSampling_STR));
 				ImGui::Combo("Point Cloud Extension", &_fractureParameters->_exportPointCloudExtension, FractureParameters::ExportPointCloud_STR, IM_ARRAYSIZE(FractureParameters::ExportPointCloud_STR));
 				ImGui::SameLine(0, 20);
 				if (ImGui::Button("Export Point Cloud"))
@@ -22,10 +22,13 @@
 // [Standard libraries: basic]
 
 #include <algorithm>
+#include <bit>
 #include <cmath>
 #include <cassert>
+#include <charconv>
 #include <chrono>
 #include <climits>
+#include <condition_variable>
 #include <cstdint>
 #include <exception>
 #include <execution>
@@ -36,6 +39,7 @@
 #include <iostream>
 #include <limits>
 #include <memory>
+#include <mutex>
 #include <numeric>
 #include <random>
 #include <regex>
@@ -51,6 +55,7 @@
 // [Standard libraries: data structures]
 
 #include <map>
+#include <queue>
 #include <set>
 #include <unordered_map>
 #include <unordered_set>
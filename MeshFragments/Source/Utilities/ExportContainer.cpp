@@ -0,0 +1,33 @@
+#include "stdafx.h"
+#include "ExportContainer.h"
+
+// [Static members initialization]
+
+const std::string ExportContainer::TEMPORARY_EXTENSION = ".part";
+
+/// [Public methods]
+
+void ExportContainer::write(ExportContainer* container, const std::string& filename, const std::function<void(std::ostream&)>& writer)
+{
+	if (!container)
+	{
+		std::ofstream file(filename, std::ios::out | std::ios::binary);
+		if (!file.is_open())
+			throw std::runtime_error("Failed to open file " + filename);
+
+		writer(file);
+		file.close();
+
+		if (file.fail())
+			throw std::runtime_error("Failed to write file " + filename);
+
+		return;
+	}
+
+	std::ostringstream stream(std::ios::out | std::ios::binary);
+	writer(stream);
+	const std::string content = std::move(stream).str();
+
+	if (!container->addFile(std::filesystem::path(filename).filename().string(), content.data(), content.size()))
+		throw std::runtime_error("Failed to add " + filename + " to the export container");
+}
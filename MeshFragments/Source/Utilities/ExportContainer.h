@@ -0,0 +1,31 @@
+#pragma once
+
+/**
+*	@brief Destination that packs exported files together instead of writing them individually to the file system.
+*/
+class ExportContainer
+{
+public:
+	const static std::string TEMPORARY_EXTENSION;					//!< Suffix of container files while they are being written
+
+public:
+	/**
+	*	@brief Destructor.
+	*/
+	virtual ~ExportContainer() {}
+
+	/**
+	*	@brief Adds a file to the container. Implementations must be thread-safe.
+	*	@param name Name of the file, without folders.
+	*	@return Success of operation.
+	*/
+	virtual bool addFile(const std::string& name, const char* data, size_t size) = 0;
+
+	/**
+	*	@brief Runs a writer over the file named filename, or over an in-memory entry of container if it is not null. Entries are
+	*	named after the last component of filename. Throws std::runtime_error if the file or entry cannot be written, so that
+	*	exports running in ExportPool report the failure through their future.
+	*/
+	static void write(ExportContainer* container, const std::string& filename, const std::function<void(std::ostream&)>& writer);
+};
+
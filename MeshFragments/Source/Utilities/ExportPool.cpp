@@ -0,0 +1,119 @@
+#include "stdafx.h"
+#include "ExportPool.h"
+
+// [Static members initialization]
+
+const size_t ExportPool::DEFAULT_QUEUE_SIZE = 64;
+
+/// [Public methods]
+
+ExportPool::~ExportPool()
+{
+	this->stop();
+}
+
+unsigned ExportPool::collect(std::vector<std::future<void>>& futures, bool wait)
+{
+	unsigned numFailures = 0;
+	size_t numPending = 0;
+
+	for (std::future<void>& future : futures)
+	{
+		if (!wait && future.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		{
+			if (&futures[numPending] != &future) futures[numPending] = std::move(future);
+			++numPending;
+			continue;
+		}
+
+		try
+		{
+			future.get();
+		}
+		catch (const std::exception& exception)
+		{
+			std::cerr << "Export failed: " << exception.what() << std::endl;
+			++numFailures;
+		}
+	}
+
+	futures.resize(numPending);
+
+	return numFailures;
+}
+
+void ExportPool::configure(unsigned numThreads, size_t maxQueuedJobs)
+{
+	if (numThreads == 0) numThreads = std::max(1u, std::thread::hardware_concurrency());
+
+	this->stop();
+	_maxQueuedJobs = std::max(maxQueuedJobs, size_t(1));
+	this->start(numThreads);
+}
+
+std::future<void> ExportPool::submit(std::function<void()>&& job)
+{
+	std::packaged_task<void()> task(std::move(job));
+	std::future<void> future = task.get_future();
+
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		_slotAvailable.wait(lock, [this] { return _jobs.size() < _maxQueuedJobs; });
+		_jobs.push(std::move(task));
+	}
+
+	_jobAvailable.notify_one();
+
+	return future;
+}
+
+/// [Protected methods]
+
+ExportPool::ExportPool() : _maxQueuedJobs(DEFAULT_QUEUE_SIZE), _stop(false)
+{
+	this->start(std::max(1u, std::thread::hardware_concurrency()));
+}
+
+void ExportPool::start(unsigned numThreads)
+{
+	_stop = false;
+
+	_workers.reserve(numThreads);
+	for (unsigned threadIdx = 0; threadIdx < numThreads; ++threadIdx)
+		_workers.emplace_back(&ExportPool::work, this);
+}
+
+void ExportPool::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stop = true;
+	}
+
+	_jobAvailable.notify_all();
+
+	for (std::thread& worker : _workers)
+		worker.join();
+	_workers.clear();
+}
+
+void ExportPool::work()
+{
+	while (true)
+	{
+		std::packaged_task<void()> task;
+
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_jobAvailable.wait(lock, [this] { return _stop || !_jobs.empty(); });
+
+			if (_jobs.empty()) return;
+
+			task = std::move(_jobs.front());
+			_jobs.pop();
+		}
+
+		_slotAvailable.notify_one();
+		task();
+	}
+}
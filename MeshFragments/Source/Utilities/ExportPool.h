@@ -0,0 +1,77 @@
+#pragma once
+
+#include "Utilities/Singleton.h"
+
+/**
+*	@brief Fixed set of worker threads that write exported files. Jobs are kept in a bounded queue, so that submitting blocks while
+*	the queue is full instead of spawning a new thread or keeping an unbounded amount of pending buffers in memory.
+*/
+class ExportPool: public Singleton<ExportPool>
+{
+	friend class Singleton<ExportPool>;
+
+public:
+	const static size_t DEFAULT_QUEUE_SIZE;								//!< Maximum number of pending jobs unless configured otherwise
+
+protected:
+	std::condition_variable						_jobAvailable;			//!< Notifies workers that a job was queued or the pool is stopping
+	std::queue<std::packaged_task<void()>>		_jobs;					//!< Pending jobs
+	size_t										_maxQueuedJobs;			//!< Capacity of the queue
+	std::mutex									_mutex;					//!< Guards the queue and the stop flag
+	std::condition_variable						_slotAvailable;			//!< Notifies producers that the queue is no longer full
+	bool										_stop;					//!< Workers finish the queued jobs and exit
+	std::vector<std::thread>					_workers;				//!< Worker threads
+
+protected:
+	/**
+	*	@brief Constructor. Launches one worker per hardware thread.
+	*/
+	ExportPool();
+
+	/**
+	*	@brief Launches the workers.
+	*/
+	void start(unsigned numThreads);
+
+	/**
+	*	@brief Waits for the queued jobs to finish and joins the workers.
+	*/
+	void stop();
+
+	/**
+	*	@brief Loop of each worker, which pops and runs jobs until the pool is stopped and the queue is empty.
+	*/
+	void work();
+
+public:
+	/**
+	*	@brief Destructor. Pending jobs are completed before returning.
+	*/
+	virtual ~ExportPool();
+
+	/**
+	*	@brief Waits for the pending futures. Failed jobs are reported through the standard error output.
+	*	@param wait If false, only the futures that are already completed are collected.
+	*	@return Number of failed jobs.
+	*/
+	static unsigned collect(std::vector<std::future<void>>& futures, bool wait = true);
+
+	/**
+	*	@brief Restarts the pool with a different concurrency. Pending jobs are completed beforehand.
+	*	@param numThreads Number of workers; zero selects the number of hardware threads.
+	*	@param maxQueuedJobs Capacity of the queue, after which submit blocks.
+	*/
+	void configure(unsigned numThreads, size_t maxQueuedJobs);
+
+	/**
+	*	@return Number of worker threads.
+	*/
+	unsigned getNumThreads() const { return static_cast<unsigned>(_workers.size()); }
+
+	/**
+	*	@brief Queues a job, blocking while the queue is full. The job should own the data it writes.
+	*	@return Future which is ready once the job has finished, and rethrows its exception, if any.
+	*/
+	std::future<void> submit(std::function<void()>&& job);
+};
+
@@ -0,0 +1,23 @@
+#include "stdafx.h"
+#include "HashUtilities.h"
+
+/// [Public methods]
+
+uint64_t HashUtilities::hash(const void* data, size_t size, uint64_t seed)
+{
+	const uint64_t PRIME = 0x9E3779B97F4A7C15ull;
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	const size_t numWords = size / sizeof(uint64_t);
+	uint64_t hash = (seed ^ size) * PRIME, word;
+
+	for (size_t wordIdx = 0; wordIdx < numWords; ++wordIdx)
+	{
+		std::memcpy(&word, bytes + wordIdx * sizeof(uint64_t), sizeof(uint64_t));
+		hash = (std::rotl(hash, 31) ^ word) * PRIME;
+	}
+
+	for (size_t byteIdx = numWords * sizeof(uint64_t); byteIdx < size; ++byteIdx)
+		hash = (hash ^ bytes[byteIdx]) * PRIME;
+
+	return hash ^ (hash >> 32);
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+/**
+*	@brief Non-cryptographic hashing of binary buffers, used to key caches on their inputs.
+*/
+namespace HashUtilities
+{
+	/**
+	*	@brief Folds a buffer into a multiplicative hash over 8-byte words, followed by the remaining bytes. Chained buffers pass the
+	*	hash of the previous ones as seed.
+	*/
+	uint64_t hash(const void* data, size_t size, uint64_t seed = 0);
+}
@@ -0,0 +1,133 @@
+#include "stdafx.h"
+#include "LZCodec.h"
+
+static uint32_t read32(const uint8_t* data)
+{
+	uint32_t value;
+	std::memcpy(&value, data, sizeof(uint32_t));
+	return value;
+}
+
+static void appendLength(std::vector<uint8_t>& output, size_t length)
+{
+	for (; length >= 255; length -= 255)
+		output.push_back(255);
+	output.push_back(static_cast<uint8_t>(length));
+}
+
+static bool readLength(const uint8_t*& data, const uint8_t* end, size_t& length)
+{
+	uint8_t byte;
+
+	do
+	{
+		if (data >= end) return false;
+
+		byte = *data++;
+		length += byte;
+	} while (byte == 255);
+
+	return true;
+}
+
+static void appendSequence(std::vector<uint8_t>& output, const uint8_t* literals, size_t numLiterals, size_t offset, size_t matchLength)
+{
+	const size_t extraMatch = matchLength ? matchLength - LZCodec::MIN_MATCH : 0;
+	output.push_back(static_cast<uint8_t>((std::min(numLiterals, static_cast<size_t>(15)) << 4) | std::min(extraMatch, static_cast<size_t>(15))));
+
+	if (numLiterals >= 15)
+		appendLength(output, numLiterals - 15);
+	output.insert(output.end(), literals, literals + numLiterals);
+
+	if (!matchLength) return;
+
+	output.push_back(static_cast<uint8_t>(offset));
+	output.push_back(static_cast<uint8_t>(offset >> 8));
+	if (extraMatch >= 15)
+		appendLength(output, extraMatch - 15);
+}
+
+/// [Public methods]
+
+void LZCodec::compress(const uint8_t* data, size_t size, std::vector<uint8_t>& output)
+{
+	// Empty blocks are a single token without literals, and data may then be null
+	if (!size)
+	{
+		output.push_back(0);
+		return;
+	}
+
+	std::vector<uint32_t> table(static_cast<size_t>(1) << HASH_BITS, std::numeric_limits<uint32_t>::max());
+	size_t anchor = 0, position = 0;
+
+	while (position + MIN_MATCH <= size)
+	{
+		const uint32_t sequence = read32(data + position);
+		const uint32_t hash = (sequence * 2654435761u) >> (32 - HASH_BITS);
+		const uint32_t candidate = table[hash];
+		table[hash] = static_cast<uint32_t>(position);
+
+		if (candidate == std::numeric_limits<uint32_t>::max() || position - candidate > MAX_OFFSET || read32(data + candidate) != sequence)
+		{
+			// Step faster through data that does not compress
+			position += 1 + ((position - anchor) >> 6);
+			continue;
+		}
+
+		size_t length = MIN_MATCH;
+		while (position + length < size && data[candidate + length] == data[position + length])
+			++length;
+
+		appendSequence(output, data + anchor, position - anchor, position - candidate, length);
+		position += length;
+		anchor = position;
+	}
+
+	appendSequence(output, data + anchor, size - anchor, 0, 0);
+}
+
+bool LZCodec::decompress(const uint8_t* data, size_t dataSize, uint8_t* output, size_t size)
+{
+	if (!size) return dataSize == 1 && data[0] == 0;
+
+	const uint8_t* end = data + dataSize;
+	size_t position = 0;
+
+	while (data < end)
+	{
+		const uint8_t token = *data++;
+		size_t numLiterals = token >> 4, matchLength = token & 15;
+
+		if (numLiterals == 15 && !readLength(data, end, numLiterals)) return false;
+		if (numLiterals > static_cast<size_t>(end - data) || numLiterals > size - position) return false;
+
+		std::memcpy(output + position, data, numLiterals);
+		data += numLiterals;
+		position += numLiterals;
+
+		// Last sequence, which has no match
+		if (data == end) break;
+
+		if (end - data < 2) return false;
+		const size_t offset = data[0] | (data[1] << 8);
+		data += 2;
+
+		if (matchLength == 15 && !readLength(data, end, matchLength)) return false;
+		matchLength += MIN_MATCH;
+
+		if (offset == 0 || offset > position || matchLength > size - position) return false;
+
+		// Matches may overlap the bytes they produce, e.g., runs have an offset of 1
+		const uint8_t* source = output + position - offset;
+		if (offset >= matchLength)
+			std::memcpy(output + position, source, matchLength);
+		else
+			for (size_t idx = 0; idx < matchLength; ++idx)
+				output[position + idx] = source[idx];
+
+		position += matchLength;
+	}
+
+	return position == size;
+}
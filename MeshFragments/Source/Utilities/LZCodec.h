@@ -0,0 +1,26 @@
+#pragma once
+
+/**
+*	@brief Byte-oriented LZ77 codec in the spirit of LZ4, meant for fast compression of independent blocks. A block is a sequence of
+*	(literals, match) pairs, and the last one only holds literals.
+*
+*	Sequence: token (literal length << 4 | match length - MIN_MATCH) | extra literal length bytes | literals | offset (uint16_t) |
+*	extra match length bytes. Lengths of 15 continue in the following bytes, which are added until one of them is below 255.
+*/
+namespace LZCodec
+{
+	const unsigned HASH_BITS = 14;								//!< Size of the match finder table
+	const size_t MAX_OFFSET = 65535;							//!< Maximum distance of a match
+	const unsigned MIN_MATCH = 4;								//!< Shortest match that is coded
+
+	/**
+	*	@brief Appends the compressed form of data to output.
+	*/
+	void compress(const uint8_t* data, size_t size, std::vector<uint8_t>& output);
+
+	/**
+	*	@brief Decompresses a block whose original size is known.
+	*	@return False if the block is corrupted or does not decompress to exactly size bytes.
+	*/
+	bool decompress(const uint8_t* data, size_t dataSize, uint8_t* output, size_t size);
+}
@@ -0,0 +1,114 @@
+#include "stdafx.h"
+#include "MemoryMappedFile.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/// [Public methods]
+
+#ifdef _WIN32
+
+MemoryMappedFile::MemoryMappedFile() :
+	_data(nullptr), _size(0), _file(INVALID_HANDLE_VALUE), _mapping(nullptr)
+{
+}
+
+void MemoryMappedFile::close()
+{
+	if (_data) UnmapViewOfFile(_data);
+	if (_mapping) CloseHandle(_mapping);
+	if (_file != INVALID_HANDLE_VALUE) CloseHandle(_file);
+
+	_data = nullptr;
+	_size = 0;
+	_mapping = nullptr;
+	_file = INVALID_HANDLE_VALUE;
+}
+
+bool MemoryMappedFile::open(const std::string& filename)
+{
+	this->close();
+
+	_file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (_file == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(_file, &fileSize) || fileSize.QuadPart == 0)
+	{
+		this->close();
+		return false;
+	}
+
+	_mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!_mapping)
+	{
+		this->close();
+		return false;
+	}
+
+	_data = static_cast<const uint8_t*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+	if (!_data)
+	{
+		this->close();
+		return false;
+	}
+
+	_size = static_cast<size_t>(fileSize.QuadPart);
+
+	return true;
+}
+
+#else
+
+MemoryMappedFile::MemoryMappedFile() :
+	_data(nullptr), _size(0), _file(-1)
+{
+}
+
+void MemoryMappedFile::close()
+{
+	if (_data) munmap(const_cast<uint8_t*>(_data), _size);
+	if (_file >= 0) ::close(_file);
+
+	_data = nullptr;
+	_size = 0;
+	_file = -1;
+}
+
+bool MemoryMappedFile::open(const std::string& filename)
+{
+	this->close();
+
+	_file = ::open(filename.c_str(), O_RDONLY);
+	if (_file < 0) return false;
+
+	struct stat fileStat;
+	if (fstat(_file, &fileStat) != 0 || fileStat.st_size == 0)
+	{
+		this->close();
+		return false;
+	}
+
+	void* data = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, _file, 0);
+	if (data == MAP_FAILED)
+	{
+		this->close();
+		return false;
+	}
+
+	_data = static_cast<const uint8_t*>(data);
+	_size = static_cast<size_t>(fileStat.st_size);
+
+	return true;
+}
+
+#endif
+
+MemoryMappedFile::~MemoryMappedFile()
+{
+	this->close();
+}
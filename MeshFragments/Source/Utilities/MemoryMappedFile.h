@@ -0,0 +1,65 @@
+#pragma once
+
+/**
+*	@brief Read-only view of a whole file mapped in memory, so that binary formats can be decoded without intermediate copies.
+*/
+class MemoryMappedFile
+{
+protected:
+	const uint8_t*	_data;						//!< First byte of the mapping
+	size_t			_size;						//!< Size of the file in bytes
+
+#ifdef _WIN32
+	HANDLE			_file;						//!< File handle
+	HANDLE			_mapping;					//!< File-mapping object
+#else
+	int				_file;						//!< File descriptor
+#endif
+
+public:
+	/**
+	*	@brief Constructor. The file must be opened before accessing data.
+	*/
+	MemoryMappedFile();
+
+	/**
+	*	@brief Deleted copy constructor, since the mapping is owned by this object.
+	*/
+	MemoryMappedFile(const MemoryMappedFile& file) = delete;
+
+	/**
+	*	@brief Destructor. Unmaps the file.
+	*/
+	virtual ~MemoryMappedFile();
+
+	/**
+	*	@brief Unmaps the file, if any.
+	*/
+	void close();
+
+	/**
+	*	@return Mapped bytes, or nullptr if the file is not open or is empty.
+	*/
+	const uint8_t* data() const { return _data; }
+
+	/**
+	*	@return True if a file is currently mapped.
+	*/
+	bool isOpen() const { return _data != nullptr; }
+
+	/**
+	*	@brief Maps a file in read-only mode. Empty files cannot be mapped.
+	*	@return Success of operation.
+	*/
+	bool open(const std::string& filename);
+
+	/**
+	*	@brief Deleted assignment operator.
+	*/
+	MemoryMappedFile& operator=(const MemoryMappedFile& file) = delete;
+
+	/**
+	*	@return Size of the mapped file.
+	*/
+	size_t size() const { return _size; }
+};
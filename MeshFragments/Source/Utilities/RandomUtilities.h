@@ -67,6 +67,11 @@ public:
 	*/
 	static int getUniformRandomInt(int min, int max);
 
+	/**
+	*	@return Random index in [min, max], both included. Unlike getUniformRandomInt, every index is equally likely.
+	*/
+	static size_t getUniformRandomIndex(size_t min, size_t max);
+
 	/**
 	*	@return Random single integer value biased towards the middle value.
 	*/
@@ -143,6 +148,11 @@ inline int RandomUtilities::getUniformRandomInt(int min, int max)
 	return static_cast<int>(getUniformRandom(min, max));
 }
 
+inline size_t RandomUtilities::getUniformRandomIndex(size_t min, size_t max)
+{
+	return std::uniform_int_distribution<size_t>(min, max)(generator);
+}
+
 inline int RandomUtilities::getBiasedRandomInt(int min, int max, int divs)
 {
 	int number = 0;
@@ -0,0 +1,184 @@
+#include "stdafx.h"
+#include "RangeCoder.h"
+
+/// [Encoder]
+
+RangeCoder::Encoder::Encoder(std::vector<uint8_t>& output) :
+	_cache(0), _cacheSize(1), _low(0), _output(&output), _range(0xFFFFFFFF)
+{
+}
+
+void RangeCoder::Encoder::encodeBit(uint16_t& probability, unsigned bit)
+{
+	const uint32_t bound = (_range >> PROBABILITY_BITS) * probability;
+
+	if (bit == 0)
+	{
+		_range = bound;
+		probability += ((1 << PROBABILITY_BITS) - probability) >> ADAPTATION_SHIFT;
+	}
+	else
+	{
+		_low += bound;
+		_range -= bound;
+		probability -= probability >> ADAPTATION_SHIFT;
+	}
+
+	while (_range < TOP_VALUE)
+	{
+		_range <<= 8;
+		this->shiftLow();
+	}
+}
+
+void RangeCoder::Encoder::encodeByte(ByteModel& model, uint8_t byte)
+{
+	unsigned node = 1;
+
+	for (int bitIdx = 7; bitIdx >= 0; --bitIdx)
+	{
+		const unsigned bit = (byte >> bitIdx) & 1;
+		this->encodeBit(model._probabilities[node], bit);
+		node = (node << 1) | bit;
+	}
+}
+
+void RangeCoder::Encoder::encodeDirectBits(uint32_t value, unsigned numBits)
+{
+	for (int bitIdx = static_cast<int>(numBits) - 1; bitIdx >= 0; --bitIdx)
+	{
+		_range >>= 1;
+		if ((value >> bitIdx) & 1)
+			_low += _range;
+
+		while (_range < TOP_VALUE)
+		{
+			_range <<= 8;
+			this->shiftLow();
+		}
+	}
+}
+
+void RangeCoder::Encoder::encodeVarint(VarintModel& model, uint32_t value)
+{
+	unsigned group = 0;
+
+	do
+	{
+		const uint8_t byte = static_cast<uint8_t>(value & 0x7F) | (value > 0x7F ? 0x80 : 0x00);
+		this->encodeByte(model._groups[std::min(group++, VarintModel::NUM_GROUP_MODELS - 1)], byte);
+		value >>= 7;
+	} while (value);
+}
+
+void RangeCoder::Encoder::finish()
+{
+	for (int byteIdx = 0; byteIdx < 5; ++byteIdx)
+		this->shiftLow();
+}
+
+void RangeCoder::Encoder::shiftLow()
+{
+	if (static_cast<uint32_t>(_low) < 0xFF000000 || (_low >> 32) != 0)
+	{
+		const uint8_t carry = static_cast<uint8_t>(_low >> 32);
+		uint8_t byte = _cache;
+
+		do
+		{
+			_output->push_back(static_cast<uint8_t>(byte + carry));
+			byte = 0xFF;
+		} while (--_cacheSize != 0);
+
+		_cache = static_cast<uint8_t>(_low >> 24);
+	}
+
+	++_cacheSize;
+	_low = (_low & 0x00FFFFFF) << 8;
+}
+
+/// [Decoder]
+
+RangeCoder::Decoder::Decoder(const uint8_t* data, size_t size) :
+	_code(0), _data(data), _end(data + size), _range(0xFFFFFFFF)
+{
+	for (int byteIdx = 0; byteIdx < 5; ++byteIdx)
+		_code = (_code << 8) | this->nextByte();
+}
+
+unsigned RangeCoder::Decoder::decodeBit(uint16_t& probability)
+{
+	const uint32_t bound = (_range >> PROBABILITY_BITS) * probability;
+	unsigned bit;
+
+	if (_code < bound)
+	{
+		_range = bound;
+		probability += ((1 << PROBABILITY_BITS) - probability) >> ADAPTATION_SHIFT;
+		bit = 0;
+	}
+	else
+	{
+		_code -= bound;
+		_range -= bound;
+		probability -= probability >> ADAPTATION_SHIFT;
+		bit = 1;
+	}
+
+	while (_range < TOP_VALUE)
+	{
+		_range <<= 8;
+		_code = (_code << 8) | this->nextByte();
+	}
+
+	return bit;
+}
+
+uint8_t RangeCoder::Decoder::decodeByte(ByteModel& model)
+{
+	unsigned node = 1;
+
+	while (node < 256)
+		node = (node << 1) | this->decodeBit(model._probabilities[node]);
+
+	return static_cast<uint8_t>(node - 256);
+}
+
+uint32_t RangeCoder::Decoder::decodeDirectBits(unsigned numBits)
+{
+	uint32_t value = 0;
+
+	for (unsigned bitIdx = 0; bitIdx < numBits; ++bitIdx)
+	{
+		_range >>= 1;
+
+		const unsigned bit = _code >= _range;
+		if (bit)
+			_code -= _range;
+		value = (value << 1) | bit;
+
+		while (_range < TOP_VALUE)
+		{
+			_range <<= 8;
+			_code = (_code << 8) | this->nextByte();
+		}
+	}
+
+	return value;
+}
+
+uint32_t RangeCoder::Decoder::decodeVarint(VarintModel& model)
+{
+	uint32_t value = 0;
+	unsigned group = 0, shift = 0;
+	uint8_t byte;
+
+	do
+	{
+		byte = this->decodeByte(model._groups[std::min(group++, VarintModel::NUM_GROUP_MODELS - 1)]);
+		value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+		shift += 7;
+	} while ((byte & 0x80) && shift < 35);
+
+	return value;
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+/**
+*	@brief Adaptive binary range coder (LZMA-style). Bytes and integers are coded as sequences of binary decisions over bit trees,
+*	so every model adapts to the data without storing any table in the stream.
+*/
+namespace RangeCoder
+{
+	const unsigned PROBABILITY_BITS = 11;						//!< Precision of bit probabilities
+	const unsigned ADAPTATION_SHIFT = 5;						//!< Speed of adaptation of probabilities
+	const uint16_t INITIAL_PROBABILITY = 1 << (PROBABILITY_BITS - 1);
+	const uint32_t TOP_VALUE = 1 << 24;							//!< Renormalization threshold
+	const unsigned MAX_SYMBOLS_PER_BYTE = 46;					//!< Bound of bytes or varints a coded byte may hold, as a decision costs at least log2(2048 / 2017) bits
+
+	/**
+	*	@brief Adaptive model for 8-bit symbols.
+	*/
+	struct ByteModel
+	{
+		uint16_t _probabilities[256];
+
+		ByteModel() { std::fill(std::begin(_probabilities), std::end(_probabilities), INITIAL_PROBABILITY); }
+	};
+
+	/**
+	*	@brief Adaptive model for unsigned integers coded as variable-length groups of 7 bits. Each group position has its own byte model.
+	*/
+	struct VarintModel
+	{
+		const static unsigned NUM_GROUP_MODELS = 5;
+
+		ByteModel _groups[NUM_GROUP_MODELS];
+	};
+
+	/**
+	*	@brief Maps signed integers to unsigned ones so that small magnitudes produce small codes.
+	*/
+	inline uint32_t zigzagEncode(int32_t value) { return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31); }
+
+	/**
+	*	@brief Inverse of zigzagEncode.
+	*/
+	inline int32_t zigzagDecode(uint32_t value) { return static_cast<int32_t>(value >> 1) ^ -static_cast<int32_t>(value & 1); }
+
+	/**
+	*	@brief Appends the coded stream to a byte vector.
+	*/
+	class Encoder
+	{
+	protected:
+		uint8_t					_cache;						//!< Byte pending to be written, as it may receive a carry
+		uint64_t				_cacheSize;					//!< Number of pending bytes (cache plus 0xFF bytes)
+		uint64_t				_low;						//!< Lower bound of the current interval
+		std::vector<uint8_t>*	_output;					//!< Destination of the stream
+		uint32_t				_range;						//!< Size of the current interval
+
+	protected:
+		/**
+		*	@brief Writes the top byte of low, propagating carries into the pending bytes.
+		*/
+		void shiftLow();
+
+	public:
+		/**
+		*	@brief Constructor. Coded bytes are appended to output.
+		*/
+		Encoder(std::vector<uint8_t>& output);
+
+		/**
+		*	@brief Codes a binary decision and adapts its probability.
+		*/
+		void encodeBit(uint16_t& probability, unsigned bit);
+
+		/**
+		*	@brief Codes a byte with an adaptive model.
+		*/
+		void encodeByte(ByteModel& model, uint8_t byte);
+
+		/**
+		*	@brief Codes the lowest numBits bits of value, most significant first, with a fixed probability of one half.
+		*/
+		void encodeDirectBits(uint32_t value, unsigned numBits);
+
+		/**
+		*	@brief Codes an unsigned integer with an adaptive model.
+		*/
+		void encodeVarint(VarintModel& model, uint32_t value);
+
+		/**
+		*	@brief Flushes the remaining bytes. The encoder must not be used afterwards.
+		*/
+		void finish();
+	};
+
+	/**
+	*	@brief Decodes a stream from memory, e.g., a memory-mapped file. Reading beyond the end of the buffer yields zeros.
+	*/
+	class Decoder
+	{
+	protected:
+		uint32_t				_code;						//!< Current code value
+		const uint8_t*			_data;						//!< Coded stream
+		const uint8_t*			_end;						//!< End of the coded stream
+		uint32_t				_range;						//!< Size of the current interval
+
+	protected:
+		/**
+		*	@return Next byte of the stream.
+		*/
+		uint8_t nextByte() { return _data < _end ? *_data++ : 0; }
+
+	public:
+		/**
+		*	@brief Constructor.
+		*/
+		Decoder(const uint8_t* data, size_t size);
+
+		/**
+		*	@brief Decodes a binary decision and adapts its probability.
+		*/
+		unsigned decodeBit(uint16_t& probability);
+
+		/**
+		*	@brief Decodes a byte.
+		*/
+		uint8_t decodeByte(ByteModel& model);
+
+		/**
+		*	@brief Decodes numBits bits coded with encodeDirectBits.
+		*/
+		uint32_t decodeDirectBits(unsigned numBits);
+
+		/**
+		*	@brief Decodes an unsigned integer.
+		*/
+		uint32_t decodeVarint(VarintModel& model);
+	};
+}
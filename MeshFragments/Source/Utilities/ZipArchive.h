@@ -0,0 +1,115 @@
+#pragma once
+
+#include "Utilities/ExportContainer.h"
+
+/**
+*	@brief Uncompressed ZIP archive written in a single pass. Entries are appended as they arrive, from any thread, and the central
+*	directory is written when the archive is closed. The archive is built under a temporary name and renamed once it is complete,
+*	so an interrupted run never leaves a truncated archive behind. ZIP64 records are emitted when the archive requires them.
+*/
+class ZipArchive: public ExportContainer
+{
+protected:
+	struct Entry
+	{
+		std::string		_name;
+		uint32_t		_crc;
+		uint32_t		_size;
+		uint64_t		_offset;									//!< Position of the local header
+	};
+
+	const static uint32_t	CRC_TABLE[256];							//!< CRC-32 (IEEE 802.3) lookup table
+
+	const static uint32_t	LOCAL_HEADER_SIGNATURE = 0x04034B50;
+	const static uint32_t	CENTRAL_HEADER_SIGNATURE = 0x02014B50;
+	const static uint32_t	END_SIGNATURE = 0x06054B50;
+	const static uint32_t	ZIP64_END_SIGNATURE = 0x06064B50;
+	const static uint32_t	ZIP64_LOCATOR_SIGNATURE = 0x07064B50;
+	const static uint16_t	VERSION_STORE = 20;						//!< Minimum version to extract stored entries
+	const static uint16_t	VERSION_ZIP64 = 45;						//!< Minimum version to extract ZIP64 records
+	const static uint16_t	UTF8_NAMES = 1 << 11;					//!< General purpose flag for UTF-8 entry names
+	const static uint16_t	ZIP64_EXTRA_FIELD = 0x0001;
+
+protected:
+	uint16_t			_dosDate, _dosTime;							//!< Modification date of every entry
+	std::vector<Entry>	_entries;									//!< Entries of the central directory
+	std::string			_filename;									//!< Final path of the archive
+	std::mutex			_mutex;										//!< Guards the stream and the entries
+	uint64_t			_offset;									//!< Bytes written so far
+	std::ofstream		_stream;									//!< Temporary file
+
+protected:
+	/**
+	*	@brief Appends a little-endian integer to a header buffer.
+	*/
+	template<typename T>
+	static void append(std::string& buffer, T value);
+
+	/**
+	*	@brief Writes the central directory and the end records.
+	*/
+	void writeCentralDirectory();
+
+public:
+	/**
+	*	@brief Constructor. The archive must be opened before adding entries.
+	*/
+	ZipArchive();
+
+	/**
+	*	@brief Deleted copy constructor.
+	*/
+	ZipArchive(const ZipArchive& archive) = delete;
+
+	/**
+	*	@brief Destructor. Finalises the archive if it is still open.
+	*/
+	virtual ~ZipArchive();
+
+	/**
+	*	@brief Adds a file to the archive. Thread-safe.
+	*	@param name Path of the entry inside the archive.
+	*	@return Success of operation. Fails if the archive is not open or a previous entry could not be written.
+	*/
+	bool addFile(const std::string& name, const char* data, size_t size) override;
+
+	/**
+	*	@brief Writes the central directory and moves the archive to its final path.
+	*	@return Success of operation.
+	*/
+	bool close();
+
+	/**
+	*	@brief Computes the CRC-32 checksum of a buffer.
+	*/
+	static uint32_t crc32(const char* data, size_t size, uint32_t crc = 0);
+
+	/**
+	*	@brief Closes and removes the partial archive.
+	*/
+	void discard();
+
+	/**
+	*	@return True if the archive accepts new entries.
+	*/
+	bool isOpen() const { return _stream.is_open(); }
+
+	/**
+	*	@brief Starts a new archive. It is written next to filename under a temporary name until it is closed.
+	*	@return Success of operation. Fails if a previous archive is still open and cannot be finalised.
+	*/
+	bool open(const std::string& filename);
+
+	/**
+	*	@brief Deleted assignment operator.
+	*/
+	ZipArchive& operator=(const ZipArchive& archive) = delete;
+};
+
+template<typename T>
+inline void ZipArchive::append(std::string& buffer, T value)
+{
+	for (size_t byteIdx = 0; byteIdx < sizeof(T); ++byteIdx)
+		buffer.push_back(static_cast<char>((static_cast<uint64_t>(value) >> (byteIdx * 8)) & 0xFF));
+}
+